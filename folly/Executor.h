@@ -63,6 +63,11 @@ class Executor {
   /// This is up to the implementation to enforce
   virtual void addWithPriority(Func, int8_t priority);
 
+  /// Enqueue several functions at once, moving them out of the range. An
+  /// Executor may amortize its per-function costs, such as waking up threads,
+  /// over the batch. By default, each function is passed to add() in turn.
+  virtual void addBatch(Range<Func*> funcs);
+
   virtual uint8_t getNumPriorities() const { return 1; }
 
   static constexpr int8_t LO_PRI = SCHAR_MIN;
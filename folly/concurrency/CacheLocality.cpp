@@ -338,6 +338,113 @@ CacheLocality CacheLocality::uniform(size_t numCpus) {
   return CacheLocality{std::move(equivClassesByCpu)};
 }
 
+////////////// NumaTopology
+
+/// Parses a sysfs cpu list like "0-3,8,10-11", or throws an exception.
+static std::vector<size_t> parseCpuList(const std::string& line) {
+  std::vector<size_t> cpus;
+  size_t pos = 0;
+  while (pos < line.size()) {
+    auto const first = parseLeadingNumber(line.substr(pos));
+    auto last = first;
+    pos = line.find_first_of(",-", pos);
+    if (pos != std::string::npos && line[pos] == '-') {
+      last = parseLeadingNumber(line.substr(pos + 1));
+      pos = line.find(',', pos);
+    }
+    if (last < first) {
+      throw std::runtime_error(fmt::format("error parsing list '{}'", line));
+    }
+    for (auto cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+    if (pos == std::string::npos) {
+      break;
+    }
+    ++pos;
+  }
+  return cpus;
+}
+
+size_t NumaTopology::currentNode() const {
+  static Getcpu::Func const getcpu = [] {
+    auto func = Getcpu::resolveVdsoFunc();
+    return func ? func : [](unsigned* c, unsigned*, void*) {
+      *c = 0;
+      return 0;
+    };
+  }();
+  unsigned cpu = 0;
+  getcpu(&cpu, nullptr, nullptr);
+  return cpu < nodeByCpu.size() ? nodeByCpu[cpu] : 0;
+}
+
+const NumaTopology& NumaTopology::system() {
+  static Indestructible<NumaTopology> const topology{[] {
+    if (kIsLinux) {
+      try {
+        return readFromSysfs();
+      } catch (...) {
+        // no NUMA support in the kernel, or sysfs is not mounted
+      }
+    }
+    return uniform(CacheLocality::system().numCpus);
+  }()};
+  return *topology;
+}
+
+NumaTopology NumaTopology::readFromSysfsTree(
+    const std::function<std::string(std::string const&)>& mapping) {
+  auto const online = mapping("/sys/devices/system/node/online");
+  if (online.empty()) {
+    throw std::runtime_error("unable to load NUMA nodes from sysfs");
+  }
+  std::vector<std::vector<size_t>> cpusByNode;
+  for (auto const node : parseCpuList(online)) {
+    auto const cpuList = mapping(
+        fmt::format("/sys/devices/system/node/node{}/cpulist", node));
+    if (!cpuList.empty()) {
+      cpusByNode.push_back(parseCpuList(cpuList));
+    }
+  }
+  if (cpusByNode.empty()) {
+    throw std::runtime_error("unable to load NUMA node cpus from sysfs");
+  }
+  return fromCpusByNode(std::move(cpusByNode));
+}
+
+NumaTopology NumaTopology::readFromSysfs() {
+  return readFromSysfsTree([](std::string const& name) {
+    std::ifstream xi(name.c_str());
+    std::string rv;
+    std::getline(xi, rv);
+    return rv;
+  });
+}
+
+NumaTopology NumaTopology::uniform(size_t numCpus) {
+  std::vector<size_t> cpus(numCpus);
+  std::iota(cpus.begin(), cpus.end(), 0);
+  return fromCpusByNode({std::move(cpus)});
+}
+
+NumaTopology NumaTopology::fromCpusByNode(
+    std::vector<std::vector<size_t>> cpusByNode) {
+  NumaTopology topology;
+  for (size_t node = 0; node < cpusByNode.size(); ++node) {
+    auto& cpus = cpusByNode[node];
+    std::sort(cpus.begin(), cpus.end());
+    for (auto const cpu : cpus) {
+      if (topology.nodeByCpu.size() <= cpu) {
+        topology.nodeByCpu.resize(cpu + 1, 0);
+      }
+      topology.nodeByCpu[cpu] = node;
+    }
+  }
+  topology.cpusByNode = std::move(cpusByNode);
+  return topology;
+}
+
 ////////////// Getcpu
 
 Getcpu::Func Getcpu::resolveVdsoFunc() {
@@ -134,6 +134,48 @@ struct CacheLocality {
   explicit CacheLocality(std::vector<std::vector<size_t>> equivClasses);
 };
 
+/// The NUMA nodes of the machine and their cpus, read from sysfs without
+/// depending on libnuma. Nodes are numbered densely from 0, in the order of
+/// their sysfs ids, and nodes without cpus are omitted.
+struct NumaTopology {
+  /// For each node, its cpus in increasing order.
+  std::vector<std::vector<size_t>> cpusByNode;
+
+  /// A map from cpu (from sched_getcpu or getcpu) to its node. Cpus
+  /// missing from all nodes map to node 0.
+  std::vector<size_t> nodeByCpu;
+
+  size_t numNodes() const { return cpusByNode.size(); }
+
+  /// Returns the node of the cpu the calling thread is running on, or 0 if
+  /// it can't be determined.
+  size_t currentNode() const;
+
+  /// Returns the NUMA topology of the current system, cached for fast
+  /// access. A single node holding all cpus if sysfs can't be read.
+  static const NumaTopology& system();
+
+  /// Reads the NUMA topology from a tree structured like the sysfs
+  /// filesystem, with a mapping like that of
+  /// CacheLocality::readFromSysfsTree. The function will be called with
+  /// the paths /sys/devices/system/node/online and
+  /// /sys/devices/system/node/node*/cpulist. Throws an exception if no node
+  /// with cpus can be parsed.
+  static NumaTopology readFromSysfsTree(
+      const std::function<std::string(std::string const&)>& mapping);
+
+  /// Reads the NUMA topology from the real sysfs filesystem.
+  static NumaTopology readFromSysfs();
+
+  /// Returns a topology with a single node holding the specified number
+  /// of cpus.
+  static NumaTopology uniform(size_t numCpus);
+
+  /// Returns a topology with the specified cpus on each node.
+  static NumaTopology fromCpusByNode(
+      std::vector<std::vector<size_t>> cpusByNode);
+};
+
 /// Knows how to derive a function pointer to the VDSO implementation of
 /// getcpu(2), if available
 struct Getcpu {
@@ -0,0 +1,692 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+#include <boost/intrusive/list.hpp>
+
+#include <folly/Optional.h>
+#include <folly/SharedMutex.h>
+#include <folly/container/F14Set.h>
+#include <folly/container/HeterogeneousAccess.h>
+#include <folly/container/small_vector.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Align.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+
+/**
+ * A thread-safe, sharded LRU evicting cache with an API modeled after
+ * EvictingCacheMap.
+ *
+ * Keys are distributed over 1 << ShardBits shards, each of which owns an
+ * independent hash index and LRU list guarded by its own SharedMutex, the
+ * same way ConcurrentHashMap shards its buckets. Operations on different
+ * shards never contend.
+ *
+ * Lookups only take the shard lock in shared mode. Instead of moving the
+ * node to the head of the LRU on every hit (which would need the exclusive
+ * lock), a hit records the node in a small per-shard promotion buffer. The
+ * buffer is drained in access order by the next writer on that shard, or
+ * opportunistically by the reader that fills it. When the buffer is full,
+ * further hits are dropped until it is drained, so the LRU order is an
+ * approximation under heavy read load - the same trade-off made by
+ * buffered-read caches such as Caffeine.
+ *
+ * Differences from EvictingCacheMap:
+ *
+ * * There are no iterators. Lookups return copies of the value, so TValue
+ *   should be cheap to copy (e.g. a shared_ptr) if it is large.
+ *
+ * * maxSize and clearSize are enforced per shard: each shard holds at most
+ *   ceil(maxSize / NumShards) entries, and eviction is LRU within a shard.
+ *   Pick ShardBits so that maxSize is large relative to the shard count.
+ *
+ * * Prune and erase hooks are invoked after the shard lock is released, so
+ *   they may safely call back into the cache.
+ *
+ * NOTE: maxSize==0 is a special case that disables automatic evictions, as
+ * in EvictingCacheMap.
+ */
+template <
+    class TKey,
+    class TValue,
+    class THash = HeterogeneousAccessHash<TKey>,
+    class TKeyEqual = HeterogeneousAccessEqualTo<TKey>,
+    uint8_t ShardBits = 6>
+class ConcurrentEvictingCacheMap {
+ private:
+  struct Node;
+  struct KeyHasher;
+  struct KeyValueEqual;
+  using NodeMap = F14VectorSet<Node*, KeyHasher, KeyValueEqual>;
+  using NodeList = boost::intrusive::list<Node>;
+  using TPair = std::pair<const TKey, TValue>;
+
+ public:
+  using PruneHookCall = std::function<void(TKey, TValue&&)>;
+
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using hasher = THash;
+
+  static constexpr std::size_t NumShards = std::size_t(1) << ShardBits;
+
+  /*
+   * Number of hits each shard buffers before they must be applied to its
+   * LRU list under the exclusive lock.
+   */
+  static constexpr std::size_t kPromotionBufferSize = 32;
+
+ private:
+  template <typename K, typename T>
+  using EnableHeterogeneousFind = std::enable_if_t<
+      detail::EligibleForHeterogeneousFind<TKey, THash, TKeyEqual, K>::value,
+      T>;
+
+  template <typename K, typename T>
+  using EnableHeterogeneousInsert = std::enable_if_t<
+      detail::EligibleForHeterogeneousInsert<TKey, THash, TKeyEqual, K>::value,
+      T>;
+
+ public:
+  /**
+   * Construct a ConcurrentEvictingCacheMap
+   * @param maxSize maximum size of the cache map, split evenly across the
+   *     shards.
+   * @param clearSize the number of elements to clear from a shard at a time
+   *     when automatic eviction on insert is triggered.
+   */
+  explicit ConcurrentEvictingCacheMap(
+      std::size_t maxSize,
+      std::size_t clearSize = 1,
+      const THash& keyHash = THash(),
+      const TKeyEqual& keyEqual = TKeyEqual())
+      : keyHash_(keyHash), maxSize_(maxSize) {
+    auto const shardMax = shardMaxSize(maxSize);
+    for (auto& shard : shards_) {
+      shard.index = NodeMap(
+          shardMax + /*transient*/ 1,
+          KeyHasher(keyHash),
+          KeyValueEqual(keyEqual));
+      shard.maxSize = shardMax;
+      shard.clearSize = clearSize;
+    }
+  }
+
+  ConcurrentEvictingCacheMap(const ConcurrentEvictingCacheMap&) = delete;
+  ConcurrentEvictingCacheMap& operator=(const ConcurrentEvictingCacheMap&) =
+      delete;
+
+  ~ConcurrentEvictingCacheMap() {
+    for (auto& shard : shards_) {
+      shard.lru.clear_and_dispose([](Node* ptr) { delete ptr; });
+    }
+  }
+
+  /**
+   * Adjust the max size, evicting as needed to ensure the new max is not
+   * exceeded. An argument of 0 removes the limit.
+   *
+   * @param maxSize new maximum size of the cache map.
+   * @param pruneHook eviction callback to use INSTEAD OF the configured one
+   */
+  void setMaxSize(std::size_t maxSize, PruneHookCall pruneHook = nullptr) {
+    maxSize_.store(maxSize, std::memory_order_relaxed);
+    auto const shardMax = shardMaxSize(maxSize);
+    for (auto& shard : shards_) {
+      Evicted evicted;
+      std::shared_ptr<PruneHookCall> hook;
+      {
+        auto lock = lockAndDrain(shard);
+        shard.maxSize = shardMax;
+        if (shardMax != 0 && shardMax < shard.lru.size()) {
+          pruneLocked(
+              shard,
+              std::max(shard.lru.size() - shardMax, shard.clearSize),
+              evicted);
+          hook = hookToInvoke(shard, evicted, pruneHook);
+        }
+      }
+      invokeHook(evicted, pruneHook, hook.get());
+    }
+  }
+
+  std::size_t getMaxSize() const {
+    return maxSize_.load(std::memory_order_relaxed);
+  }
+
+  void setClearSize(std::size_t clearSize) {
+    for (auto& shard : shards_) {
+      auto lock = lockAndDrain(shard);
+      shard.clearSize = clearSize;
+    }
+  }
+
+  /**
+   * Check for existence of a specific key in the map. This operation has
+   *     no effect on LRU order.
+   */
+  bool exists(const TKey& key) const { return existsImpl(key); }
+
+  template <typename K, EnableHeterogeneousFind<K, int> = 0>
+  bool exists(const K& key) const {
+    return existsImpl(key);
+  }
+
+  /**
+   * Get a copy of the value associated with a specific key. A hit is
+   *     buffered and promotes the entry to the head of its shard's LRU once
+   *     the buffer is drained.
+   * @throw std::out_of_range exception of the key does not exist
+   */
+  TValue get(const TKey& key) const { return getImpl(key, true); }
+
+  template <typename K, EnableHeterogeneousFind<K, int> = 0>
+  TValue get(const K& key) const {
+    return getImpl(key, true);
+  }
+
+  /**
+   * As get(), but returns none instead of throwing if the key does not exist.
+   */
+  Optional<TValue> tryGet(const TKey& key) const {
+    return tryGetImpl(key, true);
+  }
+
+  template <typename K, EnableHeterogeneousFind<K, int> = 0>
+  Optional<TValue> tryGet(const K& key) const {
+    return tryGetImpl(key, true);
+  }
+
+  /**
+   * Get a copy of the value associated with a specific key. This function
+   *     never promotes a found value.
+   * @throw std::out_of_range exception of the key does not exist
+   */
+  TValue getWithoutPromotion(const TKey& key) const {
+    return getImpl(key, false);
+  }
+
+  template <typename K, EnableHeterogeneousFind<K, int> = 0>
+  TValue getWithoutPromotion(const K& key) const {
+    return getImpl(key, false);
+  }
+
+  Optional<TValue> tryGetWithoutPromotion(const TKey& key) const {
+    return tryGetImpl(key, false);
+  }
+
+  template <typename K, EnableHeterogeneousFind<K, int> = 0>
+  Optional<TValue> tryGetWithoutPromotion(const K& key) const {
+    return tryGetImpl(key, false);
+  }
+
+  /**
+   * Erase the key-value pair associated with key if it exists. Prune hook
+   * is not called unless one passed in here.
+   * @param key key associated with the value
+   * @param eraseHook callback to use with erased entry (similar to a prune
+   * hook)
+   * @return true if the key existed and was erased, else false
+   */
+  bool erase(const TKey& key, PruneHookCall eraseHook = nullptr) {
+    return eraseImpl(key, eraseHook);
+  }
+
+  template <typename K, EnableHeterogeneousFind<K, int> = 0>
+  bool erase(const K& key, PruneHookCall eraseHook = nullptr) {
+    return eraseImpl(key, eraseHook);
+  }
+
+  /**
+   * Set a key-value pair in the dictionary
+   * @param key key to associate with value
+   * @param value value to associate with the key
+   * @param promote boolean flag indicating whether or not to move something
+   *     to the front of an LRU.  This only really matters if you're setting
+   *     a value that already exists.
+   * @param pruneHook eviction callback to use INSTEAD OF the configured one
+   */
+  void set(
+      const TKey& key,
+      TValue value,
+      bool promote = true,
+      PruneHookCall pruneHook = nullptr) {
+    setImpl(key, std::move(value), promote, pruneHook);
+  }
+
+  template <typename K, EnableHeterogeneousInsert<K, int> = 0>
+  void set(
+      const K& key,
+      TValue value,
+      bool promote = true,
+      PruneHookCall pruneHook = nullptr) {
+    setImpl(key, std::move(value), promote, pruneHook);
+  }
+
+  /**
+   * Insert a new key-value pair in the dictionary if no element exists for key
+   * @param key key to associate with value
+   * @param value value to associate with the key
+   * @param pruneHook eviction callback to use INSTEAD OF the configured one
+   * @return true if the insertion took place
+   */
+  bool insert(
+      const TKey& key, TValue value, PruneHookCall pruneHook = nullptr) {
+    return tryEmplaceImpl(key, pruneHook, std::move(value));
+  }
+
+  template <typename K, EnableHeterogeneousInsert<K, int> = 0>
+  bool insert(const K& key, TValue value, PruneHookCall pruneHook = nullptr) {
+    return tryEmplaceImpl(key, pruneHook, std::move(value));
+  }
+
+  /**
+   * Emplace a new key-value pair in the dictionary if no element exists for
+   * key, utilizing the configured prunehook
+   * @param key key to associate with value
+   * @param args args to construct TValue in place, to associate with the key
+   * @return true if the insertion took place
+   */
+  template <typename K, typename... Args>
+  bool try_emplace(const K& key, Args&&... args) {
+    return tryEmplaceImpl(key, nullptr, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Get the number of elements in the dictionary. The result is a snapshot
+   *     that may be stale by the time it is returned.
+   */
+  std::size_t size() const {
+    std::size_t res = 0;
+    for (auto& shard : shards_) {
+      res += shard.size.load(std::memory_order_relaxed);
+    }
+    return res;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  /**
+   * Remove all entries (as if all evicted)
+   * @param pruneHook eviction callback to use INSTEAD OF the configured one
+   */
+  void clear(PruneHookCall pruneHook = nullptr) {
+    for (auto& shard : shards_) {
+      Evicted evicted;
+      std::shared_ptr<PruneHookCall> hook;
+      {
+        auto lock = lockAndDrain(shard);
+        pruneLocked(shard, shard.lru.size(), evicted);
+        hook = hookToInvoke(shard, evicted, pruneHook);
+      }
+      invokeHook(evicted, pruneHook, hook.get());
+    }
+  }
+
+  /**
+   * Set the prune hook, which is the function invoked on the key and value
+   *     on each eviction. Like in EvictingCacheMap, it is not called on
+   *     entries explicitly erase()ed nor on remaining entries at destruction.
+   * @param pruneHook eviction callback to set as default, or nullptr to clear
+   */
+  void setPruneHook(PruneHookCall pruneHook) {
+    for (auto& shard : shards_) {
+      // Each shard owns a copy, so that keeping it alive across the call does
+      // not touch a reference count shared by all the shards.
+      auto hook =
+          pruneHook ? std::make_shared<PruneHookCall>(pruneHook) : nullptr;
+      auto lock = lockAndDrain(shard);
+      shard.pruneHook = std::move(hook);
+    }
+  }
+
+  /**
+   * Prune about pruneSize elements in total from the back of the shards'
+   * LRU lists, spread evenly over the shards.
+   * @param pruneSize number of elements to prune
+   * @param pruneHook eviction callback to use INSTEAD OF the configured one
+   */
+  void prune(std::size_t pruneSize, PruneHookCall pruneHook = nullptr) {
+    auto const perShard = (pruneSize + NumShards - 1) / NumShards;
+    for (auto& shard : shards_) {
+      if (pruneSize == 0) {
+        break;
+      }
+      Evicted evicted;
+      std::shared_ptr<PruneHookCall> hook;
+      {
+        auto lock = lockAndDrain(shard);
+        pruneLocked(shard, std::min(perShard, pruneSize), evicted);
+        hook = hookToInvoke(shard, evicted, pruneHook);
+      }
+      pruneSize -= evicted.size();
+      invokeHook(evicted, pruneHook, hook.get());
+    }
+  }
+
+ private:
+  struct Node
+      : public boost::intrusive::list_base_hook<
+            boost::intrusive::link_mode<boost::intrusive::safe_link>> {
+    template <typename Key, typename... Args>
+    explicit Node(std::piecewise_construct_t, Key&& k, Args&&... args)
+        : pr(std::piecewise_construct,
+             std::forward_as_tuple(std::forward<Key>(k)),
+             std::forward_as_tuple(std::forward<Args>(args)...)) {}
+    TPair pr;
+  };
+  using NodePtr = Node*;
+
+  struct KeyHasher {
+    using is_transparent = void;
+    using folly_is_avalanching = IsAvalanchingHasher<THash, TKey>;
+
+    KeyHasher() : hash() {}
+    explicit KeyHasher(const THash& keyHash) : hash(keyHash) {}
+    std::size_t operator()(const NodePtr& node) const {
+      return hash(node->pr.first);
+    }
+    template <typename K>
+    std::size_t operator()(const K& key) const {
+      return hash(key);
+    }
+    THash hash;
+  };
+
+  struct KeyValueEqual {
+    using is_transparent = void;
+
+    KeyValueEqual() : equal() {}
+    explicit KeyValueEqual(const TKeyEqual& keyEqual) : equal(keyEqual) {}
+    template <typename K>
+    bool operator()(const K& lhs, const NodePtr& rhs) const {
+      return equal(lhs, rhs->pr.first);
+    }
+    template <typename K>
+    bool operator()(const NodePtr& lhs, const K& rhs) const {
+      return equal(lhs->pr.first, rhs);
+    }
+    bool operator()(const NodePtr& lhs, const NodePtr& rhs) const {
+      return equal(lhs->pr.first, rhs->pr.first);
+    }
+    TKeyEqual equal;
+  };
+
+  struct alignas(hardware_destructive_interference_size) Shard {
+    mutable SharedMutex mutex;
+    NodeMap index;
+    NodeList lru;
+    std::size_t maxSize{0};
+    std::size_t clearSize{1};
+    std::shared_ptr<PruneHookCall> pruneHook;
+    std::atomic<std::size_t> size{0};
+
+    // Hits recorded under the shared lock, applied under the exclusive lock.
+    // Slots past kPromotionBufferSize are dropped.
+    mutable std::atomic<std::size_t> promotionCount{0};
+    mutable std::array<std::atomic<Node*>, kPromotionBufferSize> promotions{};
+  };
+
+  using Evicted = small_vector<std::unique_ptr<Node>, 1>;
+
+  static std::size_t shardMaxSize(std::size_t maxSize) {
+    return maxSize == 0 ? 0 : (maxSize + NumShards - 1) / NumShards;
+  }
+
+  template <typename K>
+  std::size_t hashKey(const K& key) const {
+    return keyHash_(key);
+  }
+
+  Shard& pickShard(std::size_t h) const {
+    // The shard index is taken from a remix of the hash so that the bits
+    // used by the per-shard F14 index stay uncorrelated with the shard.
+    return shards_[hash::twang_mix64(h) & (NumShards - 1)];
+  }
+
+  template <typename K>
+  static Node* findInIndex(const Shard& shard, std::size_t h, const K& key) {
+    auto const token = shard.index.prehash(key, h);
+    auto it = shard.index.find(token, key);
+    return it != shard.index.end() ? *it : nullptr;
+  }
+
+  // Acquires the exclusive lock and applies buffered promotions. Every
+  // mutation goes through here, so buffered nodes are never dangling.
+  std::unique_lock<SharedMutex> lockAndDrain(Shard& shard) const {
+    std::unique_lock<SharedMutex> lock(shard.mutex);
+    drainPromotionsLocked(shard);
+    return lock;
+  }
+
+  static void drainPromotionsLocked(Shard& shard) {
+    auto const count = std::min(
+        shard.promotionCount.load(std::memory_order_relaxed),
+        kPromotionBufferSize);
+    for (std::size_t i = 0; i < count; ++i) {
+      Node* node =
+          shard.promotions[i].exchange(nullptr, std::memory_order_relaxed);
+      if (node) {
+        shard.lru.splice(
+            shard.lru.begin(), shard.lru, shard.lru.iterator_to(*node));
+      }
+    }
+    shard.promotionCount.store(0, std::memory_order_relaxed);
+  }
+
+  // Must be called with the shard lock held in shared mode. Returns true if
+  // this hit filled the buffer, in which case the caller should try to drain
+  // it once the shared lock is released.
+  static bool recordPromotion(const Shard& shard, Node* node) {
+    auto const slot =
+        shard.promotionCount.fetch_add(1, std::memory_order_relaxed);
+    if (slot < kPromotionBufferSize) {
+      shard.promotions[slot].store(node, std::memory_order_relaxed);
+    }
+    return slot + 1 == kPromotionBufferSize;
+  }
+
+  void tryDrainPromotions(Shard& shard) const {
+    std::unique_lock<SharedMutex> lock(shard.mutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+      drainPromotionsLocked(shard);
+    }
+  }
+
+  template <typename K>
+  bool existsImpl(const K& key) const {
+    auto const h = hashKey(key);
+    auto& shard = pickShard(h);
+    std::shared_lock<SharedMutex> lock(shard.mutex);
+    return findInIndex(shard, h, key) != nullptr;
+  }
+
+  template <typename K>
+  Optional<TValue> tryGetImpl(const K& key, bool promote) const {
+    auto const h = hashKey(key);
+    auto& shard = pickShard(h);
+    Optional<TValue> res;
+    bool drain = false;
+    {
+      std::shared_lock<SharedMutex> lock(shard.mutex);
+      Node* node = findInIndex(shard, h, key);
+      if (!node) {
+        return res;
+      }
+      res.emplace(node->pr.second);
+      if (promote) {
+        drain = recordPromotion(shard, node);
+      }
+    }
+    if (drain) {
+      tryDrainPromotions(shard);
+    }
+    return res;
+  }
+
+  template <typename K>
+  TValue getImpl(const K& key, bool promote) const {
+    auto res = tryGetImpl(key, promote);
+    if (!res) {
+      throw_exception<std::out_of_range>("Key does not exist");
+    }
+    return std::move(*res);
+  }
+
+  template <typename K>
+  bool eraseImpl(const K& key, PruneHookCall& eraseHook) {
+    auto const h = hashKey(key);
+    auto& shard = pickShard(h);
+    std::unique_ptr<Node> owner;
+    {
+      auto lock = lockAndDrain(shard);
+      Node* node = findInIndex(shard, h, key);
+      if (!node) {
+        return false;
+      }
+      owner.reset(node);
+      shard.index.erase(node);
+      shard.lru.erase(shard.lru.iterator_to(*node));
+      shard.size.store(shard.lru.size(), std::memory_order_relaxed);
+    }
+    if (eraseHook) {
+      eraseHook(owner->pr.first, std::move(owner->pr.second));
+    }
+    return true;
+  }
+
+  template <typename K>
+  void setImpl(
+      const K& key, TValue&& value, bool promote, PruneHookCall& pruneHook) {
+    auto const h = hashKey(key);
+    auto& shard = pickShard(h);
+    Evicted evicted;
+    std::shared_ptr<PruneHookCall> hook;
+    {
+      auto lock = lockAndDrain(shard);
+      Node* node = findInIndex(shard, h, key);
+      if (node) {
+        node->pr.second = std::move(value);
+        if (promote) {
+          shard.lru.splice(
+              shard.lru.begin(), shard.lru, shard.lru.iterator_to(*node));
+        }
+        return;
+      }
+      insertLocked(
+          shard,
+          h,
+          std::make_unique<Node>(
+              std::piecewise_construct, key, std::move(value)),
+          evicted);
+      hook = hookToInvoke(shard, evicted, pruneHook);
+    }
+    invokeHook(evicted, pruneHook, hook.get());
+  }
+
+  template <typename K, typename... Args>
+  bool tryEmplaceImpl(const K& key, PruneHookCall pruneHook, Args&&... args) {
+    auto const h = hashKey(key);
+    auto& shard = pickShard(h);
+    Evicted evicted;
+    std::shared_ptr<PruneHookCall> hook;
+    {
+      auto lock = lockAndDrain(shard);
+      if (findInIndex(shard, h, key)) {
+        return false;
+      }
+      insertLocked(
+          shard,
+          h,
+          std::make_unique<Node>(
+              std::piecewise_construct, key, std::forward<Args>(args)...),
+          evicted);
+      hook = hookToInvoke(shard, evicted, pruneHook);
+    }
+    invokeHook(evicted, pruneHook, hook.get());
+    return true;
+  }
+
+  void insertLocked(
+      Shard& shard,
+      std::size_t h,
+      std::unique_ptr<Node> nodeOwner,
+      Evicted& evicted) {
+    Node* node = nodeOwner.get();
+    auto const token = shard.index.prehash(node->pr.first, h);
+    shard.index.emplace_token(token, node);
+    shard.lru.push_front(*nodeOwner.release());
+
+    // no evictions if maxSize is 0 i.e. unlimited capacity
+    if (shard.maxSize > 0 && shard.lru.size() > shard.maxSize) {
+      pruneLocked(shard, shard.clearSize, evicted);
+    }
+    shard.size.store(shard.lru.size(), std::memory_order_relaxed);
+  }
+
+  static void pruneLocked(Shard& shard, std::size_t count, Evicted& evicted) {
+    for (std::size_t i = 0; i < count && !shard.lru.empty(); ++i) {
+      Node* node = &shard.lru.back();
+      shard.lru.pop_back();
+      shard.index.erase(node);
+      evicted.emplace_back(node);
+    }
+    shard.size.store(shard.lru.size(), std::memory_order_relaxed);
+  }
+
+  // The shard's hook, kept alive past the shard lock, if it is going to be
+  // invoked on evicted. Copying it only then keeps its reference count off
+  // the path of the inserts that do not evict.
+  static std::shared_ptr<PruneHookCall> hookToInvoke(
+      const Shard& shard,
+      const Evicted& evicted,
+      const PruneHookCall& pruneHook) {
+    if (evicted.empty() || pruneHook) {
+      return nullptr;
+    }
+    return shard.pruneHook;
+  }
+
+  static void invokeHook(
+      Evicted& evicted,
+      const PruneHookCall& pruneHook,
+      const PruneHookCall* defaultHook) {
+    auto ph = pruneHook ? &pruneHook : defaultHook;
+    if (!ph || !*ph) {
+      return;
+    }
+    for (auto& node : evicted) {
+      // NOTE: might throw; the remaining nodes are still freed by `evicted`
+      (*ph)(node->pr.first, std::move(node->pr.second));
+    }
+  }
+
+  THash keyHash_;
+  std::atomic<std::size_t> maxSize_;
+  mutable std::array<Shard, NumShards> shards_;
+};
+
+} // namespace folly
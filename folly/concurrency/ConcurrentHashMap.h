@@ -69,7 +69,11 @@ namespace folly {
  *
  * 2: ConcurrentHashMapSIMD, based on F14ValueMap.  If the map is
  *    larger than the cache size, it has superior performance due to
- *    vectorized key lookup.
+ *    vectorized key lookup.  Tags are probed with SSE2 or NEON (the
+ *    same platforms as F14), and find() never waits for or retries
+ *    around a concurrent rehash: readers keep probing the previous
+ *    table until the grown one is published.  On platforms without
+ *    F14 vector support it falls back to ConcurrentHashMap.
  *
  *
  *
@@ -813,7 +817,7 @@ using ConcurrentHashMapSIMD = ConcurrentHashMap<
     ShardBits,
     Atom,
     Mutex,
-#if FOLLY_SSE_PREREQ(4, 2) && FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
+#if FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
     detail::concurrenthashmap::simd::SIMDTable
 #else
     // fallback to regular impl
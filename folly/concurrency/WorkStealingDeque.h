@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/lang/Align.h>
+#include <folly/lang/Bits.h>
+
+namespace folly {
+
+/// WorkStealingDeque is the Chase-Lev work-stealing deque, in the
+/// formulation of Le, Pop, Cohen and Zappa Nardelli, "Correct and
+/// Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+///
+/// A single owner thread pushes and pops at the bottom, in LIFO order,
+/// and any number of thieves steal from the top, in FIFO order. Owner
+/// operations don't use read-modify-write instructions except to pop
+/// the last element, which may race with a thief.
+///
+/// The deque grows as needed and never shrinks. Arrays replaced by
+/// growth may still be read by thieves, so they are kept until the deque
+/// is destroyed; their total size is less than that of the current one.
+///
+/// T must be trivially copyable, typically a pointer.
+///
+/// Functions:
+///   Owner only
+///     void push(T);
+///     Optional<T> pop();
+///   Any thread
+///     Optional<T> steal();
+///     size_t size() const;  // approximate when not called by the owner
+///     bool empty() const;
+template <typename T>
+class WorkStealingDeque {
+  static_assert(
+      std::is_trivially_copyable_v<T>,
+      "WorkStealingDeque elements must be trivially copyable");
+
+  struct Array {
+    explicit Array(int64_t cap)
+        : capacity{cap}, slots{std::make_unique<std::atomic<T>[]>(cap)} {}
+
+    T get(int64_t i) const noexcept {
+      return slots[i & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t i, T value) noexcept {
+      slots[i & (capacity - 1)].store(value, std::memory_order_relaxed);
+    }
+
+    int64_t const capacity;
+    std::unique_ptr<std::atomic<T>[]> const slots;
+  };
+
+  alignas(hardware_destructive_interference_size) std::atomic<int64_t> top_{0};
+  alignas(hardware_destructive_interference_size)
+      std::atomic<int64_t> bottom_{0};
+  std::atomic<Array*> array_;
+  // Owner only.
+  std::vector<std::unique_ptr<Array>> arrays_;
+
+ public:
+  explicit WorkStealingDeque(size_t capacity = 64) {
+    arrays_.push_back(std::make_unique<Array>(
+        static_cast<int64_t>(nextPowTwo(std::max<size_t>(capacity, 2)))));
+    array_.store(arrays_.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(WorkStealingDeque const&) = delete;
+  WorkStealingDeque& operator=(WorkStealingDeque const&) = delete;
+
+  /// Owner only.
+  void push(T value) {
+    auto const b = bottom_.load(std::memory_order_relaxed);
+    auto const t = top_.load(std::memory_order_acquire);
+    auto a = array_.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1) {
+      a = grow(a, t, b);
+    }
+    a->put(b, value);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  /// Owner only. Takes the most recently pushed element.
+  Optional<T> pop() noexcept {
+    auto const b = bottom_.load(std::memory_order_relaxed) - 1;
+    auto const a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return none;
+    }
+    T value = a->get(b);
+    if (t == b) {
+      // Last element: race with thieves for it.
+      bool const won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      if (!won) {
+        return none;
+      }
+    }
+    return value;
+  }
+
+  /// Takes the least recently pushed element. Fails, spuriously, if
+  /// another thread took an element concurrently.
+  Optional<T> steal() noexcept {
+    auto t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto const b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return none;
+    }
+    // Acquire pairs with the release store in grow(), so that the slots
+    // copied to a new array are visible.
+    auto const a = array_.load(std::memory_order_acquire);
+    T value = a->get(t);
+    if (!top_.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return none;
+    }
+    return value;
+  }
+
+  size_t size() const noexcept {
+    auto const b = bottom_.load(std::memory_order_relaxed);
+    auto const t = top_.load(std::memory_order_relaxed);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+
+ private:
+  Array* grow(Array* a, int64_t t, int64_t b) {
+    auto next = std::make_unique<Array>(a->capacity * 2);
+    for (auto i = t; i < b; ++i) {
+      next->put(i, a->get(i));
+    }
+    arrays_.push_back(std::move(next));
+    auto const result = arrays_.back().get();
+    array_.store(result, std::memory_order_release);
+    return result;
+  }
+};
+
+} // namespace folly
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#include <folly/concurrency/container/SingleWriterFixedHashMap.h>
+#include <folly/lang/Bits.h>
+#include <folly/synchronization/Hazptr.h>
+
+#include <glog/logging.h>
+
+namespace folly {
+
+/// SingleWriterHashMap:
+///
+/// Single-writer multi-reader hash map that grows and shrinks as
+/// needed, built on SingleWriterFixedHashMap. Readers are lock-free
+/// and never wait for the writer.
+///
+/// Supports:
+/// - Concurrent read-only lookup.
+/// - insert() and erase() by a single writer at a time.
+///
+/// Unlike SingleWriterFixedHashMap, the caller doesn't manage
+/// capacity or tombstones. When the current table runs low on empty
+/// slots the writer allocates a new one, sized for the live entries,
+/// and moves entries over incrementally: each insert() or erase()
+/// migrates a few entries of the old table, so no write pays for a
+/// full rehash. Until migration is complete, readers look up both tables.
+/// Readers protect the tables they use with a hazard pointer, and a
+/// table is reclaimed by hazptr once no reader can still be using it.
+///
+/// Notes on algorithm:
+/// - insert() adds a key to the new table only if neither table has
+///   it. Migration copies entries without removing them from the old
+///   table, so readers that look up the new table first and then the
+///   old one cannot miss a key that is being migrated.
+/// - erase() removes a key from both tables, so readers cannot find
+///   a stale copy in the old table.
+///
+/// Writer-only operations:
+/// - insert()
+/// - erase()
+/// - capacity()
+/// - migrating()
+///
+template <typename Key, typename Value>
+class SingleWriterHashMap {
+  using Table = SingleWriterFixedHashMap<Key, Value>;
+  using TableIterator = typename Table::Iterator;
+
+  static constexpr size_t kInitialCapacity = 8;
+  static constexpr size_t kSlackReciprocal = 4; // unused >= 1/4 capacity
+  // Entries of the old table migrated by each write. Large enough that
+  // migration completes before the new table needs to grow again.
+  static constexpr size_t kMigrationBatch = 8;
+
+  // The tables visible to readers. Replaced when a migration starts
+  // and when it completes.
+  struct State : hazptr_obj_base<State> {
+    std::shared_ptr<Table> cur;
+    std::shared_ptr<Table> prev; // being migrated into cur, if not null
+
+    State(std::shared_ptr<Table> c, std::shared_ptr<Table> p)
+        : cur(std::move(c)), prev(std::move(p)) {}
+  };
+
+  std::atomic<State*> state_;
+  std::atomic<size_t> size_{0};
+  std::optional<TableIterator> migrateIt_;
+
+ public:
+  explicit SingleWriterHashMap(size_t capacity = kInitialCapacity)
+      : state_(new State(
+            std::make_shared<Table>(std::max(capacity, kInitialCapacity)),
+            nullptr)) {}
+
+  SingleWriterHashMap(const SingleWriterHashMap&) = delete;
+  SingleWriterHashMap& operator=(const SingleWriterHashMap&) = delete;
+
+  ~SingleWriterHashMap() { delete state_.load(std::memory_order_relaxed); }
+
+  /* data-race-free, can be called by readers */
+  FOLLY_ALWAYS_INLINE size_t size() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  FOLLY_ALWAYS_INLINE bool empty() const { return size() == 0; }
+
+  /* data-race-free, can be called by readers */
+  std::optional<Value> find(Key key) const {
+    hazptr_local<1> h;
+    State* state = h[0].protect(state_);
+    auto it = state->cur->find(key);
+    if (it != state->cur->end()) {
+      return it.value();
+    }
+    if (state->prev) {
+      it = state->prev->find(key);
+      if (it != state->prev->end()) {
+        return it.value();
+      }
+    }
+    return std::nullopt;
+  }
+
+  /* data-race-free, can be called by readers */
+  bool contains(Key key) const { return find(key).has_value(); }
+
+  /* not data-race-free, to be called only by the single writer */
+  size_t capacity() const { return writer_state()->cur->capacity(); }
+
+  /* not data-race-free, to be called only by the single writer */
+  bool migrating() const { return writer_state()->prev != nullptr; }
+
+  /// Inserts the key if it is not already present. Returns true if it
+  /// was inserted.
+  bool insert(Key key, Value value) {
+    migrate_step();
+    State* state = writer_state();
+    if (state->cur->contains(key) ||
+        (state->prev && state->prev->contains(key))) {
+      return false;
+    }
+    if (!state->prev && need_expand(*state->cur)) {
+      start_migration();
+      state = writer_state();
+    }
+    DCHECK(!need_expand(*state->cur));
+    state->cur->insert(key, value);
+    size_.store(size() + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Erases the key. Returns true if it was present.
+  bool erase(Key key) {
+    migrate_step();
+    State* state = writer_state();
+    bool erased = state->prev && state->prev->erase(key);
+    erased = state->cur->erase(key) || erased;
+    if (erased) {
+      size_.store(size() - 1, std::memory_order_release);
+    }
+    return erased;
+  }
+
+ private:
+  State* writer_state() const {
+    return state_.load(std::memory_order_relaxed);
+  }
+
+  static bool need_expand(const Table& table) {
+    return kSlackReciprocal * (table.available() - 1) < table.capacity();
+  }
+
+  void publish(State* state) {
+    State* old = state_.exchange(state, std::memory_order_acq_rel);
+    old->retire();
+  }
+
+  void start_migration() {
+    State* state = writer_state();
+    DCHECK(!state->prev);
+    // Room for twice the live entries and for those inserted while
+    // migrating, so the new table is at most half used when migration
+    // completes. Tombstones are not carried over, so the new table may
+    // be smaller than the old one.
+    size_t live = size() + state->cur->capacity() / kMigrationBatch;
+    size_t capacity = std::max(kInitialCapacity, nextPowTwo(2 * live));
+    auto next = std::make_shared<Table>(capacity);
+    auto prev = state->cur;
+    migrateIt_ = prev->begin();
+    publish(new State(std::move(next), std::move(prev)));
+  }
+
+  void migrate_step() {
+    State* state = writer_state();
+    if (!state->prev) {
+      return;
+    }
+    auto& it = *migrateIt_;
+    auto end = state->prev->end();
+    for (size_t i = 0; i < kMigrationBatch && it != end; ++i, ++it) {
+      // The entry `it` stopped at in the previous step may have been
+      // erased since.
+      Key key = it.key();
+      if (state->prev->contains(key)) {
+        state->cur->insert(key, it.value());
+      }
+    }
+    if (it == end) {
+      migrateIt_.reset();
+      publish(new State(state->cur, nullptr));
+    }
+  }
+}; // SingleWriterHashMap
+
+} // namespace folly
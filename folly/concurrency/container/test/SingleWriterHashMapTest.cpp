@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/container/SingleWriterHashMap.h>
+
+#include <folly/Benchmark.h>
+#include <folly/concurrency/ConcurrentHashMap.h>
+#include <folly/container/Array.h>
+#include <folly/portability/GFlags.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/test/Barrier.h>
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <thread>
+
+DEFINE_bool(bench, false, "run benchmark");
+DEFINE_int32(reps, 10, "number of reps");
+DEFINE_int32(ops, 1000000, "number of operations per rep");
+DEFINE_int32(bench_size, 100000, "number of entries in the benchmark maps");
+
+using SWHM = folly::SingleWriterHashMap<int, int>;
+
+void basic_test() {
+  SWHM m;
+
+  ASSERT_TRUE(m.empty());
+  ASSERT_FALSE(m.erase(0));
+  ASSERT_FALSE(m.find(0).has_value());
+
+  ASSERT_TRUE(m.insert(1, 10));
+  ASSERT_FALSE(m.insert(1, 11));
+  ASSERT_EQ(m.size(), 1);
+  ASSERT_EQ(m.find(1), 10);
+  ASSERT_TRUE(m.contains(1));
+
+  ASSERT_TRUE(m.insert(2, 20));
+  ASSERT_EQ(m.size(), 2);
+  ASSERT_TRUE(m.erase(1));
+  ASSERT_FALSE(m.erase(1));
+  ASSERT_EQ(m.size(), 1);
+  ASSERT_FALSE(m.contains(1));
+  ASSERT_EQ(m.find(2), 20);
+}
+
+TEST(SingleWriterHashMap, basic) {
+  basic_test();
+}
+
+void grow_test() {
+  SWHM m;
+  const int n = 100000;
+  size_t migrations = 0;
+  bool wasMigrating = false;
+  for (int i = 0; i < n; ++i) {
+    ASSERT_TRUE(m.insert(i, -i));
+    migrations += m.migrating() && !wasMigrating;
+    wasMigrating = m.migrating();
+    // Spot check that nothing is lost while entries are being moved.
+    if (m.migrating() && i % 97 == 0) {
+      for (int j = 0; j <= i; j += 13) {
+        ASSERT_EQ(m.find(j), -j);
+      }
+    }
+  }
+  ASSERT_EQ(m.size(), n);
+  ASSERT_GE(m.capacity(), n);
+  ASSERT_GT(migrations, 10);
+  for (int i = 0; i < n; ++i) {
+    ASSERT_EQ(m.find(i), -i);
+  }
+  ASSERT_FALSE(m.contains(n));
+}
+
+TEST(SingleWriterHashMap, grow) {
+  grow_test();
+}
+
+void erase_while_migrating_test() {
+  SWHM m;
+  int next = 0;
+  // Fill until a migration starts.
+  while (!m.migrating()) {
+    m.insert(next, next);
+    ++next;
+  }
+  // Erase and reinsert keys on both sides of the migration cursor.
+  for (int i = 0; i < next; i += 2) {
+    ASSERT_TRUE(m.erase(i));
+    ASSERT_FALSE(m.contains(i));
+  }
+  for (int i = 0; i < next; i += 4) {
+    ASSERT_TRUE(m.insert(i, -i));
+  }
+  while (m.migrating()) {
+    m.insert(next, next);
+    ++next;
+  }
+  for (int i = 0; i < next; ++i) {
+    if (i % 4 == 0) {
+      ASSERT_EQ(m.find(i), -i);
+    } else if (i % 2 == 0) {
+      ASSERT_FALSE(m.contains(i));
+    } else {
+      ASSERT_EQ(m.find(i), i);
+    }
+  }
+}
+
+TEST(SingleWriterHashMap, eraseWhileMigrating) {
+  erase_while_migrating_test();
+}
+
+void tombstones_test() {
+  // Tombstones used up by insert/erase churn are dropped by
+  // migration, so the capacity stays bounded.
+  SWHM m;
+  for (int i = 0; i < 100000; ++i) {
+    ASSERT_TRUE(m.insert(i, i));
+    ASSERT_TRUE(m.erase(i));
+  }
+  ASSERT_TRUE(m.empty());
+  ASSERT_LE(m.capacity(), 64);
+}
+
+TEST(SingleWriterHashMap, tombstones) {
+  tombstones_test();
+}
+
+void drf_test() {
+  SWHM m;
+  const int stable = 1000;
+  for (int i = 0; i < stable; ++i) {
+    m.insert(i, i);
+  }
+  int nthr = 5;
+  folly::test::Barrier b1(nthr + 1);
+  std::atomic<bool> stop{false};
+
+  auto writer = std::thread([&] {
+    b1.wait();
+    // Grow and shrink repeatedly, migrating the stable keys each time.
+    for (int r = 0; r < 10; ++r) {
+      for (int j = stable; j < stable + 5000; ++j) {
+        m.insert(j, j);
+      }
+      for (int j = stable; j < stable + 5000; ++j) {
+        m.erase(j);
+      }
+    }
+    stop.store(true);
+  });
+
+  std::vector<std::thread> readers(nthr - 1);
+  for (int i = 0; i < nthr - 1; ++i) {
+    readers[i] = std::thread([&, i] {
+      b1.wait();
+      int key = i;
+      while (!stop) {
+        key = (key + 7) % stable;
+        auto v = m.find(key);
+        ASSERT_TRUE(v.has_value());
+        ASSERT_EQ(*v, key);
+        ASSERT_FALSE(m.contains(-1 - key));
+      }
+    });
+  }
+
+  b1.wait();
+  writer.join();
+  for (int i = 0; i < nthr - 1; ++i) {
+    readers[i].join();
+  }
+  ASSERT_EQ(m.size(), stable);
+}
+
+TEST(SingleWriterHashMap, drf) {
+  drf_test();
+}
+
+// Benchmarks
+
+template <typename Func>
+inline uint64_t run_once(int nthr, const Func& fn) {
+  folly::test::Barrier b1(nthr + 1);
+
+  std::vector<std::thread> thr(nthr);
+  for (int tid = 0; tid < nthr; ++tid) {
+    thr[tid] = std::thread([&, tid] {
+      b1.wait();
+      fn(tid);
+    });
+  }
+
+  b1.wait();
+  /* begin time measurement */
+  auto const tbegin = std::chrono::steady_clock::now();
+  /* wait for completion */
+  for (int i = 0; i < nthr; ++i) {
+    thr[i].join();
+  }
+  /* end time measurement */
+  auto const tend = std::chrono::steady_clock::now();
+  auto const dur = tend - tbegin;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(dur).count();
+}
+
+template <typename RepFunc>
+uint64_t runBench(int ops, const RepFunc& repFn) {
+  uint64_t reps = FLAGS_reps;
+  uint64_t min = UINTMAX_MAX;
+  uint64_t max = 0;
+  uint64_t sum = 0;
+  std::vector<uint64_t> durs(reps);
+  for (uint64_t r = 0; r < reps; ++r) {
+    uint64_t dur = repFn();
+    durs[r] = dur;
+    sum += dur;
+    min = std::min(min, dur);
+    max = std::max(max, dur);
+    // if each rep takes too long run at least 3 reps
+    const uint64_t minute = 60000000000ULL;
+    if (sum > minute && r >= 2) {
+      reps = r + 1;
+      break;
+    }
+  }
+  const std::string ns_unit = " ns";
+  uint64_t avg = sum / reps;
+  uint64_t res = min;
+  uint64_t varsum = 0;
+  for (uint64_t r = 0; r < reps; ++r) {
+    auto term = int64_t(reps * durs[r]) - int64_t(sum);
+    varsum += term * term;
+  }
+  uint64_t dev = uint64_t(std::sqrt(varsum) * std::pow(reps, -1.5));
+  std::cout << "   " << std::setw(4) << max / ops << ns_unit;
+  std::cout << "   " << std::setw(4) << avg / ops << ns_unit;
+  std::cout << "   " << std::setw(4) << dev / ops << ns_unit;
+  std::cout << "   " << std::setw(4) << res / ops << ns_unit;
+  std::cout << std::endl;
+  return res;
+}
+
+struct SWHMAdapter {
+  SWHM m;
+  bool find(int key) const { return m.find(key).has_value(); }
+  void insert(int key, int value) { m.insert(key, value); }
+  void erase(int key) { m.erase(key); }
+};
+
+struct CHMAdapter {
+  folly::ConcurrentHashMap<int, int> m;
+  bool find(int key) const { return m.find(key) != m.cend(); }
+  void insert(int key, int value) { m.insert(key, value); }
+  void erase(int key) { m.erase(key); }
+};
+
+// Thread 0 writes once per `writeEvery` operations, inserting and
+// erasing keys outside the read set so that the map keeps growing and
+// migrating; the other threads only read. Reports time per read.
+template <typename Map>
+uint64_t bench_read_mostly(
+    const int nthr, const uint64_t ops, const int writeEvery) {
+  auto repFn = [&] {
+    Map map;
+    const int size = FLAGS_bench_size;
+    for (int i = 0; i < size; ++i) {
+      map.insert(i, i);
+    }
+    auto fn = [&](int tid) {
+      int key = tid;
+      int next = size;
+      for (uint64_t i = tid; i < ops; i += nthr) {
+        key = (key + 7919) % size;
+        if (tid == 0 && writeEvery && i % writeEvery == 0) {
+          map.insert(next, next);
+          if (next - size >= size) {
+            map.erase(next - size);
+          }
+          ++next;
+        } else if (!map.find(key)) {
+          ASSERT_TRUE(map.find(key));
+        }
+      }
+    };
+    return run_once(nthr, fn);
+  };
+  return runBench(ops, repFn);
+}
+
+void dottedLine() {
+  std::cout
+      << "........................................................................"
+      << std::endl;
+}
+
+constexpr auto nthr = folly::make_array<int>(1, 10);
+
+TEST(SingleWriterHashMapBench, Bench) {
+  if (!FLAGS_bench) {
+    return;
+  }
+  std::cout
+      << "========================================================================"
+      << std::endl;
+  std::cout << std::setw(2) << FLAGS_reps << " reps of " << std::setw(8)
+            << FLAGS_ops << " operations\n";
+  dottedLine();
+  std::cout << "$ numactl -N 1 $dir/single_writer_hash_map_test --bench\n";
+  std::cout
+      << "========================================================================"
+      << std::endl;
+  std::cout
+      << "Test name                         Max time  Avg time  Dev time  Min time"
+      << std::endl;
+  for (int i : nthr) {
+    std::cout << "============================== " << std::setw(2) << i
+              << " threads " << "==============================" << std::endl;
+    const uint64_t ops = FLAGS_ops;
+    std::cout << "CHM find only                  ";
+    bench_read_mostly<CHMAdapter>(i, ops, 0);
+    std::cout << "SWHM find only                 ";
+    bench_read_mostly<SWHMAdapter>(i, ops, 0);
+    std::cout << "CHM 1% writes                  ";
+    bench_read_mostly<CHMAdapter>(i, ops, 100);
+    std::cout << "SWHM 1% writes                 ";
+    bench_read_mostly<SWHMAdapter>(i, ops, 100);
+  }
+  std::cout
+      << "========================================================================"
+      << std::endl;
+}
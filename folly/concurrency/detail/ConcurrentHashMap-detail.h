@@ -22,12 +22,25 @@
 #include <new>
 
 #include <folly/container/HeterogeneousAccess.h>
+#include <folly/container/detail/F14IntrinsicsAvailability.h>
 #include <folly/container/detail/F14Mask.h>
 #include <folly/lang/Exception.h>
 #include <folly/synchronization/Hazptr.h>
 
-#if FOLLY_SSE_PREREQ(4, 2) && !FOLLY_MOBILE
-#include <nmmintrin.h>
+#if FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
+#if FOLLY_F14_CRC_INTRINSIC_AVAILABLE
+#if FOLLY_NEON
+#include <arm_acle.h> // __crc32cd
+#else
+#include <nmmintrin.h> // _mm_crc32_u64
+#endif
+#endif
+
+#if FOLLY_NEON
+#include <arm_neon.h> // uint8x16t intrinsics
+#elif FOLLY_SSE >= 2
+#include <emmintrin.h> // __m128i intrinsics
+#endif
 #endif
 
 namespace folly {
@@ -779,11 +792,10 @@ class alignas(64) BucketTable {
 
 } // namespace bucket
 
-#if FOLLY_SSE_PREREQ(4, 2) && FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
+#if FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
 
 namespace simd {
 
-using folly::f14::detail::DenseMaskIter;
 using folly::f14::detail::FirstEmptyInMask;
 using folly::f14::detail::FullMask;
 using folly::f14::detail::MaskType;
@@ -912,6 +924,41 @@ class alignas(64) SIMDTable {
       setNodeAndTag(index, nullptr, 0);
     }
 
+    // The tag words are loaded atomically and then filtered in vector
+    // registers, the same way as F14Chunk filters its tag array. The two
+    // overflow counter bytes at the top of tags_hi_ are masked off by
+    // kFullMask.
+#if FOLLY_NEON
+    ////////
+    // Tag filtering using NEON intrinsics
+
+    SparseMaskIter tagMatchIter(std::size_t needle) const {
+      FOLLY_SAFE_DCHECK(needle >= 0x80 && needle < 0x100, "");
+      uint64_t low = tags_low_.load(std::memory_order_acquire);
+      uint64_t hi = tags_hi_.load(std::memory_order_acquire);
+      uint8x16_t tagV = vreinterpretq_u8_u64(
+          vcombine_u64(vcreate_u64(low), vcreate_u64(hi)));
+      auto needleV = vdupq_n_u8(static_cast<uint8_t>(needle));
+      auto eqV = vceqq_u8(tagV, needleV);
+      // get info from every byte into the bottom half of every uint16_t
+      // by shifting right 4, then round to get it into a 64-bit vector
+      uint8x8_t maskV = vshrn_n_u16(vreinterpretq_u16_u8(eqV), 4);
+      uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(maskV), 0) & kFullMask;
+      return SparseMaskIter(mask);
+    }
+
+    MaskType occupiedMask() const {
+      uint64_t low = tags_low_.load(std::memory_order_relaxed);
+      uint64_t hi = tags_hi_.load(std::memory_order_relaxed);
+      uint8x16_t tagV = vreinterpretq_u8_u64(
+          vcombine_u64(vcreate_u64(low), vcreate_u64(hi)));
+      // signed shift extends top bit to all bits
+      auto occupiedV =
+          vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(tagV), 7));
+      uint8x8_t maskV = vshrn_n_u16(vreinterpretq_u16_u8(occupiedV), 4);
+      return vget_lane_u64(vreinterpret_u64_u8(maskV), 0) & kFullMask;
+    }
+#elif FOLLY_SSE >= 2
     ////////
     // Tag filtering using SSE2 intrinsics
 
@@ -932,10 +979,39 @@ class alignas(64) SIMDTable {
       auto tagV = _mm_set_epi64x(hi, low);
       return _mm_movemask_epi8(tagV) & kFullMask;
     }
+#else
+    ////////
+    // Tag filtering using plain C/C++
+
+    SparseMaskIter tagMatchIter(std::size_t needle) const {
+      FOLLY_SAFE_DCHECK(needle >= 0x80 && needle < 0x100, "");
+      uint64_t words[2] = {
+          tags_low_.load(std::memory_order_acquire),
+          tags_hi_.load(std::memory_order_acquire)};
+      MaskType mask = 0;
+      for (unsigned i = 0; i < kCapacity; i++) {
+        auto tag = uint8_t(words[i / 8] >> ((i % 8) * 8));
+        mask |= MaskType(tag == static_cast<uint8_t>(needle)) << i;
+      }
+      return SparseMaskIter{mask};
+    }
 
-    DenseMaskIter occupiedIter() const {
+    MaskType occupiedMask() const {
+      uint64_t words[2] = {
+          tags_low_.load(std::memory_order_relaxed),
+          tags_hi_.load(std::memory_order_relaxed)};
+      MaskType mask = 0;
+      for (unsigned i = 0; i < kCapacity; i++) {
+        mask |= MaskType((words[i / 8] >> ((i % 8) * 8 + 7)) & 1) << i;
+      }
+      return mask;
+    }
+#endif
+
+    SparseMaskIter occupiedIter() const {
       // Currently only invoked when relaxed semantics are sufficient.
-      return DenseMaskIter{nullptr /*unused*/, occupiedMask()};
+      // DenseMaskIter would need the tags as a byte array on ARM.
+      return SparseMaskIter{occupiedMask()};
     }
 
     FirstEmptyInMask firstEmpty() const {
@@ -994,14 +1070,17 @@ class alignas(64) SIMDTable {
     }
   };
 
+  // The chunk array records its own size, so that readers get a consistent
+  // (chunks, count) pair from a single hazptr-protected load and never wait
+  // for or retry around a concurrent rehash.
   class Chunks : public hazptr_obj_base<Chunks, Atom, HazptrTableDeleter> {
-    Chunks() {}
+    explicit Chunks(size_t count) : count_(count) {}
     ~Chunks() {}
 
    public:
     static Chunks* create(size_t count, hazptr_obj_cohort<Atom>* cohort) {
       auto buf = Allocator().allocate(sizeof(Chunks) + sizeof(Chunk) * count);
-      auto chunks = new (buf) Chunks();
+      auto chunks = new (buf) Chunks(count);
       DCHECK(cohort);
       chunks->set_cohort_tag(cohort); // defined in hazptr_obj
       for (size_t i = 0; i < count; i++) {
@@ -1038,10 +1117,14 @@ class alignas(64) SIMDTable {
 
     Chunk* getChunk(size_t index, size_t ccount) {
       DCHECK(isPowTwo(ccount));
+      DCHECK_EQ(ccount, count_);
       return &chunks_[index & (ccount - 1)];
     }
 
+    size_t count() const { return count_; }
+
    private:
+    size_t const count_;
     Chunk chunks_[0];
   };
 
@@ -1164,10 +1247,7 @@ class alignas(64) SIMDTable {
       float load_factor,
       size_t max_size,
       hazptr_obj_cohort<Atom>* cohort)
-      : load_factor_(load_factor),
-        max_size_(max_size),
-        chunks_(nullptr),
-        chunk_count_(0) {
+      : load_factor_(load_factor), max_size_(max_size), chunks_(nullptr) {
     DCHECK(cohort);
     DCHECK(
         max_size_ == 0 ||
@@ -1184,7 +1264,7 @@ class alignas(64) SIMDTable {
     chunks_.store(nullptr, std::memory_order_release);
     // We can delete and not retire() here, since users must have
     // their own synchronization around destruction.
-    auto count = chunk_count_.load(std::memory_order_relaxed);
+    auto count = chunks->count();
     chunks->reclaim_nodes(count);
     chunks->destroy(count);
   }
@@ -1355,9 +1435,9 @@ class alignas(64) SIMDTable {
 
     std::unique_lock<Mutex> g(m_);
 
-    size_t ccount = chunk_count_.load(std::memory_order_relaxed);
     auto chunks = chunks_.load(std::memory_order_relaxed);
     DCHECK(chunks); // Use-after-destruction by user.
+    size_t ccount = chunks->count();
     size_t chunk_idx, tag_idx;
 
     Node* node = find_internal(key, hp, chunks, ccount, chunk_idx, tag_idx);
@@ -1410,13 +1490,13 @@ class alignas(64) SIMDTable {
     Chunks* chunks;
     {
       std::lock_guard<Mutex> g(m_);
-      ccount = chunk_count_.load(std::memory_order_relaxed);
-      auto newchunks = Chunks::create(ccount, cohort);
       chunks = chunks_.load(std::memory_order_relaxed);
+      DCHECK(chunks); // Use-after-destruction by user.
+      ccount = chunks->count();
+      auto newchunks = Chunks::create(ccount, cohort);
       chunks_.store(newchunks, std::memory_order_release);
       clearSize();
     }
-    DCHECK(chunks); // Use-after-destruction by user.
     chunks->reclaim_nodes(ccount);
     chunks->retire(HazptrTableDeleter(ccount));
   }
@@ -1428,7 +1508,7 @@ class alignas(64) SIMDTable {
     }
     std::lock_guard<Mutex> g(m_);
     load_factor_ = factor;
-    auto ccount = chunk_count_.load(std::memory_order_relaxed);
+    auto ccount = chunks_.load(std::memory_order_relaxed)->count();
     grow_threshold_ = ccount * Chunk::kCapacity * load_factor_;
   }
 
@@ -1446,9 +1526,25 @@ class alignas(64) SIMDTable {
 
  private:
   static HashPair splitHash(std::size_t hash) {
+    static_assert(sizeof(std::size_t) == sizeof(uint64_t), "");
+#if FOLLY_F14_CRC_INTRINSIC_AVAILABLE
+#if FOLLY_SSE_PREREQ(4, 2)
     std::size_t c = _mm_crc32_u64(0, hash);
+#else
+    std::size_t c = __crc32cd(0, hash);
+#endif
     size_t tag = (c >> 24) | 0x80;
     hash += c;
+#else
+    // Without a CRC instruction, use the murmur3 64-bit finalizer, which
+    // avalanches all bits into both the chunk index and the tag.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    size_t tag = (hash >> 56) | 0x80;
+#endif
     return std::make_pair(hash, tag);
   }
 
@@ -1499,8 +1595,9 @@ class alignas(64) SIMDTable {
       Chunks*& chunks,
       size_t& ccount,
       const HashPair& hp) {
-    ccount = chunk_count_.load(std::memory_order_relaxed);
     chunks = chunks_.load(std::memory_order_relaxed);
+    DCHECK(chunks); // Use-after-destruction by user.
+    ccount = chunks->count();
 
     if (size() >= grow_threshold_ && type == InsertType::DOES_NOT_EXIST) {
       if (max_size_ && size() << 1 > max_size_) {
@@ -1508,11 +1605,10 @@ class alignas(64) SIMDTable {
         throw_exception<std::bad_alloc>();
       }
       rehash_internal(ccount << 1, cohort);
-      ccount = chunk_count_.load(std::memory_order_relaxed);
       chunks = chunks_.load(std::memory_order_relaxed);
+      ccount = chunks->count();
     }
 
-    DCHECK(chunks); // Use-after-destruction by user.
     node = find_internal(k, hp, chunks, ccount, chunk_idx, tag_idx);
 
     it.hazptrs_[0].reset_protection(chunks);
@@ -1538,9 +1634,8 @@ class alignas(64) SIMDTable {
           throw_exception<std::bad_alloc>();
         }
         rehash_internal(ccount << 1, cohort);
-        ccount = chunk_count_.load(std::memory_order_relaxed);
         chunks = chunks_.load(std::memory_order_relaxed);
-        DCHECK(chunks); // Use-after-destruction by user.
+        ccount = chunks->count();
         it.hazptrs_[0].reset_protection(chunks);
       }
     }
@@ -1550,12 +1645,12 @@ class alignas(64) SIMDTable {
   void rehash_internal(
       size_t new_chunk_count, hazptr_obj_cohort<Atom>* cohort) {
     DCHECK(isPowTwo(new_chunk_count));
-    auto old_chunk_count = chunk_count_.load(std::memory_order_relaxed);
+    auto old_chunks = chunks_.load(std::memory_order_relaxed);
+    auto old_chunk_count = old_chunks ? old_chunks->count() : 0;
     if (old_chunk_count >= new_chunk_count) {
       return;
     }
     auto new_chunks = Chunks::create(new_chunk_count, cohort);
-    auto old_chunks = chunks_.load(std::memory_order_relaxed);
     grow_threshold_ =
         to_integral(new_chunk_count * Chunk::kCapacity * load_factor_);
 
@@ -1577,10 +1672,9 @@ class alignas(64) SIMDTable {
       }
     }
 
-    seqlock_.fetch_add(1, std::memory_order_release);
-    chunk_count_.store(new_chunk_count, std::memory_order_release);
+    // Readers keep probing the old chunks, which stay intact, until they
+    // observe the new ones.
     chunks_.store(new_chunks, std::memory_order_release);
-    seqlock_.fetch_add(1, std::memory_order_release);
     if (old_chunks) {
       old_chunks->retire(HazptrTableDeleter(old_chunk_count));
     }
@@ -1588,16 +1682,9 @@ class alignas(64) SIMDTable {
 
   void getChunksAndCount(
       size_t& ccount, Chunks*& chunks, hazptr_holder<Atom>& hazptr) {
-    while (true) {
-      auto seqlock = seqlock_.load(std::memory_order_acquire);
-      ccount = chunk_count_.load(std::memory_order_acquire);
-      chunks = hazptr.protect(chunks_);
-      auto seqlock2 = seqlock_.load(std::memory_order_acquire);
-      if (!(seqlock & 1) && (seqlock == seqlock2)) {
-        break;
-      }
-    }
+    chunks = hazptr.protect(chunks_);
     DCHECK(chunks);
+    ccount = chunks->count();
   }
 
   std::pair<size_t, size_t> findEmptyInsertLocation(
@@ -1628,12 +1715,10 @@ class alignas(64) SIMDTable {
 
   // Fields needed for read-only access, on separate cacheline.
   alignas(64) Atom<Chunks*> chunks_{nullptr};
-  std::atomic<uint64_t> seqlock_{0};
-  Atom<size_t> chunk_count_;
 };
 } // namespace simd
 
-#endif // FOLLY_SSE_PREREQ(4, 2) && FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
+#endif // FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
 
 } // namespace concurrenthashmap
 
@@ -325,6 +325,56 @@ TEST(CacheLocality, FakeSysfs) {
   EXPECT_EQ(expectedLocalityIndexByCpu, parsed.localityIndexByCpu);
 }
 
+static std::unordered_map<std::string, std::string> fakeNumaSysfsTree = {
+    {"/sys/devices/system/node/online", "0-2"},
+    {"/sys/devices/system/node/node0/cpulist", "0-3,8-11"},
+    // A memory-only node, which is skipped.
+    {"/sys/devices/system/node/node1/cpulist", ""},
+    {"/sys/devices/system/node/node2/cpulist", "4-7,12"}};
+
+TEST(NumaTopology, FakeSysfs) {
+  auto parsed = NumaTopology::readFromSysfsTree([](std::string const& name) {
+    auto iter = fakeNumaSysfsTree.find(name);
+    return iter == fakeNumaSysfsTree.end() ? std::string() : iter->second;
+  });
+
+  std::vector<std::vector<size_t>> expectedCpusByNode = {
+      {0, 1, 2, 3, 8, 9, 10, 11}, {4, 5, 6, 7, 12}};
+  std::vector<size_t> expectedNodeByCpu = {
+      0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1};
+
+  EXPECT_EQ(2, parsed.numNodes());
+  EXPECT_EQ(expectedCpusByNode, parsed.cpusByNode);
+  EXPECT_EQ(expectedNodeByCpu, parsed.nodeByCpu);
+}
+
+TEST(NumaTopology, FakeSysfsNoNodes) {
+  EXPECT_THROW(
+      NumaTopology::readFromSysfsTree([](std::string const&) { return ""; }),
+      std::runtime_error);
+}
+
+TEST(NumaTopology, FromCpusByNode) {
+  auto topology = NumaTopology::fromCpusByNode({{3, 1}, {0, 2}});
+  std::vector<std::vector<size_t>> expectedCpusByNode = {{1, 3}, {0, 2}};
+  std::vector<size_t> expectedNodeByCpu = {1, 0, 1, 0};
+  EXPECT_EQ(expectedCpusByNode, topology.cpusByNode);
+  EXPECT_EQ(expectedNodeByCpu, topology.nodeByCpu);
+
+  auto uniform = NumaTopology::uniform(4);
+  EXPECT_EQ(1, uniform.numNodes());
+  EXPECT_EQ(0, uniform.currentNode());
+}
+
+TEST(NumaTopology, System) {
+  auto const& topology = NumaTopology::system();
+  ASSERT_GE(topology.numNodes(), 1);
+  EXPECT_LT(topology.currentNode(), topology.numNodes());
+  for (auto const& cpus : topology.cpusByNode) {
+    EXPECT_FALSE(cpus.empty());
+  }
+}
+
 static const std::vector<std::string> fakeProcCpuinfo = {
     "processor	: 0",
     "vendor_id	: GenuineIntel",
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/ConcurrentEvictingCacheMap.h>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/test/Barrier.h>
+
+DEFINE_int64(cache_size, 100000, "maximum number of entries in the cache");
+DEFINE_int32(write_percent, 10, "percentage of operations that are sets");
+
+using namespace folly;
+
+namespace {
+
+// Keys follow a rough power law over 4x the cache size, so that there is a
+// mix of hits, misses and evictions.
+std::vector<uint64_t> makeKeys(size_t n, uint32_t seed) {
+  std::mt19937_64 rng(seed);
+  std::exponential_distribution<double> dist(1.0 / 8);
+  auto const range = uint64_t(FLAGS_cache_size) * 4;
+  std::vector<uint64_t> keys(n);
+  for (auto& key : keys) {
+    key = uint64_t(dist(rng) * double(range) / 32) % range;
+  }
+  return keys;
+}
+
+struct SynchronizedCache {
+  explicit SynchronizedCache(size_t maxSize) : cache(std::in_place, maxSize) {}
+
+  void set(uint64_t key, uint64_t value) { cache.wlock()->set(key, value); }
+
+  bool get(uint64_t key) {
+    // Promotion mutates the LRU, so a hit needs the exclusive lock.
+    auto locked = cache.wlock();
+    auto it = locked->find(key);
+    return it != locked->end();
+  }
+
+  Synchronized<EvictingCacheMap<uint64_t, uint64_t>> cache;
+};
+
+struct ShardedCache {
+  explicit ShardedCache(size_t maxSize) : cache(maxSize) {}
+
+  void set(uint64_t key, uint64_t value) { cache.set(key, value); }
+
+  bool get(uint64_t key) { return cache.tryGet(key).has_value(); }
+
+  ConcurrentEvictingCacheMap<uint64_t, uint64_t> cache;
+};
+
+template <typename Cache>
+void contention(size_t iters, size_t nthreads) {
+  BenchmarkSuspender braces;
+  Cache cache(FLAGS_cache_size);
+  for (auto key : makeKeys(FLAGS_cache_size, 0)) {
+    cache.set(key, key);
+  }
+  auto const perThread = std::max<size_t>(iters / nthreads, 1);
+  std::vector<std::vector<uint64_t>> keys;
+  for (size_t t = 0; t < nthreads; ++t) {
+    keys.push_back(makeKeys(perThread, uint32_t(t + 1)));
+  }
+
+  test::Barrier barrier(nthreads + 1);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < nthreads; ++t) {
+    threads.emplace_back([&, t] {
+      size_t hits = 0;
+      barrier.wait();
+      for (size_t i = 0; i < perThread; ++i) {
+        auto const key = keys[t][i];
+        if (int(i % 100) < FLAGS_write_percent) {
+          cache.set(key, i);
+        } else {
+          hits += cache.get(key);
+        }
+      }
+      doNotOptimizeAway(hits);
+    });
+  }
+  braces.dismissing([&] {
+    barrier.wait();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  });
+}
+
+void synchronizedCache(size_t iters, size_t nthreads) {
+  contention<SynchronizedCache>(iters, nthreads);
+}
+
+void shardedCache(size_t iters, size_t nthreads) {
+  contention<ShardedCache>(iters, nthreads);
+}
+
+} // namespace
+
+BENCHMARK_NAMED_PARAM(synchronizedCache, 1thread, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(shardedCache, 1thread, 1)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(synchronizedCache, 4threads, 4)
+BENCHMARK_RELATIVE_NAMED_PARAM(shardedCache, 4threads, 4)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(synchronizedCache, 16threads, 16)
+BENCHMARK_RELATIVE_NAMED_PARAM(shardedCache, 16threads, 16)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(synchronizedCache, 32threads, 32)
+BENCHMARK_RELATIVE_NAMED_PARAM(shardedCache, 32threads, 32)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(synchronizedCache, 64threads, 64)
+BENCHMARK_RELATIVE_NAMED_PARAM(shardedCache, 64threads, 64)
+
+int main(int argc, char** argv) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
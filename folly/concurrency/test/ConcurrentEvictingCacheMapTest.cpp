@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/ConcurrentEvictingCacheMap.h>
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+// A single shard makes the eviction order exactly LRU, which is what most of
+// these tests check.
+template <typename K, typename V>
+using SingleShardCache = ConcurrentEvictingCacheMap<
+    K,
+    V,
+    HeterogeneousAccessHash<K>,
+    HeterogeneousAccessEqualTo<K>,
+    0>;
+
+TEST(ConcurrentEvictingCacheMap, SanityTest) {
+  ConcurrentEvictingCacheMap<int, int> map(0);
+
+  EXPECT_EQ(0, map.size());
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.exists(1));
+  map.set(1, 1);
+  EXPECT_EQ(1, map.size());
+  EXPECT_FALSE(map.empty());
+  EXPECT_EQ(1, map.get(1));
+  EXPECT_TRUE(map.exists(1));
+  map.set(1, 2);
+  EXPECT_EQ(1, map.size());
+  EXPECT_EQ(2, map.get(1));
+  EXPECT_FALSE(map.insert(1, 3));
+  EXPECT_EQ(2, map.getWithoutPromotion(1));
+  EXPECT_TRUE(map.insert(2, 3));
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ(3, *map.tryGet(2));
+  EXPECT_FALSE(map.tryGet(3).has_value());
+  EXPECT_FALSE(map.tryGetWithoutPromotion(3).has_value());
+  EXPECT_THROW(map.get(3), std::out_of_range);
+  EXPECT_TRUE(map.erase(1));
+  EXPECT_FALSE(map.erase(1));
+  EXPECT_EQ(1, map.size());
+  EXPECT_FALSE(map.exists(1));
+  map.clear();
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(ConcurrentEvictingCacheMap, LruPromotionTest) {
+  SingleShardCache<int, int> map(3);
+  map.set(1, 1);
+  map.set(2, 2);
+  map.set(3, 3);
+
+  // The hit is buffered and applied by the next writer, before it evicts.
+  EXPECT_EQ(1, map.get(1));
+  map.set(4, 4);
+  EXPECT_TRUE(map.exists(1));
+  EXPECT_FALSE(map.exists(2));
+  EXPECT_TRUE(map.exists(3));
+  EXPECT_TRUE(map.exists(4));
+
+  EXPECT_EQ(3, map.getWithoutPromotion(3));
+  map.set(5, 5);
+  EXPECT_FALSE(map.exists(3));
+  EXPECT_TRUE(map.exists(1));
+}
+
+TEST(ConcurrentEvictingCacheMap, PromotionBufferOverflow) {
+  SingleShardCache<int, int> map(100);
+  for (int i = 0; i < 100; ++i) {
+    map.set(i, i);
+  }
+  // Overflow the promotion buffer several times; the reader that fills it
+  // drains it, so later hits are not lost.
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i, map.get(i));
+  }
+  map.set(100, 100);
+  EXPECT_EQ(100, map.size());
+  EXPECT_FALSE(map.exists(0));
+  EXPECT_TRUE(map.exists(99));
+  EXPECT_TRUE(map.exists(100));
+}
+
+TEST(ConcurrentEvictingCacheMap, PruneHookTest) {
+  SingleShardCache<int, int> map(2);
+  std::vector<int> pruned;
+  map.setPruneHook([&](int key, int&& value) {
+    EXPECT_EQ(key, value);
+    pruned.push_back(key);
+  });
+  map.set(1, 1);
+  map.set(2, 2);
+  map.set(3, 3);
+  EXPECT_EQ(std::vector<int>({1}), pruned);
+
+  std::vector<int> overridden;
+  map.set(4, 4, true, [&](int key, int&&) { overridden.push_back(key); });
+  EXPECT_EQ(std::vector<int>({1}), pruned);
+  EXPECT_EQ(std::vector<int>({2}), overridden);
+
+  // Erase does not invoke the prune hook.
+  std::vector<int> erased;
+  EXPECT_TRUE(map.erase(3, [&](int key, int&&) { erased.push_back(key); }));
+  EXPECT_EQ(std::vector<int>({1}), pruned);
+  EXPECT_EQ(std::vector<int>({3}), erased);
+
+  map.clear();
+  EXPECT_EQ(std::vector<int>({1, 4}), pruned);
+}
+
+TEST(ConcurrentEvictingCacheMap, PruneHookReentrant) {
+  SingleShardCache<int, int> map(1);
+  std::vector<int> survivors;
+  map.setPruneHook([&](int key, int&&) {
+    // Hooks run outside of the shard lock, so they may use the cache.
+    EXPECT_FALSE(map.exists(key));
+    survivors.push_back(map.get(2));
+  });
+  map.set(1, 1);
+  map.set(2, 2);
+  EXPECT_EQ(std::vector<int>({2}), survivors);
+}
+
+TEST(ConcurrentEvictingCacheMap, SetMaxSize) {
+  SingleShardCache<int, int> map(100, 20);
+  for (int i = 0; i < 90; ++i) {
+    map.set(i, i);
+  }
+  EXPECT_EQ(90, map.size());
+  map.setMaxSize(50);
+  EXPECT_EQ(50, map.size());
+  EXPECT_EQ(50, map.getMaxSize());
+  for (int i = 0; i < 90; ++i) {
+    map.set(i, i);
+  }
+  EXPECT_EQ(40, map.size());
+  map.setMaxSize(0);
+  for (int i = 0; i < 90; ++i) {
+    map.set(i, i);
+  }
+  EXPECT_EQ(90, map.size());
+  map.prune(20);
+  EXPECT_EQ(70, map.size());
+}
+
+TEST(ConcurrentEvictingCacheMap, ShardedSize) {
+  ConcurrentEvictingCacheMap<int, int> map(1000);
+  for (int i = 0; i < 10000; ++i) {
+    map.set(i, i);
+  }
+  // The bound is enforced per shard.
+  EXPECT_LE(map.size(), 1000 + map.NumShards);
+  EXPECT_TRUE(map.exists(9999));
+  map.prune(map.size());
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(ConcurrentEvictingCacheMap, HeterogeneousAccess) {
+  SingleShardCache<std::string, int> map(2);
+  std::string_view key = "hello";
+  map.set(key, 1);
+  EXPECT_TRUE(map.exists(key));
+  EXPECT_TRUE(map.exists("hello"));
+  EXPECT_EQ(1, map.get(key));
+  EXPECT_EQ(1, map.getWithoutPromotion(key));
+  EXPECT_FALSE(map.insert(key, 2));
+  EXPECT_TRUE(map.try_emplace(std::string_view("world"), 3));
+  EXPECT_EQ(3, *map.tryGet(std::string_view("world")));
+  EXPECT_TRUE(map.erase(key));
+  EXPECT_FALSE(map.exists(key));
+}
+
+TEST(ConcurrentEvictingCacheMap, ConcurrentAccess) {
+  constexpr int kThreads = 8;
+  constexpr int kOps = 20000;
+  constexpr int kKeys = 4000;
+  constexpr int kMaxSize = 1000;
+  ConcurrentEvictingCacheMap<
+      int,
+      int,
+      HeterogeneousAccessHash<int>,
+      HeterogeneousAccessEqualTo<int>,
+      2>
+      map(kMaxSize);
+  std::atomic<int> pruned{0};
+  map.setPruneHook([&](int key, int&& value) {
+    EXPECT_EQ(key, value);
+    ++pruned;
+  });
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kOps; ++i) {
+        int key = (i * 7919 + t * 104729) % kKeys;
+        switch (i % 8) {
+          case 0:
+            map.erase(key);
+            break;
+          case 1:
+          case 2:
+          case 3:
+            map.set(key, key);
+            break;
+          default:
+            if (auto v = map.tryGet(key)) {
+              EXPECT_EQ(key, *v);
+            }
+            break;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(map.size(), kMaxSize);
+  EXPECT_GT(pruned.load(), 0);
+}
@@ -103,10 +103,11 @@ uint64_t bench_ctor_dtor(
   return runBench(name, ops, repFn);
 }
 
+template <typename Map = folly::ConcurrentHashMap<int, int>>
 uint64_t bench_find(
     const int nthr, const bool sameItem, const std::string& name) {
   int ops = FLAGS_ops;
-  folly::ConcurrentHashMap<int, int> m;
+  Map m;
   for (int j = 0; j < FLAGS_size; ++j) {
     m.insert(j, j);
   }
@@ -221,6 +222,10 @@ void benches() {
     dottedLine();
     bench_find(nthr, false, "CHM find() -- 10M items         ");
     bench_find(nthr, true, "CHM find() -- 1 of 10M items    ");
+    bench_find<folly::ConcurrentHashMapSIMD<int, int>>(
+        nthr, false, "CHMSIMD find() -- 10M items     ");
+    bench_find<folly::ConcurrentHashMapSIMD<int, int>>(
+        nthr, true, "CHMSIMD find() -- 1 of 10M items");
     dottedLine();
     bench_begin(nthr, 0, "CHM begin() -- empty            ");
     bench_begin(nthr, 1, "CHM begin() -- 1 item           ");
@@ -1062,9 +1062,7 @@ TYPED_TEST_P(ConcurrentHashMapTest, EraseClonedNonCopyable) {
   // Using a non-copyable value type to use the node structure with an
   // extra level of indirection to key-value items.
   using Value = std::unique_ptr<int>;
-  // [TODO] Fix the SIMD version to pass this test, then change the
-  // map type to CHM.
-  ConcurrentHashMap<int, Value> map;
+  CHM<int, Value> map;
   int cloned = 32; // The item that will end up being cloned.
   for (int i = 0; i < cloned; i++) {
     map.try_emplace(256 * i, std::make_unique<int>(0));
@@ -1235,7 +1233,7 @@ REGISTER_TYPED_TEST_SUITE_P(
 
 using folly::detail::concurrenthashmap::bucket::BucketTable;
 
-#if FOLLY_SSE_PREREQ(4, 2) && FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
+#if FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
 using folly::detail::concurrenthashmap::simd::SIMDTable;
 typedef ::testing::Types<MapFactory<BucketTable>, MapFactory<SIMDTable>>
     MapFactoryTypes;
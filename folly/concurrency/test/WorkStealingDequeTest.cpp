@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/WorkStealingDeque.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+TEST(WorkStealingDequeTest, OwnerIsLifo) {
+  WorkStealingDeque<int> q;
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.pop().has_value());
+  for (int i = 0; i < 3; ++i) {
+    q.push(i);
+  }
+  EXPECT_EQ(3, q.size());
+  EXPECT_EQ(2, q.pop().value());
+  EXPECT_EQ(1, q.pop().value());
+  EXPECT_EQ(0, q.pop().value());
+  EXPECT_FALSE(q.pop().has_value());
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(WorkStealingDequeTest, ThiefIsFifo) {
+  WorkStealingDeque<int> q;
+  for (int i = 0; i < 3; ++i) {
+    q.push(i);
+  }
+  EXPECT_EQ(0, q.steal().value());
+  EXPECT_EQ(2, q.pop().value());
+  EXPECT_EQ(1, q.steal().value());
+  EXPECT_FALSE(q.steal().has_value());
+  EXPECT_FALSE(q.pop().has_value());
+}
+
+TEST(WorkStealingDequeTest, Growth) {
+  WorkStealingDeque<int> q(2);
+  // Wrap around before growing.
+  q.push(-1);
+  EXPECT_EQ(-1, q.steal().value());
+  for (int i = 0; i < 1000; ++i) {
+    q.push(i);
+  }
+  EXPECT_EQ(1000, q.size());
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(i, q.steal().value());
+  }
+  for (int i = 999; i >= 500; --i) {
+    EXPECT_EQ(i, q.pop().value());
+  }
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(WorkStealingDequeTest, ConcurrentThieves) {
+  constexpr int kItems = 100000;
+  constexpr int kThieves = 4;
+  WorkStealingDeque<int> q;
+  std::vector<std::atomic<int>> seen(kItems);
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> thieves;
+  for (int t = 0; t < kThieves; ++t) {
+    thieves.emplace_back([&] {
+      while (!done.load() || !q.empty()) {
+        if (auto item = q.steal()) {
+          seen[*item].fetch_add(1);
+        }
+      }
+    });
+  }
+  // The owner pushes in bursts and pops some items itself, so that it races
+  // with thieves for the last element.
+  for (int i = 0; i < kItems; ++i) {
+    q.push(i);
+    if (i % 3 == 0) {
+      if (auto item = q.pop()) {
+        seen[*item].fetch_add(1);
+      }
+    }
+  }
+  while (auto item = q.pop()) {
+    seen[*item].fetch_add(1);
+  }
+  done = true;
+  for (auto& thief : thieves) {
+    thief.join();
+  }
+  for (int i = 0; i < kItems; ++i) {
+    EXPECT_EQ(1, seen[i].load()) << i;
+  }
+}
@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/ConcurrentRegexMatchCache.h>
+
+#include <folly/portability/Windows.h>
+
+#include <algorithm>
+
+#include <boost/regex.hpp>
+
+#include <folly/ScopeGuard.h>
+
+namespace folly {
+
+class ConcurrentRegexMatchCache::RegexObject {
+ private:
+  boost::regex object;
+
+ public:
+  explicit RegexObject(std::string_view const regex)
+      : object{std::string(regex)} {}
+
+  bool operator()(std::string const& string) const {
+    return boost::regex_match(string, object);
+  }
+};
+
+namespace {
+
+// Evaluates a regex over strings, accounting the cost to the regex. A string
+// for which evaluation throws, as for a pathological regex, does not match.
+template <typename Object, typename Stats>
+std::vector<std::string const*> evaluate(
+    Object const& object,
+    Stats& stats,
+    std::string const* const* strings,
+    size_t const count) {
+  std::vector<std::string const*> matches;
+  uint64_t errors = 0;
+  auto const start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    try {
+      if (object(*strings[i])) {
+        matches.push_back(strings[i]);
+      }
+    } catch (...) {
+      ++errors;
+    }
+  }
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+  stats.evaluations += count;
+  stats.matches += matches.size();
+  stats.errors += errors;
+  stats.nanos +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  return matches;
+}
+
+} // namespace
+
+ConcurrentRegexMatchCache::ConcurrentRegexMatchCache(
+    Executor::KeepAlive<> executor, size_t const batchSize)
+    : executor_{std::move(executor)},
+      batchSize_{std::max(batchSize, size_t(1))},
+      snapshot_{new Snapshot()} {}
+
+ConcurrentRegexMatchCache::~ConcurrentRegexMatchCache() {
+  waitUntilIdle();
+  delete snapshot_.load(std::memory_order_relaxed);
+}
+
+void ConcurrentRegexMatchCache::addRegex(std::string_view const regex) {
+  regex_key const key{regex};
+  //  compile outside the lock, and throw before any change if invalid
+  auto object = std::make_shared<RegexObject const>(regex);
+  auto stats = std::make_shared<Stats>(regex);
+  {
+    std::unique_lock lock{mutex_};
+    auto const [iter, inserted] = regexes_.try_emplace(key);
+    if (!inserted) {
+      return;
+    }
+    auto rollback = makeGuard([&, iter_ = iter] { regexes_.erase(iter_); });
+    iter->second.object = std::move(object);
+    iter->second.stats = std::move(stats);
+    regexQueue_.push_back(key);
+    rollback.dismiss();
+    publishLocked();
+    if (std::exchange(scheduled_, true)) {
+      return;
+    }
+  }
+  schedule();
+}
+
+void ConcurrentRegexMatchCache::eraseRegex(regex_key const& regex) {
+  std::unique_lock lock{mutex_};
+  if (regexes_.erase(regex)) {
+    publishLocked();
+  }
+}
+
+void ConcurrentRegexMatchCache::addString(string_pointer const string) {
+  {
+    std::unique_lock lock{mutex_};
+    if (strings_.contains(string) || inflight_.contains(string) ||
+        !queued_.insert(string).second) {
+      return;
+    }
+    auto rollback = makeGuard([&] { queued_.erase(string); });
+    stringQueue_.push_back(string);
+    rollback.dismiss();
+    pendingStrings_.fetch_add(1, std::memory_order_release);
+    if (std::exchange(scheduled_, true)) {
+      return;
+    }
+  }
+  schedule();
+}
+
+void ConcurrentRegexMatchCache::eraseString(string_pointer const string) {
+  std::unique_lock lock{mutex_};
+  if (queued_.erase(string) || inflight_.erase(string)) {
+    //  never published as a match
+    pendingStrings_.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+  if (!strings_.erase(string)) {
+    return;
+  }
+  bool changed = false;
+  for (auto& [regex, state] : regexes_) {
+    if (state.matches.erase(string)) {
+      state.published = nullptr;
+      changed = true;
+    }
+  }
+  if (changed) {
+    publishLocked();
+  }
+}
+
+bool ConcurrentRegexMatchCache::isReadyToFindMatches(
+    regex_key const& regex) const {
+  //  the batch is published before it stops being pending, so load pending
+  //  first to never see an old snapshot together with no pending strings
+  auto const pending = pendingStrings_.load(std::memory_order_acquire);
+  hazptr_local<1> h;
+  auto const snapshot = h[0].protect(snapshot_);
+  auto const iter = snapshot->regexes.find(regex);
+  return iter != snapshot->regexes.end() && iter->second->evaluated &&
+      pending == 0;
+}
+
+ConcurrentRegexMatchCache::Matches ConcurrentRegexMatchCache::findMatches(
+    regex_key const& regex) const {
+  Matches result;
+  result.holder_ = make_hazard_pointer();
+  auto const snapshot = result.holder_.protect(snapshot_);
+  auto const iter = snapshot->regexes.find(regex);
+  if (iter == snapshot->regexes.end() || !iter->second->evaluated) {
+    return Matches();
+  }
+  auto const& published = *iter->second;
+  auto const shard = AccessSpreader<>::cachedCurrent(Stats::kLookupShards);
+  published.stats->lookups[shard].count += 1;
+  //  the protected snapshot owns the published state, which owns the list
+  result.matches_ = range(published.matches);
+  result.found_ = true;
+  return result;
+}
+
+std::vector<ConcurrentRegexMatchCache::RegexStats>
+ConcurrentRegexMatchCache::getRegexStats() const {
+  std::vector<RegexStats> result;
+  {
+    hazptr_local<1> h;
+    auto const snapshot = h[0].protect(snapshot_);
+    result.reserve(snapshot->regexes.size());
+    for (auto const& [regex, published] : snapshot->regexes) {
+      auto const& stats = *published->stats;
+      auto& out = result.emplace_back();
+      out.regex = stats.regex;
+      for (auto const& shard : stats.lookups) {
+        out.lookups += shard.count;
+      }
+      out.evaluations = stats.evaluations;
+      out.matches = stats.matches;
+      out.errors = stats.errors;
+      out.elapsed = std::chrono::nanoseconds(stats.nanos);
+    }
+  }
+  std::sort(result.begin(), result.end(), [](auto const& a, auto const& b) {
+    return a.elapsed > b.elapsed;
+  });
+  return result;
+}
+
+void ConcurrentRegexMatchCache::waitUntilIdle() {
+  std::unique_lock lock{mutex_};
+  idle_.wait(lock, [&] { return !scheduled_; });
+}
+
+void ConcurrentRegexMatchCache::schedule() {
+  //  scheduled_ is set, so only this thread schedules the task
+  auto guard = makeGuard([&] {
+    std::unique_lock lock{mutex_};
+    scheduled_ = false;
+    idle_.notify_all();
+  });
+  executor_->add([this] { drain(); });
+  guard.dismiss();
+}
+
+void ConcurrentRegexMatchCache::drain() noexcept {
+  std::unique_lock lock{mutex_};
+  //  regexes first, so that a batch of strings is evaluated against all
+  //  regexes added before it
+  while (evaluateNextRegex(lock) || evaluateNextStrings(lock)) {
+  }
+  scheduled_ = false;
+  idle_.notify_all();
+}
+
+bool ConcurrentRegexMatchCache::evaluateNextRegex(
+    std::unique_lock<std::mutex>& lock) {
+  RegexState* state = nullptr;
+  while (!state && !regexQueue_.empty()) {
+    auto const iter = regexes_.find(regexQueue_.back());
+    state = iter == regexes_.end() || iter->second.evaluated ? nullptr
+                                                             : &iter->second;
+    if (!state) {
+      regexQueue_.pop_back();
+    }
+  }
+  if (!state) {
+    return false;
+  }
+  regex_key const key = regexQueue_.back();
+  regexQueue_.pop_back();
+  auto const object = state->object;
+  auto const stats = state->stats;
+  std::vector<string_pointer> const strings(strings_.begin(), strings_.end());
+
+  //  strings_ is only changed by this task or by erasure, so every string
+  //  still in it when relocking was evaluated
+  lock.unlock();
+  auto const matches =
+      evaluate(*object, *stats, strings.data(), strings.size());
+  lock.lock();
+
+  auto const iter = regexes_.find(key);
+  if (iter == regexes_.end() || iter->second.object != object) {
+    return true; // erased, and maybe added again, while evaluating
+  }
+  auto& current = iter->second;
+  for (auto const string : matches) {
+    if (strings_.contains(string)) {
+      current.matches.insert(string);
+    }
+  }
+  current.evaluated = true;
+  current.published = nullptr;
+  publishLocked();
+  return true;
+}
+
+bool ConcurrentRegexMatchCache::evaluateNextStrings(
+    std::unique_lock<std::mutex>& lock) {
+  std::vector<string_pointer> batch;
+  while (batch.size() < batchSize_ && !stringQueue_.empty()) {
+    auto const string = stringQueue_.front();
+    stringQueue_.pop_front();
+    if (queued_.erase(string)) {
+      batch.push_back(string);
+      inflight_.insert(string);
+    }
+  }
+  if (batch.empty()) {
+    return false;
+  }
+  struct Evaluation {
+    regex_key key;
+    std::shared_ptr<RegexObject const> object;
+    std::shared_ptr<Stats> stats;
+    std::vector<string_pointer> matches;
+  };
+  std::vector<Evaluation> evaluations;
+  evaluations.reserve(regexes_.size());
+  for (auto const& [regex, state] : regexes_) {
+    //  unevaluated regexes see these strings when they are evaluated
+    if (state.evaluated) {
+      evaluations.push_back({regex, state.object, state.stats, {}});
+    }
+  }
+
+  lock.unlock();
+  for (auto& evaluation : evaluations) {
+    evaluation.matches = evaluate(
+        *evaluation.object, *evaluation.stats, batch.data(), batch.size());
+  }
+  lock.lock();
+
+  for (auto& evaluation : evaluations) {
+    auto const iter = regexes_.find(evaluation.key);
+    if (iter == regexes_.end() || iter->second.object != evaluation.object) {
+      continue;
+    }
+    auto& state = iter->second;
+    for (auto const string : evaluation.matches) {
+      if (inflight_.contains(string)) {
+        state.matches.insert(string);
+        state.published = nullptr;
+      }
+    }
+  }
+  size_t evaluated = 0;
+  for (auto const string : batch) {
+    if (inflight_.erase(string)) {
+      strings_.insert(string);
+      ++evaluated;
+    }
+  }
+  publishLocked();
+  pendingStrings_.fetch_sub(evaluated, std::memory_order_release);
+  return true;
+}
+
+//  Rebuilds the map of the snapshot, which is linear in the number of
+//  regexes, but shares the published state of every regex that did not change.
+void ConcurrentRegexMatchCache::publishLocked() {
+  auto next = std::make_unique<Snapshot>();
+  next->regexes.reserve(regexes_.size());
+  for (auto& [regex, state] : regexes_) {
+    if (!state.published) {
+      auto published = std::make_shared<Published>();
+      published->matches.assign(state.matches.begin(), state.matches.end());
+      published->evaluated = state.evaluated;
+      published->stats = state.stats;
+      state.published = std::move(published);
+    }
+    next->regexes.emplace(regex, state.published);
+  }
+  auto const prev =
+      snapshot_.exchange(next.release(), std::memory_order_acq_rel);
+  prev->retire();
+}
+
+} // namespace folly
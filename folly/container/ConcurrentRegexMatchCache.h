@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <folly/Executor.h>
+#include <folly/Range.h>
+#include <folly/concurrency/CacheLocality.h>
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
+#include <folly/container/RegexMatchCache.h>
+#include <folly/lang/Align.h>
+#include <folly/synchronization/Hazptr.h>
+#include <folly/synchronization/RelaxedAtomic.h>
+
+namespace folly {
+
+/// ConcurrentRegexMatchCache
+///
+/// A variant of RegexMatchCache for concurrent use, where lookups must not
+/// wait for writers or for regex-match operations.
+///
+/// As with RegexMatchCache, the data structure owns regexes but does not own
+/// strings, and the caller must keep strings alive until they are erased.
+///
+/// Lookups are lock-free. They read an immutable snapshot of the cache,
+/// protected by a hazard pointer, which writers replace when the cache
+/// changes. A lookup may therefore observe a state that lags behind writes
+/// made concurrently by other threads; isReadyToFindMatches tells whether the
+/// snapshot is complete with respect to all strings added so far.
+///
+/// Writes are serialized by a mutex, but never perform regex-match
+/// operations themselves, except to check that an added regex is valid.
+/// Added strings and regexes are queued, and matched in batches by a task
+/// on the given executor. At most one such task is in flight per cache, so
+/// the executor is not flooded by a burst of additions.
+///
+/// Every write that changes what lookups see publishes a new snapshot, which
+/// costs a map of all regexes, plus a new match list for each regex whose
+/// matches changed. Matching publishes once per batch of strings, but each
+/// addRegex, eraseRegex and eraseString publishes on its own, so bursts of
+/// these are linear in the number of regexes each.
+///
+/// For each regex, statistics are kept of the number of lookups and of the
+/// cost of matching it, to find the patterns that dominate matching time.
+/// The lookup counter is sharded over cache lines so that lookups of a
+/// popular regex do not contend on it.
+class ConcurrentRegexMatchCache {
+ public:
+  using regex_key = RegexMatchCacheKey;
+  using string_pointer = std::string const*;
+
+  struct RegexStats {
+    std::string regex;
+    /// Lookups by findMatches.
+    uint64_t lookups{};
+    /// Strings the regex was evaluated over, and of those, strings it
+    /// matched and strings for which evaluation threw.
+    uint64_t evaluations{};
+    uint64_t matches{};
+    uint64_t errors{};
+    /// Total time spent evaluating the regex.
+    std::chrono::nanoseconds elapsed{};
+  };
+
+  /// The strings matching a regex, viewed in place in a snapshot of the
+  /// cache. The handle holds a hazard pointer to the snapshot, so the view
+  /// stays valid as long as the handle is alive, and no reference count is
+  /// shared with other lookups. A held handle keeps the snapshot from being
+  /// reclaimed, so it should not be held for long, and must not outlive the
+  /// cache. Empty if the regex has not yet been added and evaluated.
+  class Matches {
+   public:
+    Matches() = default;
+
+    Matches(Matches&& that) noexcept
+        : holder_{std::move(that.holder_)},
+          matches_{std::exchange(that.matches_, {})},
+          found_{std::exchange(that.found_, false)} {}
+
+    Matches& operator=(Matches&& that) noexcept {
+      if (this != &that) {
+        holder_ = std::move(that.holder_);
+        matches_ = std::exchange(that.matches_, {});
+        found_ = std::exchange(that.found_, false);
+      }
+      return *this;
+    }
+
+    explicit operator bool() const noexcept { return found_; }
+
+    Range<string_pointer const*> const& operator*() const noexcept {
+      return matches_;
+    }
+    Range<string_pointer const*> const* operator->() const noexcept {
+      return &matches_;
+    }
+
+   private:
+    friend class ConcurrentRegexMatchCache;
+
+    hazptr_holder<> holder_;
+    Range<string_pointer const*> matches_;
+    bool found_{false};
+  };
+
+  explicit ConcurrentRegexMatchCache(
+      Executor::KeepAlive<> executor, size_t batchSize = 1024);
+
+  /// Waits for the in-flight batch, if any.
+  ~ConcurrentRegexMatchCache();
+
+  ConcurrentRegexMatchCache(ConcurrentRegexMatchCache const&) = delete;
+  ConcurrentRegexMatchCache& operator=(ConcurrentRegexMatchCache const&) =
+      delete;
+
+  /// Adds a regex, to be evaluated over all strings in the background.
+  /// Throws if the regex is invalid.
+  void addRegex(std::string_view regex);
+  void eraseRegex(regex_key const& regex);
+
+  /// Adds a string, to be evaluated against all regexes in the background.
+  void addString(string_pointer string);
+  void eraseString(string_pointer string);
+
+  /// Lock-free. Whether the regex has been added and evaluated over all
+  /// strings added so far.
+  bool isReadyToFindMatches(regex_key const& regex) const;
+
+  /// Lock-free. The strings matching the regex, or an empty handle if the
+  /// regex has not yet been added and evaluated. If strings are pending
+  /// evaluation, which isReadyToFindMatches tells, some of their matches may
+  /// be missing.
+  Matches findMatches(regex_key const& regex) const;
+
+  /// Lock-free. Statistics of all regexes, most expensive first.
+  std::vector<RegexStats> getRegexStats() const;
+
+  /// Blocks until all strings and regexes added so far are evaluated.
+  void waitUntilIdle();
+
+ private:
+  class RegexObject;
+
+  struct Stats {
+    static constexpr size_t kLookupShards = 8;
+
+    struct alignas(hardware_destructive_interference_size) LookupShard {
+      relaxed_atomic<uint64_t> count{0};
+    };
+
+    explicit Stats(std::string_view r) : regex{r} {}
+
+    std::string const regex;
+    std::array<LookupShard, kLookupShards> lookups;
+    relaxed_atomic<uint64_t> evaluations{0};
+    relaxed_atomic<uint64_t> matches{0};
+    relaxed_atomic<uint64_t> errors{0};
+    relaxed_atomic<uint64_t> nanos{0};
+  };
+
+  /// The state of one regex as seen by lookups. Immutable, and shared by
+  /// successive snapshots until the regex changes.
+  struct Published {
+    std::vector<string_pointer> matches;
+    bool evaluated{};
+    std::shared_ptr<Stats> stats;
+  };
+
+  struct Snapshot : hazptr_obj_base<Snapshot> {
+    F14FastMap<regex_key, std::shared_ptr<Published const>> regexes;
+  };
+
+  struct RegexState {
+    std::shared_ptr<RegexObject const> object;
+    std::shared_ptr<Stats> stats;
+    F14FastSet<string_pointer> matches;
+    bool evaluated{false};
+    /// Null when the state changed since it was last published.
+    std::shared_ptr<Published const> published;
+  };
+
+  void schedule();
+  void drain() noexcept;
+  bool evaluateNextRegex(std::unique_lock<std::mutex>& lock);
+  bool evaluateNextStrings(std::unique_lock<std::mutex>& lock);
+  void publishLocked();
+
+  Executor::KeepAlive<> const executor_;
+  size_t const batchSize_;
+
+  std::atomic<Snapshot*> snapshot_;
+  /// Strings added but not yet evaluated, including the in-flight batch.
+  std::atomic<size_t> pendingStrings_{0};
+
+  std::mutex mutex_;
+  std::condition_variable idle_;
+  bool scheduled_{false};
+  F14NodeMap<regex_key, RegexState> regexes_;
+  /// Regexes added but not yet evaluated, possibly erased since.
+  std::vector<regex_key> regexQueue_;
+  /// Strings evaluated against all evaluated regexes.
+  F14FastSet<string_pointer> strings_;
+  /// Strings added but not yet evaluated. The queue may hold strings erased
+  /// since, which are no longer in the set.
+  std::deque<string_pointer> stringQueue_;
+  F14FastSet<string_pointer> queued_;
+  /// Strings of the in-flight batch. Erasure removes them from here.
+  F14FastSet<string_pointer> inflight_;
+};
+
+} // namespace folly
@@ -23,6 +23,8 @@
 #include <boost/intrusive/list.hpp>
 #include <boost/iterator/iterator_adaptor.hpp>
 
+#include <folly/CppAttributes.h>
+#include <folly/container/EvictingCachePolicy.h>
 #include <folly/container/F14Set.h>
 #include <folly/container/HeterogeneousAccess.h>
 #include <folly/lang/Exception.h>
@@ -57,12 +59,21 @@ namespace folly {
  *
  * NOTE: Previous versions of this structure used a hash table size that was
  * fixed at creation time, but that limitation is no longer present.
+ *
+ * The eviction policy is LRU by default. TPolicy can select a policy with an
+ * admission filter, such as TinyLfuEvictingCachePolicy, that protects
+ * frequently used entries from being flushed by scans (see
+ * EvictingCachePolicy.h). With such a policy, the list is split into a small
+ * window of recently inserted entries followed by the main LRU segment, and
+ * hits on main entries promote them to the head of the main segment rather
+ * than to the head of the whole list.
  */
 template <
     class TKey,
     class TValue,
     class THash = HeterogeneousAccessHash<TKey>,
-    class TKeyEqual = HeterogeneousAccessEqualTo<TKey>>
+    class TKeyEqual = HeterogeneousAccessEqualTo<TKey>,
+    class TPolicy = LruEvictingCachePolicy>
 class EvictingCacheMap {
  private:
   // typedefs for brevity
@@ -73,6 +84,8 @@ class EvictingCacheMap {
   using NodeMap = F14VectorSet<Node*, KeyHasher, KeyValueEqual>;
   using TPair = std::pair<const TKey, TValue>;
 
+  static constexpr bool kAdmission = TPolicy::kAdmission;
+
  public:
   using PruneHookCall = std::function<void(TKey, TValue&&)>;
 
@@ -116,6 +129,7 @@ class EvictingCacheMap {
   using key_type = TKey;
   using mapped_type = TValue;
   using hasher = THash;
+  using policy_type = TPolicy;
 
   /*
    * Approximate size of memory used by each entry added to the cache,
@@ -158,17 +172,24 @@ class EvictingCacheMap {
    *     maxSize, the map will begin to evict.
    * @param clearSize the number of elements to clear at a time when automatic
    *     eviction on insert is triggered.
+   * @param policy eviction policy state, see EvictingCachePolicy.h
    */
   explicit EvictingCacheMap(
       std::size_t maxSize,
       std::size_t clearSize = 1,
       const THash& keyHash = THash(),
-      const TKeyEqual& keyEqual = TKeyEqual())
+      const TKeyEqual& keyEqual = TKeyEqual(),
+      const TPolicy& policy = TPolicy())
       : keyHash_(keyHash),
         keyEqual_(keyEqual),
         index_(maxSize + /*transient*/ 1, keyHash_, keyEqual_),
         maxSize_(maxSize),
-        clearSize_(clearSize) {}
+        clearSize_(clearSize),
+        policy_(policy) {
+    if constexpr (kAdmission) {
+      reservePolicy(maxSize);
+    }
+  }
 
   EvictingCacheMap(const EvictingCacheMap&) = delete;
   EvictingCacheMap& operator=(const EvictingCacheMap&) = delete;
@@ -193,6 +214,9 @@ class EvictingCacheMap {
       prune(std::max(size() - maxSize, clearSize_), pruneHook);
     }
     maxSize_ = maxSize;
+    if constexpr (kAdmission) {
+      reservePolicy(maxSize);
+    }
   }
 
   std::size_t getMaxSize() const { return maxSize_; }
@@ -464,26 +488,32 @@ class EvictingCacheMap {
 
   PruneHookCall getPruneHook() { return pruneHook_; }
 
+  const TPolicy& getPolicy() const { return policy_; }
+
   /**
    * Prune the minimum of pruneSize and size() from the back of the LRU.
+   * With an admission policy, a pending admission candidate may be pruned
+   * instead of the back of the LRU, as decided by the policy.
    * Will throw if pruneHook throws.
    * @param pruneSize minimum number of elements to prune
    * @param pruneHook eviction callback to use INSTEAD OF the configured one
    */
   void prune(std::size_t pruneSize, PruneHookCall pruneHook = nullptr) {
-    auto& ph = (nullptr == pruneHook) ? pruneHook_ : pruneHook;
-
-    for (std::size_t i = 0; i < pruneSize && !lru_.empty(); i++) {
-      auto* node = &(*lru_.rbegin());
-      std::unique_ptr<Node> node_owner(node);
+    pruneImpl(pruneSize, nullptr, pruneHook);
+  }
 
-      lru_.erase(lru_.iterator_to(*node));
-      index_.erase(node);
-      if (ph) {
-        // NOTE: might throw, so we are in an exception-safe state
-        ph(node->pr.first, std::move(node->pr.second));
-      }
-    }
+  /**
+   * Like prune(), but never prunes the entry at pos, which must be an entry
+   * of this map. Stops early when it is the only entry left.
+   * @param pruneSize minimum number of elements to prune
+   * @param pos entry to keep
+   * @param pruneHook eviction callback to use INSTEAD OF the configured one
+   */
+  void pruneExcept(
+      std::size_t pruneSize,
+      const_iterator pos,
+      PruneHookCall pruneHook = nullptr) {
+    pruneImpl(pruneSize, &*pos.base(), pruneHook);
   }
 
   // Iterators and such
@@ -513,9 +543,19 @@ class EvictingCacheMap {
   }
 
  private:
+  // Segment membership, only tracked with an admission policy.
+  struct NodeWindowState {
+    bool inWindow{false};
+  };
+  struct NodeNoWindowState {};
+
   struct Node
       : public boost::intrusive::list_base_hook<
-            boost::intrusive::link_mode<boost::intrusive::safe_link>> {
+            boost::intrusive::link_mode<boost::intrusive::safe_link>>,
+        public std::conditional_t<
+            kAdmission,
+            NodeWindowState,
+            NodeNoWindowState> {
     template <typename K>
     Node(const K& key, TValue&& value) : pr(key, std::move(value)) {}
 
@@ -611,11 +651,11 @@ class EvictingCacheMap {
 
   template <typename Self, typename K>
   static auto findImpl(Self& self, const K& key) {
-    Node* ptr = self.findInIndex(key);
+    Node* ptr = self.findAndRecordAccess(key);
     if (!ptr) {
       return self.end();
     }
-    self.lru_.splice(self.lru_.begin(), self.lru_, self.lru_.iterator_to(*ptr));
+    self.promote(ptr);
     return self_iterator_t<Self>(self.lru_.iterator_to(*ptr));
   }
 
@@ -641,6 +681,7 @@ class EvictingCacheMap {
       typename NodeList::const_iterator base_iter,
       PruneHookCall eraseHook) {
     std::unique_ptr<Node> node_owner(ptr);
+    unlinkFromWindow(ptr);
     index_.erase(ptr);
     auto next_base_iter = lru_.erase(base_iter);
     if (eraseHook) {
@@ -663,16 +704,16 @@ class EvictingCacheMap {
   template <typename K>
   void setImpl(
       const K& key, TValue&& value, bool promote, PruneHookCall pruneHook) {
-    Node* ptr = findInIndex(key);
+    Node* ptr = findAndRecordAccess(key);
     if (ptr) {
       ptr->pr.second = std::move(value);
       if (promote) {
-        lru_.splice(lru_.begin(), lru_, lru_.iterator_to(*ptr));
+        this->promote(ptr);
       }
     } else {
       auto node = new Node(key, std::move(value));
       index_.insert(node);
-      lru_.push_front(*node);
+      pushFront(node);
 
       // no evictions if maxSize_ is 0 i.e. unlimited capacity
       if (maxSize_ > 0 && size() > maxSize_) {
@@ -702,7 +743,7 @@ class EvictingCacheMap {
     }
 
     // Complete insertion
-    lru_.push_front(*nodeOwner.release());
+    pushFront(nodeOwner.release());
 
     // no evictions if maxSize_ is 0 i.e. unlimited capacity
     if (maxSize_ > 0 && size() > maxSize_) {
@@ -722,6 +763,160 @@ class EvictingCacheMap {
     }
   }
 
+  // Like findInIndex, but also counts a hit for the policy, hashing the key
+  // only once. Misses are counted by pushFront() if the key gets inserted, so
+  // that a lookup followed by an insertion counts once.
+  template <typename K>
+  Node* findAndRecordAccess(const K& key) {
+    if constexpr (kAdmission) {
+      auto const hash = keyHash_.hash(key);
+      auto it = index_.find(index_.prehash(key, hash), key);
+      if (it == index_.end()) {
+        return nullptr;
+      }
+      policy_.recordAccess(hash);
+      return *it;
+    } else {
+      return findInIndex(key);
+    }
+  }
+
+  // Moves a node to the head of the LRU, or to the head of its segment with
+  // an admission policy.
+  void promote(Node* node) {
+    if constexpr (kAdmission) {
+      if (node->inWindow) {
+        if (node == window_.tail && window_.size > 1) {
+          window_.tail = &*std::prev(lru_.iterator_to(*node));
+        }
+        lru_.splice(lru_.begin(), lru_, lru_.iterator_to(*node));
+      } else {
+        auto pos = window_.tail ? std::next(lru_.iterator_to(*window_.tail))
+                                : lru_.begin();
+        if (&*pos != node) {
+          lru_.splice(pos, lru_, lru_.iterator_to(*node));
+        }
+      }
+    } else {
+      lru_.splice(lru_.begin(), lru_, lru_.iterator_to(*node));
+    }
+  }
+
+  // Links a new node at the head of the LRU. With an admission policy, the
+  // node enters the window, and the entry overflowing the window becomes the
+  // admission candidate for the next eviction.
+  void pushFront(Node* node) {
+    lru_.push_front(*node);
+    if constexpr (kAdmission) {
+      auto const capacity = maxSize_ > 0 ? maxSize_ : lru_.size();
+      if (capacity > window_.capacity) {
+        // Without a max size (as in the weighted maps), grow geometrically
+        // so that the policy is only resized O(log n) times.
+        reservePolicy(std::max(capacity, 2 * window_.capacity));
+      }
+      policy_.recordAccess(keyHash_.hash(node->pr.first));
+      node->inWindow = true;
+      if (window_.size++ == 0) {
+        window_.tail = node;
+      }
+      auto const windowMax = policy_.windowSize(capacity);
+      while (window_.size > windowMax) {
+        Node* candidate = window_.tail;
+        unlinkFromWindow(candidate);
+        window_.candidate = candidate;
+      }
+    }
+  }
+
+  // Sizes the policy for a cache of `capacity` entries.
+  void reservePolicy(std::size_t capacity) {
+    window_.capacity = capacity;
+    policy_.reserve(capacity);
+  }
+
+  // Window bookkeeping for a node about to leave the window or the cache.
+  void unlinkFromWindow(Node* node) {
+    if constexpr (kAdmission) {
+      if (node == window_.candidate) {
+        window_.candidate = nullptr;
+      }
+      if (node->inWindow) {
+        node->inWindow = false;
+        if (node == window_.tail) {
+          window_.tail = window_.size > 1
+              ? &*std::prev(lru_.iterator_to(*node))
+              : nullptr;
+        }
+        --window_.size;
+      }
+    }
+  }
+
+  void pruneImpl(
+      std::size_t pruneSize, const Node* keep, PruneHookCall& pruneHook) {
+    auto& ph = (nullptr == pruneHook) ? pruneHook_ : pruneHook;
+    std::size_t const minSize = keep ? 1 : 0;
+
+    for (std::size_t i = 0; i < pruneSize && lru_.size() > minSize; i++) {
+      auto* node = selectVictim(keep);
+      std::unique_ptr<Node> node_owner(node);
+
+      unlinkFromWindow(node);
+      lru_.erase(lru_.iterator_to(*node));
+      index_.erase(node);
+      if (ph) {
+        // NOTE: might throw, so we are in an exception-safe state
+        ph(node->pr.first, std::move(node->pr.second));
+      }
+    }
+  }
+
+  // Picks the next entry to evict: the back of the LRU, unless the policy
+  // prefers to reject the pending admission candidate. Never picks keep,
+  // which must not be the only entry.
+  Node* selectVictim(const Node* keep = nullptr) {
+    Node* victim = &lru_.back();
+    if (victim == keep) {
+      victim = &*std::prev(lru_.iterator_to(*victim));
+    }
+    if constexpr (kAdmission) {
+      Node* candidate = window_.candidate;
+      if (candidate && candidate != keep && candidate != victim &&
+          !victim->inWindow) {
+        // The candidate is decided either way: admitted to the main segment,
+        // or evicted.
+        window_.candidate = nullptr;
+        if (!policy_.admit(
+                keyHash_.hash(candidate->pr.first),
+                keyHash_.hash(victim->pr.first))) {
+          return candidate;
+        }
+      }
+    }
+    return victim;
+  }
+
+  // Window segment state, only used with an admission policy. Moves leave
+  // the source empty, matching NodeList.
+  struct WindowState {
+    WindowState() = default;
+    WindowState(WindowState&& that) noexcept { *this = std::move(that); }
+    WindowState& operator=(WindowState&& that) noexcept {
+      tail = std::exchange(that.tail, nullptr);
+      candidate = std::exchange(that.candidate, nullptr);
+      size = std::exchange(that.size, 0);
+      capacity = std::exchange(that.capacity, 0);
+      return *this;
+    }
+
+    Node* tail{nullptr};
+    Node* candidate{nullptr};
+    std::size_t size{0};
+    // The capacity the policy was last sized for.
+    std::size_t capacity{0};
+  };
+  struct NoWindowState {};
+
   PruneHookCall pruneHook_;
   KeyHasher keyHash_;
   KeyValueEqual keyEqual_;
@@ -729,6 +924,9 @@ class EvictingCacheMap {
   NodeList lru_;
   std::size_t maxSize_;
   std::size_t clearSize_;
+  [[FOLLY_ATTR_NO_UNIQUE_ADDRESS]] TPolicy policy_;
+  [[FOLLY_ATTR_NO_UNIQUE_ADDRESS]]
+  std::conditional_t<kAdmission, WindowState, NoWindowState> window_;
 };
 
 } // namespace folly
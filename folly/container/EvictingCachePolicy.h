@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <folly/hash/Hash.h>
+#include <folly/lang/Bits.h>
+
+namespace folly {
+
+/**
+ * Eviction policies for EvictingCacheMap and the weighted variants built on
+ * it, selected with the TPolicy template parameter.
+ *
+ * A policy with `kAdmission == false` (LruEvictingCachePolicy) leaves the
+ * cache as a pure LRU and costs nothing. A policy with `kAdmission == true`
+ * makes the cache split its LRU list into a small *window* segment at the
+ * head, holding the most recently inserted entries, followed by the *main*
+ * segment. Entries overflowing the window become admission candidates; when
+ * the cache must evict, the policy decides whether the candidate or the LRU
+ * victim of the main segment goes. Such a policy must provide:
+ *
+ *   // Size internal state for a cache holding about `capacity` entries.
+ *   void reserve(std::size_t capacity);
+ *   // Number of entries in the window for a cache of `capacity` entries.
+ *   std::size_t windowSize(std::size_t capacity) const;
+ *   // Record a hit or insertion of a key with the given hash.
+ *   void recordAccess(std::size_t hash);
+ *   // True to evict the victim and keep the candidate, false to evict the
+ *   // candidate instead.
+ *   bool admit(std::size_t candidateHash, std::size_t victimHash) const;
+ */
+
+/**
+ * Plain LRU: every new entry is admitted and the least recently used entry
+ * is evicted. This is the default.
+ */
+struct LruEvictingCachePolicy {
+  static constexpr bool kAdmission = false;
+};
+
+namespace detail {
+
+/**
+ * A count-min sketch of 4-bit counters used to estimate access frequencies,
+ * as described in "TinyLFU: A Highly Efficient Cache Admission Policy"
+ * (Einziger, Friedman, Manes). Each key maps to one counter in each of four
+ * rows of 4 * capacity counters (8 bytes per cached entry); its estimate is
+ * the minimum of them. Increments are conservative (only the minimal counters
+ * are bumped), and once the number of increments reaches ten times the
+ * capacity, all counters are halved so that the estimate tracks recent
+ * popularity.
+ */
+class EvictingCacheFrequencySketch {
+ public:
+  static constexpr std::size_t kRows = 4;
+  static constexpr uint32_t kMaxCount = 15;
+
+  EvictingCacheFrequencySketch() = default;
+
+  /**
+   * Size the sketch for about `capacity` distinct keys. Growing keeps the
+   * recorded counts: each counter is copied to the counters it splits into,
+   * so estimates never drop. Shrinking is a no-op.
+   */
+  void reserve(std::size_t capacity) {
+    auto const rounded = nextPowTwo(std::max<std::size_t>(capacity, 4));
+    auto const width = 4 * rounded;
+    if (width <= width_ && !table_.empty()) {
+      return;
+    }
+    std::vector<uint64_t> table(kRows * width / kCountersPerWord, 0);
+    if (!table_.empty()) {
+      // Indexes are the top bits of the mixed hash, so old counter i covers
+      // new counters [i * factor, (i + 1) * factor).
+      auto const factor = width / width_;
+      for (std::size_t row = 0; row < kRows; ++row) {
+        for (std::size_t idx = 0; idx < width_; ++idx) {
+          uint64_t const count = counterAt(row, idx);
+          if (count == 0) {
+            continue;
+          }
+          for (auto i = idx * factor; i < (idx + 1) * factor; ++i) {
+            table[(row * width + i) / kCountersPerWord] |= count
+                << shiftOf(i);
+          }
+        }
+      }
+    }
+    table_ = std::move(table);
+    width_ = width;
+    widthShift_ = 64 - findLastSet(width - 1);
+    sampleSize_ = 10 * rounded;
+  }
+
+  std::size_t width() const { return width_; }
+
+  void increment(std::size_t hash) {
+    if (table_.empty()) {
+      return;
+    }
+    std::size_t idx[kRows];
+    uint32_t min = kMaxCount;
+    for (std::size_t row = 0; row < kRows; ++row) {
+      idx[row] = indexOf(hash, row);
+      min = std::min(min, counterAt(row, idx[row]));
+    }
+    if (min == kMaxCount) {
+      return;
+    }
+    for (std::size_t row = 0; row < kRows; ++row) {
+      if (counterAt(row, idx[row]) == min) {
+        wordAt(row, idx[row]) += uint64_t(1) << shiftOf(idx[row]);
+      }
+    }
+    if (++additions_ >= sampleSize_) {
+      halve();
+    }
+  }
+
+  uint32_t frequency(std::size_t hash) const {
+    if (table_.empty()) {
+      return 0;
+    }
+    uint32_t min = kMaxCount;
+    for (std::size_t row = 0; row < kRows; ++row) {
+      min = std::min(min, counterAt(row, indexOf(hash, row)));
+    }
+    return min;
+  }
+
+ private:
+  static constexpr std::size_t kCountersPerWord = 16;
+
+  std::size_t indexOf(std::size_t hash, std::size_t row) const {
+    // Keys may come from a non-avalanching hasher, so remix before using
+    // multiply-shift hashing with a distinct odd multiplier per row.
+    static constexpr uint64_t kSeeds[kRows] = {
+        0xc3a5c85c97cb3127ULL,
+        0xb492b66fbe98f273ULL,
+        0x9ae16a3b2f90404fULL,
+        0xcbf29ce484222325ULL};
+    uint64_t const mixed = hash::twang_mix64(uint64_t(hash));
+    return std::size_t((mixed * kSeeds[row]) >> widthShift_);
+  }
+
+  static unsigned shiftOf(std::size_t idx) {
+    return unsigned(idx % kCountersPerWord) * 4;
+  }
+
+  uint64_t& wordAt(std::size_t row, std::size_t idx) {
+    return table_[(row * width_ + idx) / kCountersPerWord];
+  }
+
+  uint32_t counterAt(std::size_t row, std::size_t idx) const {
+    auto const word = table_[(row * width_ + idx) / kCountersPerWord];
+    return uint32_t(word >> shiftOf(idx)) & kMaxCount;
+  }
+
+  void halve() {
+    for (auto& word : table_) {
+      word = (word >> 1) & 0x7777777777777777ULL;
+    }
+    additions_ /= 2;
+  }
+
+  std::vector<uint64_t> table_;
+  std::size_t width_{0};
+  unsigned widthShift_{64};
+  std::size_t sampleSize_{0};
+  std::size_t additions_{0};
+};
+
+} // namespace detail
+
+/**
+ * W-TinyLFU: a small LRU window (1% of the capacity by default) absorbs
+ * bursts of new keys, and a TinyLFU frequency sketch decides whether an entry
+ * leaving the window may replace the LRU entry of the main segment. Keys that
+ * are seen only once, as in a scan, lose to any entry that was hit more than
+ * once and are evicted from the window without disturbing the main segment.
+ *
+ * See "Adaptive Software Cache Management" (Einziger, Eytan, Friedman,
+ * Manes) and the Caffeine cache for the design.
+ */
+class TinyLfuEvictingCachePolicy {
+ public:
+  static constexpr bool kAdmission = true;
+
+  /**
+   * @param windowRatio fraction of the capacity used by the window segment.
+   */
+  explicit TinyLfuEvictingCachePolicy(double windowRatio = 0.01)
+      : windowRatio_(windowRatio) {
+    assert(windowRatio_ >= 0 && windowRatio_ <= 1);
+  }
+
+  void reserve(std::size_t capacity) { sketch_.reserve(capacity); }
+
+  std::size_t windowSize(std::size_t capacity) const {
+    return std::max<std::size_t>(
+        1, std::size_t(double(capacity) * windowRatio_));
+  }
+
+  void recordAccess(std::size_t hash) { sketch_.increment(hash); }
+
+  bool admit(std::size_t candidateHash, std::size_t victimHash) const {
+    return sketch_.frequency(candidateHash) > sketch_.frequency(victimHash);
+  }
+
+  /**
+   * Estimated recent access frequency of a key with the given hash, in
+   * [0, 15].
+   */
+  uint32_t frequency(std::size_t hash) const {
+    return sketch_.frequency(hash);
+  }
+
+ private:
+  double windowRatio_;
+  detail::EvictingCacheFrequencySketch sketch_;
+};
+
+} // namespace folly
@@ -0,0 +1,487 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <folly/CppAttributes.h>
+#include <folly/Likely.h>
+#include <folly/Range.h>
+#include <folly/container/detail/F14Table.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Bits.h>
+#include <folly/lang/Exception.h>
+
+#if FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
+
+namespace folly {
+
+namespace detail {
+
+struct F14FrozenStringRef {
+  uint64_t offset;
+  uint64_t size;
+};
+
+// How a key or mapped value is stored in an item. Trivially copyable types
+// are stored inline; strings are stored in the string section of the buffer
+// and referred to by offset, like the records of a string_tape.
+template <typename T>
+struct F14FrozenField {
+  static_assert(
+      std::is_trivially_copyable<T>::value,
+      "F14FrozenMap keys and values must be trivially copyable or "
+      "std::string_view");
+
+  using Stored = T;
+  using Reference = T const&;
+
+  static Reference load(Stored const& stored, char const*) { return stored; }
+
+  static Stored store(T const& value, std::string&) { return value; }
+};
+
+template <>
+struct F14FrozenField<std::string_view> {
+  using Stored = F14FrozenStringRef;
+  using Reference = std::string_view;
+
+  static Reference load(Stored const& stored, char const* strings) {
+    return {strings + stored.offset, std::size_t(stored.size)};
+  }
+
+  static Stored store(std::string_view value, std::string& strings) {
+    Stored stored{strings.size(), value.size()};
+    strings.append(value);
+    return stored;
+  }
+};
+
+template <typename Key, typename Mapped>
+struct F14FrozenItem {
+  typename F14FrozenField<Key>::Stored key;
+  typename F14FrozenField<Mapped>::Stored mapped;
+};
+
+struct F14FrozenHeader {
+  // "F14FROZN" on a little-endian machine, so it doesn't match if the
+  // buffer was written on a machine with a different byte order.
+  static constexpr uint64_t kMagic = 0x4e5a4f5246343146ULL;
+  static constexpr uint32_t kVersion = 1;
+
+  uint64_t magic;
+  uint32_t version;
+  uint32_t chunkSize;
+  uint32_t itemSize;
+  uint32_t chunkCapacity;
+  uint64_t size;
+  uint64_t chunkCount;
+  uint64_t chunksOffset;
+  uint64_t stringsOffset;
+  uint64_t stringsSize;
+};
+
+// The first occupied item at or after `index` in a chunk of `capacity` items
+// whose occupiedMask() is `mask`, or `capacity` if there is none. Masks have
+// Spacing bits per item: 4 on NEON, 1 elsewhere.
+template <unsigned Spacing, typename Mask>
+std::size_t f14FrozenNextOccupied(
+    Mask mask, std::size_t index, std::size_t capacity) {
+  if (index >= capacity) {
+    return capacity;
+  }
+  auto const rest = mask >> (index * Spacing);
+  if (rest == 0) {
+    return capacity;
+  }
+  return index + (findFirstSet(rest) - 1) / Spacing;
+}
+
+} // namespace detail
+
+/**
+ * F14FrozenMap is a read-only hash map stored in a single relocatable byte
+ * buffer, so that a map built once can be written to a file and later used
+ * straight out of a memory mapping, without rebuilding or deserializing it.
+ *
+ *   // Offline:
+ *   F14FastMap<uint64_t, uint64_t> map = ...;
+ *   writeFile(F14FrozenMap<uint64_t, uint64_t>::serialize(map), path);
+ *
+ *   // At startup:
+ *   MemoryMapping mapping(path);
+ *   F14FrozenMap<uint64_t, uint64_t> frozen(mapping.range());
+ *   auto it = frozen.find(key);
+ *   if (it != frozen.end()) {
+ *     use(it->second);
+ *   }
+ *
+ * The buffer holds a header, an array of F14 chunks and a string section.
+ * The chunks use the tags, overflow counts and probing of F14ValueMap, so
+ * find() costs the same as on an F14ValueMap. Items contain no pointers:
+ * std::string_view keys and values are stored as offsets into the string
+ * section, and every other key and value type must be trivially copyable
+ * and is stored inline. Constructing an F14FrozenMap only checks the header
+ * and looks up one key, so it takes constant time; the rest of the buffer
+ * is trusted, and must outlive the map.
+ *
+ * The Hasher must produce the same hashes in the process that serializes
+ * the map and in the ones that read it. folly::hasher, the default, does,
+ * std::hash makes no such promise. The buffer can also only be read by a
+ * build with the same byte order and chunk layout. The constructor throws
+ * std::invalid_argument if it detects a mismatch of any of these.
+ *
+ * Only available when F14 uses vector intrinsics.
+ */
+template <
+    typename Key,
+    typename Mapped,
+    typename Hasher = hasher<Key>,
+    typename KeyEqual = std::equal_to<Key>>
+class F14FrozenMap {
+  using KeyField = detail::F14FrozenField<Key>;
+  using MappedField = detail::F14FrozenField<Mapped>;
+  using Item = detail::F14FrozenItem<Key, Mapped>;
+  using Chunk = f14::detail::F14Chunk<Item>;
+  using Header = detail::F14FrozenHeader;
+  using HashPair = std::pair<std::size_t, std::size_t>;
+
+  // Offset of the chunks in the buffer, and the alignment the buffer must
+  // have. Any memory mapping satisfies it.
+  static constexpr std::size_t kChunkAlignment = 64;
+  static_assert(kChunkAlignment % alignof(Chunk) == 0, "");
+
+ public:
+  using key_type = Key;
+  using mapped_type = Mapped;
+  using value_type = std::pair<
+      typename KeyField::Reference,
+      typename MappedField::Reference>;
+  using size_type = std::size_t;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = F14FrozenMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+
+    struct pointer {
+      value_type value;
+      value_type const* operator->() const { return &value; }
+    };
+
+    const_iterator() = default;
+
+    reference operator*() const {
+      auto const& item = chunk_->citem(index_);
+      return {
+          KeyField::load(item.key, strings_),
+          MappedField::load(item.mapped, strings_)};
+    }
+
+    pointer operator->() const { return pointer{**this}; }
+
+    const_iterator& operator++() {
+      ++index_;
+      skipEmpty();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      auto prev = *this;
+      ++*this;
+      return prev;
+    }
+
+    bool operator==(const_iterator const& rhs) const {
+      return chunk_ == rhs.chunk_ && index_ == rhs.index_;
+    }
+
+    bool operator!=(const_iterator const& rhs) const { return !(*this == rhs); }
+
+   private:
+    friend class F14FrozenMap;
+
+    const_iterator(
+        Chunk const* chunk,
+        std::size_t index,
+        Chunk const* last,
+        char const* strings)
+        : chunk_{chunk}, index_{index}, last_{last}, strings_{strings} {}
+
+    void skipEmpty() {
+      while (chunk_ != last_) {
+        index_ = detail::f14FrozenNextOccupied<f14::detail::kMaskSpacing>(
+            chunk_->occupiedMask(), index_, Chunk::kCapacity);
+        if (index_ < Chunk::kCapacity) {
+          return;
+        }
+        ++chunk_;
+        index_ = 0;
+      }
+    }
+
+    Chunk const* chunk_{nullptr};
+    std::size_t index_{0};
+    Chunk const* last_{nullptr};
+    char const* strings_{nullptr};
+  };
+
+  using iterator = const_iterator;
+
+  /**
+   * An empty map.
+   */
+  F14FrozenMap() = default;
+
+  /**
+   * A map stored in `bytes`, as produced by serialize(). The chunks in
+   * `bytes` must be suitably aligned, which a buffer starting on a page
+   * boundary (e.g. a MemoryMapping) always is.
+   */
+  explicit F14FrozenMap(
+      ByteRange bytes,
+      Hasher const& hasher = Hasher{},
+      KeyEqual const& equal = KeyEqual{})
+      : hasher_(hasher), equal_(equal) {
+    Header header;
+    if (bytes.size() < sizeof(header)) {
+      throwInvalid("buffer is too small");
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != Header::kMagic) {
+      throwInvalid("not a frozen map, or written with another byte order");
+    }
+    if (header.version != Header::kVersion ||
+        header.chunkSize != sizeof(Chunk) || header.itemSize != sizeof(Item) ||
+        header.chunkCapacity != Chunk::kCapacity) {
+      throwInvalid("written with another format, key, value or chunk layout");
+    }
+    auto const count = header.chunkCount;
+    if (count == 0 || (count & (count - 1)) != 0 ||
+        count > bytes.size() / sizeof(Chunk) ||
+        header.size > count * Chunk::kCapacity) {
+      throwInvalid("corrupt chunk count or size");
+    }
+    if (header.chunksOffset % kChunkAlignment != 0 ||
+        header.chunksOffset > bytes.size() - count * sizeof(Chunk) ||
+        header.stringsOffset > bytes.size() ||
+        header.stringsSize > bytes.size() - header.stringsOffset) {
+      throwInvalid("corrupt section offsets");
+    }
+    auto const chunks = bytes.data() + header.chunksOffset;
+    if (reinterpret_cast<uintptr_t>(chunks) % alignof(Chunk) != 0) {
+      throwInvalid("buffer is not aligned");
+    }
+    chunks_ = reinterpret_cast<Chunk const*>(chunks);
+    chunkMask_ = std::size_t(count - 1);
+    size_ = std::size_t(header.size);
+    strings_ = reinterpret_cast<char const*>(bytes.data()) +
+        std::size_t(header.stringsOffset);
+
+    // A different hasher, or one that isn't deterministic, would make most
+    // lookups miss. Finding one key isn't proof, but it's cheap.
+    if (size_ != 0) {
+      auto first = begin();
+      if (first == end() || find((*first).first) != first) {
+        throwInvalid("hasher differs from the one that wrote the buffer");
+      }
+    }
+  }
+
+  /**
+   * Serializes [begin(entries), end(entries)), a range of pairs such as an
+   * F14 map, into a buffer that F14FrozenMap can use. Throws
+   * std::invalid_argument if a key appears more than once.
+   */
+  template <typename Entries>
+  static std::string serialize(
+      Entries const& entries,
+      Hasher const& hasher = Hasher{},
+      KeyEqual const& equal = KeyEqual{}) {
+    auto const n =
+        std::size_t(std::distance(std::begin(entries), std::end(entries)));
+    auto const chunkCount = nextPowTwo(std::max<std::size_t>(
+        1, (n + Chunk::kDesiredCapacity - 1) / Chunk::kDesiredCapacity));
+    auto const chunkMask = chunkCount - 1;
+    std::vector<Chunk> chunks(chunkCount);
+    std::vector<uint8_t> fullness(chunkCount);
+    std::string strings;
+
+    for (auto const& entry : entries) {
+      Key const& key = entry.first;
+      auto const hp = splitHash(hasher(key));
+      if (findItem(chunks.data(), chunkMask, strings.data(), equal, hp, key)
+              .first != nullptr) {
+        throw_exception<std::invalid_argument>(
+            "F14FrozenMap::serialize: duplicate key");
+      }
+
+      // Same placement as F14Table::allocateTag.
+      std::size_t index = hp.first;
+      while (true) {
+        index &= chunkMask;
+        if (FOLLY_LIKELY(fullness[index] < Chunk::kCapacity)) {
+          break;
+        }
+        chunks[index].incrOutboundOverflowCount();
+        index += probeDelta(hp);
+      }
+      auto& chunk = chunks[index];
+      auto const itemIndex = fullness[index]++;
+
+      // Zero the padding too, so that serialization is deterministic.
+      Item item;
+      std::memset(static_cast<void*>(&item), 0, sizeof(item));
+      item.key = KeyField::store(key, strings);
+      item.mapped = MappedField::store(entry.second, strings);
+      std::memcpy(
+          static_cast<void*>(chunk.itemAddr(itemIndex)), &item, sizeof(item));
+      chunk.setTag(itemIndex, hp.second);
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = Header::kMagic;
+    header.version = Header::kVersion;
+    header.chunkSize = sizeof(Chunk);
+    header.itemSize = sizeof(Item);
+    header.chunkCapacity = Chunk::kCapacity;
+    header.size = n;
+    header.chunkCount = chunkCount;
+    header.chunksOffset =
+        (sizeof(header) + kChunkAlignment - 1) / kChunkAlignment *
+        kChunkAlignment;
+    header.stringsOffset = header.chunksOffset + chunkCount * sizeof(Chunk);
+    header.stringsSize = strings.size();
+
+    std::string out;
+    out.reserve(std::size_t(header.stringsOffset) + strings.size());
+    out.append(reinterpret_cast<char const*>(&header), sizeof(header));
+    out.resize(std::size_t(header.chunksOffset), '\0');
+    out.append(
+        reinterpret_cast<char const*>(chunks.data()),
+        chunkCount * sizeof(Chunk));
+    out.append(strings);
+    return out;
+  }
+
+  size_type size() const noexcept { return size_; }
+
+  bool empty() const noexcept { return size_ == 0; }
+
+  const_iterator begin() const {
+    if (size_ == 0) {
+      return end();
+    }
+    const_iterator it{chunks_, 0, chunks_ + chunkMask_ + 1, strings_};
+    it.skipEmpty();
+    return it;
+  }
+
+  const_iterator end() const {
+    auto const last = size_ == 0 ? nullptr : chunks_ + chunkMask_ + 1;
+    return const_iterator{last, 0, last, strings_};
+  }
+
+  const_iterator find(key_type const& key) const {
+    if (size_ == 0) {
+      return end();
+    }
+    auto const found = findItem(
+        chunks_, chunkMask_, strings_, equal_, splitHash(hasher_(key)), key);
+    if (found.first == nullptr) {
+      return end();
+    }
+    return const_iterator{
+        found.first, found.second, chunks_ + chunkMask_ + 1, strings_};
+  }
+
+  bool contains(key_type const& key) const { return find(key) != end(); }
+
+  size_type count(key_type const& key) const { return contains(key) ? 1 : 0; }
+
+  typename MappedField::Reference at(key_type const& key) const {
+    auto it = find(key);
+    if (it == end()) {
+      throw_exception<std::out_of_range>("at() did not find key");
+    }
+    return (*it).second;
+  }
+
+ private:
+  [[noreturn]] static void throwInvalid(char const* what) {
+    throw_exception<std::invalid_argument>(
+        std::string("F14FrozenMap: ") + what);
+  }
+
+  static HashPair splitHash(std::size_t hash) {
+    return f14::detail::splitHashImpl<Hasher, Key>(hash);
+  }
+
+  static std::size_t probeDelta(HashPair hp) { return 2 * hp.second + 1; }
+
+  // Same probing as F14Table::findImpl. Returns the chunk and index of the
+  // item, or a null chunk.
+  static std::pair<Chunk const*, std::size_t> findItem(
+      Chunk const* chunks,
+      std::size_t chunkMask,
+      char const* strings,
+      KeyEqual const& equal,
+      HashPair hp,
+      key_type const& key) {
+    std::size_t index = hp.first;
+    for (std::size_t tries = 0; tries <= chunkMask; ++tries) {
+      Chunk const* chunk = chunks + (index & chunkMask);
+      auto hits = chunk->tagMatchIter(hp.second);
+      while (hits.hasNext()) {
+        auto i = hits.next();
+        if (FOLLY_LIKELY(
+                equal(key, KeyField::load(chunk->citem(i).key, strings)))) {
+          return {chunk, i};
+        }
+      }
+      if (FOLLY_LIKELY(chunk->outboundOverflowCount() == 0)) {
+        break;
+      }
+      index += probeDelta(hp);
+    }
+    return {nullptr, 0};
+  }
+
+  Chunk const* chunks_{nullptr};
+  std::size_t chunkMask_{0};
+  std::size_t size_{0};
+  char const* strings_{nullptr};
+  [[FOLLY_ATTR_NO_UNIQUE_ADDRESS]] Hasher hasher_;
+  [[FOLLY_ATTR_NO_UNIQUE_ADDRESS]] KeyEqual equal_;
+};
+
+} // namespace folly
+
+#endif // FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
@@ -916,6 +916,41 @@ class F14BasicMap {
     return table_.makeConstIter(table_.find(token, key));
   }
 
+  /**
+   * @overloadbrief Look up a batch of keys.
+   * @methodset Lookup
+   *
+   * findMany(first, last, visitor) calls visitor(key, find(key)) for each
+   * key in [first, last), in order. It performs the prehash()/prefetch()
+   * pipelining described above automatically: keys are hashed and their
+   * first chunk is prefetched a few keys ahead of being probed, so that on
+   * a cold map the cache misses of different keys overlap instead of being
+   * paid one after the other.
+   *
+   * [first, last) must be a forward range whose elements are key_type, or
+   * a type eligible for heterogeneous lookup.
+   *
+   *   std::size_t hits = 0;
+   *   map.findMany(keys.begin(), keys.end(), [&](auto const&, auto it) {
+   *     hits += it != map.end();
+   *   });
+   */
+  template <typename ForwardIt, typename Visitor>
+  void findMany(ForwardIt first, ForwardIt last, Visitor&& visitor) {
+    checkFindManyKey<ForwardIt>();
+    table_.findMany(first, last, [&](auto const& key, auto itemIter) {
+      visitor(key, table_.makeIter(itemIter));
+    });
+  }
+
+  template <typename ForwardIt, typename Visitor>
+  void findMany(ForwardIt first, ForwardIt last, Visitor&& visitor) const {
+    checkFindManyKey<ForwardIt>();
+    table_.findMany(first, last, [&](auto const& key, auto itemIter) {
+      visitor(key, table_.makeConstIter(itemIter));
+    });
+  }
+
   /**
    * @overloadbrief Checks if the container contains an element with the
    * specific key.
@@ -1094,6 +1129,19 @@ class F14BasicMap {
   F14TableStats computeStats() const noexcept { return table_.computeStats(); }
 
  private:
+  template <typename ForwardIt>
+  static constexpr void checkFindManyKey() {
+    using K = remove_cvref_t<decltype(*std::declval<ForwardIt&>())>;
+    static_assert(
+        std::is_same<K, typename Policy::Key>::value ||
+            ::folly::detail::EligibleForHeterogeneousFind<
+                typename Policy::Key,
+                typename Policy::Hasher,
+                typename Policy::KeyEqual,
+                K>::value,
+        "findMany() keys must be key_type or support heterogeneous lookup");
+  }
+
   template <typename Self, typename K>
   FOLLY_ALWAYS_INLINE static auto& at(Self& self, K const& key) {
     auto iter = self.find(key);
@@ -53,16 +53,23 @@ namespace folly {
  *
  * This implementation has not been highly optimized and is a wrapper around
  * EvictingCacheMap.
+ *
+ * TPolicy selects the eviction policy as in EvictingCacheMap. With an
+ * admission policy such as TinyLfuEvictingCachePolicy, the window segment is
+ * sized as a fraction of the current number of entries, and each eviction
+ * needed to get under the max total weight may reject the pending admission
+ * candidate instead of the LRU entry.
  */
 template <
     class TKey,
     class TValue,
     class TWeightFn,
     class THash = HeterogeneousAccessHash<TKey>,
-    class TKeyEqual = HeterogeneousAccessEqualTo<TKey>>
+    class TKeyEqual = HeterogeneousAccessEqualTo<TKey>,
+    class TPolicy = LruEvictingCachePolicy>
 class ImplicitlyWeightedEvictingCacheMap {
  private: // typedefs
-  using ECM = EvictingCacheMap<TKey, TValue, THash, TKeyEqual>;
+  using ECM = EvictingCacheMap<TKey, TValue, THash, TKeyEqual, TPolicy>;
 
  public:
   using PruneHookCall = std::function<void(TKey, TValue&&)>;
@@ -71,8 +78,9 @@ class ImplicitlyWeightedEvictingCacheMap {
       std::size_t maxTotalWeight,
       const TWeightFn& weightFn = TWeightFn(),
       const THash& keyHash = THash(),
-      const TKeyEqual& keyEqual = TKeyEqual())
-      : ecm_(/* no max size*/ 0, 1, keyHash, keyEqual),
+      const TKeyEqual& keyEqual = TKeyEqual(),
+      const TPolicy& policy = TPolicy())
+      : ecm_(/* no max size*/ 0, 1, keyHash, keyEqual, policy),
         weightFn_(weightFn),
         maxTotalWeight_(maxTotalWeight),
         currentTotalWeight_(0) {
@@ -200,8 +208,9 @@ class ImplicitlyWeightedEvictingCacheMap {
    * is more than maxTotalWeight, the entry is inserted anyway and all other
    * entries are evicted, so that get() after set() always succeeds. The
    * structure can be temporarily over max weight until the next modification.
-   * The new or modified entry is always inserted at or promoted to the head
-   * of the LRU.
+   * The new or modified entry is inserted at or promoted to the head of the
+   * LRU, or of its segment with an admission policy, and is never evicted by
+   * this call.
    *
    * @param key key to associate with value
    * @param value value to associate with the key
@@ -228,10 +237,11 @@ class ImplicitlyWeightedEvictingCacheMap {
       new (ptr) TValue(std::move(value));
     } else {
       // No existing entry
-      ecm_.insert(key, std::move(value));
+      it = const_iterator(ecm_.insert(key, std::move(value)).first.base());
     }
-    // Protect the entry we just put at the head of the LRU
-    entryWeightUpdated(old_weight, new_weight, /*protect_one*/ true);
+    // Protect the entry we just set. With an admission policy, promotion
+    // does not necessarily move it to the head of the LRU.
+    entryWeightUpdated(old_weight, new_weight, it);
   }
 
   template <typename K>
@@ -284,7 +294,8 @@ class ImplicitlyWeightedEvictingCacheMap {
    * against eviction even if exceeding max total weight (like set(), iterator
    * remains valid). The iterator also remains valid if the weight does not
    * increase. Otherwise, the iterator is potentially invalidated by eviction
-   * during this operation.
+   * during this operation. With an admission policy, find() only promotes an
+   * entry to the head of its segment; use set() to protect it instead.
    *
    * If TValue is a const type, this function is invalid.
    * @param it const_iterator for the entry to modify, which must come from
@@ -298,7 +309,7 @@ class ImplicitlyWeightedEvictingCacheMap {
     // Overwrite in place
     const_cast<TValue&>(it->second) = std::move(value);
     // Evict as needed (possibly including this entry, unless it's LRU head)
-    entryWeightUpdated(old_weight, new_weight, /*protect_one*/ true);
+    entryWeightUpdated(old_weight, new_weight, begin());
   }
 
   void replace(const_iterator it, const TValue& value) {
@@ -335,24 +346,31 @@ class ImplicitlyWeightedEvictingCacheMap {
     });
   }
 
+  // Evicts entries as needed after the weight of an entry changed, except
+  // the entry at keep.
   void entryWeightUpdated(
-      std::size_t old_weight,
-      std::size_t new_weight,
-      bool protect_one = false) {
+      std::size_t old_weight, std::size_t new_weight, const_iterator keep) {
     assert(old_weight <= currentTotalWeight_);
     currentTotalWeight_ += new_weight - old_weight;
-    pruneToMaxTotalWeight(protect_one);
+    // NOTE: Avoid infinite loop even in the case of weight tracking bug
+    while (currentTotalWeight_ > maxTotalWeight_ && ecm_.size() > 1) {
+      ecm_.pruneExcept(1, keep);
+    }
   }
 
-  void pruneToMaxTotalWeight(bool protect_one = false) {
+  void pruneToMaxTotalWeight() {
     // NOTE: Avoid infinite loop even in the case of weight tracking bug
-    size_t min_count = protect_one ? 1 : 0;
-    while (currentTotalWeight_ > maxTotalWeight_ && ecm_.size() > min_count) {
+    while (currentTotalWeight_ > maxTotalWeight_ && !ecm_.empty()) {
       ecm_.prune(1);
     }
   }
 
-  template <class _TKey, class _TValue, class _THash, class _TKeyEqual>
+  template <
+      class _TKey,
+      class _TValue,
+      class _THash,
+      class _TKeyEqual,
+      class _TPolicy>
   friend class WeightedEvictingCacheMap;
 
  private: // data
@@ -388,12 +406,16 @@ class ImplicitlyWeightedEvictingCacheMap {
  * EligibleForHeterogeneousFind/Insert.)
  *
  * This implementation has not been highly optimized.
+ *
+ * TPolicy selects the eviction policy, as in
+ * ImplicitlyWeightedEvictingCacheMap.
  */
 template <
     class TKey,
     class TValue,
     class THash = HeterogeneousAccessHash<TKey>,
-    class TKeyEqual = HeterogeneousAccessEqualTo<TKey>>
+    class TKeyEqual = HeterogeneousAccessEqualTo<TKey>,
+    class TPolicy = LruEvictingCachePolicy>
 class WeightedEvictingCacheMap {
  public: // types
   struct ValueAndWeight {
@@ -416,7 +438,8 @@ class WeightedEvictingCacheMap {
       ValueAndWeight,
       WeightFn,
       THash,
-      TKeyEqual>;
+      TKeyEqual,
+      TPolicy>;
 
  public:
   using PruneHookCall = std::function<void(TKey, TValue&&, size_t)>;
@@ -424,8 +447,9 @@ class WeightedEvictingCacheMap {
   explicit WeightedEvictingCacheMap(
       std::size_t maxTotalWeight,
       const THash& keyHash = THash(),
-      const TKeyEqual& keyEqual = TKeyEqual())
-      : iwecm_(maxTotalWeight, WeightFn(), keyHash, keyEqual) {}
+      const TKeyEqual& keyEqual = TKeyEqual(),
+      const TPolicy& policy = TPolicy())
+      : iwecm_(maxTotalWeight, WeightFn(), keyHash, keyEqual, policy) {}
 
   // Like EvictingCacheMap
   WeightedEvictingCacheMap(const WeightedEvictingCacheMap&) = delete;
@@ -532,8 +556,9 @@ class WeightedEvictingCacheMap {
    * is more than maxTotalWeight, the entry is inserted anyway and all other
    * entries are evicted, so that get() after set() always succeeds. The
    * structure can be temporarily over max weight until the next modification.
-   * The new or modified entry is always inserted at or promoted to the head
-   * of the LRU.
+   * The new or modified entry is inserted at or promoted to the head of the
+   * LRU, or of its segment with an admission policy, and is never evicted by
+   * this call.
    *
    * @param key key to associate with value
    * @param value value to associate with the key
@@ -597,7 +622,9 @@ class WeightedEvictingCacheMap {
    * entry is protected against eviction even if exceeding max total weight
    * (like set(), iterator remains valid). The iterator also remains valid if
    * the weight does not increase. Otherwise, the iterator is potentially
-   * invalidated by eviction during this operation.
+   * invalidated by eviction during this operation. With an admission policy,
+   * find() only promotes an entry to the head of its segment; use set() to
+   * protect it instead.
    *
    * @param it iterator for the entry to modify, which must come from
    * this cache map
@@ -641,7 +668,7 @@ class WeightedEvictingCacheMap {
     // Overwrite in place
     const_cast<std::size_t&>(it->second.weight) = new_weight;
     // Evict as needed (possibly including this entry, unless it's LRU head)
-    iwecm_.entryWeightUpdated(old_weight, new_weight, /*protect_one*/ true);
+    iwecm_.entryWeightUpdated(old_weight, new_weight, iwecm_.begin());
   }
 
   PruneHookCall pruneHook_;
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Portability.h>
+#include <folly/Range.h>
+#include <folly/ScopeGuard.h>
+#include <folly/Traits.h>
+#include <folly/container/Iterator.h>
+#include <folly/container/tape.h>
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace folly {
+namespace detail {
+
+template <typename Field>
+struct columnar_tape_column {
+  static_assert(
+      std::is_trivially_copyable_v<Field>,
+      "columnar_tape fields must be trivially copyable or a tape");
+
+  using type = std::vector<Field>;
+  using const_reference = const Field&;
+  using view = Range<const Field*>;
+  using mutable_view = Range<Field*>;
+
+  static view make_view(const type& c) { return {c.data(), c.size()}; }
+};
+
+template <typename Container>
+struct columnar_tape_column<tape<Container>> {
+  using type = tape<Container>;
+  using const_reference = typename type::const_reference;
+  using view = const type&;
+
+  static view make_view(const type& c) { return c; }
+};
+
+} // namespace detail
+
+/* # Columnar tape
+ *
+ * A struct-of-arrays container of records with a fixed set of fields.
+ * Each field is stored in its own contiguous column, so a scan over one
+ * field only touches the bytes of that field:
+ *
+ *   columnar_tape<int64_t, string_tape, double> rows;
+ *   rows.push_back(1, "first", 0.5);
+ *   rows.push_back(2, "second", 1.5);
+ *
+ *   // column<I>() is contiguous and suitable for vectorized loops.
+ *   double sum = 0;
+ *   for (double d : rows.column<2>()) {
+ *     sum += d;
+ *   }
+ *
+ * A field of a trivially copyable type `T` is stored in a `std::vector<T>`
+ * and its column is a `Range<const T*>`. A field of type `tape<C>` holds a
+ * variable-length record (a string for `string_tape`) and its column is
+ * that tape.
+ *
+ * Records can be appended one at a time with `push_back`, or a column at a
+ * time with `append`, which takes one range per field and is much faster
+ * when the data is already columnar. Records are read by index as a tuple
+ * of references; iterating records is supported but defeats the purpose,
+ * prefer `column<I>()` for scans.
+ *
+ * As for `tape`, only basic exception safety is provided. If `push_back` or
+ * `append` throws part-way, the fields already appended are removed, so that
+ * all columns keep the same number of records.
+ */
+template <typename... Fields>
+class columnar_tape {
+  static_assert(sizeof...(Fields) > 0, "columnar_tape needs a field");
+
+  template <std::size_t I>
+  using traits =
+      detail::columnar_tape_column<type_pack_element_t<I, Fields...>>;
+
+ public:
+  static constexpr std::size_t column_count = sizeof...(Fields);
+
+  template <std::size_t I>
+  using field_type = type_pack_element_t<I, Fields...>;
+  template <std::size_t I>
+  using column_type = typename traits<I>::type;
+
+  using const_reference = std::tuple<
+      typename detail::columnar_tape_column<Fields>::const_reference...>;
+  using reference = const_reference;
+  // As for tape, a record has no value type of its own.
+  using value_type = const_reference;
+
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  using iterator = folly::index_iterator<const columnar_tape>;
+  using const_iterator = iterator;
+
+  columnar_tape() = default;
+
+  // access ------
+
+  [[nodiscard]] const_reference operator[](size_type i) const noexcept {
+    return get_record(i, std::index_sequence_for<Fields...>{});
+  }
+
+  [[nodiscard]] const_reference at(size_type i) const {
+    if (FOLLY_UNLIKELY(i >= size())) {
+      throw std::out_of_range("columnar_tape");
+    }
+    return operator[](i);
+  }
+
+  // One field of one record.
+  template <std::size_t I>
+  [[nodiscard]] typename traits<I>::const_reference get(
+      size_type i) const noexcept {
+    return std::get<I>(columns_)[i];
+  }
+
+  // All values of one field: a `Range<const T*>` over contiguous values or,
+  // for a variable-length field, its tape.
+  template <std::size_t I>
+  [[nodiscard]] typename traits<I>::view column() const noexcept {
+    return traits<I>::make_view(std::get<I>(columns_));
+  }
+
+  // Mutable values of a fixed-width field, for in-place updates.
+  template <std::size_t I>
+  [[nodiscard]] typename traits<I>::mutable_view mutable_column() noexcept {
+    auto& c = std::get<I>(columns_);
+    return {c.data(), c.size()};
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+  [[nodiscard]] size_type size() const noexcept {
+    return std::get<0>(columns_).size();
+  }
+
+  [[nodiscard]] const_reference front() const noexcept { return operator[](0); }
+  [[nodiscard]] const_reference back() const noexcept {
+    return operator[](size() - 1);
+  }
+
+  // iterators ----
+
+  [[nodiscard]] const_iterator begin() const noexcept { return {*this, 0}; }
+  [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+  [[nodiscard]] const_iterator end() const noexcept { return {*this, size()}; }
+  [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+  // modifiers ------
+
+  // Appends one record, given one argument per field. Arguments for a
+  // variable-length field are anything its tape's push_back accepts.
+  template <typename... Args>
+  void push_back(Args&&... args) {
+    static_assert(
+        sizeof...(Args) == column_count, "one argument per field is required");
+    auto rollback = makeGuard([this, n = size()] { truncate(n); });
+    push_back_impl(
+        std::index_sequence_for<Fields...>{}, std::forward<Args>(args)...);
+    rollback.dismiss();
+  }
+
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    push_back(std::forward<Args>(args)...);
+  }
+
+  // Appends a record per element of the given ranges, one range per field.
+  // All ranges must have the same size.
+  template <typename... Ranges>
+  void append(const Ranges&... ranges) {
+    static_assert(
+        sizeof...(Ranges) == column_count, "one range per field is required");
+    const size_type sizes[] = {static_cast<size_type>(
+        std::distance(std::begin(ranges), std::end(ranges)))...};
+    for (auto n : sizes) {
+      if (n != sizes[0]) {
+        throw std::invalid_argument("columnar_tape::append: size mismatch");
+      }
+    }
+    auto rollback = makeGuard([this, n = size()] { truncate(n); });
+    append_impl(std::index_sequence_for<Fields...>{}, sizes[0], ranges...);
+    rollback.dismiss();
+  }
+
+  void pop_back() noexcept {
+    assert(!empty());
+    for_each_column([](auto& c) { c.pop_back(); });
+  }
+
+  // capacity ------
+
+  void reserve(size_type records) {
+    for_each_column([&](auto& c) { c.reserve(records); });
+  }
+
+  void clear() noexcept {
+    for_each_column([](auto& c) { c.clear(); });
+  }
+
+  // ordering --------
+
+  friend bool operator==(const columnar_tape& x, const columnar_tape& y) {
+    return x.columns_ == y.columns_;
+  }
+
+  friend bool operator!=(const columnar_tape& x, const columnar_tape& y) {
+    return !(x == y);
+  }
+
+ private:
+  template <typename F>
+  void for_each_column(F f) {
+    std::apply([&](auto&... c) { (f(c), ...); }, columns_);
+  }
+
+  // Cuts every column back to n records, after an append threw.
+  void truncate(size_type n) noexcept {
+    for_each_column([n](auto& c) { truncate_column(c, n); });
+  }
+
+  template <typename T>
+  static void truncate_column(std::vector<T>& c, size_type n) noexcept {
+    c.erase(c.begin() + n, c.end());
+  }
+
+  template <typename Container>
+  static void truncate_column(tape<Container>& c, size_type n) noexcept {
+    // A destroyed record builder discards the elements of a record the tape
+    // was writing when it threw.
+    { auto discard = c.new_record_builder(); }
+    if (c.size() > n) {
+      c.resize(n);
+    }
+  }
+
+  template <std::size_t... Is>
+  const_reference get_record(size_type i, std::index_sequence<Is...>) const {
+    return const_reference{get<Is>(i)...};
+  }
+
+  template <std::size_t... Is, typename... Args>
+  void push_back_impl(std::index_sequence<Is...>, Args&&... args) {
+    (std::get<Is>(columns_).push_back(std::forward<Args>(args)), ...);
+  }
+
+  template <std::size_t I, typename R>
+  void append_column(size_type n, const R& r) {
+    auto& c = std::get<I>(columns_);
+    if constexpr (std::is_same_v<column_type<I>, std::vector<field_type<I>>>) {
+      c.insert(c.end(), std::begin(r), std::end(r));
+    } else {
+      // Reserving flat space would need a pass over the records, so only
+      // the markers are reserved.
+      c.reserve(c.size() + n, c.size_flat());
+      for (const auto& record : r) {
+        c.push_back(record);
+      }
+    }
+  }
+
+  template <std::size_t... Is, typename... Ranges>
+  void append_impl(
+      std::index_sequence<Is...>, size_type n, const Ranges&... ranges) {
+    (append_column<Is>(n, ranges), ...);
+  }
+
+  std::tuple<typename detail::columnar_tape_column<Fields>::type...> columns_;
+};
+
+} // namespace folly
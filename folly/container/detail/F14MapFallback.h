@@ -615,6 +615,22 @@ class F14BasicMap : public std::unordered_map<K, M, H, E, A> {
       F14HashToken const&, K2 const& key) const {
     return contains(key);
   }
+  // No prefetching without F14 tables; this is just a loop over find().
+  template <typename ForwardIt, typename Visitor>
+  void findMany(ForwardIt first, ForwardIt last, Visitor&& visitor) {
+    for (; first != last; ++first) {
+      auto const& key = *first;
+      visitor(key, find(key));
+    }
+  }
+
+  template <typename ForwardIt, typename Visitor>
+  void findMany(ForwardIt first, ForwardIt last, Visitor&& visitor) const {
+    for (; first != last; ++first) {
+      auto const& key = *first;
+      visitor(key, find(key));
+    }
+  }
 };
 } // namespace detail
 } // namespace f14
@@ -368,6 +368,10 @@ struct FOLLY_MSVC_DECLSPEC(empty_bases) BasePolicy
     }
   }
 
+  // True if items can be dropped by clear() and reset() without calling
+  // destroyItem() on each of them, even though destroyItemOnClear().
+  static constexpr bool skipDestroyItemOnClear() { return false; }
+
   void beforeClear(std::size_t /*size*/, std::size_t /*capacity*/) {}
 
   void afterClear(std::size_t /*size*/, std::size_t /*capacity*/) {}
@@ -802,6 +806,16 @@ class NodeContainerPolicy
 
   static constexpr bool destroyItemOnClear() { return true; }
 
+  // Nodes allocated from an arena (an allocator whose deallocate() is a
+  // no-op) are reclaimed with the arena, so if destroying the value is
+  // also a no-op there is nothing to do per node.
+  static constexpr bool skipDestroyItemOnClear() {
+    return std::conjunction<
+        AllocatorHasTrivialDeallocate<Alloc>,
+        std::is_trivially_destructible<Value>,
+        AllocatorHasDefaultObjectDestroy<Alloc, Value>>::value;
+  }
+
   // inherit constructors
   using Super::Super;
 
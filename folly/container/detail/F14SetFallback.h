@@ -448,6 +448,14 @@ class F14BasicSet
       F14HashToken const&, K const& key) const {
     return find(key) != this->end();
   }
+  // No prefetching without F14 tables; this is just a loop over find().
+  template <typename ForwardIt, typename Visitor>
+  void findMany(ForwardIt first, ForwardIt last, Visitor&& visitor) const {
+    for (; first != last; ++first) {
+      auto const& key = *first;
+      visitor(key, find(key));
+    }
+  }
 };
 } // namespace detail
 } // namespace f14
@@ -1650,6 +1650,44 @@ class F14Table : public Policy {
     return findImpl(static_cast<HashPair>(token), key, Prefetch::DISABLED);
   }
 
+  // Number of keys findMany() hashes and prefetches ahead of the key it is
+  // probing. Large enough to keep several cache misses in flight, small
+  // enough that the prefetched lines are still resident when probed.
+  static constexpr std::size_t kFindManyLookahead = 8;
+
+  // Calls visitor(key, find(key)) for each key in [first, last), in order.
+  // This is find() with the prehash()/prefetch() pipelining applied: keys
+  // are hashed and their first chunk prefetched kFindManyLookahead keys
+  // before they are probed, so that the cache misses of consecutive
+  // lookups overlap instead of being paid serially. Iter must be a forward
+  // iterator.
+  template <typename Iter, typename Visitor>
+  void findMany(Iter first, Iter last, Visitor&& visitor) const {
+    HashPair pending[kFindManyLookahead];
+    auto hashAndPrefetch = [&](auto const& key) {
+      auto hp = splitHash(this->computeKeyHash(key));
+      prefetchAddr(chunks_ + moduloByChunkCount(hp.first));
+      return hp;
+    };
+
+    Iter ahead = first;
+    std::size_t primed = 0;
+    while (primed < kFindManyLookahead && ahead != last) {
+      pending[primed++] = hashAndPrefetch(*ahead);
+      ++ahead;
+    }
+    for (std::size_t slot = 0; first != last; ++first) {
+      auto hp = pending[slot];
+      if (ahead != last) {
+        pending[slot] = hashAndPrefetch(*ahead);
+        ++ahead;
+      }
+      slot = slot + 1 == kFindManyLookahead ? 0 : slot + 1;
+      auto const& key = *first;
+      visitor(key, findImpl(hp, key, Prefetch::ENABLED));
+    }
+  }
+
   // Searches for a key using a key predicate that is a refinement
   // of key equality.  func(k) should return true only if k is equal
   // to key according to key_eq(), but is allowed to apply additional
@@ -2400,7 +2438,7 @@ class F14Table : public Policy {
     }
 
     if (!empty()) {
-      if (destroyItemOnClear()) {
+      if (destroyItemOnClear() && !this->skipDestroyItemOnClear()) {
         for (std::size_t ci = 0; ci < chunkCount(); ++ci) {
           ChunkPtr chunk = chunks_ + ci;
           auto iter = chunk->occupiedIter();
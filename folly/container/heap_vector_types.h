@@ -305,6 +305,24 @@ void getOffsets(size_type size, Offsets& offsets) {
   } while (i || offset < size);
 }
 
+// Writes `size` sorted elements read from `first` to `out`, in heap order.
+// An in-order traversal of the heap visits the offsets in the order of the
+// elements, so the input is read once, sequentially, and each element is
+// written once, to its final offset. For example, given a sorted input:
+//     { 0, 10, 20, 30, 40, 50, 60, 70 }
+// offsets are visited in the order 7, 3, 1, 4, 0, 5, 2, 6 and out becomes:
+//     { 40, 20, 60, 10, 30, 50, 70, 0 }
+template <typename size_type, class InputIterator, class RandomAccessIterator>
+void copy_sorted_as_heap(
+    InputIterator first, size_type size, RandomAccessIterator out) {
+  // 1-based, as required by next()
+  size_type offset = firstOffset(size) + 1;
+  for (size_type i = 0; i < size; ++i, ++first) {
+    out[offset - 1] = *first;
+    offset = next(offset, size);
+  }
+}
+
 // Inplace conversion of a sorted vector to heap layout
 // This algorithm utilizes circular swaps to position each element in its heap
 // order offset in the vector. For example, given a sorted vector below:
@@ -322,6 +340,10 @@ template <class Container>
 void heapify(Container& cont) {
   using size_type = typename Container::size_type;
   size_type size = cont.size();
+  if (size == 0) {
+    // getOffsets needs at least one element.
+    return;
+  }
   std::vector<size_type> offsets;
   offsets.resize(size);
   getOffsets(size, offsets);
@@ -990,6 +1012,32 @@ class heap_vector_container : growth_policy_wrapper<GrowthPolicy> {
     heap_vector_detail::heapify(m_.cont_);
   }
 
+  // Construct a heap_vector_container from a range whose elements are sorted
+  // and unique, as sorted_unique_t hints. The input is read once, in order,
+  // and each element is copied straight to its offset in heap order, so this
+  // is O(n) without the inplace heapify of the constructor above.
+  template <class ForwardIterator>
+  heap_vector_container(
+      sorted_unique_t /* unused */,
+      ForwardIterator first,
+      ForwardIterator last,
+      const Compare& comp = Compare(),
+      const Allocator& alloc = Allocator())
+      : m_(value_compare(comp), alloc) {
+    assert(
+        std::adjacent_find(first, last, [&](const auto& a, const auto& b) {
+          return !value_comp()(a, b);
+        }) == last);
+    if constexpr (std::is_default_constructible<value_type>::value) {
+      m_.cont_.resize(std::distance(first, last));
+      heap_vector_detail::copy_sorted_as_heap(
+          first, m_.cont_.size(), m_.cont_.begin());
+    } else {
+      m_.cont_.assign(first, last);
+      heap_vector_detail::heapify(m_.cont_);
+    }
+  }
+
   Allocator get_allocator() const { return m_.cont_.get_allocator(); }
 
   const Container& get_container() const noexcept { return m_.cont_; }
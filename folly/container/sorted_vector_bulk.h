@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Bulk construction of sorted_vector_map / sorted_vector_set (and of the
+ * heap_vector types, which share their constructors) from large inputs.
+ *
+ *   // Sort tens of millions of pairs on a thread pool, then take over the
+ *   // storage without a copy.
+ *   std::vector<std::pair<K, V>> pairs = ...;
+ *   auto map = parallel_build_sorted_vector<sorted_vector_map<K, V>>(
+ *       std::move(pairs), getKeepAliveToken(executor));
+ *
+ *   // Combine several maps in one pass.
+ *   auto merged = sorted_vector_merge<sorted_vector_map<K, V>>(
+ *       std::vector<const sorted_vector_map<K, V>*>{&a, &b, &c});
+ *
+ * As for the container constructors, when keys are duplicated only one
+ * element is kept: parallel_build_sorted_vector keeps an unspecified one,
+ * sorted_vector_merge keeps the one from the earliest input.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <folly/Executor.h>
+#include <folly/container/sorted_vector_types.h>
+#include <folly/synchronization/Baton.h>
+
+namespace folly {
+
+namespace detail {
+
+// Below this many elements per task, sorting in parallel doesn't pay for
+// the merges.
+constexpr std::size_t kParallelSortMinChunk = 1 << 14;
+
+// Runs fn(0) ... fn(count - 1) on the calling thread and on up to
+// count - 1 tasks added to the executor, and waits for all of them.
+// Rethrows the first exception thrown by any.
+//
+// Indices are claimed from a shared counter, and the calling thread keeps
+// claiming until none are left, so it only ever waits for indices a task
+// has already started on. Tasks that start late find nothing to do. It is
+// therefore safe to call from a thread of the executor, even when all of
+// its threads are busy: the caller then runs everything itself.
+template <class Fn>
+void parallel_for_each_index(
+    Executor::KeepAlive<> const& executor, std::size_t count, Fn const& fn) {
+  // Shared with the tasks, which may outlive this call if they start late.
+  struct State {
+    explicit State(std::size_t n) : remaining(n) {}
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> remaining;
+    Baton<> done;
+    std::mutex mutex;
+    std::exception_ptr error;
+  };
+  auto state = std::make_shared<State>(count);
+  // fn is only used while an index is unfinished, so before this returns.
+  auto work = [state, &fn, count] {
+    for (auto i = state->next++; i < count; i = state->next++) {
+      try {
+        fn(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->error) {
+          state->error = std::current_exception();
+        }
+      }
+      if (--state->remaining == 0) {
+        state->done.post();
+      }
+    }
+  };
+  for (std::size_t i = 1; i < count; ++i) {
+    executor->add(work);
+  }
+  work();
+  state->done.wait();
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+}
+
+// Sorts [first, last) by sorting chunks in parallel and then merging pairs
+// of adjacent runs in parallel, halving the number of runs at each round.
+template <class RandomAccessIterator, class Compare>
+void parallel_sort(
+    RandomAccessIterator first,
+    RandomAccessIterator last,
+    Compare const& comp,
+    Executor::KeepAlive<> const& executor,
+    std::size_t tasks) {
+  auto const size = static_cast<std::size_t>(last - first);
+  auto const chunks = std::min(tasks, size / kParallelSortMinChunk);
+  if (chunks <= 1) {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  std::vector<RandomAccessIterator> bounds(chunks + 1);
+  for (std::size_t i = 0; i <= chunks; ++i) {
+    bounds[i] = first + size * i / chunks;
+  }
+  parallel_for_each_index(executor, chunks, [&](std::size_t i) {
+    std::sort(bounds[i], bounds[i + 1], comp);
+  });
+
+  for (std::size_t width = 1; width < chunks; width *= 2) {
+    auto const merges = (chunks + 2 * width - 1) / (2 * width);
+    parallel_for_each_index(executor, merges, [&](std::size_t m) {
+      auto const lo = 2 * width * m;
+      auto const mid = lo + width;
+      if (mid < chunks) {
+        std::inplace_merge(
+            bounds[lo],
+            bounds[mid],
+            bounds[std::min(mid + width, chunks)],
+            comp);
+      }
+    });
+  }
+}
+
+} // namespace detail
+
+/**
+ * Builds a SortedVector (a sorted_vector_map, sorted_vector_set or one of
+ * the heap_vector types) from an unsorted container, sorting it with up to
+ * `tasks` tasks on `executor`. The calling thread takes part in the work
+ * and blocks until it is done, but never waits for a task that has not
+ * started, so this can be called from a thread of `executor`. By default,
+ * one task is used per hardware thread. Inputs too small to benefit are
+ * sorted on the calling thread.
+ *
+ * Like the container's own `SortedVector(Container&&)` constructor, the
+ * storage of `container` is reused, so no allocation is performed beyond
+ * the scratch space of the merges.
+ */
+template <class SortedVector>
+SortedVector parallel_build_sorted_vector(
+    typename SortedVector::container_type&& container,
+    Executor::KeepAlive<> executor,
+    std::size_t tasks = 0,
+    typename SortedVector::key_compare const& comp =
+        typename SortedVector::key_compare()) {
+  if (tasks == 0) {
+    tasks = std::max(1u, std::thread::hardware_concurrency());
+  }
+  auto const valueComp = SortedVector(comp).value_comp();
+  detail::parallel_sort(
+      container.begin(), container.end(), valueComp, executor, tasks);
+  container.erase(
+      std::unique(
+          container.begin(),
+          container.end(),
+          [&](auto const& a, auto const& b) { return !valueComp(a, b); }),
+      container.end());
+  return SortedVector(sorted_unique, std::move(container), comp);
+}
+
+/**
+ * Merges several SortedVectors into one in a single pass over their
+ * elements, with a k-way merge rather than repeated pairwise inserts.
+ * `inputs` is a range of SortedVectors or of pointers to them. On equal
+ * keys, the element of the earliest input is kept.
+ *
+ * The inputs must be in sorted order, so the heap_vector types, which are
+ * iterated in sorted order, are supported as inputs as well as outputs.
+ */
+template <class SortedVector, class Inputs>
+SortedVector sorted_vector_merge(
+    Inputs const& inputs,
+    typename SortedVector::key_compare const& comp =
+        typename SortedVector::key_compare()) {
+  auto const deref = [](auto const& input) -> decltype(auto) {
+    if constexpr (std::is_pointer_v<std::decay_t<decltype(input)>>) {
+      return *input;
+    } else {
+      return input;
+    }
+  };
+  using Input = std::remove_reference_t<decltype(deref(*std::begin(inputs)))>;
+  using Iterator = typename Input::const_iterator;
+  struct Cursor {
+    Iterator it;
+    Iterator end;
+    std::size_t index;
+  };
+
+  auto const valueComp = SortedVector(comp).value_comp();
+  std::vector<Cursor> cursors;
+  std::size_t total = 0;
+  for (auto const& input : inputs) {
+    auto const& in = deref(input);
+    total += in.size();
+    if (!in.empty()) {
+      cursors.push_back({in.begin(), in.end(), cursors.size()});
+    }
+  }
+
+  // std heaps are max-heaps, so the cursor that compares greatest under
+  // this ordering, the smallest element of the earliest input, is on top.
+  auto const after = [&](Cursor const& a, Cursor const& b) {
+    if (valueComp(*b.it, *a.it)) {
+      return true;
+    }
+    return !valueComp(*a.it, *b.it) && b.index < a.index;
+  };
+  std::make_heap(cursors.begin(), cursors.end(), after);
+
+  typename SortedVector::container_type out;
+  out.reserve(total);
+  while (!cursors.empty()) {
+    std::pop_heap(cursors.begin(), cursors.end(), after);
+    auto& top = cursors.back();
+    if (out.empty() || valueComp(out.back(), *top.it)) {
+      out.push_back(*top.it);
+    }
+    if (++top.it == top.end) {
+      cursors.pop_back();
+    } else {
+      std::push_heap(cursors.begin(), cursors.end(), after);
+    }
+  }
+  return SortedVector(sorted_unique, std::move(out), comp);
+}
+
+} // namespace folly
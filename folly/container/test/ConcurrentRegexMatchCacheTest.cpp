@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/ConcurrentRegexMatchCache.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ManualExecutor.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+using namespace std::literals;
+
+using folly::ConcurrentRegexMatchCache;
+using folly::RegexMatchCacheKey;
+using testing::UnorderedElementsAre;
+
+namespace {
+
+class ConcurrentRegexMatchCacheTest : public testing::Test {
+ protected:
+  folly::ManualExecutor executor;
+  ConcurrentRegexMatchCache cache{getKeepAliveToken(executor), 2};
+
+  std::string const foo = "foo";
+  std::string const bar = "bar";
+  std::string const baz = "baz";
+  std::string const qux = "qux";
+
+  RegexMatchCacheKey const ba{"ba."};
+  RegexMatchCacheKey const any{".*"};
+};
+
+} // namespace
+
+TEST_F(ConcurrentRegexMatchCacheTest, StringsBeforeRegex) {
+  cache.addString(&foo);
+  cache.addString(&bar);
+  cache.addString(&baz);
+  cache.addRegex("ba.");
+  EXPECT_FALSE(cache.isReadyToFindMatches(ba));
+  EXPECT_FALSE(cache.findMatches(ba));
+
+  executor.drain();
+  EXPECT_TRUE(cache.isReadyToFindMatches(ba));
+  EXPECT_THAT(*cache.findMatches(ba), UnorderedElementsAre(&bar, &baz));
+  EXPECT_FALSE(cache.isReadyToFindMatches(any));
+
+  //  lookups view the published list in place rather than copying it
+  auto const matches = cache.findMatches(ba);
+  EXPECT_EQ(matches->begin(), cache.findMatches(ba)->begin());
+  cache.eraseString(&bar);
+  EXPECT_THAT(*cache.findMatches(ba), UnorderedElementsAre(&baz));
+  EXPECT_THAT(*matches, UnorderedElementsAre(&bar, &baz));
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, StringsAfterRegex) {
+  cache.addRegex("ba.");
+  cache.addRegex(".*");
+  executor.drain();
+  EXPECT_TRUE(cache.isReadyToFindMatches(ba));
+  EXPECT_THAT(*cache.findMatches(ba), UnorderedElementsAre());
+
+  cache.addString(&foo);
+  cache.addString(&bar);
+  cache.addString(&baz);
+  //  lookups see the last snapshot while strings are pending
+  EXPECT_FALSE(cache.isReadyToFindMatches(ba));
+  EXPECT_THAT(*cache.findMatches(ba), UnorderedElementsAre());
+
+  //  a single task evaluates both batches of two strings
+  EXPECT_EQ(1, executor.drain());
+  EXPECT_TRUE(cache.isReadyToFindMatches(ba));
+  EXPECT_THAT(*cache.findMatches(ba), UnorderedElementsAre(&bar, &baz));
+  EXPECT_THAT(*cache.findMatches(any), UnorderedElementsAre(&foo, &bar, &baz));
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, Erase) {
+  cache.addRegex("ba.");
+  cache.addString(&bar);
+  cache.addString(&baz);
+  executor.drain();
+
+  cache.eraseString(&bar);
+  EXPECT_THAT(*cache.findMatches(ba), UnorderedElementsAre(&baz));
+
+  //  erased while pending
+  cache.addString(&qux);
+  cache.eraseString(&qux);
+  EXPECT_TRUE(cache.isReadyToFindMatches(ba));
+  executor.drain();
+  EXPECT_THAT(*cache.findMatches(ba), UnorderedElementsAre(&baz));
+
+  cache.eraseRegex(ba);
+  EXPECT_FALSE(cache.isReadyToFindMatches(ba));
+  EXPECT_FALSE(cache.findMatches(ba));
+
+  //  erased and added again before evaluation
+  cache.addRegex("ba.");
+  cache.eraseRegex(ba);
+  cache.addRegex("ba.");
+  executor.drain();
+  EXPECT_THAT(*cache.findMatches(ba), UnorderedElementsAre(&baz));
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, InvalidRegex) {
+  EXPECT_ANY_THROW(cache.addRegex("("));
+  EXPECT_FALSE(cache.isReadyToFindMatches(RegexMatchCacheKey{"("}));
+  EXPECT_TRUE(cache.getRegexStats().empty());
+}
+
+TEST_F(ConcurrentRegexMatchCacheTest, Stats) {
+  cache.addString(&foo);
+  cache.addString(&bar);
+  cache.addString(&baz);
+  cache.addRegex("ba.");
+  cache.addRegex(".*");
+  executor.drain();
+  for (int i = 0; i < 5; ++i) {
+    (void)cache.findMatches(ba);
+  }
+
+  auto stats = cache.getRegexStats();
+  ASSERT_EQ(2, stats.size());
+  EXPECT_GE(stats[0].elapsed, stats[1].elapsed);
+  for (auto const& s : stats) {
+    EXPECT_EQ(3, s.evaluations);
+    EXPECT_EQ(0, s.errors);
+    if (s.regex == "ba.") {
+      EXPECT_EQ(5, s.lookups);
+      EXPECT_EQ(2, s.matches);
+    } else {
+      EXPECT_EQ(".*", s.regex);
+      EXPECT_EQ(0, s.lookups);
+      EXPECT_EQ(3, s.matches);
+    }
+  }
+}
+
+TEST(ConcurrentRegexMatchCache, ConcurrentLookups) {
+  folly::CPUThreadPoolExecutor executor(2);
+  ConcurrentRegexMatchCache cache{getKeepAliveToken(executor), 16};
+  RegexMatchCacheKey const even{"[0-9]*[02468]"};
+  cache.addRegex("[0-9]*[02468]");
+
+  constexpr size_t kStrings = 2000;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < kStrings; ++i) {
+    strings.push_back(std::to_string(i));
+  }
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; ++r) {
+    readers.emplace_back([&] {
+      size_t last = 0;
+      while (!done.load()) {
+        if (auto matches = cache.findMatches(even)) {
+          //  snapshots only grow while strings are only added
+          EXPECT_LE(last, matches->size());
+          last = matches->size();
+        }
+      }
+    });
+  }
+  for (auto const& s : strings) {
+    cache.addString(&s);
+  }
+  cache.waitUntilIdle();
+  done.store(true);
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_TRUE(cache.isReadyToFindMatches(even));
+  EXPECT_EQ(kStrings / 2, cache.findMatches(even)->size());
+  auto stats = cache.getRegexStats();
+  ASSERT_EQ(1, stats.size());
+  EXPECT_EQ(kStrings, stats[0].evaluations);
+  EXPECT_EQ(kStrings / 2, stats[0].matches);
+}
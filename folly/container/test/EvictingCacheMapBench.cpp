@@ -16,6 +16,11 @@
 
 #include <folly/container/EvictingCacheMap.h>
 
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
 #include <folly/Benchmark.h>
 
 using namespace folly;
@@ -58,6 +63,116 @@ void insertCache(uint32_t n, size_t numElts) {
   }
 }
 
+// Keys drawn from a Zipf(0.9) distribution over `numKeys` keys, by inverse
+// transform of the precomputed CDF.
+std::vector<uint64_t> zipfTrace(size_t n, size_t numKeys, uint32_t seed) {
+  std::vector<double> cdf(numKeys);
+  double sum = 0;
+  for (size_t i = 0; i < numKeys; ++i) {
+    sum += 1.0 / std::pow(double(i + 1), 0.9);
+    cdf[i] = sum;
+  }
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> dist(0, sum);
+  std::vector<uint64_t> trace(n);
+  for (auto& k : trace) {
+    auto it = std::lower_bound(cdf.begin(), cdf.end(), dist(rng));
+    k = key(size_t(it - cdf.begin()));
+  }
+  return trace;
+}
+
+// A Zipf trace where every other access is part of a sequential scan over
+// keys that are never reused.
+std::vector<uint64_t> scanMixedTrace(size_t n, size_t numKeys, uint32_t seed) {
+  auto trace = zipfTrace(n, numKeys, seed);
+  for (size_t i = 1; i < n; i += 2) {
+    trace[i] = key(numKeys + i);
+  }
+  return trace;
+}
+
+// Replays `trace` against a cache of `cacheSize` entries, inserting on miss,
+// and reports the hit ratio as a counter.
+template <class TPolicy>
+void replayTrace(
+    UserCounters& counters,
+    size_t iters,
+    const std::vector<uint64_t>& trace,
+    size_t cacheSize) {
+  size_t hits = 0;
+  size_t lookups = 0;
+  for (size_t iter = 0; iter < iters; ++iter) {
+    BenchmarkSuspender suspender;
+    EvictingCacheMap<
+        uint64_t,
+        size_t,
+        HeterogeneousAccessHash<uint64_t>,
+        HeterogeneousAccessEqualTo<uint64_t>,
+        TPolicy>
+        m(cacheSize);
+    suspender.dismiss();
+    for (auto k : trace) {
+      auto it = m.find(k);
+      if (it != m.end()) {
+        ++hits;
+      } else {
+        m.insert(k, k);
+      }
+    }
+    lookups += trace.size();
+  }
+  counters["hit_pct"] = int64_t(100 * hits / lookups);
+}
+
+constexpr size_t kTraceLength = 1 << 20;
+constexpr size_t kTraceKeys = 1 << 18;
+constexpr size_t kTraceCacheSize = 1 << 14;
+
+const std::vector<uint64_t>& zipf() {
+  static const auto trace = zipfTrace(kTraceLength, kTraceKeys, 1);
+  return trace;
+}
+
+const std::vector<uint64_t>& scanMixed() {
+  static const auto trace = scanMixedTrace(kTraceLength, kTraceKeys, 2);
+  return trace;
+}
+
+BENCHMARK_COUNTERS(zipfLru, counters, iters) {
+  BenchmarkSuspender suspender;
+  auto& trace = zipf();
+  suspender.dismiss();
+  replayTrace<LruEvictingCachePolicy>(counters, iters, trace, kTraceCacheSize);
+}
+
+BENCHMARK_COUNTERS_RELATIVE(zipfTinyLfu, counters, iters) {
+  BenchmarkSuspender suspender;
+  auto& trace = zipf();
+  suspender.dismiss();
+  replayTrace<TinyLfuEvictingCachePolicy>(
+      counters, iters, trace, kTraceCacheSize);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_COUNTERS(scanMixedLru, counters, iters) {
+  BenchmarkSuspender suspender;
+  auto& trace = scanMixed();
+  suspender.dismiss();
+  replayTrace<LruEvictingCachePolicy>(counters, iters, trace, kTraceCacheSize);
+}
+
+BENCHMARK_COUNTERS_RELATIVE(scanMixedTinyLfu, counters, iters) {
+  BenchmarkSuspender suspender;
+  auto& trace = scanMixed();
+  suspender.dismiss();
+  replayTrace<TinyLfuEvictingCachePolicy>(
+      counters, iters, trace, kTraceCacheSize);
+}
+
+BENCHMARK_DRAW_LINE();
+
 // Increment by factor of 4 * golden ratio to vary distance between
 // powers of 2
 BENCHMARK_PARAM(scanCache, 1000)
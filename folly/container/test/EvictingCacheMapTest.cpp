@@ -160,6 +160,23 @@ TEST(EvictingCacheMap, PruneTest) {
   }
 }
 
+TEST(EvictingCacheMap, PruneExceptTest) {
+  EvictingCacheMap<int, int> map(0);
+  for (int i = 0; i < 5; i++) {
+    map.set(i, i);
+  }
+  // 0 is at the back of the LRU, so the next entries go instead.
+  map.pruneExcept(3, map.findWithoutPromotion(0));
+  EXPECT_EQ(2, map.size());
+  EXPECT_TRUE(map.exists(0));
+  EXPECT_TRUE(map.exists(4));
+
+  // Stops at the kept entry.
+  map.pruneExcept(10, map.findWithoutPromotion(0));
+  EXPECT_EQ(1, map.size());
+  EXPECT_TRUE(map.exists(0));
+}
+
 TEST(EvictingCacheMap, PruneHookTest) {
   EvictingCacheMap<int, int> map(0);
   EXPECT_EQ(0, map.size());
@@ -840,3 +857,129 @@ TEST(EvictingCacheMap, PiecewiseConstructTest) {
   EXPECT_TRUE(inserted);
   EXPECT_EQ(iter->second, "test");
 }
+
+template <typename K, typename V>
+using TinyLfuCacheMap = EvictingCacheMap<
+    K,
+    V,
+    HeterogeneousAccessHash<K>,
+    HeterogeneousAccessEqualTo<K>,
+    TinyLfuEvictingCachePolicy>;
+
+TEST(EvictingCacheMap, TinyLfuSanityTest) {
+  TinyLfuCacheMap<int, int> map(10);
+  for (int i = 0; i < 10; ++i) {
+    map.set(i, i);
+  }
+  EXPECT_EQ(10, map.size());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, map.get(i));
+  }
+  EXPECT_TRUE(map.erase(5));
+  EXPECT_EQ(9, map.size());
+  EXPECT_EQ(9, std::distance(map.begin(), map.end()));
+  EXPECT_TRUE(map.insert(5, 5).second);
+  EXPECT_FALSE(map.insert(5, 6).second);
+  EXPECT_EQ(5, map.get(5));
+  for (int i = 10; i < 100; ++i) {
+    map.set(i, i);
+    EXPECT_EQ(10, map.size());
+    EXPECT_TRUE(map.exists(i)) << "new entries are admitted to the window";
+  }
+  EXPECT_EQ(10, map.size());
+  map.clear();
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(EvictingCacheMap, TinyLfuUnboundedKeepsCounts) {
+  // Without a max size, as in the weighted maps, the policy grows with the
+  // map and must not lose the counts recorded so far.
+  TinyLfuCacheMap<int, int> map(0);
+  for (int i = 0; i < 100; ++i) {
+    map.set(i, i);
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(0, map.get(0));
+  }
+  auto const hash = HeterogeneousAccessHash<int>()(0);
+  EXPECT_GE(map.getPolicy().frequency(hash), 5);
+  for (int i = 100; i < 5000; ++i) {
+    map.set(i, i);
+  }
+  EXPECT_EQ(5000, map.size());
+  EXPECT_GE(map.getPolicy().frequency(hash), 5);
+}
+
+TEST(EvictingCacheMap, TinyLfuScanResistance) {
+  constexpr int kHot = 80;
+  TinyLfuCacheMap<int, int> tinyLfu(100);
+  EvictingCacheMap<int, int> lru(100);
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < kHot; ++i) {
+      tinyLfu.set(i, i);
+      lru.set(i, i);
+    }
+  }
+  // A scan of keys that are each used once, interleaved with the hot keys.
+  // The reuse distance of the hot keys exceeds the cache size, so LRU never
+  // hits.
+  int tinyLfuHits = 0;
+  int lruHits = 0;
+  for (int i = 0; i < 4000; ++i) {
+    int hot = i % kHot;
+    tinyLfuHits += tinyLfu.find(hot) != tinyLfu.end();
+    lruHits += lru.find(hot) != lru.end();
+    tinyLfu.set(hot, hot);
+    lru.set(hot, hot);
+    tinyLfu.set(1000 + i, i);
+    lru.set(1000 + i, i);
+  }
+  EXPECT_GT(tinyLfuHits, 3900);
+  EXPECT_LT(lruHits, 100);
+  EXPECT_EQ(100, tinyLfu.size());
+}
+
+TEST(EvictingCacheMap, TinyLfuPruneHook) {
+  TinyLfuCacheMap<int, int> map(4);
+  std::vector<int> pruned;
+  map.setPruneHook([&](int key, int&& value) {
+    EXPECT_EQ(key, value);
+    pruned.push_back(key);
+  });
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      map.set(i, i);
+    }
+  }
+  map.get(3);
+  map.get(3);
+  EXPECT_TRUE(pruned.empty());
+  // 10 is admitted to the window, pushing 3 out as the candidate; 3 is the
+  // hottest, so the LRU entry 0 is evicted in its place. 11 then pushes 10
+  // out of the window, and the cold 10 is rejected.
+  map.set(10, 10);
+  map.set(11, 11);
+  EXPECT_EQ(std::vector<int>({0, 10}), pruned);
+  EXPECT_TRUE(map.exists(3));
+  EXPECT_TRUE(map.exists(11));
+  EXPECT_EQ(4, map.size());
+}
+
+TEST(EvictingCacheMap, TinyLfuMoveTest) {
+  TinyLfuCacheMap<int, int> map(10);
+  for (int i = 0; i < 20; ++i) {
+    map.set(i, i);
+  }
+  TinyLfuCacheMap<int, int> map2 = std::move(map);
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(10, map2.size());
+  for (int i = 20; i < 40; ++i) {
+    map.set(i, i);
+    map2.set(i, i);
+  }
+  EXPECT_EQ(10, map.size());
+  EXPECT_EQ(10, map2.size());
+  map = std::move(map2);
+  EXPECT_EQ(10, map.size());
+  EXPECT_TRUE(map.exists(39));
+}
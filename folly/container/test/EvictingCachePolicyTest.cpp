@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/EvictingCachePolicy.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+TEST(EvictingCacheFrequencySketch, Frequency) {
+  detail::EvictingCacheFrequencySketch sketch;
+  EXPECT_EQ(0, sketch.frequency(42));
+  sketch.increment(42);
+  EXPECT_EQ(0, sketch.frequency(42)) << "not sized yet";
+
+  sketch.reserve(1000);
+  EXPECT_EQ(4096, sketch.width());
+  for (uint32_t i = 1; i <= 5; ++i) {
+    sketch.increment(42);
+    EXPECT_EQ(i, sketch.frequency(42));
+  }
+  // Small integers are not avalanched by std::hash, so neighbors must still
+  // get independent counters.
+  EXPECT_EQ(0, sketch.frequency(43));
+
+  for (int i = 0; i < 100; ++i) {
+    sketch.increment(42);
+  }
+  EXPECT_EQ(
+      detail::EvictingCacheFrequencySketch::kMaxCount, sketch.frequency(42));
+
+  // Shrinking does not reset.
+  sketch.reserve(10);
+  EXPECT_EQ(4096, sketch.width());
+  EXPECT_EQ(
+      detail::EvictingCacheFrequencySketch::kMaxCount, sketch.frequency(42));
+}
+
+TEST(EvictingCacheFrequencySketch, GrowKeepsCounts) {
+  detail::EvictingCacheFrequencySketch sketch;
+  sketch.reserve(16);
+  for (std::size_t key = 0; key < 8; ++key) {
+    for (std::size_t i = 0; i < key; ++i) {
+      sketch.increment(key);
+    }
+  }
+  sketch.reserve(10000);
+  EXPECT_EQ(65536, sketch.width());
+  for (std::size_t key = 0; key < 8; ++key) {
+    // Count-min estimates never undercount.
+    EXPECT_GE(sketch.frequency(key), key);
+  }
+  // Keys that collided in the small table may keep an overestimate, but
+  // most unseen keys must still read 0.
+  std::size_t unseen = 0;
+  for (std::size_t key = 100; key < 200; ++key) {
+    unseen += sketch.frequency(key) == 0;
+  }
+  EXPECT_GT(unseen, 50);
+}
+
+TEST(EvictingCacheFrequencySketch, Aging) {
+  detail::EvictingCacheFrequencySketch sketch;
+  sketch.reserve(16);
+  for (int i = 0; i < 15; ++i) {
+    sketch.increment(7);
+  }
+  EXPECT_EQ(15, sketch.frequency(7));
+  // 10 * capacity increments in total trigger a halving of all counters.
+  for (std::size_t i = 0; sketch.frequency(7) == 15 && i < 1000; ++i) {
+    sketch.increment(1000 + i);
+  }
+  EXPECT_EQ(7, sketch.frequency(7));
+}
+
+TEST(TinyLfuEvictingCachePolicy, Admission) {
+  TinyLfuEvictingCachePolicy policy;
+  policy.reserve(100);
+  EXPECT_EQ(1, policy.windowSize(100));
+  EXPECT_EQ(10, policy.windowSize(1000));
+  EXPECT_EQ(1, policy.windowSize(0));
+
+  policy.recordAccess(1);
+  policy.recordAccess(1);
+  policy.recordAccess(2);
+  EXPECT_TRUE(policy.admit(1, 2));
+  EXPECT_FALSE(policy.admit(2, 1));
+  EXPECT_FALSE(policy.admit(2, 2)) << "ties favor the incumbent";
+  EXPECT_FALSE(policy.admit(3, 2));
+
+  TinyLfuEvictingCachePolicy bigWindow(0.5);
+  EXPECT_EQ(50, bigWindow.windowSize(100));
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/F14FrozenMap.h>
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/FileUtil.h>
+#include <folly/container/F14Map.h>
+#include <folly/portability/GTest.h>
+#include <folly/system/MemoryMapping.h>
+#include <folly/testing/TestUtil.h>
+
+#if FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
+
+using namespace folly;
+
+namespace {
+
+// serialize() returns a std::string, whose data isn't guaranteed to be
+// aligned like a memory mapping, so tests open a copy.
+struct AlignedBuffer {
+  explicit AlignedBuffer(std::string const& bytes)
+      : storage((bytes.size() + 63) / 64 + 1) {
+    std::memcpy(storage.data(), bytes.data(), bytes.size());
+    size = bytes.size();
+  }
+
+  ByteRange range() const {
+    return {reinterpret_cast<uint8_t const*>(storage.data()), size};
+  }
+
+  struct alignas(64) Line {
+    char bytes[64];
+  };
+  std::vector<Line> storage;
+  std::size_t size;
+};
+
+} // namespace
+
+TEST(F14FrozenMap, empty) {
+  F14FrozenMap<uint64_t, uint64_t> def;
+  EXPECT_TRUE(def.empty());
+  EXPECT_EQ(def.begin(), def.end());
+  EXPECT_EQ(def.find(1), def.end());
+
+  AlignedBuffer buf(
+      F14FrozenMap<uint64_t, uint64_t>::serialize(
+          std::vector<std::pair<uint64_t, uint64_t>>{}));
+  F14FrozenMap<uint64_t, uint64_t> map(buf.range());
+  EXPECT_EQ(0, map.size());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_FALSE(map.contains(0));
+  EXPECT_THROW(map.at(0), std::out_of_range);
+}
+
+TEST(F14FrozenMap, nextOccupied) {
+  // Items 1, 5 and 13 occupied, with the mask layout of SSE (1 bit per item)
+  // and of NEON (4 bits per item).
+  uint32_t const sse = (1u << 1) | (1u << 5) | (1u << 13);
+  uint64_t const neon = (1ull << 4) | (1ull << 20) | (1ull << 52);
+  for (auto const& [index, expected] : std::vector<std::pair<int, int>>{
+           {0, 1}, {1, 1}, {2, 5}, {5, 5}, {6, 13}, {13, 13}, {14, 14}}) {
+    EXPECT_EQ(expected, detail::f14FrozenNextOccupied<1>(sse, index, 14))
+        << index;
+    EXPECT_EQ(expected, detail::f14FrozenNextOccupied<4>(neon, index, 14))
+        << index;
+  }
+  EXPECT_EQ(14, detail::f14FrozenNextOccupied<4>(uint64_t(0), 0, 14));
+}
+
+TEST(F14FrozenMap, integers) {
+  for (uint64_t n : {1, 10, 1000, 100000}) {
+    F14FastMap<uint64_t, uint64_t> source;
+    for (uint64_t i = 0; i < n; ++i) {
+      source[i * 7919] = i;
+    }
+    AlignedBuffer buf(F14FrozenMap<uint64_t, uint64_t>::serialize(source));
+    F14FrozenMap<uint64_t, uint64_t> map(buf.range());
+    EXPECT_EQ(n, map.size());
+    for (uint64_t i = 0; i < n; ++i) {
+      auto it = map.find(i * 7919);
+      ASSERT_NE(it, map.end());
+      EXPECT_EQ(i * 7919, it->first);
+      EXPECT_EQ(i, it->second);
+      EXPECT_EQ(i, map.at(i * 7919));
+      EXPECT_FALSE(map.contains(i * 7919 + 1));
+    }
+
+    std::size_t visited = 0;
+    for (auto entry : map) {
+      EXPECT_EQ(source.at(entry.first), entry.second);
+      ++visited;
+    }
+    EXPECT_EQ(n, visited);
+  }
+}
+
+TEST(F14FrozenMap, strings) {
+  std::map<std::string, std::string> source;
+  for (int i = 0; i < 5000; ++i) {
+    source[std::to_string(i)] = std::string(i % 50, 'x') + std::to_string(i);
+  }
+  source[""] = "empty key";
+  source["empty value"] = "";
+  AlignedBuffer buf(
+      F14FrozenMap<std::string_view, std::string_view>::serialize(source));
+  F14FrozenMap<std::string_view, std::string_view> map(buf.range());
+  EXPECT_EQ(source.size(), map.size());
+  for (auto const& [key, value] : source) {
+    auto it = map.find(key);
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(key, it->first);
+    EXPECT_EQ(value, it->second);
+  }
+  EXPECT_FALSE(map.contains("5000"));
+  EXPECT_EQ("empty key", map.at(""));
+  EXPECT_EQ("", map.at("empty value"));
+}
+
+TEST(F14FrozenMap, mixedFields) {
+  struct Point {
+    int32_t x;
+    int32_t y;
+  };
+  std::vector<std::pair<std::string, Point>> source;
+  std::vector<std::pair<uint32_t, std::string>> reverse;
+  for (int i = 0; i < 100; ++i) {
+    source.emplace_back(std::to_string(i), Point{i, -i});
+    reverse.emplace_back(i, std::to_string(i));
+  }
+  AlignedBuffer buf(F14FrozenMap<std::string_view, Point>::serialize(source));
+  F14FrozenMap<std::string_view, Point> map(buf.range());
+  EXPECT_EQ(42, map.at("42").x);
+  EXPECT_EQ(-42, map.at("42").y);
+
+  AlignedBuffer rbuf(
+      F14FrozenMap<uint32_t, std::string_view>::serialize(reverse));
+  F14FrozenMap<uint32_t, std::string_view> rmap(rbuf.range());
+  EXPECT_EQ("42", rmap.at(42));
+}
+
+TEST(F14FrozenMap, duplicateKey) {
+  std::vector<std::pair<uint64_t, uint64_t>> source{{1, 1}, {2, 2}, {1, 3}};
+  EXPECT_THROW(
+      (F14FrozenMap<uint64_t, uint64_t>::serialize(source)),
+      std::invalid_argument);
+}
+
+TEST(F14FrozenMap, deterministic) {
+  F14FastMap<uint64_t, uint64_t> source;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    source[i] = i;
+  }
+  auto a = F14FrozenMap<uint64_t, uint64_t>::serialize(source);
+  auto b = F14FrozenMap<uint64_t, uint64_t>::serialize(source);
+  EXPECT_EQ(a, b);
+}
+
+TEST(F14FrozenMap, invalidBuffer) {
+  using Map = F14FrozenMap<uint64_t, uint64_t>;
+  std::vector<std::pair<uint64_t, uint64_t>> source{{1, 1}, {2, 2}};
+  auto bytes = Map::serialize(source);
+
+  EXPECT_THROW(
+      Map(AlignedBuffer(bytes.substr(0, 8)).range()), std::invalid_argument);
+  EXPECT_THROW(
+      Map(AlignedBuffer(bytes.substr(0, bytes.size() - 1)).range()),
+      std::invalid_argument);
+
+  auto badMagic = bytes;
+  badMagic[0] ^= 1;
+  EXPECT_THROW(Map(AlignedBuffer(badMagic).range()), std::invalid_argument);
+
+  using Wider = F14FrozenMap<uint64_t, std::string_view>;
+  EXPECT_THROW(Wider(AlignedBuffer(bytes).range()), std::invalid_argument);
+
+  struct OtherHasher {
+    std::size_t operator()(uint64_t key) const {
+      return ~hasher<uint64_t>{}(key);
+    }
+  };
+  using Rehashed = F14FrozenMap<uint64_t, uint64_t, OtherHasher>;
+  EXPECT_THROW(Rehashed(AlignedBuffer(bytes).range()), std::invalid_argument);
+}
+
+TEST(F14FrozenMap, memoryMapping) {
+  F14FastMap<std::string, uint64_t> source;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    source[std::to_string(i)] = i;
+  }
+  test::TemporaryFile file;
+  ASSERT_TRUE(writeFile(
+      F14FrozenMap<std::string_view, uint64_t>::serialize(source),
+      file.path().string().c_str()));
+
+  MemoryMapping mapping(file.path().string().c_str());
+  F14FrozenMap<std::string_view, uint64_t> map(mapping.range());
+  EXPECT_EQ(source.size(), map.size());
+  for (auto const& [key, value] : source) {
+    EXPECT_EQ(value, map.at(key));
+  }
+}
+
+#endif // FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
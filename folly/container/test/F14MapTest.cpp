@@ -923,6 +923,66 @@ TEST(F14FastMap, prehash) {
   runPrehash<F14FastMap<std::string, std::string>>();
 }
 
+template <typename T>
+void runFindMany() {
+  T h;
+  std::vector<std::string> keys;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(folly::to<std::string>(i));
+    if (i % 3 != 0) {
+      h[keys.back()] = folly::to<std::string>(-i);
+    }
+  }
+
+  std::size_t visited = 0;
+  h.findMany(keys.begin(), keys.end(), [&](auto const& key, auto it) {
+    // Keys are visited in order.
+    EXPECT_EQ(keys[visited], key);
+    EXPECT_TRUE(it == h.find(key));
+    if (it != h.end()) {
+      EXPECT_EQ(it->second, "-" + key);
+      it->second += "!";
+    }
+    ++visited;
+  });
+  EXPECT_EQ(keys.size(), visited);
+  EXPECT_EQ(h.find("1")->second, "-1!");
+
+  // Heterogeneous keys, const map, and ranges shorter than the lookahead.
+  T const& ch = h;
+  std::vector<folly::StringPiece> pieces = {"1", "3", "4"};
+  std::vector<bool> found;
+  ch.findMany(pieces.begin(), pieces.end(), [&](auto, auto it) {
+    found.push_back(it != ch.end());
+  });
+  EXPECT_EQ((std::vector<bool>{true, false, true}), found);
+  ch.findMany(pieces.end(), pieces.end(), [&](auto, auto) { ADD_FAILURE(); });
+
+  T empty;
+  visited = 0;
+  empty.findMany(keys.begin(), keys.end(), [&](auto const&, auto it) {
+    EXPECT_TRUE(it == empty.end());
+    ++visited;
+  });
+  EXPECT_EQ(keys.size(), visited);
+}
+
+TEST(F14ValueMap, findMany) {
+  runFindMany<F14ValueMap<std::string, std::string>>();
+}
+
+TEST(F14NodeMap, findMany) {
+  runFindMany<F14NodeMap<std::string, std::string>>();
+}
+
+TEST(F14VectorMap, findMany) {
+  runFindMany<F14VectorMap<std::string, std::string>>();
+}
+
+TEST(F14FastMap, findMany) {
+  runFindMany<F14FastMap<std::string, std::string>>();
+}
+
 TEST(F14ValueMap, random) {
   runRandom<F14ValueMap<
       uint64_t,
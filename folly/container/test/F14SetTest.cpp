@@ -717,6 +717,45 @@ TEST(F14FastSet, simple) {
   runSimple<F14FastSet<std::string>>();
 }
 
+template <typename T>
+void runFindMany() {
+  T h;
+  std::vector<int> keys(1000);
+  std::iota(keys.begin(), keys.end(), 0);
+  for (auto k : keys) {
+    if (k % 3 != 0) {
+      h.insert(k);
+    }
+  }
+  std::size_t visited = 0;
+  h.findMany(keys.begin(), keys.end(), [&](int key, auto it) {
+    EXPECT_EQ(keys[visited++], key);
+    if (key % 3 != 0) {
+      ASSERT_TRUE(it != h.end());
+      EXPECT_EQ(key, *it);
+    } else {
+      EXPECT_TRUE(it == h.end());
+    }
+  });
+  EXPECT_EQ(keys.size(), visited);
+}
+
+TEST(F14ValueSet, findMany) {
+  runFindMany<F14ValueSet<int>>();
+}
+
+TEST(F14NodeSet, findMany) {
+  runFindMany<F14NodeSet<int>>();
+}
+
+TEST(F14VectorSet, findMany) {
+  runFindMany<F14VectorSet<int>>();
+}
+
+TEST(F14FastSet, findMany) {
+  runFindMany<F14FastSet<int>>();
+}
+
 #if FOLLY_HAS_MEMORY_RESOURCE
 TEST(F14ValueSet, pmrSimple) {
   runSimple<pmr::F14ValueSet<std::string>>();
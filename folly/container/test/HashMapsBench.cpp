@@ -17,6 +17,8 @@
 #include <cstddef>
 #include <functional>
 #include <map>
+#include <memory>
+#include <random>
 #include <string>
 #include <unordered_map>
 
@@ -47,6 +49,13 @@ DEFINE_int32(
     "max number of entries to benchmark each map with (inclusive)");
 DEFINE_int32(
     map_size_step, 32, "multiplier for each benchmark between iterations");
+DEFINE_int32(
+    find_many_size_max,
+    1 << 25,
+    "max number of entries in the find vs findMany benchmarks, which start "
+    "at 1M entries and grow by 8x; the default is well beyond most LLCs");
+DEFINE_int32(
+    find_many_batch, 256, "number of keys passed to each findMany call");
 
 //////// Key related preparation ////////
 
@@ -365,6 +374,111 @@ template <class K, class V>
 using f14node = F14NodeMap<K, V>;
 template <class K, class V>
 using f14vec = F14VectorMap<K, V>;
+template <class K, class V>
+using f14fast = F14FastMap<K, V>;
+
+//////// find vs findMany on maps that don't fit in cache ////////
+
+// Building a map of tens of millions of entries takes seconds, so the last
+// one is kept around for the next benchmark of the same map type and size.
+template <class Map>
+struct LookupFixture {
+  int size = 0;
+  Map map;
+  std::vector<uint64_t> keys;
+};
+
+template <class Map>
+LookupFixture<Map> const& lookupFixture(int size) {
+  static std::unique_ptr<LookupFixture<Map>> fixture;
+  if (!fixture || fixture->size != size) {
+    fixture.reset();
+    fixture = std::make_unique<LookupFixture<Map>>();
+    fixture->size = size;
+    fixture->map.reserve(size);
+    for (int i = 0; i < size; ++i) {
+      fixture->map.emplace(hash::twang_mix64(i), i);
+    }
+    // Enough random hits that the key list itself doesn't stay in L1/L2.
+    std::mt19937_64 rng(size);
+    std::uniform_int_distribution<int> dist(0, size - 1);
+    fixture->keys.resize(1 << 20);
+    for (auto& k : fixture->keys) {
+      k = hash::twang_mix64(dist(rng));
+    }
+  }
+  return *fixture;
+}
+
+// Both variants report the time per looked up key.
+template <class Map>
+void benchmarkLookupSerial(int iters, int size) {
+  BenchmarkSuspender braces;
+  auto const& fixture = lookupFixture<Map>(size);
+  auto const& keys = fixture.keys;
+  auto const mask = keys.size() - 1;
+  uint64_t x = 0;
+  braces.dismissing([&] {
+    for (int i = 0; i < iters; ++i) {
+      auto found = fixture.map.find(keys[i & mask]);
+      x ^= found->second;
+    }
+  });
+  folly::doNotOptimizeAway(x);
+}
+
+template <class Map>
+void benchmarkLookupBatched(int iters, int size) {
+  BenchmarkSuspender braces;
+  auto const& fixture = lookupFixture<Map>(size);
+  auto const& keys = fixture.keys;
+  auto const batch = std::size_t(FLAGS_find_many_batch);
+  uint64_t x = 0;
+  braces.dismissing([&] {
+    std::size_t offset = 0;
+    for (std::size_t done = 0; done < std::size_t(iters);) {
+      auto const n = std::min(batch, std::size_t(iters) - done);
+      if (offset + n > keys.size()) {
+        offset = 0;
+      }
+      auto const first = keys.begin() + offset;
+      fixture.map.findMany(first, first + n, [&](auto const&, auto found) {
+        x ^= found->second;
+      });
+      offset += n;
+      done += n;
+    }
+  });
+  folly::doNotOptimizeAway(x);
+}
+
+void runFindManyTests() {
+  for (int64_t n = 1 << 20; n <= FLAGS_find_many_size_max; n *= 8) {
+    auto const size = int(n);
+#define X(map)                                                               \
+  addBenchmark(                                                              \
+      __FILE__,                                                              \
+      folly::sformat(                                                        \
+          "Lookup {:>8}<uint64_t, uint64_t>[{}] find", #map, size),          \
+      [=](int iters) {                                                       \
+        benchmarkLookupSerial<map<uint64_t, uint64_t>>(iters, size);         \
+        return iters;                                                        \
+      });                                                                    \
+  addBenchmark(                                                              \
+      __FILE__,                                                              \
+      folly::sformat(                                                        \
+          "%Lookup {:>8}<uint64_t, uint64_t>[{}] findMany", #map, size),     \
+      [=](int iters) {                                                       \
+        benchmarkLookupBatched<map<uint64_t, uint64_t>>(iters, size);        \
+        return iters;                                                        \
+      });                                                                    \
+  addBenchmark(__FILE__, "-", [](int iters) { return iters; });
+
+    X(f14fast)
+    X(f14val)
+#undef X
+  }
+}
 
 void runAllHashMapTests() {
   using std::map;
@@ -453,6 +567,7 @@ int main(int argc, char** argv) {
       "bm_max_secs", "1", folly::gflags::SET_FLAG_IF_DEFAULT);
   LOG(INFO) << "Preparing benchmark...";
   runAllHashMapTests();
+  runFindManyTests();
   LOG(INFO) << "Running benchmark, which could take tens of minutes...";
   runBenchmarks();
   return 0;
@@ -798,3 +798,82 @@ TEST(WeightedEvictingCacheMap, PruneHook) {
   EXPECT_EQ(std::get<1>(prunedValues[1]), 5);
   EXPECT_EQ(std::get<2>(prunedValues[1]), 6);
 }
+
+namespace {
+template <class TPolicy>
+int weightedScanHits(std::size_t* prunedWeight = nullptr) {
+  WeightedEvictingCacheMap<
+      int,
+      int,
+      HeterogeneousAccessHash<int>,
+      HeterogeneousAccessEqualTo<int>,
+      TPolicy>
+      map(1000);
+  std::size_t pruned = 0;
+  map.setPruneHook([&](int, int&&, std::size_t weight) { pruned += weight; });
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < 40; ++i) {
+      map.set(i, i, 20);
+    }
+  }
+  EXPECT_EQ(800, map.getCurrentTotalWeight());
+  // A scan of keys that are each used once, interleaved with the hot keys,
+  // whose reuse distance exceeds what the cache can hold. Hot keys are
+  // reloaded on a miss.
+  int hits = 0;
+  std::size_t reloaded = 0;
+  for (int i = 0; i < 2000; ++i) {
+    int hot = i % 40;
+    if (map.find(hot) != map.end()) {
+      ++hits;
+    } else {
+      map.set(hot, hot, 20);
+      reloaded += 20;
+    }
+    map.set(1000 + i, i, 10);
+    EXPECT_LE(map.getCurrentTotalWeight(), 1000);
+  }
+  EXPECT_EQ(
+      800 + reloaded + 2000 * 10, map.getCurrentTotalWeight() + pruned);
+  if (prunedWeight) {
+    *prunedWeight = pruned;
+  }
+  return hits;
+}
+} // namespace
+
+TEST(WeightedEvictingCacheMap, TinyLfuScanResistance) {
+  int lruHits = weightedScanHits<LruEvictingCachePolicy>();
+  int tinyLfuHits = weightedScanHits<TinyLfuEvictingCachePolicy>();
+  EXPECT_LT(lruHits, 100);
+  EXPECT_GT(tinyLfuHits, 1500);
+}
+
+TEST(WeightedEvictingCacheMap, TinyLfuSetKeepsMainEntry) {
+  WeightedEvictingCacheMap<
+      int,
+      int,
+      HeterogeneousAccessHash<int>,
+      HeterogeneousAccessEqualTo<int>,
+      TinyLfuEvictingCachePolicy>
+      map(2);
+  map.set(1, 1, 1);
+  map.set(2, 2, 1);
+  // 2 is in the window and 1 in the main segment, at the back of the LRU.
+  EXPECT_EQ(2, map.begin()->first);
+  EXPECT_EQ(1, map.rbegin()->first);
+
+  // Promotion keeps 1 at the back of the LRU, behind the window, but the
+  // entry being set is never the one evicted.
+  map.set(1, 10, 2);
+  EXPECT_EQ(1, map.size());
+  EXPECT_EQ(10, map.get(1));
+  EXPECT_EQ(2, map.getCurrentTotalWeight());
+
+  // Same for a new entry that is heavier than everything else together.
+  map.set(2, 2, 1);
+  map.set(3, 3, 5);
+  EXPECT_EQ(1, map.size());
+  EXPECT_EQ(3, map.get(3));
+  EXPECT_EQ(5, map.getCurrentTotalWeight());
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/columnar_tape.h>
+
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+namespace {
+
+using rows_t = folly::columnar_tape<int64_t, folly::string_tape, double>;
+
+static_assert(rows_t::column_count == 3);
+static_assert(std::is_same_v<
+              decltype(std::declval<const rows_t&>().column<0>()),
+              folly::Range<const int64_t*>>);
+static_assert(std::is_same_v<
+              decltype(std::declval<const rows_t&>().column<1>()),
+              const folly::string_tape&>);
+
+TEST(ColumnarTape, Basic) {
+  rows_t rows;
+  EXPECT_TRUE(rows.empty());
+  EXPECT_EQ(rows.begin(), rows.end());
+
+  rows.push_back(1, "first", 0.5);
+  rows.push_back(2, std::string("second"), 1.5);
+  rows.emplace_back(3, std::vector<char>{'x'}, 2.5);
+
+  ASSERT_EQ(3, rows.size());
+  EXPECT_EQ(2, rows.get<0>(1));
+  EXPECT_EQ("second", rows.get<1>(1));
+  EXPECT_EQ(1.5, rows.get<2>(1));
+
+  auto [id, name, score] = rows[0];
+  EXPECT_EQ(1, id);
+  EXPECT_EQ("first", name);
+  EXPECT_EQ(0.5, score);
+
+  EXPECT_EQ("x", std::get<1>(rows.back()));
+  EXPECT_EQ(1, std::get<0>(rows.front()));
+  EXPECT_THROW((void)rows.at(3), std::out_of_range);
+
+  EXPECT_THAT(rows.column<0>(), testing::ElementsAre(1, 2, 3));
+  EXPECT_THAT(rows.column<1>(), testing::ElementsAre("first", "second", "x"));
+  EXPECT_EQ(
+      4.5,
+      std::accumulate(rows.column<2>().begin(), rows.column<2>().end(), 0.0));
+
+  std::vector<int64_t> ids;
+  for (auto record : rows) {
+    ids.push_back(std::get<0>(record));
+  }
+  EXPECT_THAT(ids, testing::ElementsAre(1, 2, 3));
+
+  rows.pop_back();
+  EXPECT_EQ(2, rows.size());
+  EXPECT_EQ(2, rows.column<1>().size());
+  EXPECT_EQ("second", std::get<1>(rows.back()));
+
+  rows.clear();
+  EXPECT_TRUE(rows.empty());
+  EXPECT_TRUE(rows.column<1>().empty());
+}
+
+TEST(ColumnarTape, Append) {
+  std::vector<int64_t> ids{1, 2, 3};
+  std::vector<std::string> names{"a", "bb", "ccc"};
+  double scores[] = {0.1, 0.2, 0.3};
+
+  rows_t rows;
+  rows.reserve(6);
+  rows.append(ids, names, scores);
+  rows.append(ids, names, scores);
+  ASSERT_EQ(6, rows.size());
+  EXPECT_THAT(rows.column<0>(), testing::ElementsAre(1, 2, 3, 1, 2, 3));
+  EXPECT_EQ("ccc", rows.get<1>(5));
+  EXPECT_EQ(0.2, rows.get<2>(4));
+
+  std::vector<int64_t> tooShort{1};
+  EXPECT_THROW(rows.append(tooShort, names, scores), std::invalid_argument);
+  EXPECT_EQ(6, rows.size());
+
+  rows_t pushed;
+  for (int i = 0; i < 2; ++i) {
+    for (std::size_t j = 0; j < ids.size(); ++j) {
+      pushed.push_back(ids[j], names[j], scores[j]);
+    }
+  }
+  EXPECT_EQ(pushed, rows);
+  pushed.pop_back();
+  EXPECT_NE(pushed, rows);
+}
+
+TEST(ColumnarTape, MutableColumn) {
+  folly::columnar_tape<int, float> rows;
+  rows.append(std::vector<int>{1, 2, 3}, std::vector<float>{1, 2, 3});
+  for (auto& x : rows.mutable_column<0>()) {
+    x *= 10;
+  }
+  EXPECT_THAT(rows.column<0>(), testing::ElementsAre(10, 20, 30));
+  EXPECT_THAT(rows.column<1>(), testing::ElementsAre(1, 2, 3));
+}
+
+TEST(ColumnarTape, IntTapeField) {
+  folly::columnar_tape<folly::tape<std::vector<int>>, char> rows;
+  rows.push_back(std::vector<int>{1, 2}, 'a');
+  rows.push_back(std::initializer_list<int>{}, 'b');
+  ASSERT_EQ(2, rows.size());
+  EXPECT_THAT(rows.get<0>(0), testing::ElementsAre(1, 2));
+  EXPECT_TRUE(rows.get<0>(1).empty());
+  EXPECT_EQ(2, rows.column<0>().size_flat());
+}
+
+// Converts to any field type, or throws if poisoned.
+struct Poisonable {
+  int value;
+  bool poisoned = false;
+
+  template <typename T>
+  operator T() const {
+    if (poisoned) {
+      throw std::runtime_error("poisoned");
+    }
+    return T(value);
+  }
+};
+
+TEST(ColumnarTape, ExceptionSafety) {
+  folly::columnar_tape<folly::tape<std::vector<int>>, int64_t, double> rows;
+  rows.push_back(std::vector<int>{1}, 1, 0.5);
+
+  // The last field throws after the others were appended.
+  EXPECT_THROW(
+      rows.push_back(std::vector<int>{2}, 2, Poisonable{2, true}),
+      std::runtime_error);
+  // A variable-length field throws part-way through its record.
+  std::vector<Poisonable> elements{{3}, {3, true}};
+  EXPECT_THROW(rows.push_back(elements, 3, 3.5), std::runtime_error);
+  // A column throws part-way through an append.
+  std::vector<std::vector<int>> records{{4}, {5}};
+  std::vector<Poisonable> ids{{4}, {5, true}};
+  EXPECT_THROW(
+      rows.append(records, ids, std::vector<double>{4.5, 5.5}),
+      std::runtime_error);
+
+  ASSERT_EQ(1, rows.size());
+  EXPECT_EQ(1, rows.column<0>().size());
+  EXPECT_EQ(1, rows.column<0>().size_flat());
+  EXPECT_EQ(1, rows.column<1>().size());
+  EXPECT_EQ(1, rows.column<2>().size());
+
+  rows.push_back(std::vector<int>{6, 7}, 6, 6.5);
+  ASSERT_EQ(2, rows.size());
+  EXPECT_THAT(rows.get<0>(1), testing::ElementsAre(6, 7));
+  EXPECT_THAT(rows.column<1>(), testing::ElementsAre(1, 6));
+  EXPECT_THAT(rows.column<2>(), testing::ElementsAre(0.5, 6.5));
+}
+
+} // namespace
@@ -1772,3 +1772,38 @@ TEST(HeapVectorTypes, TestGetContainer) {
   heap_vector_set<int> s;
   EXPECT_TRUE(s.get_container().empty());
 }
+
+TEST(HeapVectorTypes, TestCreationFromSortedRange) {
+  for (int size : {0, 1, 2, 7, 8, 100}) {
+    std::vector<std::pair<int, int>> sorted;
+    for (int i = 0; i < size; ++i) {
+      sorted.emplace_back(i * 10, i);
+    }
+    heap_vector_map<int, int> m(
+        folly::sorted_unique, sorted.begin(), sorted.end());
+    heap_vector_map<int, int> expected(sorted.begin(), sorted.end());
+    EXPECT_EQ(expected.get_container(), m.get_container());
+    EXPECT_TRUE(std::equal(m.begin(), m.end(), sorted.begin(), sorted.end()));
+  }
+
+  // Elements that are not default constructible are heapified after copy.
+  struct NoDefault {
+    explicit NoDefault(int v) : value(v) {}
+    bool operator<(const NoDefault& other) const {
+      return value < other.value;
+    }
+    int value;
+  };
+  std::vector<NoDefault> sorted;
+  for (int i = 0; i < 7; ++i) {
+    sorted.emplace_back(i);
+  }
+  heap_vector_set<NoDefault> s(
+      folly::sorted_unique, sorted.begin(), sorted.end());
+  EXPECT_EQ(3, s.get_container()[0].value);
+  int next = 0;
+  for (auto& v : s) {
+    EXPECT_EQ(next++, v.value);
+  }
+  EXPECT_EQ(7, next);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/sorted_vector_bulk.h>
+
+#include <utility>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Random.h>
+#include <folly/container/heap_vector_types.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/init/Init.h>
+
+namespace {
+
+using pairs_t = std::vector<std::pair<int, int>>;
+
+pairs_t sortedPairs(std::size_t n) {
+  pairs_t pairs;
+  pairs.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    pairs.emplace_back(int(i), int(i));
+  }
+  return pairs;
+}
+
+pairs_t randomPairs(std::size_t n) {
+  pairs_t pairs;
+  pairs.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    pairs.emplace_back(int(folly::Random::rand32()), int(i));
+  }
+  return pairs;
+}
+
+// Sorted input laid out in heap order in place, by following the cycles of
+// the permutation.
+void heapifyInPlace(std::size_t iters, std::size_t n) {
+  folly::BenchmarkSuspender susp;
+  for (std::size_t i = 0; i < iters; ++i) {
+    auto pairs = sortedPairs(n);
+    susp.dismiss();
+    folly::heap_vector_map<int, int> map(
+        folly::sorted_unique, std::move(pairs));
+    folly::doNotOptimizeAway(map.size());
+    susp.rehire();
+  }
+}
+
+// Sorted input copied straight to heap order by the (sorted_unique, first,
+// last) constructor.
+void copySortedAsHeap(std::size_t iters, std::size_t n) {
+  folly::BenchmarkSuspender susp;
+  auto const pairs = sortedPairs(n);
+  for (std::size_t i = 0; i < iters; ++i) {
+    susp.dismiss();
+    folly::heap_vector_map<int, int> map(
+        folly::sorted_unique, pairs.begin(), pairs.end());
+    folly::doNotOptimizeAway(map.size());
+    susp.rehire();
+  }
+}
+
+void parallelBuild(std::size_t iters, std::size_t n, std::size_t tasks) {
+  folly::BenchmarkSuspender susp;
+  folly::CPUThreadPoolExecutor executor(tasks);
+  for (std::size_t i = 0; i < iters; ++i) {
+    auto pairs = randomPairs(n);
+    susp.dismiss();
+    auto map =
+        folly::parallel_build_sorted_vector<folly::sorted_vector_map<int, int>>(
+            std::move(pairs), folly::getKeepAliveToken(executor), tasks);
+    folly::doNotOptimizeAway(map.size());
+    susp.rehire();
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(heapifyInPlace, 1k, 1000)
+BENCHMARK_RELATIVE_NAMED_PARAM(copySortedAsHeap, 1k, 1000)
+BENCHMARK_NAMED_PARAM(heapifyInPlace, 1m, 1000000)
+BENCHMARK_RELATIVE_NAMED_PARAM(copySortedAsHeap, 1m, 1000000)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(parallelBuild, 1m_1task, 1000000, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(parallelBuild, 1m_4tasks, 1000000, 4)
+BENCHMARK_NAMED_PARAM(parallelBuild, 10m_1task, 10000000, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(parallelBuild, 10m_4tasks, 10000000, 4)
+BENCHMARK_DRAW_LINE();
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::Init init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
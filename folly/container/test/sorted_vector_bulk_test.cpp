@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/sorted_vector_bulk.h>
+
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <folly/Random.h>
+#include <folly/container/heap_vector_types.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/InlineExecutor.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+
+namespace {
+
+std::vector<std::pair<int, int>> randomPairs(size_t n, int maxKey) {
+  std::vector<std::pair<int, int>> pairs;
+  pairs.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    pairs.emplace_back(Random::rand32(maxKey), int(i));
+  }
+  return pairs;
+}
+
+template <class Map>
+void checkParallelBuild(Executor::KeepAlive<> executor, size_t tasks) {
+  for (size_t n : {0, 1, 1000, 100000, 300001}) {
+    auto pairs = randomPairs(n, int(n / 2 + 1));
+    Map expected(pairs.begin(), pairs.end());
+    auto map = parallel_build_sorted_vector<Map>(
+        std::move(pairs), executor, tasks);
+    ASSERT_EQ(expected.size(), map.size());
+    auto it = expected.begin();
+    for (auto& [k, v] : map) {
+      EXPECT_EQ(it->first, k);
+      ++it;
+    }
+  }
+}
+
+TEST(SortedVectorBulk, ParallelBuild) {
+  CPUThreadPoolExecutor executor(4);
+  checkParallelBuild<sorted_vector_map<int, int>>(
+      getKeepAliveToken(executor), 0);
+  checkParallelBuild<sorted_vector_map<int, int>>(
+      getKeepAliveToken(executor), 7);
+  checkParallelBuild<heap_vector_map<int, int>>(
+      getKeepAliveToken(executor), 4);
+  checkParallelBuild<sorted_vector_map<int, int>>(
+      getKeepAliveToken(InlineExecutor::instance()), 8);
+}
+
+TEST(SortedVectorBulk, ParallelBuildFromExecutorThread) {
+  // The only thread of the executor builds, so none of the tasks it adds can
+  // start until it is done.
+  CPUThreadPoolExecutor executor(1);
+  auto pairs = randomPairs(300000, 1000);
+  Baton<> built;
+  size_t size = 0;
+  executor.add([&] {
+    size = parallel_build_sorted_vector<sorted_vector_map<int, int>>(
+               std::move(pairs), getKeepAliveToken(executor), 4)
+               .size();
+    built.post();
+  });
+  ASSERT_TRUE(built.try_wait_for(std::chrono::seconds(60)));
+  EXPECT_EQ(1000, size);
+}
+
+TEST(SortedVectorBulk, ParallelBuildCompare) {
+  CPUThreadPoolExecutor executor(2);
+  std::vector<int> values(100000);
+  for (auto& v : values) {
+    v = Random::rand32(1000);
+  }
+  auto set = parallel_build_sorted_vector<
+      sorted_vector_set<int, std::greater<int>>>(
+      std::move(values), getKeepAliveToken(executor), 4);
+  EXPECT_EQ(1000, set.size());
+  EXPECT_EQ(999, *set.begin());
+  EXPECT_TRUE(std::is_sorted(set.begin(), set.end(), std::greater<int>()));
+}
+
+TEST(SortedVectorBulk, ParallelBuildException) {
+  struct Throwing {
+    bool operator()(int a, int b) const {
+      if (a == -1 || b == -1) {
+        throw std::runtime_error("compare");
+      }
+      return a < b;
+    }
+  };
+  CPUThreadPoolExecutor executor(2);
+  std::vector<int> values(100000);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = int(i);
+  }
+  values.back() = -1;
+  EXPECT_THROW(
+      (parallel_build_sorted_vector<sorted_vector_set<int, Throwing>>(
+          std::move(values), getKeepAliveToken(executor), 4)),
+      std::runtime_error);
+}
+
+TEST(SortedVectorBulk, Merge) {
+  using Map = sorted_vector_map<int, std::string>;
+  Map a{{1, "a1"}, {3, "a3"}, {5, "a5"}};
+  Map b{{1, "b1"}, {2, "b2"}, {6, "b6"}};
+  Map empty;
+  Map c{{0, "c0"}, {5, "c5"}, {7, "c7"}};
+
+  auto merged =
+      sorted_vector_merge<Map>(std::vector<const Map*>{&a, &b, &empty, &c});
+  EXPECT_THAT(
+      merged,
+      testing::ElementsAre(
+          std::pair<int, std::string>(0, "c0"),
+          std::pair<int, std::string>(1, "a1"),
+          std::pair<int, std::string>(2, "b2"),
+          std::pair<int, std::string>(3, "a3"),
+          std::pair<int, std::string>(5, "a5"),
+          std::pair<int, std::string>(6, "b6"),
+          std::pair<int, std::string>(7, "c7")));
+
+  auto reversed = sorted_vector_merge<Map>(std::vector<Map>{c, b, a});
+  EXPECT_EQ("b1", reversed.at(1));
+  EXPECT_EQ("c5", reversed.at(5));
+
+  EXPECT_TRUE(sorted_vector_merge<Map>(std::vector<Map>{}).empty());
+}
+
+TEST(SortedVectorBulk, MergeMany) {
+  std::vector<heap_vector_set<int>> inputs(20);
+  sorted_vector_set<int> expected;
+  for (auto& input : inputs) {
+    for (int i = 0; i < 500; ++i) {
+      auto v = int(Random::rand32(5000));
+      input.insert(v);
+      expected.insert(v);
+    }
+  }
+  auto merged = sorted_vector_merge<sorted_vector_set<int>>(inputs);
+  EXPECT_EQ(expected, merged);
+  auto heap = sorted_vector_merge<heap_vector_set<int>>(inputs);
+  EXPECT_TRUE(
+      std::equal(heap.begin(), heap.end(), expected.begin(), expected.end()));
+}
+
+} // namespace
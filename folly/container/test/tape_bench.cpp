@@ -16,10 +16,12 @@
 
 #include <folly/container/tape.h>
 
+#include <numeric>
 #include <random>
 #include <string>
 #include <vector>
 #include <folly/Benchmark.h>
+#include <folly/container/columnar_tape.h>
 #include <folly/init/Init.h>
 
 namespace {
@@ -172,6 +174,112 @@ void iterateStrings(std::size_t iters) {
   iterateBenchImpl(copies, iters);
 }
 
+// Scans over one field of many records, as an analytic query would do.
+
+struct Row {
+  std::int64_t id;
+  std::string name;
+  double score;
+};
+
+using rows_tape = folly::columnar_tape<std::int64_t, st_tape, double>;
+
+constexpr std::size_t kScanRows = 1'000'000;
+
+const std::vector<Row>& scanRowsVec() {
+  static const std::vector<Row> res = [] {
+    ContGenerator<std::string> gen{0, 32};
+    std::vector<Row> r;
+    r.reserve(kScanRows);
+    for (std::size_t i = 0; i != kScanRows; ++i) {
+      r.push_back({std::int64_t(i), gen(), double(i % 100)});
+    }
+    return r;
+  }();
+  return res;
+}
+
+const rows_tape& scanRowsTape() {
+  static const rows_tape res = [] {
+    rows_tape r;
+    r.reserve(kScanRows);
+    for (const auto& row : scanRowsVec()) {
+      r.push_back(row.id, row.name, row.score);
+    }
+    return r;
+  }();
+  return res;
+}
+
+void scanScoresVec(std::size_t iters) {
+  const auto& rows = scanRowsVec();
+  while (iters--) {
+    double sum = 0;
+    for (const auto& row : rows) {
+      sum += row.score;
+    }
+    folly::doNotOptimizeAway(sum);
+  }
+}
+
+void scanScoresTape(std::size_t iters) {
+  const auto& rows = scanRowsTape();
+  while (iters--) {
+    auto scores = rows.column<2>();
+    folly::doNotOptimizeAway(std::reduce(scores.begin(), scores.end(), 0.0));
+  }
+}
+
+void scanNameLengthsVec(std::size_t iters) {
+  const auto& rows = scanRowsVec();
+  while (iters--) {
+    std::size_t sum = 0;
+    for (const auto& row : rows) {
+      sum += row.name.size();
+    }
+    folly::doNotOptimizeAway(sum);
+  }
+}
+
+void scanNameLengthsTape(std::size_t iters) {
+  const auto& rows = scanRowsTape();
+  while (iters--) {
+    std::size_t sum = 0;
+    for (auto name : rows.column<1>()) {
+      sum += name.size();
+    }
+    folly::doNotOptimizeAway(sum);
+  }
+}
+
+void appendRowsTape(std::size_t iters) {
+  const auto& vec = scanRowsVec();
+  std::vector<std::int64_t> ids;
+  std::vector<std::string> names;
+  std::vector<double> scores;
+  for (std::size_t i = 0; i != 1000; ++i) {
+    ids.push_back(vec[i].id);
+    names.push_back(vec[i].name);
+    scores.push_back(vec[i].score);
+  }
+  while (iters--) {
+    rows_tape r;
+    r.append(ids, names, scores);
+    folly::doNotOptimizeAway(r);
+  }
+}
+
+void pushBackRowsTape(std::size_t iters) {
+  const auto& vec = scanRowsVec();
+  while (iters--) {
+    rows_tape r;
+    for (std::size_t i = 0; i != 1000; ++i) {
+      r.push_back(vec[i].id, vec[i].name, vec[i].score);
+    }
+    folly::doNotOptimizeAway(r);
+  }
+}
+
 // Disabling clang format for table formatting
 // clang-format off
 BENCHMARK(IterateVecIntsCacheMiss_20_0_15,     n) { iterateInts   <vv_int,  20, 0, 15>(n); }
@@ -189,6 +297,13 @@ BENCHMARK(ConstructTapeLargeStrings_20_16_32, n) { constructorStrings<st_tape, 2
 BENCHMARK_DRAW_LINE();
 BENCHMARK(ConstructVec2SmallStrings,    n) { constructorStrings<vec_str, 2, 0, 15>(n); }
 BENCHMARK(ConstructTape2SmallStrings,   n) { constructorStrings<st_tape, 2, 0, 15>(n); }
+BENCHMARK_DRAW_LINE();
+BENCHMARK(ScanScoresVecOfStructs,        n) { scanScoresVec(n); }
+BENCHMARK(ScanScoresColumnarTape,        n) { scanScoresTape(n); }
+BENCHMARK(ScanNameLengthsVecOfStructs,   n) { scanNameLengthsVec(n); }
+BENCHMARK(ScanNameLengthsColumnarTape,   n) { scanNameLengthsTape(n); }
+BENCHMARK(PushBack1000RowsColumnarTape,  n) { pushBackRowsTape(n); }
+BENCHMARK(Append1000RowsColumnarTape,    n) { appendRowsTape(n); }
 // clang-format on
 
 } // namespace
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <folly/lang/Align.h>
+#include <folly/portability/Asm.h>
+#include <folly/synchronization/RelaxedAtomic.h>
+
+namespace folly {
+
+/**
+ * AdaptiveIdleSpin decides how long an idle worker of a thread pool spins,
+ * polling the task queue, before it parks on the queue's semaphore.
+ *
+ * Spinning trades CPU time for latency: a worker that finds a task while
+ * spinning saves the cost of a park and an unpark, but a spin that ends
+ * without a task is wasted CPU. A fixed budget suits neither a pool whose
+ * tasks arrive microseconds apart nor one whose tasks arrive milliseconds
+ * apart, so the budget here follows the arrival gaps of the pool: an idle
+ * worker spins for a few mean gaps, within [minSpin, maxSpin], and only if
+ * the next task can be expected within maxSpin. In particular, a worker
+ * going idle after the stream of tasks stopped for longer than maxSpin parks
+ * right away.
+ *
+ * On a single CPU a spinning worker only delays the producer it waits for,
+ * so workers never spin there.
+ *
+ * Arrivals are recorded by the producers, with an atomic exchange on a
+ * shared timestamp, which only pools that enable the policy pay for.
+ */
+class AdaptiveIdleSpin {
+ public:
+  struct Options {
+    constexpr Options() noexcept {}
+
+    // Bounds of the spin of an idle worker.
+    std::chrono::nanoseconds minSpin{0};
+    std::chrono::nanoseconds maxSpin{std::chrono::microseconds{50}};
+    // The spin covers this many mean arrival gaps.
+    double gapsPerSpin{2.0};
+  };
+
+  struct Stats {
+    // Idle workers that found a task while spinning.
+    uint64_t spinHits{0};
+    // Times idle workers blocked after spinning, and times they took a task
+    // after blocking, rather than timing out, stopping or blocking again.
+    uint64_t parks{0};
+    uint64_t unparks{0};
+    // Total time spent spinning, including spins that ended in a park.
+    std::chrono::nanoseconds spinTime{0};
+    // The current estimates.
+    std::chrono::nanoseconds meanArrivalGap{0};
+    std::chrono::nanoseconds spinBudget{0};
+  };
+
+  explicit AdaptiveIdleSpin(Options options = {})
+      : options_(options),
+        canSpin_(std::thread::hardware_concurrency() != 1) {}
+
+  // Called by producers when n tasks are added at once.
+  void recordArrivals(size_t n = 1) noexcept {
+    if (n == 0) {
+      return;
+    }
+    auto const now = nowNanos();
+    auto const last = lastArrival_.exchange(now, std::memory_order_relaxed);
+    if (last == 0 || now <= last) {
+      return;
+    }
+    // Moving average with a weight of 1/8 for the latest gap. Concurrent
+    // updates may be lost, which only delays the estimate.
+    auto const gap = static_cast<int64_t>((now - last) / n);
+    auto const mean = static_cast<int64_t>(meanGap_.load());
+    meanGap_.store(static_cast<uint64_t>(mean + (gap - mean) / 8));
+  }
+
+  std::chrono::nanoseconds spinBudget() const noexcept {
+    if (!canSpin_) {
+      return std::chrono::nanoseconds(0);
+    }
+    auto const last = lastArrival_.load(std::memory_order_relaxed);
+    if (last == 0) {
+      return options_.minSpin;
+    }
+    auto const now = nowNanos();
+    auto const sinceLast = now > last ? now - last : 0;
+    auto const gap = std::max(meanGap_.load(), sinceLast);
+    if (gap > static_cast<uint64_t>(options_.maxSpin.count())) {
+      return options_.minSpin;
+    }
+    auto const spin = std::chrono::nanoseconds(
+        static_cast<int64_t>(static_cast<double>(gap) * options_.gapsPerSpin));
+    return std::clamp(spin, options_.minSpin, options_.maxSpin);
+  }
+
+  // Polls tryTake() until it returns a task, tested by conversion to bool,
+  // or the spin budget is exhausted, and returns its last result.
+  template <typename TryTake>
+  auto spin(TryTake&& tryTake) {
+    auto result = tryTake();
+    if (result) {
+      return result;
+    }
+    auto const budget = spinBudget();
+    if (budget.count() <= 0) {
+      return result;
+    }
+    auto const start = std::chrono::steady_clock::now();
+    auto const deadline = start + budget;
+    auto now = start;
+    do {
+      asm_volatile_pause();
+      result = tryTake();
+      now = std::chrono::steady_clock::now();
+    } while (!result && now < deadline);
+    spinNanos_ += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - start)
+            .count());
+    if (result) {
+      spinHits_ += 1;
+    }
+    return result;
+  }
+
+  // Called by a worker before it blocks on the semaphore of the queue, and
+  // when it takes a task after blocking.
+  void recordPark() noexcept { parks_ += 1; }
+  void recordUnpark() noexcept { unparks_ += 1; }
+
+  Stats getStats() const noexcept {
+    Stats stats;
+    stats.spinHits = spinHits_;
+    stats.parks = parks_;
+    stats.unparks = unparks_;
+    stats.spinTime = std::chrono::nanoseconds(spinNanos_.load());
+    stats.meanArrivalGap = std::chrono::nanoseconds(meanGap_.load());
+    stats.spinBudget = spinBudget();
+    return stats;
+  }
+
+ private:
+  static uint64_t nowNanos() noexcept {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+
+  Options const options_;
+  bool const canSpin_;
+
+  // Written by producers.
+  alignas(cacheline_align_v) std::atomic<uint64_t> lastArrival_{0};
+  relaxed_atomic<uint64_t> meanGap_{0};
+
+  // Written by idle workers.
+  alignas(cacheline_align_v) relaxed_atomic<uint64_t> spinHits_{0};
+  relaxed_atomic<uint64_t> parks_{0};
+  relaxed_atomic<uint64_t> unparks_{0};
+  relaxed_atomic<uint64_t> spinNanos_{0};
+};
+
+} // namespace folly
@@ -17,9 +17,15 @@
 #include <folly/Executor.h>
 #include <folly/executors/CPUThreadPoolExecutor.h>
 
+#include <algorithm>
 #include <atomic>
+#include <vector>
+
 #include <folly/Memory.h>
 #include <folly/Optional.h>
+#include <folly/ScopeGuard.h>
+#include <folly/SharedMutex.h>
+#include <folly/concurrency/WorkStealingDeque.h>
 #include <folly/executors/QueueObserver.h>
 #include <folly/executors/task_queue/PriorityLifoSemMPMCQueue.h>
 #include <folly/executors/task_queue/PriorityUnboundedBlockingQueue.h>
@@ -41,6 +47,72 @@ namespace folly {
 
 const size_t CPUThreadPoolExecutor::kDefaultMaxQueueSize = 1 << 14;
 
+// The local deques of the workers, in work-stealing mode. Deques hold
+// heap-allocated tasks, as they only hold trivially copyable elements.
+struct CPUThreadPoolExecutor::WorkStealing {
+  struct Worker {
+    explicit Worker(WorkStealing& o) : owner{&o} {}
+
+    WorkStealing* const owner;
+    WorkStealingDeque<CPUTask*> deque;
+    // Where the next steal starts, so that thieves spread over victims.
+    size_t nextVictim{0};
+  };
+
+  static folly::Optional<CPUTask> unwrap(CPUTask* ptr) {
+    std::unique_ptr<CPUTask> task{ptr};
+    return std::move(*task);
+  }
+
+  static folly::Optional<CPUTask> pop(Worker& worker) {
+    if (auto ptr = worker.deque.pop()) {
+      return unwrap(*ptr);
+    }
+    return folly::none;
+  }
+
+  folly::Optional<CPUTask> steal(Worker& self) {
+    std::shared_lock r{workersLock};
+    auto const n = workers.size();
+    auto const start = self.nextVictim++;
+    for (size_t i = 0; i < n; ++i) {
+      auto& victim = *workers[(start + i) % n];
+      if (&victim == &self) {
+        continue;
+      }
+      // Steals fail spuriously when racing with other thieves.
+      while (!victim.deque.empty()) {
+        if (auto ptr = victim.deque.steal()) {
+          return unwrap(*ptr);
+        }
+      }
+    }
+    return folly::none;
+  }
+
+  size_t size() const {
+    std::shared_lock r{workersLock};
+    size_t size = 0;
+    for (auto* worker : workers) {
+      size += worker->deque.size();
+    }
+    return size;
+  }
+
+  // The worker of the calling thread, if it is a worker of a pool in
+  // work-stealing mode.
+  static thread_local Worker* current;
+
+  mutable SharedMutex workersLock;
+  std::vector<Worker*> workers;
+  // Workers about to block on the shared queue. Tasks added locally while
+  // there are any are handed over through the shared queue, to wake one.
+  std::atomic<size_t> idleWorkers{0};
+};
+
+thread_local CPUThreadPoolExecutor::WorkStealing::Worker*
+    CPUThreadPoolExecutor::WorkStealing::current = nullptr;
+
 CPUThreadPoolExecutor::CPUTask::CPUTask(
     Func&& f,
     std::chrono::milliseconds expiration,
@@ -118,7 +190,14 @@ CPUThreadPoolExecutor::CPUThreadPoolExecutor(
     : ThreadPoolExecutor(
           numThreads.first, numThreads.second, std::move(threadFactory)),
       taskQueue_(std::move(taskQueue)),
-      prohibitBlockingOnThreadPools_{opt.blocking} {
+      prohibitBlockingOnThreadPools_{opt.blocking},
+      maxDequeueBatch_{std::max<size_t>(opt.maxDequeueBatch, 1)} {
+  if (opt.workStealing) {
+    workStealing_ = std::make_unique<WorkStealing>();
+  }
+  if (opt.adaptiveIdleSpin) {
+    idleSpin_ = std::make_unique<AdaptiveIdleSpin>(opt.idleSpinOptions);
+  }
   setNumThreads(numThreads.first);
   if (numThreads.second == 0) {
     minThreads_.store(1, std::memory_order_relaxed);
@@ -237,6 +316,61 @@ void CPUThreadPoolExecutor::add(
       std::move(func), priority, expiration, std::move(expireCallback));
 }
 
+void CPUThreadPoolExecutor::addBatch(Range<Func*> funcs) {
+  if (workStealing_ && WorkStealing::current &&
+      WorkStealing::current->owner == workStealing_.get()) {
+    // Tasks go to the deque of the calling worker, one by one anyway.
+    for (auto& func : funcs) {
+      add(std::move(func));
+    }
+    return;
+  }
+
+  std::vector<CPUTask> tasks;
+  tasks.reserve(funcs.size());
+  auto const queueObserver = getQueueObserver(0);
+  for (auto& func : funcs) {
+    if (!func) {
+      invokeCatchingExns("ThreadPoolExecutor: func", std::move(func));
+      continue;
+    }
+    tasks.emplace_back(
+        std::move(func), std::chrono::milliseconds(0), Func(), int8_t(0));
+    if (queueObserver) {
+      tasks.back().queueObserverPayload_ =
+          queueObserver->onEnqueued(tasks.back().context_.get());
+    }
+    registerTaskEnqueue(tasks.back());
+  }
+  if (tasks.empty()) {
+    return;
+  }
+
+  // As in addImpl().
+  bool mayNeedToAddThreads = minThreads_.load(std::memory_order_relaxed) == 0 ||
+      activeThreads_.load(std::memory_order_relaxed) <
+          maxThreads_.load(std::memory_order_relaxed);
+  folly::Executor::KeepAlive<> ka = mayNeedToAddThreads
+      ? getKeepAliveToken(this)
+      : folly::Executor::KeepAlive<>{};
+
+  if (idleSpin_) {
+    idleSpin_->recordArrivals(tasks.size());
+  }
+  auto const result = taskQueue_->addBatch(range(tasks));
+
+  if (mayNeedToAddThreads && !result.reusedThread) {
+    // Start a thread per task that no idle thread was woken up for, up to
+    // the maximum.
+    for (size_t i = 0; i < tasks.size() &&
+         activeThreads_.load(std::memory_order_relaxed) <
+             maxThreads_.load(std::memory_order_relaxed);
+         ++i) {
+      ensureActiveThreads();
+    }
+  }
+}
+
 template <bool withPriority>
 void CPUThreadPoolExecutor::addImpl(
     Func func,
@@ -260,6 +394,14 @@ void CPUThreadPoolExecutor::addImpl(
   }
   registerTaskEnqueue(task);
 
+  if (!withPriority && workStealing_ && tryAddLocal(task)) {
+    return;
+  }
+
+  if (idleSpin_) {
+    idleSpin_->recordArrivals();
+  }
+
   // It's not safe to expect that the executor is alive after a task is added to
   // the queue (this task could be holding the last KeepAlive and when finished
   // - it may unblock the executor shutdown).
@@ -281,12 +423,130 @@ void CPUThreadPoolExecutor::addImpl(
   }
 }
 
+bool CPUThreadPoolExecutor::tryAddLocal(CPUTask& task) {
+  auto* const worker = WorkStealing::current;
+  if (!worker || worker->owner != workStealing_.get()) {
+    return false;
+  }
+  auto ptr = std::make_unique<CPUTask>(std::move(task));
+  worker->deque.push(ptr.get());
+  ptr.release();
+
+  // Pairs with the increment of idleWorkers in takeTask(): either an idle
+  // worker finds the task when it steals before blocking, or it is woken by
+  // a task handed over here. The executor is alive, as this thread runs one
+  // of its tasks.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (workStealing_->idleWorkers.load(std::memory_order_relaxed) > 0) {
+    if (auto handover = WorkStealing::pop(*worker)) {
+      auto result = taskQueue_->add(std::move(*handover));
+      if (!result.reusedThread) {
+        ensureActiveThreads();
+      }
+    }
+  } else if (
+      worker->deque.size() > 1 &&
+      activeThreads_.load(std::memory_order_relaxed) <
+          maxThreads_.load(std::memory_order_relaxed)) {
+    // This worker runs the task it just added next, so only start a thread,
+    // which steals, when tasks are piling up behind it.
+    ensureActiveThreads();
+  }
+  return true;
+}
+
+// A worker runs the tasks it took in a batch first. In work-stealing mode, it
+// then runs the tasks of its own deque, then those of the shared queue, then
+// steals from other workers before blocking.
+folly::Optional<CPUThreadPoolExecutor::CPUTask>
+CPUThreadPoolExecutor::takeTask(std::vector<CPUTask>& batch) {
+  if (!batch.empty()) {
+    batchedTasks_.fetch_sub(1, std::memory_order_relaxed);
+    folly::Optional<CPUTask> task{std::move(batch.back())};
+    batch.pop_back();
+    return task;
+  }
+  auto const timeout = threadTimeout_.load(std::memory_order_relaxed);
+  auto* const worker = WorkStealing::current;
+  if (!worker) {
+    return takeShared(timeout, batch);
+  }
+  if (auto task = WorkStealing::pop(*worker)) {
+    return task;
+  }
+  if (auto task = takeShared(std::chrono::milliseconds(0), batch)) {
+    return task;
+  }
+  if (auto task = workStealing_->steal(*worker)) {
+    return task;
+  }
+  workStealing_->idleWorkers.fetch_add(1, std::memory_order_seq_cst);
+  SCOPE_EXIT {
+    workStealing_->idleWorkers.fetch_sub(1, std::memory_order_relaxed);
+  };
+  if (auto task = workStealing_->steal(*worker)) {
+    return task;
+  }
+  return takeShared(timeout, batch);
+}
+
+// Takes a task from the shared queue, and with it up to maxDequeueBatch_ - 1
+// more that are kept in batch, in reverse order. With adaptive idle spin, a
+// blocking take first spins polling the queue.
+folly::Optional<CPUThreadPoolExecutor::CPUTask>
+CPUThreadPoolExecutor::takeShared(
+    std::chrono::milliseconds timeout, std::vector<CPUTask>& batch) {
+  if (idleSpin_ && timeout.count() != 0) {
+    auto task = idleSpin_->spin([&]() -> folly::Optional<CPUTask> {
+      // A timed take on an empty queue registers a waiter, so check first.
+      if (taskQueue_->size() == 0) {
+        return folly::none;
+      }
+      return takeSharedImpl(std::chrono::milliseconds(0), batch);
+    });
+    if (task) {
+      return task;
+    }
+    idleSpin_->recordPark();
+    task = takeSharedImpl(timeout, batch);
+    if (task) {
+      idleSpin_->recordUnpark();
+    }
+    return task;
+  }
+  return takeSharedImpl(timeout, batch);
+}
+
+folly::Optional<CPUThreadPoolExecutor::CPUTask>
+CPUThreadPoolExecutor::takeSharedImpl(
+    std::chrono::milliseconds timeout, std::vector<CPUTask>& batch) {
+  if (maxDequeueBatch_ == 1) {
+    return taskQueue_->try_take_for(timeout);
+  }
+  DCHECK(batch.empty());
+  auto const taken =
+      taskQueue_->try_take_batch_for(timeout, maxDequeueBatch_, batch);
+  if (taken == 0) {
+    return folly::none;
+  }
+  std::reverse(batch.begin(), batch.end());
+  batchedTasks_.fetch_add(taken - 1, std::memory_order_relaxed);
+  folly::Optional<CPUTask> task{std::move(batch.back())};
+  batch.pop_back();
+  return task;
+}
+
 uint8_t CPUThreadPoolExecutor::getNumPriorities() const {
   return taskQueue_->getNumPriorities();
 }
 
 size_t CPUThreadPoolExecutor::getTaskQueueSize() const {
-  return taskQueue_->size();
+  return taskQueue_->size() + (workStealing_ ? workStealing_->size() : 0) +
+      batchedTasks_.load(std::memory_order_relaxed);
+}
+
+AdaptiveIdleSpin::Stats CPUThreadPoolExecutor::getIdleSpinStats() const {
+  return idleSpin_ ? idleSpin_->getStats() : AdaptiveIdleSpin::Stats{};
 }
 
 WorkerProvider* CPUThreadPoolExecutor::getThreadIdCollector() {
@@ -337,13 +597,54 @@ void CPUThreadPoolExecutor::threadRun(ThreadPtr thread) {
     // so it should block until the collection finishes to exit.
     threadIdCollector_->removeTid(folly::getOSThreadID());
   });
+
+  std::unique_ptr<WorkStealing::Worker> worker;
+  if (workStealing_) {
+    worker = std::make_unique<WorkStealing::Worker>(*workStealing_);
+    std::unique_lock w{workStealing_->workersLock};
+    workStealing_->workers.push_back(worker.get());
+    WorkStealing::current = worker.get();
+  }
+  auto workerGuard = folly::makeGuard([&] {
+    if (!worker) {
+      return;
+    }
+    // Only the owner adds to the deque, and it is emptied before stopping.
+    DCHECK(worker->deque.empty());
+    WorkStealing::current = nullptr;
+    std::unique_lock w{workStealing_->workersLock};
+    auto& workers = workStealing_->workers;
+    workers.erase(std::find(workers.begin(), workers.end(), worker.get()));
+  });
+
+  std::vector<CPUTask> batch;
+  if (maxDequeueBatch_ > 1) {
+    batch.reserve(maxDequeueBatch_);
+  }
+
   while (true) {
-    auto task = taskQueue_->try_take_for(
-        threadTimeout_.load(std::memory_order_relaxed));
+    auto task = takeTask(batch);
 
     // Handle thread stopping, either by task timeout, or
     // by 'poison' task added in join() or stop().
     if (FOLLY_UNLIKELY(!task || !task->func_)) {
+      if (FOLLY_UNLIKELY(!batch.empty())) {
+        // A poison taken in a batch. Run the tasks of the batch first, so
+        // that this thread doesn't stop with tasks in hand, and give the
+        // other poisons back to the other threads.
+        if (std::any_of(batch.begin(), batch.end(), [](const CPUTask& t) {
+              return bool(t.func_);
+            })) {
+          batch.insert(batch.begin(), std::move(*task));
+          batchedTasks_.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        batchedTasks_.fetch_sub(batch.size(), std::memory_order_relaxed);
+        for (auto& poison : batch) {
+          taskQueue_->addWithPriority(std::move(poison), Executor::LO_PRI);
+        }
+        batch.clear();
+      }
       // Actually remove the thread from the list.
       std::unique_lock w{threadListLock_};
       if (taskShouldStop(task)) {
@@ -363,7 +664,15 @@ void CPUThreadPoolExecutor::threadRun(ThreadPtr thread) {
     }
     runTask(thread, std::move(task.value()));
 
-    if (FOLLY_UNLIKELY(threadsToStop_ > 0 && !isJoin_)) {
+    if (FOLLY_UNLIKELY(threadsToStop_ > 0 && !isJoin_ && batch.empty())) {
+      // This thread may be stopped, so hand the tasks of its deque over to
+      // the other threads. Poison and timeouts are only taken with an empty
+      // deque. Tasks taken in a batch are run first.
+      while (auto local = worker ? WorkStealing::pop(*worker) : folly::none) {
+        if (!taskQueue_->add(std::move(*local)).reusedThread) {
+          ensureActiveThreads();
+        }
+      }
       std::unique_lock w{threadListLock_};
       if (tryDecrToStop()) {
         threadList_.remove(thread);
@@ -383,7 +692,7 @@ void CPUThreadPoolExecutor::stopThreads(size_t n) {
 
 // threadListLock_ is read (or write) locked.
 size_t CPUThreadPoolExecutor::getPendingTaskCountImpl() const {
-  return taskQueue_->size();
+  return getTaskQueueSize();
 }
 
 std::unique_ptr<folly::QueueObserverFactory>
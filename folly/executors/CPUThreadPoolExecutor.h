@@ -20,6 +20,7 @@
 
 #include <array>
 
+#include <folly/executors/AdaptiveIdleSpin.h>
 #include <folly/executors/QueueObserver.h>
 #include <folly/executors/ThreadPoolExecutor.h>
 
@@ -64,6 +65,27 @@ namespace folly {
  * themselves don't have priorities set, so a series of long running low
  * priority tasks could still hog all the threads. (at last check pthreads
  * thread priorities didn't work very well).
+ *
+ * @note Optionally, with Options::setWorkStealing(true), each worker thread
+ * also has a local deque (a WorkStealingDeque). Tasks added without a
+ * priority by a task running on the pool go to the deque of the worker
+ * running it, which runs them in LIFO order, and idle workers steal from the
+ * deques of busy ones. Other tasks, including all tasks added from outside
+ * the pool, go through the shared queue. This suits fork-join workloads,
+ * where tasks spawn subtasks, that would otherwise contend on the shared
+ * queue. A worker runs the tasks of its deque before those of the shared
+ * queue, so priorities only order tasks in the shared queue. Local tasks
+ * only go to the shared queue to wake an idle worker; a pool below its
+ * maximum thread count instead starts a thread, which steals, when tasks
+ * pile up in a deque.
+ *
+ * @note addBatch() adds a burst of tasks with a single wake-up of the idle
+ * threads, as many as there are tasks, instead of one per task. With
+ * Options::setMaxDequeueBatch(n), a worker that wakes up also takes up to
+ * n - 1 more tasks that are already queued, without waiting, and runs them
+ * before going back to the queue. This amortizes the queue and semaphore
+ * operations over short tasks, but tasks taken in a batch are not run by
+ * other threads meanwhile, so it suits tasks of similar, short, duration.
  */
 class CPUThreadPoolExecutor
     : public ThreadPoolExecutor,
@@ -76,14 +98,41 @@ class CPUThreadPoolExecutor
       allow,
     };
 
-    constexpr Options() noexcept : blocking{Blocking::allow} {}
+    constexpr Options() noexcept
+        : blocking{Blocking::allow},
+          workStealing{false},
+          maxDequeueBatch{1},
+          adaptiveIdleSpin{false} {}
 
     Options& setBlocking(Blocking b) {
       blocking = b;
       return *this;
     }
 
+    Options& setWorkStealing(bool ws) {
+      workStealing = ws;
+      return *this;
+    }
+
+    Options& setMaxDequeueBatch(size_t n) {
+      maxDequeueBatch = n;
+      return *this;
+    }
+
+    Options& setAdaptiveIdleSpin(AdaptiveIdleSpin::Options o = {}) {
+      adaptiveIdleSpin = true;
+      idleSpinOptions = o;
+      return *this;
+    }
+
     Blocking blocking;
+    bool workStealing;
+    // The most tasks a worker takes from the queue at once.
+    size_t maxDequeueBatch;
+    // If set, idle workers spin on the queue before parking, for a time
+    // that follows the arrival rate of tasks. See AdaptiveIdleSpin.
+    bool adaptiveIdleSpin;
+    AdaptiveIdleSpin::Options idleSpinOptions;
   };
 
   // These function return unbounded blocking queues with the default semaphore.
@@ -154,6 +203,7 @@ class CPUThreadPoolExecutor
       Func expireCallback = nullptr) override;
 
   void addWithPriority(Func func, int8_t priority) override;
+  void addBatch(Range<Func*> funcs) override;
   virtual void add(
       Func func,
       int8_t priority,
@@ -162,6 +212,10 @@ class CPUThreadPoolExecutor
 
   size_t getTaskQueueSize() const;
 
+  // Spin and park counters of the idle workers, all zero unless
+  // Options::adaptiveIdleSpin is set.
+  AdaptiveIdleSpin::Stats getIdleSpinStats() const;
+
   uint8_t getNumPriorities() const override;
 
   /// Implements the GetThreadIdCollector interface
@@ -189,6 +243,8 @@ class CPUThreadPoolExecutor
       std::make_unique<ThreadIdWorkerProvider>()};
 
  private:
+  struct WorkStealing;
+
   void threadRun(ThreadPtr thread) override;
   void stopThreads(size_t n) override;
   size_t getPendingTaskCountImpl() const override final;
@@ -203,6 +259,13 @@ class CPUThreadPoolExecutor
       std::chrono::milliseconds expiration,
       Func expireCallback);
 
+  bool tryAddLocal(CPUTask& task);
+  folly::Optional<CPUTask> takeTask(std::vector<CPUTask>& batch);
+  folly::Optional<CPUTask> takeShared(
+      std::chrono::milliseconds timeout, std::vector<CPUTask>& batch);
+  folly::Optional<CPUTask> takeSharedImpl(
+      std::chrono::milliseconds timeout, std::vector<CPUTask>& batch);
+
   std::unique_ptr<folly::QueueObserverFactory> createQueueObserverFactory();
   QueueObserver* FOLLY_NULLABLE getQueueObserver(int8_t pri);
 
@@ -213,6 +276,13 @@ class CPUThreadPoolExecutor
       createQueueObserverFactory()};
   std::atomic<ssize_t> threadsToStop_{0};
   Options::Blocking prohibitBlockingOnThreadPools_ = Options::Blocking::allow;
+  // Only set in work-stealing mode.
+  std::unique_ptr<WorkStealing> workStealing_;
+  size_t const maxDequeueBatch_;
+  // Tasks taken in a batch by a worker but not run yet.
+  std::atomic<size_t> batchedTasks_{0};
+  // Only set with Options::adaptiveIdleSpin.
+  std::unique_ptr<AdaptiveIdleSpin> idleSpin_;
 };
 
 } // namespace folly
@@ -122,6 +122,14 @@ class Codel {
   std::chrono::nanoseconds getMinDelay();
   std::chrono::steady_clock::time_point getIntervalTime();
 
+  /// Returns true if the minimum delay of the last completed interval
+  /// exceeded the target delay. Unlike getMinDelay(), which is the running
+  /// minimum of the current interval, this only changes at the first call to
+  /// overloaded() after an interval ends.
+  bool isOverloaded() const {
+    return overloaded_.load(std::memory_order_relaxed);
+  }
+
   /// Returns the timeout condition for overload given a target delay period.
   std::chrono::milliseconds getSloughTimeout(
       std::chrono::milliseconds delay) const;
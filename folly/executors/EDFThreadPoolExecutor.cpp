@@ -76,6 +76,7 @@ class EDFThreadPoolExecutor::Task {
       f_();
       if (i >= total_ - 1) {
         std::exchange(f_, nullptr);
+        std::exchange(expireCallback_, nullptr);
       }
     } else {
       DCHECK(0 <= i && i < total_);
@@ -84,7 +85,33 @@ class EDFThreadPoolExecutor::Task {
     }
   }
 
+  // Drops run i instead of running it.
+  void expire(int i) {
+    folly::RequestContextScopeGuard guard(context_);
+    if (f_) {
+      if (i >= total_ - 1) {
+        std::exchange(f_, nullptr);
+        if (auto expireCallback = std::exchange(expireCallback_, nullptr)) {
+          expireCallback();
+        }
+      }
+    } else {
+      DCHECK(0 <= i && i < total_);
+      std::exchange(fs_[i], nullptr);
+    }
+  }
+
+  bool isExpired(
+      std::chrono::nanoseconds waitTime, uint64_t now, bool timed) const {
+    return (expiration_ > std::chrono::milliseconds::zero() &&
+            waitTime >= expiration_) ||
+        (timed && now > deadline_);
+  }
+
   Func f_;
+  // Only set for tasks with a single run.
+  Func expireCallback_;
+  std::chrono::milliseconds expiration_{0};
   std::vector<Func> fs_;
   std::atomic<int> iter_{0};
   int total_;
@@ -283,10 +310,19 @@ EDFThreadPoolExecutor::makeThrottledLifoSemSemaphore(
 EDFThreadPoolExecutor::EDFThreadPoolExecutor(
     std::size_t numThreads,
     std::shared_ptr<ThreadFactory> threadFactory,
-    std::unique_ptr<EDFThreadPoolSemaphore> semaphore)
+    std::unique_ptr<EDFThreadPoolSemaphore> semaphore,
+    Options options)
     : ThreadPoolExecutor(numThreads, numThreads, std::move(threadFactory)),
       taskQueue_(std::make_unique<TaskQueue>()),
-      sem_(std::move(semaphore)) {
+      sem_(std::move(semaphore)),
+      loadShedding_(options.loadShedding),
+      rejectUnschedulable_(options.loadShedding && options.rejectUnschedulable),
+      codel_(Codel::Options()
+                 .setInterval(options.interval)
+                 .setTargetDelay(options.targetDelay)) {
+  if (options.adaptiveIdleSpin) {
+    idleSpin_ = std::make_unique<AdaptiveIdleSpin>(options.idleSpinOptions);
+  }
   setNumThreads(numThreads);
   registerThreadPoolExecutor(this);
 }
@@ -304,27 +340,76 @@ void EDFThreadPoolExecutor::add(Func f, std::size_t total, uint64_t deadline) {
   if (FOLLY_UNLIKELY(isJoin_.load(std::memory_order_relaxed) || total == 0)) {
     return;
   }
-
-  auto task = std::make_shared<Task>(std::move(f), total, deadline);
-  registerTaskEnqueue(*task);
-  taskQueue_->push(std::move(task));
-
-  auto numIdleThreads = numIdleThreads_.load(std::memory_order_seq_cst);
-  if (numIdleThreads > 0) {
-    // If idle threads are available notify them, otherwise all worker threads
-    // are running and will get around to this task in time.
-    sem_->post(std::min(total, numIdleThreads));
+  if (FOLLY_UNLIKELY(!admit(deadline, total))) {
+    reject(deadline, total);
+    return;
   }
+
+  enqueue(std::make_shared<Task>(std::move(f), total, deadline));
 }
 
 void EDFThreadPoolExecutor::add(std::vector<Func> fs, uint64_t deadline) {
   if (FOLLY_UNLIKELY(fs.empty())) {
     return;
   }
+  if (FOLLY_UNLIKELY(!admit(deadline, fs.size()))) {
+    reject(deadline, fs.size());
+    return;
+  }
+
+  enqueue(std::make_shared<Task>(std::move(fs), deadline));
+}
+
+void EDFThreadPoolExecutor::add(
+    Func func, uint64_t deadline, Func expireCallback) {
+  addExpiring(
+      std::move(func),
+      deadline,
+      std::chrono::milliseconds::zero(),
+      std::move(expireCallback));
+}
+
+void EDFThreadPoolExecutor::add(
+    Func func, std::chrono::milliseconds expiration, Func expireCallback) {
+  addExpiring(
+      std::move(func),
+      loadShedding_ ? deadlineIn(expiration) : kLatestDeadline,
+      expiration,
+      std::move(expireCallback));
+}
+
+void EDFThreadPoolExecutor::addExpiring(
+    Func func,
+    uint64_t deadline,
+    std::chrono::milliseconds expiration,
+    Func expireCallback) {
+  if (FOLLY_UNLIKELY(isJoin_.load(std::memory_order_relaxed))) {
+    return;
+  }
+  if (FOLLY_UNLIKELY(!admit(deadline, 1))) {
+    reject(deadline, 1);
+    if (expireCallback) {
+      invokeCatchingExns(
+          "EDFThreadPoolExecutor: expireCallback", std::move(expireCallback));
+    }
+    return;
+  }
 
-  auto total = fs.size();
-  auto task = std::make_shared<Task>(std::move(fs), deadline);
+  auto task = std::make_shared<Task>(std::move(func), 1, deadline);
+  task->expireCallback_ = std::move(expireCallback);
+  task->expiration_ = expiration;
+  enqueue(std::move(task));
+}
+
+void EDFThreadPoolExecutor::enqueue(std::shared_ptr<Task> task) {
+  std::size_t total = task->total_;
   registerTaskEnqueue(*task);
+  if (idleSpin_) {
+    idleSpin_->recordArrivals(total);
+  }
+  if (loadShedding_) {
+    pendingRuns_ += total;
+  }
   taskQueue_->push(std::move(task));
 
   auto numIdleThreads = numIdleThreads_.load(std::memory_order_seq_cst);
@@ -335,10 +420,69 @@ void EDFThreadPoolExecutor::add(std::vector<Func> fs, uint64_t deadline) {
   }
 }
 
+/* static */ uint64_t EDFThreadPoolExecutor::deadlineAt(
+    std::chrono::steady_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+bool EDFThreadPoolExecutor::admit(uint64_t deadline, std::size_t total) {
+  if (!rejectUnschedulable_ || !isTimed(deadline)) {
+    return true;
+  }
+  // Only reject while the queue is overloaded, that is while every task that
+  // was dequeued in the last completed interval waited longer than the target
+  // delay. Outside of that a burst is absorbed by the queue.
+  if (!codel_.isOverloaded()) {
+    return true;
+  }
+  // This assumes that all the pending runs are ahead of the new ones, which
+  // overestimates the wait of a task with an early deadline.
+  std::size_t threads = std::max<std::size_t>(numThreads(), 1);
+  std::size_t rounds = (pendingRuns_.load() + total + threads - 1) / threads;
+  auto wait =
+      std::chrono::nanoseconds(serviceTimeNs_.load()) * int64_t(rounds);
+  return deadlineIn(wait) <= deadline;
+}
+
+void EDFThreadPoolExecutor::reject(uint64_t deadline, std::size_t total) {
+  rejected_ += total;
+  FOLLY_SDT(
+      folly,
+      edf_thread_pool_executor_task_rejected,
+      threadFactory_->getNamePrefix().c_str(),
+      deadline,
+      total);
+}
+
+void EDFThreadPoolExecutor::recordServiceTime(
+    std::chrono::nanoseconds runTime) {
+  // Exponential moving average with a weight of 1/8 for the new sample. Racing
+  // workers may lose a sample, which does not matter for an estimate.
+  int64_t prev = serviceTimeNs_.load();
+  int64_t sample = runTime.count();
+  serviceTimeNs_.store(prev == 0 ? sample : prev + (sample - prev) / 8);
+}
+
 size_t EDFThreadPoolExecutor::getTaskQueueSize() const {
   return taskQueue_->size();
 }
 
+EDFThreadPoolExecutor::LoadSheddingStats
+EDFThreadPoolExecutor::getLoadSheddingStats() const {
+  LoadSheddingStats stats;
+  stats.rejected = rejected_.load();
+  stats.expired = expired_.load();
+  stats.late = late_.load();
+  stats.serviceTime = std::chrono::nanoseconds(serviceTimeNs_.load());
+  return stats;
+}
+
+AdaptiveIdleSpin::Stats EDFThreadPoolExecutor::getIdleSpinStats() const {
+  return idleSpin_ ? idleSpin_->getStats() : AdaptiveIdleSpin::Stats{};
+}
+
 void EDFThreadPoolExecutor::threadRun(ThreadPtr thread) {
   this->threadPoolHook_.registerThread();
   ExecutorBlockingGuard guard{
@@ -366,11 +510,23 @@ void EDFThreadPoolExecutor::threadRun(ThreadPtr thread) {
       continue;
     }
 
+    if (loadShedding_) {
+      --pendingRuns_;
+    }
+
     thread->idle.store(false, std::memory_order_relaxed);
     auto startTime = std::chrono::steady_clock::now();
+    auto deadline = task->getDeadline();
+    bool timed = isTimed(deadline);
     ProcessedTaskInfo taskInfo;
     fillTaskInfo(*task, taskInfo);
     taskInfo.waitTime = startTime - taskInfo.enqueueTime;
+    if (loadShedding_) {
+      // Only to track the minimum queueing delay, tasks are shed by deadline.
+      codel_.overloaded_explicit_now(taskInfo.waitTime, startTime);
+    }
+    taskInfo.expired =
+        task->isExpired(taskInfo.waitTime, deadlineAt(startTime), timed);
     FOLLY_SDT(
         folly,
         thread_pool_executor_task_dequeued,
@@ -383,10 +539,24 @@ void EDFThreadPoolExecutor::threadRun(ThreadPtr thread) {
       observer.taskDequeued(taskInfo);
     });
 
-    invokeCatchingExns("EDFThreadPoolExecutor: func", [&] {
-      std::exchange(task, {})->run(iter);
-    });
-    taskInfo.runTime = std::chrono::steady_clock::now() - startTime;
+    if (FOLLY_UNLIKELY(taskInfo.expired)) {
+      ++expired_;
+      invokeCatchingExns("EDFThreadPoolExecutor: expireCallback", [&] {
+        std::exchange(task, {})->expire(iter);
+      });
+    } else {
+      invokeCatchingExns("EDFThreadPoolExecutor: func", [&] {
+        std::exchange(task, {})->run(iter);
+      });
+      auto endTime = std::chrono::steady_clock::now();
+      taskInfo.runTime = endTime - startTime;
+      if (loadShedding_) {
+        recordServiceTime(taskInfo.runTime);
+        if (timed && deadlineAt(endTime) > deadline) {
+          ++late_;
+        }
+      }
+    }
 
     FOLLY_SDT(
         folly,
@@ -438,7 +608,12 @@ std::shared_ptr<EDFThreadPoolExecutor::Task> EDFThreadPoolExecutor::take() {
     return nullptr;
   }
 
-  if (auto task = taskQueue_->pop()) {
+  if (idleSpin_) {
+    // Not counted as idle while spinning, so that adds don't post.
+    if (auto task = idleSpin_->spin([&] { return taskQueue_->pop(); })) {
+      return task;
+    }
+  } else if (auto task = taskQueue_->pop()) {
     return task;
   }
 
@@ -453,12 +628,15 @@ std::shared_ptr<EDFThreadPoolExecutor::Task> EDFThreadPoolExecutor::take() {
     numIdleThreads_.fetch_sub(1, std::memory_order_seq_cst);
   };
 
-  for (;;) {
+  for (bool parked = false;; parked = true) {
     if (FOLLY_UNLIKELY(shouldStop())) {
       return nullptr;
     }
 
     if (auto task = taskQueue_->pop()) {
+      if (parked && idleSpin_) {
+        idleSpin_->recordUnpark();
+      }
       // It's possible to return a finished task here, in which case
       // the worker will call this function again.
       return task;
@@ -468,6 +646,9 @@ std::shared_ptr<EDFThreadPoolExecutor::Task> EDFThreadPoolExecutor::take() {
       return nullptr;
     }
 
+    if (idleSpin_) {
+      idleSpin_->recordPark();
+    }
     sem_->wait();
   }
 }
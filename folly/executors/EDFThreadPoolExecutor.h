@@ -17,13 +17,17 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <limits>
 #include <memory>
 #include <vector>
 
+#include <folly/executors/AdaptiveIdleSpin.h>
+#include <folly/executors/Codel.h>
 #include <folly/executors/SoftRealTimeExecutor.h>
 #include <folly/executors/ThreadPoolExecutor.h>
+#include <folly/synchronization/RelaxedAtomic.h>
 
 namespace folly {
 
@@ -52,6 +56,14 @@ class EDFThreadPoolSemaphoreImpl : public EDFThreadPoolSemaphore {
  * `EDFThreadPoolExecutor` is a `SoftRealTimeExecutor` that implements the
  * earliest-deadline-first scheduling policy. Deadline ties are resolved by
  * submission order.
+ *
+ * By default deadlines are abstract and every task runs. With
+ * `Options::setLoadShedding()`, deadlines are steady clock times (see
+ * `deadlineAt()` and `deadlineIn()`) and the executor sheds the tasks that
+ * cannot meet them: a task whose deadline has passed by the time a worker
+ * picks it up is dropped, and while the queue is overloaded `add()` rejects a
+ * task whose deadline cannot be met given the queue depth and the measured
+ * service time. `kEarliestDeadline` and `kLatestDeadline` are never shed.
  */
 class EDFThreadPoolExecutor
     : public SoftRealTimeExecutor,
@@ -64,6 +76,67 @@ class EDFThreadPoolExecutor
   static constexpr uint64_t kLatestDeadline =
       std::numeric_limits<uint64_t>::max();
 
+  struct Options {
+    Options() {}
+
+    Options& setAdaptiveIdleSpin(AdaptiveIdleSpin::Options o = {}) {
+      adaptiveIdleSpin = true;
+      idleSpinOptions = o;
+      return *this;
+    }
+
+    Options& setLoadShedding(bool admissionControl = true) {
+      loadShedding = true;
+      rejectUnschedulable = admissionControl;
+      return *this;
+    }
+
+    Options& setTargetDelay(std::chrono::milliseconds value) {
+      targetDelay = value;
+      return *this;
+    }
+
+    Options& setInterval(std::chrono::milliseconds value) {
+      interval = value;
+      return *this;
+    }
+
+    // If set, idle workers spin on the queue before parking, for a time
+    // that follows the arrival rate of tasks. See AdaptiveIdleSpin.
+    bool adaptiveIdleSpin{false};
+    AdaptiveIdleSpin::Options idleSpinOptions;
+
+    // If set, deadlines are steady clock times in nanoseconds and tasks that
+    // are picked up after their deadline are dropped.
+    bool loadShedding{false};
+    // If set along with loadShedding, add() rejects tasks that cannot meet
+    // their deadline while the queue is overloaded.
+    bool rejectUnschedulable{false};
+    // The queue counts as overloaded when, as in Codel, the minimum
+    // queueing delay over the last completed interval exceeded targetDelay.
+    std::chrono::milliseconds targetDelay{5};
+    std::chrono::milliseconds interval{100};
+  };
+
+  struct LoadSheddingStats {
+    // Runs refused by add() because they could not meet their deadline. A
+    // task added with `total` runs counts `total` times.
+    uint64_t rejected{0};
+    // Runs dropped by a worker because their deadline or expiration had
+    // passed before they could start.
+    uint64_t expired{0};
+    // Runs that finished after their deadline.
+    uint64_t late{0};
+    // Moving average of the duration of a run.
+    std::chrono::nanoseconds serviceTime{0};
+  };
+
+  // Deadlines for a pool with Options::loadShedding.
+  static uint64_t deadlineAt(std::chrono::steady_clock::time_point time);
+  static uint64_t deadlineIn(std::chrono::nanoseconds timeout) {
+    return deadlineAt(std::chrono::steady_clock::now() + timeout);
+  }
+
   static std::unique_ptr<EDFThreadPoolSemaphore> makeDefaultSemaphore();
   static std::unique_ptr<EDFThreadPoolSemaphore> makeLifoSemSemaphore();
   static std::unique_ptr<EDFThreadPoolSemaphore> makeThrottledLifoSemSemaphore(
@@ -74,7 +147,8 @@ class EDFThreadPoolExecutor
       std::shared_ptr<ThreadFactory> threadFactory =
           std::make_shared<NamedThreadFactory>("EDFThreadPool"),
       std::unique_ptr<EDFThreadPoolSemaphore> semaphore =
-          makeDefaultSemaphore());
+          makeDefaultSemaphore(),
+      Options options = {});
 
   ~EDFThreadPoolExecutor() override;
 
@@ -82,11 +156,34 @@ class EDFThreadPoolExecutor
   using ThreadPoolExecutor::add;
 
   void add(Func f) override;
+  // With Options::loadShedding, a task that add() rejects is dropped and its
+  // runs are counted in LoadSheddingStats::rejected.
   void add(Func f, std::size_t total, uint64_t deadline) override;
   void add(std::vector<Func> fs, uint64_t deadline) override;
 
+  // Like add(func, deadline), but if func is shed, expireCallback is run
+  // instead. A task rejected by add() runs expireCallback on the calling
+  // thread.
+  void add(Func func, uint64_t deadline, Func expireCallback);
+
+  // If func doesn't start within expiration of being enqueued, runs
+  // expireCallback instead. With Options::loadShedding the task is scheduled
+  // by the deadline the expiration implies, otherwise at kLatestDeadline.
+  void add(
+      Func func,
+      std::chrono::milliseconds expiration,
+      Func expireCallback) override;
+
   size_t getTaskQueueSize() const;
 
+  // All zero unless Options::loadShedding is set or tasks are added with an
+  // expiration.
+  LoadSheddingStats getLoadSheddingStats() const;
+
+  // Spin and park counters of the idle workers, all zero unless
+  // Options::adaptiveIdleSpin is set.
+  AdaptiveIdleSpin::Stats getIdleSpinStats() const;
+
  protected:
   void threadRun(ThreadPtr thread) override;
   void stopThreads(std::size_t numThreads) override;
@@ -98,10 +195,37 @@ class EDFThreadPoolExecutor
 
   void fillTaskInfo(const Task& task, TaskInfo& info);
   void registerTaskEnqueue(const Task& task);
+  void enqueue(std::shared_ptr<Task> task);
+  void addExpiring(
+      Func func,
+      uint64_t deadline,
+      std::chrono::milliseconds expiration,
+      Func expireCallback);
+
+  bool isTimed(uint64_t deadline) const {
+    return loadShedding_ && deadline != kEarliestDeadline &&
+        deadline != kLatestDeadline;
+  }
+  bool admit(uint64_t deadline, std::size_t total);
+  void reject(uint64_t deadline, std::size_t total);
+  void recordServiceTime(std::chrono::nanoseconds runTime);
 
   std::unique_ptr<TaskQueue> taskQueue_;
   std::unique_ptr<EDFThreadPoolSemaphore> sem_;
   std::atomic<int> threadsToStop_{0};
+  // Only set with Options::adaptiveIdleSpin.
+  std::unique_ptr<AdaptiveIdleSpin> idleSpin_;
+
+  const bool loadShedding_;
+  const bool rejectUnschedulable_;
+  // Fed the queueing delay of every task when loadShedding_ is set.
+  Codel codel_;
+  // Runs that were added but not yet started or dropped, across all tasks.
+  relaxed_atomic<std::size_t> pendingRuns_{0};
+  relaxed_atomic<int64_t> serviceTimeNs_{0};
+  relaxed_atomic<uint64_t> rejected_{0};
+  relaxed_atomic<uint64_t> expired_{0};
+  relaxed_atomic<uint64_t> late_{0};
 
   // All operations performed on `numIdleThreads_` explicitly specify memory
   // ordering of `std::memory_order_seq_cst`. This is due to `numIdleThreads_`
@@ -38,6 +38,8 @@ class ExecutionObserver
     NotificationQueue,
     // Owned by FiberManager.
     Fiber,
+    // Owned by FairShareExecutor.
+    Task,
   };
   // Constant time size = false to support auto_unlink behavior, options are
   // mutually exclusive
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/FairShareExecutor.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+#include <folly/portability/Time.h>
+
+namespace folly {
+
+namespace {
+
+// Costs are scaled before dividing by the weight, so that the passes of
+// queues with large weights still advance by distinct amounts.
+constexpr uint64_t kWeightScale = 1 << 8;
+
+uint64_t threadCpuNanos() {
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return uint64_t(ts.tv_sec) * 1000000000 + uint64_t(ts.tv_nsec);
+}
+
+} // namespace
+
+FairShareExecutor::FairShareExecutor(KeepAlive<> keepAlive, Options options)
+    : options_(std::move(options)), kaInner_(std::move(keepAlive)) {
+  CHECK_GE(options_.maxInFlight, 1);
+  nodes_.push_back(std::make_unique<Node>(kRoot, kRoot, "root", 1, true));
+  auto const id = addQueue("default", 1, kRoot);
+  DCHECK_EQ(id, kDefaultQueue);
+}
+
+FairShareExecutor::FairShareExecutor(
+    std::unique_ptr<Executor> executor, Options options)
+    : FairShareExecutor(getKeepAliveToken(*executor), std::move(options)) {
+  ownedExecutor_ = std::move(executor);
+}
+
+FairShareExecutor::~FairShareExecutor() {
+  // Workers hold keep-alives until all pending tasks have run.
+  joinKeepAlive();
+}
+
+FairShareExecutor::QueueId FairShareExecutor::addGroup(
+    std::string name, uint32_t weight, QueueId parent) {
+  return addNode(std::move(name), weight, parent, /* group */ true);
+}
+
+FairShareExecutor::QueueId FairShareExecutor::addQueue(
+    std::string name, uint32_t weight, QueueId parent) {
+  return addNode(std::move(name), weight, parent, /* group */ false);
+}
+
+FairShareExecutor::QueueId FairShareExecutor::addNode(
+    std::string name, uint32_t weight, QueueId parent, bool group) {
+  if (weight == 0) {
+    throw std::invalid_argument("FairShareExecutor: weight must be positive");
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (parent >= nodes_.size() || !nodes_[parent]->isGroup) {
+    throw std::invalid_argument("FairShareExecutor: parent is not a group");
+  }
+  auto const id = static_cast<QueueId>(nodes_.size());
+  auto node =
+      std::make_unique<Node>(id, parent, std::move(name), weight, group);
+  if (!group) {
+    node->executor = std::make_unique<QueueExecutor>(*this, id);
+  }
+  nodes_.push_back(std::move(node));
+  return id;
+}
+
+void FairShareExecutor::setWeight(QueueId id, uint32_t weight) {
+  if (weight == 0) {
+    throw std::invalid_argument("FairShareExecutor: weight must be positive");
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (id == kRoot || id >= nodes_.size()) {
+    throw std::invalid_argument("FairShareExecutor: unknown queue");
+  }
+  nodes_[id]->weight = weight;
+}
+
+Executor::KeepAlive<> FairShareExecutor::getQueueExecutor(QueueId id) {
+  QueueExecutor* executor = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id >= nodes_.size() || nodes_[id]->isGroup) {
+      throw std::invalid_argument("FairShareExecutor: not a queue");
+    }
+    executor = nodes_[id]->executor.get();
+  }
+  return getKeepAliveToken(executor);
+}
+
+void FairShareExecutor::add(Func func) {
+  addToQueue(kDefaultQueue, std::move(func));
+}
+
+void FairShareExecutor::addToQueue(QueueId id, Func func) {
+  Task task{std::move(func), RequestContext::saveContext()};
+  bool shouldScheduleWorker = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nodes_[id]->tasks.push_back(std::move(task));
+    // Count the task in the queue and its ancestors, and make those that
+    // were idle active in their parent.
+    for (auto* node = nodes_[id].get();; node = nodes_[node->parent].get()) {
+      if (node->pending++ == 0 && node->id != kRoot) {
+        auto& parent = *nodes_[node->parent];
+        node->pass = std::max(node->pass, parent.vtime);
+        parent.active.emplace(node->pass, node->id);
+      }
+      if (node->id == kRoot) {
+        break;
+      }
+    }
+    if (inFlight_ < options_.maxInFlight) {
+      ++inFlight_;
+      shouldScheduleWorker = true;
+    }
+  }
+  if (shouldScheduleWorker) {
+    scheduleWorker();
+  }
+}
+
+bool FairShareExecutor::pickLocked(Task& task, QueueId& queue) {
+  auto* node = nodes_[kRoot].get();
+  if (node->pending == 0) {
+    return false;
+  }
+  while (node->isGroup) {
+    DCHECK(!node->active.empty());
+    auto const& [pass, child] = *node->active.begin();
+    node->vtime = pass;
+    node = nodes_[child].get();
+  }
+  DCHECK(!node->tasks.empty());
+  task = std::move(node->tasks.front());
+  node->tasks.pop_front();
+  queue = node->id;
+
+  for (; node->id != kRoot; node = nodes_[node->parent].get()) {
+    if (--node->pending == 0) {
+      nodes_[node->parent]->active.erase({node->pass, node->id});
+    }
+  }
+  --node->pending;
+  return true;
+}
+
+void FairShareExecutor::chargeLocked(QueueId queue, uint64_t cpuNanos) {
+  auto const cost = std::max<uint64_t>(cpuNanos, 1);
+  auto* node = nodes_[queue].get();
+  for (; node->id != kRoot; node = nodes_[node->parent].get()) {
+    node->tasksRun += 1;
+    node->cpuNanos += cost;
+    auto const delta =
+        std::max<uint64_t>(cost * kWeightScale / node->weight, 1);
+    if (node->pending == 0) {
+      node->pass += delta;
+      continue;
+    }
+    auto& active = nodes_[node->parent]->active;
+    active.erase({node->pass, node->id});
+    node->pass += delta;
+    active.emplace(node->pass, node->id);
+  }
+  node->tasksRun += 1;
+  node->cpuNanos += cost;
+}
+
+void FairShareExecutor::runObserved(Task& task, uint64_t& cpuNanos) {
+  auto const id = reinterpret_cast<uintptr_t>(&task);
+  {
+    std::shared_lock lock(observersMutex_);
+    for (auto& observer : observers_) {
+      observer.starting(id, ExecutionObserver::CallbackType::Task);
+    }
+  }
+  auto const start = threadCpuNanos();
+  {
+    RequestContextScopeGuard rctxGuard{std::move(task.rctx)};
+    invokeCatchingExns("FairShareExecutor", std::exchange(task.func, {}));
+  }
+  cpuNanos = threadCpuNanos() - start;
+  {
+    std::shared_lock lock(observersMutex_);
+    for (auto& observer : observers_) {
+      observer.stopped(id, ExecutionObserver::CallbackType::Task);
+    }
+  }
+}
+
+void FairShareExecutor::worker() {
+  Task task;
+  QueueId queue;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pickLocked(task, queue)) {
+      --inFlight_;
+      return;
+    }
+  }
+
+  uint64_t cpuNanos = 0;
+  runObserved(task, cpuNanos);
+
+  bool shouldRescheduleWorker;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    chargeLocked(queue, cpuNanos);
+    shouldRescheduleWorker = nodes_[kRoot]->pending > 0;
+    if (!shouldRescheduleWorker) {
+      --inFlight_;
+    }
+  }
+  // One task per worker, so that the tasks of the wrapped executor are
+  // interleaved with ours.
+  if (shouldRescheduleWorker) {
+    scheduleWorker();
+  }
+}
+
+void FairShareExecutor::scheduleWorker() {
+  folly::RequestContextScopeGuard rctxGuard{nullptr};
+  kaInner_->add([self = getKeepAliveToken(this)] { self->worker(); });
+}
+
+std::vector<FairShareExecutor::QueueStats> FairShareExecutor::getQueueStats()
+    const {
+  std::vector<QueueStats> result;
+  std::lock_guard<std::mutex> lock(mutex_);
+  result.reserve(nodes_.size());
+  for (auto const& node : nodes_) {
+    auto& stats = result.emplace_back();
+    stats.id = node->id;
+    stats.parent = node->parent;
+    stats.name = node->name;
+    stats.weight = node->weight;
+    stats.isGroup = node->isGroup;
+    stats.pendingTasks = node->pending;
+    stats.tasksRun = node->tasksRun;
+    stats.cpuTime = std::chrono::nanoseconds(node->cpuNanos);
+  }
+  return result;
+}
+
+void FairShareExecutor::addExecutionObserver(ExecutionObserver* observer) {
+  std::unique_lock lock(observersMutex_);
+  observers_.push_back(*observer);
+}
+
+void FairShareExecutor::removeExecutionObserver(ExecutionObserver* observer) {
+  std::unique_lock lock(observersMutex_);
+  observers_.erase(observers_.iterator_to(*observer));
+}
+
+} // namespace folly
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/DefaultKeepAliveExecutor.h>
+#include <folly/SharedMutex.h>
+#include <folly/executors/ExecutionObserver.h>
+#include <folly/io/async/Request.h>
+
+namespace folly {
+
+/**
+ * FairShareExecutor wraps an executor, typically a CPUThreadPoolExecutor
+ * shared by many tenants, and shares it among a tree of weighted queues in
+ * proportion to their weights, so that a burst of tasks in one queue delays
+ * the tasks of the other queues by no more than its share.
+ *
+ * The leaves of the tree are queues, to which tasks are added through
+ * getQueueExecutor(); the inner nodes are groups, which share their own
+ * share among their children. For example, with
+ *
+ *   FairShareExecutor ex(getKeepAliveToken(pool), options);
+ *   auto batch = ex.addGroup("batch", 1);
+ *   auto online = ex.addQueue("online", 3);
+ *   auto reports = ex.addQueue("reports", 1, batch);
+ *   auto backfill = ex.addQueue("backfill", 1, batch);
+ *
+ * online gets 3/4 of the pool when all queues are busy, and reports and
+ * backfill 1/8 each. A queue that is idle does not use its share, which is
+ * redistributed among the busy ones; add() adds to a default queue of
+ * weight 1 under the root.
+ *
+ * Scheduling is stride scheduling over the tree, with the CPU time of tasks
+ * as the cost: each node has a pass, advanced by the thread CPU time of the
+ * tasks run from its subtree divided by its weight, and each group picks
+ * among its children with pending tasks the one with the lowest pass. A
+ * node that becomes busy starts no lower than the pass of the child its
+ * parent picked last, i.e. of its least served busy sibling, so it cannot
+ * bank credit while idle and then monopolize the executor.
+ *
+ * At most Options::maxInFlight tasks are in the wrapped executor at any
+ * time; the others wait in their queues, so set it to the number of threads
+ * of the wrapped executor to use it fully. As costs are only known once
+ * tasks complete, the share of a queue may be exceeded by up to
+ * maxInFlight tasks.
+ *
+ * ExecutionObservers added with addExecutionObserver() are notified around
+ * each task, with CallbackType::Task. Queues and groups cannot be removed.
+ */
+class FairShareExecutor : public DefaultKeepAliveExecutor {
+ public:
+  using QueueId = uint32_t;
+
+  // The root group, and the queue of add().
+  static constexpr QueueId kRoot = 0;
+  static constexpr QueueId kDefaultQueue = 1;
+
+  struct Options {
+    Options() {}
+
+    // Maximum number of tasks in the wrapped executor at any time. This
+    // must be >= 1.
+    uint32_t maxInFlight{1};
+  };
+
+  struct QueueStats {
+    QueueId id{};
+    QueueId parent{};
+    std::string name;
+    uint32_t weight{};
+    bool isGroup{};
+    // Tasks waiting in the queue, or in the queues of the group.
+    size_t pendingTasks{};
+    // Tasks run, and the thread CPU time they used, including those of the
+    // queues of the group.
+    uint64_t tasksRun{};
+    std::chrono::nanoseconds cpuTime{};
+  };
+
+  // owning constructor
+  explicit FairShareExecutor(
+      std::unique_ptr<Executor> executor, Options options = Options());
+  // non-owning constructor
+  explicit FairShareExecutor(
+      KeepAlive<> keepAlive, Options options = Options());
+  ~FairShareExecutor() override;
+
+  // Adds a group or a queue under the given group. Throws
+  // std::invalid_argument if the parent is not a group or the weight is 0.
+  QueueId addGroup(std::string name, uint32_t weight, QueueId parent = kRoot);
+  QueueId addQueue(std::string name, uint32_t weight, QueueId parent = kRoot);
+
+  // Takes effect for the costs of the tasks that complete from now on.
+  void setWeight(QueueId id, uint32_t weight);
+
+  // An executor that adds tasks to the queue, valid as long as this
+  // executor. Throws std::invalid_argument if id is not a queue.
+  KeepAlive<> getQueueExecutor(QueueId id);
+
+  // Adds to kDefaultQueue.
+  void add(Func func) override;
+
+  // All groups and queues, the root first, in order of creation.
+  std::vector<QueueStats> getQueueStats() const;
+
+  // The observers are not owned, and must not be added or removed from a
+  // task of this executor.
+  void addExecutionObserver(ExecutionObserver* observer);
+  void removeExecutionObserver(ExecutionObserver* observer);
+
+ private:
+  class QueueExecutor : public Executor {
+   public:
+    QueueExecutor(FairShareExecutor& owner, QueueId id)
+        : owner_(owner), id_(id) {}
+
+    void add(Func func) override { owner_.addToQueue(id_, std::move(func)); }
+
+   protected:
+    // A queue lives as long as the FairShareExecutor, so keep that alive.
+    bool keepAliveAcquire() noexcept override {
+      return Executor::keepAliveAcquire(&owner_);
+    }
+
+    void keepAliveRelease() noexcept override {
+      Executor::keepAliveRelease(&owner_);
+    }
+
+   private:
+    FairShareExecutor& owner_;
+    QueueId const id_;
+  };
+
+  struct Task {
+    Func func;
+    std::shared_ptr<RequestContext> rctx;
+  };
+
+  struct Node {
+    Node(QueueId i, QueueId p, std::string n, uint32_t w, bool group)
+        : id(i), parent(p), name(std::move(n)), weight(w), isGroup(group) {}
+
+    QueueId const id;
+    QueueId const parent;
+    std::string const name;
+    uint32_t weight;
+    bool const isGroup;
+
+    // Virtual time, in units of cost per weight, compared among siblings.
+    uint64_t pass{0};
+    // Tasks waiting in the subtree. The node is in the active set of its
+    // parent when this is positive.
+    size_t pending{0};
+
+    // Queues only.
+    std::deque<Task> tasks;
+    std::unique_ptr<QueueExecutor> executor;
+
+    // Groups only: the children with pending tasks, by pass, and the pass
+    // of the last child picked, which children start at when they become
+    // busy.
+    std::set<std::pair<uint64_t, QueueId>> active;
+    uint64_t vtime{0};
+
+    uint64_t tasksRun{0};
+    uint64_t cpuNanos{0};
+  };
+
+  QueueId addNode(std::string name, uint32_t weight, QueueId parent, bool g);
+  void addToQueue(QueueId id, Func func);
+  void scheduleWorker();
+  void worker();
+  // Takes the next task to run, or returns false if none is pending.
+  bool pickLocked(Task& task, QueueId& queue);
+  void chargeLocked(QueueId queue, uint64_t cpuNanos);
+  void runObserved(Task& task, uint64_t& cpuNanos);
+
+  const Options options_;
+  std::unique_ptr<Executor> ownedExecutor_;
+  const KeepAlive<> kaInner_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Node>> nodes_;
+  // Tasks taken or about to be taken by workers in the wrapped executor.
+  uint32_t inFlight_{0};
+
+  SharedMutex observersMutex_;
+  ExecutionObserver::List observers_;
+};
+
+} // namespace folly
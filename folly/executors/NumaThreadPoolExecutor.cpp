@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/NumaThreadPoolExecutor.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <folly/ScopeGuard.h>
+#include <folly/executors/thread_factory/AffinityThreadFactory.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+
+namespace folly {
+
+namespace detail {
+
+NumaTaskRouter::NumaTaskRouter(
+    const NumaTopology& topology, size_t spillThreshold)
+    : topology_(topology),
+      spillThreshold_(spillThreshold),
+      loads_(std::make_unique<Load[]>(topology.numNodes())) {
+  CHECK_GT(topology_.numNodes(), 0);
+}
+
+size_t NumaTaskRouter::pick() const {
+  auto const numNodes = topology_.numNodes();
+  auto const node = std::min(topology_.currentNode(), numNodes - 1);
+  auto const local = loads_[node].inFlight.load();
+  if (numNodes == 1 || local <= spillThreshold_) {
+    return node;
+  }
+  auto best = node;
+  auto bestLoad = local;
+  for (size_t i = 0; i < numNodes; ++i) {
+    auto const load = loads_[i].inFlight.load();
+    if (load < bestLoad) {
+      best = i;
+      bestLoad = load;
+    }
+  }
+  return bestLoad + spillThreshold_ < local ? best : node;
+}
+
+Func NumaTaskRouter::track(size_t node, Func func) {
+  auto& load = loads_[node];
+  load.inFlight.fetch_add(1);
+  // Counted until destroyed rather than run, for tasks that are dropped.
+  auto guard = makeGuard([&load] { load.inFlight.fetch_sub(1); });
+  return [func = std::move(func), guard = std::move(guard)]() mutable {
+    func();
+  };
+}
+
+std::vector<size_t> NumaTaskRouter::splitThreads(size_t numThreads) const {
+  auto const& cpusByNode = topology_.cpusByNode;
+  size_t numCpus = 0;
+  for (auto const& cpus : cpusByNode) {
+    numCpus += cpus.size();
+  }
+  std::vector<size_t> threads(cpusByNode.size());
+  size_t assigned = 0;
+  for (size_t node = 0; node < cpusByNode.size(); ++node) {
+    threads[node] =
+        numCpus ? numThreads * cpusByNode[node].size() / numCpus : 0;
+    assigned += threads[node];
+  }
+  // Give the remainder to the first nodes, and a thread to every node.
+  for (size_t node = 0; assigned < numThreads; ++node, ++assigned) {
+    ++threads[node % threads.size()];
+  }
+  for (auto& n : threads) {
+    n = std::max(n, size_t(1));
+  }
+  return threads;
+}
+
+std::shared_ptr<ThreadFactory> NumaTaskRouter::makeThreadFactory(
+    const std::string& namePrefix, size_t node, bool pinThreads) const {
+  auto factory = std::make_shared<NamedThreadFactory>(
+      fmt::format("{}{}-", namePrefix, node));
+  if (!pinThreads) {
+    return factory;
+  }
+  return std::make_shared<AffinityThreadFactory>(
+      std::move(factory), topology_.cpusByNode[node]);
+}
+
+} // namespace detail
+
+NumaCPUThreadPoolExecutor::NumaCPUThreadPoolExecutor(
+    size_t numThreads,
+    NumaThreadPoolOptions options,
+    CPUThreadPoolExecutor::Options poolOptions,
+    std::string namePrefix)
+    : router_(options.topology, options.spillThreshold) {
+  auto const threads = router_.splitThreads(numThreads);
+  for (size_t node = 0; node < threads.size(); ++node) {
+    pools_.push_back(std::make_unique<CPUThreadPoolExecutor>(
+        threads[node],
+        router_.makeThreadFactory(namePrefix, node, options.pinThreads),
+        poolOptions));
+  }
+}
+
+NumaCPUThreadPoolExecutor::~NumaCPUThreadPoolExecutor() {
+  joinKeepAlive();
+  join();
+}
+
+void NumaCPUThreadPoolExecutor::add(Func func) {
+  auto const node = router_.pick();
+  pools_[node]->add(router_.track(node, std::move(func)));
+}
+
+size_t NumaCPUThreadPoolExecutor::getPendingTaskCount() const {
+  size_t count = 0;
+  for (auto const& pool : pools_) {
+    count += pool->getPendingTaskCount();
+  }
+  return count;
+}
+
+void NumaCPUThreadPoolExecutor::join() {
+  for (auto& pool : pools_) {
+    pool->join();
+  }
+}
+
+void NumaCPUThreadPoolExecutor::stop() {
+  for (auto& pool : pools_) {
+    pool->stop();
+  }
+}
+
+NumaIOThreadPoolExecutor::NumaIOThreadPoolExecutor(
+    size_t numThreads,
+    NumaThreadPoolOptions options,
+    IOThreadPoolExecutor::Options poolOptions,
+    std::string namePrefix)
+    : router_(options.topology, options.spillThreshold) {
+  auto const threads = router_.splitThreads(numThreads);
+  for (size_t node = 0; node < threads.size(); ++node) {
+    pools_.push_back(std::make_unique<IOThreadPoolExecutor>(
+        threads[node],
+        router_.makeThreadFactory(namePrefix, node, options.pinThreads),
+        folly::EventBaseManager::get(),
+        poolOptions));
+  }
+}
+
+NumaIOThreadPoolExecutor::~NumaIOThreadPoolExecutor() {
+  joinKeepAlive();
+  join();
+}
+
+void NumaIOThreadPoolExecutor::add(Func func) {
+  auto const node = router_.pick();
+  pools_[node]->add(router_.track(node, std::move(func)));
+}
+
+folly::EventBase* NumaIOThreadPoolExecutor::getEventBase() {
+  auto const node =
+      std::min(router_.topology().currentNode(), pools_.size() - 1);
+  return pools_[node]->getEventBase();
+}
+
+std::vector<folly::Executor::KeepAlive<folly::EventBase>>
+NumaIOThreadPoolExecutor::getAllEventBases() {
+  std::vector<folly::Executor::KeepAlive<folly::EventBase>> evbs;
+  for (auto& pool : pools_) {
+    auto nodeEvbs = pool->getAllEventBases();
+    std::move(nodeEvbs.begin(), nodeEvbs.end(), std::back_inserter(evbs));
+  }
+  return evbs;
+}
+
+void NumaIOThreadPoolExecutor::join() {
+  for (auto& pool : pools_) {
+    pool->join();
+  }
+}
+
+void NumaIOThreadPoolExecutor::stop() {
+  for (auto& pool : pools_) {
+    pool->stop();
+  }
+}
+
+} // namespace folly
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/DefaultKeepAliveExecutor.h>
+#include <folly/concurrency/CacheLocality.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/lang/Align.h>
+#include <folly/synchronization/RelaxedAtomic.h>
+
+namespace folly {
+
+// Options of NumaCPUThreadPoolExecutor and NumaIOThreadPoolExecutor.
+struct NumaThreadPoolOptions {
+  NumaThreadPoolOptions() : topology(NumaTopology::system()) {}
+
+  NumaThreadPoolOptions& setTopology(NumaTopology t) {
+    topology = std::move(t);
+    return *this;
+  }
+  NumaThreadPoolOptions& setSpillThreshold(size_t n) {
+    spillThreshold = n;
+    return *this;
+  }
+  NumaThreadPoolOptions& setPinThreads(bool b) {
+    pinThreads = b;
+    return *this;
+  }
+
+  NumaTopology topology;
+  size_t spillThreshold{64};
+  // Whether to restrict threads to the cpus of their node.
+  bool pinThreads{true};
+};
+
+namespace detail {
+
+// Picks the node to run each task on, and counts the tasks in flight on
+// each node.
+class NumaTaskRouter {
+ public:
+  NumaTaskRouter(const NumaTopology& topology, size_t spillThreshold);
+
+  size_t pick() const;
+
+  // Wraps func to count it as in flight on node until it is run or
+  // destroyed.
+  Func track(size_t node, Func func);
+
+  size_t numNodes() const { return topology_.numNodes(); }
+  const NumaTopology& topology() const { return topology_; }
+
+  // The number of threads of each node, for numThreads in total.
+  std::vector<size_t> splitThreads(size_t numThreads) const;
+
+  // A thread factory for the threads of node.
+  std::shared_ptr<ThreadFactory> makeThreadFactory(
+      const std::string& namePrefix, size_t node, bool pinThreads) const;
+
+ private:
+  struct alignas(hardware_destructive_interference_size) Load {
+    relaxed_atomic<size_t> inFlight{0};
+  };
+
+  const NumaTopology topology_;
+  const size_t spillThreshold_;
+  std::unique_ptr<Load[]> loads_;
+};
+
+} // namespace detail
+
+/**
+ * Thread pools partitioned by NUMA node, for multi-socket hosts where tasks
+ * and EventBases bouncing across sockets cause cross-node memory traffic.
+ *
+ * NumaCPUThreadPoolExecutor and NumaIOThreadPoolExecutor create one
+ * CPUThreadPoolExecutor or IOThreadPoolExecutor per node of a NumaTopology,
+ * whose threads are restricted to the cpus of the node by an
+ * AffinityThreadFactory. Threads are split across nodes in proportion to
+ * their cpus, with at least one thread per node.
+ *
+ * add() runs the task on the node of the calling thread, so that tasks added
+ * by tasks stay on their node. A task spills over to the least loaded node
+ * only when the caller's node has more than spillThreshold tasks more in
+ * flight (queued or running) than it.
+ */
+class NumaCPUThreadPoolExecutor : public DefaultKeepAliveExecutor {
+ public:
+  explicit NumaCPUThreadPoolExecutor(
+      size_t numThreads,
+      NumaThreadPoolOptions options = {},
+      CPUThreadPoolExecutor::Options poolOptions = {},
+      std::string namePrefix = "NumaCPUPool");
+
+  // Waits for the tasks added so far, as join() does.
+  ~NumaCPUThreadPoolExecutor() override;
+
+  void add(Func func) override;
+
+  size_t numNodes() const { return pools_.size(); }
+  CPUThreadPoolExecutor& getNodeExecutor(size_t node) {
+    return *pools_.at(node);
+  }
+
+  size_t getPendingTaskCount() const;
+
+  void join();
+  void stop();
+
+ private:
+  detail::NumaTaskRouter router_;
+  std::vector<std::unique_ptr<CPUThreadPoolExecutor>> pools_;
+};
+
+FOLLY_PUSH_WARNING
+// Suppress "NumaIOThreadPoolExecutor inherits DefaultKeepAliveExecutor
+// keepAliveAcquire/keepAliveRelease via dominance"
+FOLLY_MSVC_DISABLE_WARNING(4250)
+
+class NumaIOThreadPoolExecutor : public IOExecutor,
+                                 public DefaultKeepAliveExecutor {
+ public:
+  explicit NumaIOThreadPoolExecutor(
+      size_t numThreads,
+      NumaThreadPoolOptions options = {},
+      IOThreadPoolExecutor::Options poolOptions = {},
+      std::string namePrefix = "NumaIOPool");
+
+  // Waits for the tasks added so far, as join() does.
+  ~NumaIOThreadPoolExecutor() override;
+
+  void add(Func func) override;
+
+  // An EventBase of the calling thread's node, chosen round-robin.
+  folly::EventBase* getEventBase() override;
+
+  std::vector<folly::Executor::KeepAlive<folly::EventBase>> getAllEventBases();
+
+  size_t numNodes() const { return pools_.size(); }
+  IOThreadPoolExecutor& getNodeExecutor(size_t node) {
+    return *pools_.at(node);
+  }
+
+  void join();
+  void stop();
+
+ private:
+  detail::NumaTaskRouter router_;
+  std::vector<std::unique_ptr<IOThreadPoolExecutor>> pools_;
+};
+
+FOLLY_POP_WARNING
+
+} // namespace folly
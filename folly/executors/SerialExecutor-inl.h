@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include <glog/logging.h>
 
 #include <folly/ExceptionString.h>
@@ -24,15 +26,20 @@ namespace folly::detail {
 template <template <typename> typename Queue>
 class SerialExecutorImpl<Queue>::Worker {
  public:
-  explicit Worker(KeepAlive<SerialExecutorImpl> ka) : ka_(std::move(ka)) {}
+  explicit Worker(KeepAlive<SerialExecutorImpl> ka, uint64_t handOff = 0)
+      : ka_(std::move(ka)), handOff_(handOff) {}
 
   ~Worker() {
-    if (ka_) {
-      ka_->drain(); // We own the queue but we did not run.
+    // We own the queue but we did not run. If the worker that yielded to us
+    // is still handing the queue over, it takes it back, otherwise the tasks
+    // are dropped.
+    if (ka_ && !(handOff_ != 0 && ka_->handBack(handOff_))) {
+      ka_->drain();
     }
   }
 
-  Worker(Worker&& other) : ka_(std::exchange(other.ka_, {})) {}
+  Worker(Worker&& other)
+      : ka_(std::exchange(other.ka_, {})), handOff_(other.handOff_) {}
 
   Worker(const Worker&) = delete;
   Worker& operator=(const Worker&) = delete;
@@ -42,11 +49,15 @@ class SerialExecutorImpl<Queue>::Worker {
 
  private:
   KeepAlive<SerialExecutorImpl> ka_;
+  uint64_t handOff_;
 };
 
 template <template <typename> typename Queue>
-SerialExecutorImpl<Queue>::SerialExecutorImpl(KeepAlive<Executor> parent)
-    : parent_(std::move(parent)) {}
+SerialExecutorImpl<Queue>::SerialExecutorImpl(
+    KeepAlive<Executor> parent, Options options)
+    : parent_(std::move(parent)),
+      maxDrainTasks_(std::max<std::size_t>(options.maxDrainTasks, 1)),
+      maxDrainTime_(options.maxDrainTime) {}
 
 template <template <typename> typename Queue>
 SerialExecutorImpl<Queue>::~SerialExecutorImpl() {
@@ -56,15 +67,22 @@ SerialExecutorImpl<Queue>::~SerialExecutorImpl() {
 template <template <typename> typename Queue>
 Executor::KeepAlive<SerialExecutorImpl<Queue>>
 SerialExecutorImpl<Queue>::create(KeepAlive<Executor> parent) {
+  return create(std::move(parent), Options());
+}
+
+template <template <typename> typename Queue>
+Executor::KeepAlive<SerialExecutorImpl<Queue>>
+SerialExecutorImpl<Queue>::create(
+    KeepAlive<Executor> parent, Options options) {
   return makeKeepAlive<SerialExecutorImpl<Queue>>(
-      new SerialExecutorImpl<Queue>(std::move(parent)));
+      new SerialExecutorImpl<Queue>(std::move(parent), options));
 }
 
 template <template <typename> typename Queue>
 typename SerialExecutorImpl<Queue>::UniquePtr
 SerialExecutorImpl<Queue>::createUnique(std::shared_ptr<Executor> parent) {
   auto executor =
-      new SerialExecutorImpl<Queue>(getKeepAliveToken(parent.get()));
+      new SerialExecutorImpl<Queue>(getKeepAliveToken(parent.get()), Options());
   return {executor, Deleter{std::move(parent)}};
 }
 
@@ -100,6 +118,18 @@ void SerialExecutorImpl<Queue>::addWithPriority(Func func, int8_t priority) {
   }
 }
 
+template <template <typename> typename Queue>
+typename SerialExecutorImpl<Queue>::Stats SerialExecutorImpl<Queue>::getStats()
+    const {
+  Stats stats;
+  stats.queueSize = scheduled_.load(std::memory_order_relaxed);
+  stats.drains = drains_.load();
+  stats.yields = yields_.load();
+  stats.tasksRun = tasksRun_.load();
+  stats.maxDrainSize = maxDrainSize_.load();
+  return stats;
+}
+
 template <template <typename> typename Queue>
 bool SerialExecutorImpl<Queue>::scheduleTask(Func&& func) {
   queue_.enqueue(Task{std::move(func), RequestContext::saveContext()});
@@ -110,33 +140,90 @@ bool SerialExecutorImpl<Queue>::scheduleTask(Func&& func) {
 
 template <template <typename> typename Queue>
 void SerialExecutorImpl<Queue>::worker() {
-  std::size_t queueSize = scheduled_.load(std::memory_order_acquire);
-  DCHECK_NE(queueSize, 0);
-
-  std::size_t processed = 0;
-  RequestContextSaverScopeGuard ctxGuard;
-  while (true) {
-    Task task;
-    // This dequeue happens under the request context of the previous task, so
-    // that we can avoid switching context if the next task shares the same
-    // context. dequeue() is cheap, non-blocking, and doesn't run application
-    // logic, so it is fine to sneak it in the previous context.
-    queue_.dequeue(task);
-    RequestContext::setContext(std::move(task.ctx));
-    invokeCatchingExns("SerialExecutor: func", std::exchange(task.func, {}));
-
-    if (++processed == queueSize) {
-      // NOTE: scheduled_ must be decremented after the task has been processed,
-      // or add() may concurrently start another worker.
-      queueSize = scheduled_.fetch_sub(queueSize, std::memory_order_acq_rel) -
-          queueSize;
-      if (queueSize == 0) {
-        // Queue is now empty
-        return;
+  const bool timed = maxDrainTime_ != std::chrono::nanoseconds::zero();
+  do {
+    std::size_t queueSize = scheduled_.load(std::memory_order_acquire);
+    DCHECK_NE(queueSize, 0);
+
+    // The stats are only written while this worker owns the queue, that is
+    // before scheduled_ drops to zero, so they need no read-modify-write.
+    drains_ = drains_.load() + 1;
+    const auto drainDeadline = timed
+        ? std::chrono::steady_clock::now() + maxDrainTime_
+        : std::chrono::steady_clock::time_point::max();
+
+    std::size_t processed = 0;
+    std::size_t drained = 0;
+    RequestContextSaverScopeGuard ctxGuard;
+    while (true) {
+      Task task;
+      // This dequeue happens under the request context of the previous task,
+      // so that we can avoid switching context if the next task shares the
+      // same context. dequeue() is cheap, non-blocking, and doesn't run
+      // application logic, so it is fine to sneak it in the previous context.
+      queue_.dequeue(task);
+      RequestContext::setContext(std::move(task.ctx));
+      invokeCatchingExns("SerialExecutor: func", std::exchange(task.func, {}));
+
+      const bool yield = ++drained == maxDrainTasks_ ||
+          (timed && std::chrono::steady_clock::now() >= drainDeadline);
+      if (++processed == queueSize || yield) {
+        tasksRun_ = tasksRun_.load() + processed;
+        if (drained > maxDrainSize_.load()) {
+          maxDrainSize_ = drained;
+        }
+        // NOTE: scheduled_ must be decremented after the task has been
+        // processed, or add() may concurrently start another worker.
+        queueSize = scheduled_.fetch_sub(processed, std::memory_order_acq_rel) -
+            processed;
+        if (queueSize == 0) {
+          // Queue is now empty
+          return;
+        }
+        processed = 0;
+        if (yield) {
+          break;
+        }
       }
-      processed = 0;
     }
+    // The queue is still non-empty, so add() cannot start another worker and
+    // this one hands the queue over to the next. If that fails, this one
+    // keeps draining it.
+  } while (!yieldToParent());
+}
+
+template <template <typename> typename Queue>
+bool SerialExecutorImpl<Queue>::yieldToParent() {
+  yields_ = yields_.load() + 1;
+  // Only the owner of the queue starts a hand-off, and a worker can only hand
+  // the queue back while the hand-off it was created for is pending, so a
+  // plain store is enough here.
+  const uint64_t handOff = handOff_.load(std::memory_order_relaxed) / 4 + 1;
+  handOff_.store(handOff * 4 + kHandOffPending, std::memory_order_release);
+  try {
+    parent_->add(Worker{getKeepAliveToken(this), handOff});
+  } catch (...) {
+    LOG(ERROR) << "SerialExecutor: failed to reschedule the worker, "
+               << "draining inline: " << exceptionStr(std::current_exception());
+  }
+  // If the worker was destroyed without running, typically because add()
+  // threw, it handed the queue back and this one keeps draining it. Otherwise
+  // close the hand-off: the worker owns the queue, or already passed it on.
+  auto expected = handOff * 4 + kHandOffPending;
+  if (handOff_.compare_exchange_strong(
+          expected,
+          handOff * 4 + kHandOffClosed,
+          std::memory_order_acq_rel)) {
+    return true;
   }
+  return expected != handOff * 4 + kHandOffHandedBack;
+}
+
+template <template <typename> typename Queue>
+bool SerialExecutorImpl<Queue>::handBack(uint64_t handOff) {
+  auto expected = handOff * 4 + kHandOffPending;
+  return handOff_.compare_exchange_strong(
+      expected, handOff * 4 + kHandOffHandedBack, std::memory_order_acq_rel);
 }
 
 template <template <typename> typename Queue>
@@ -17,6 +17,9 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <mutex>
 
@@ -49,6 +52,11 @@ namespace detail {
  * parent executor may observe a smaller number of tasks than those added in the
  * SerialExecutor.
  *
+ * By default a worker runs tasks until the queue is empty, which may hold a
+ * thread of the parent executor for as long as producers keep up. Options can
+ * bound the number of tasks or the time of one such drain, after which the
+ * worker yields and schedules itself again on the parent executor.
+ *
  * The SerialExecutor may be deleted at any time. All tasks that have been
  * submitted will still be executed with the same guarantees, as long as the
  * parent executor is executing tasks.
@@ -61,8 +69,44 @@ class SerialExecutorImpl : public SerializedExecutor {
   SerialExecutorImpl(SerialExecutorImpl&&) = delete;
   SerialExecutorImpl& operator=(SerialExecutorImpl&&) = delete;
 
+  struct Options {
+    Options() {}
+
+    Options& setMaxDrainTasks(std::size_t value) {
+      maxDrainTasks = value;
+      return *this;
+    }
+
+    Options& setMaxDrainTime(std::chrono::nanoseconds value) {
+      maxDrainTime = value;
+      return *this;
+    }
+
+    // Maximum number of tasks run by one worker on the parent executor.
+    std::size_t maxDrainTasks{std::numeric_limits<std::size_t>::max()};
+    // Maximum time spent by one worker on the parent executor, checked after
+    // each task. Zero means no limit.
+    std::chrono::nanoseconds maxDrainTime{0};
+  };
+
+  struct Stats {
+    // Tasks added but not yet run.
+    std::size_t queueSize{0};
+    // Batches of tasks run, one per worker scheduled on the parent executor
+    // plus one per failed attempt to yield, after which the worker keeps
+    // draining inline.
+    uint64_t drains{0};
+    // Workers that yielded on Options limits with tasks left in the queue.
+    uint64_t yields{0};
+    uint64_t tasksRun{0};
+    // Most tasks run by one worker.
+    uint64_t maxDrainSize{0};
+  };
+
   static KeepAlive<SerialExecutorImpl> create(
       KeepAlive<Executor> parent = getGlobalCPUExecutor());
+  static KeepAlive<SerialExecutorImpl> create(
+      KeepAlive<Executor> parent, Options options);
 
   class Deleter {
    public:
@@ -104,6 +148,10 @@ class SerialExecutorImpl : public SerializedExecutor {
     return parent_->getNumPriorities();
   }
 
+  // The counters are updated at the end of each batch of tasks, so they may
+  // lag behind a running worker.
+  Stats getStats() const;
+
  private:
   struct Task {
     Func func;
@@ -112,7 +160,7 @@ class SerialExecutorImpl : public SerializedExecutor {
 
   class Worker;
 
-  explicit SerialExecutorImpl(KeepAlive<Executor> parent);
+  SerialExecutorImpl(KeepAlive<Executor> parent, Options options);
   ~SerialExecutorImpl() override;
 
   bool keepAliveAcquire() noexcept override;
@@ -121,11 +169,26 @@ class SerialExecutorImpl : public SerializedExecutor {
 
   bool scheduleTask(Func&& func);
   void worker();
+  bool yieldToParent();
+  bool handBack(uint64_t handOff);
   void drain();
 
   KeepAlive<Executor> parent_;
   std::atomic<std::size_t> scheduled_{0};
   std::atomic<ssize_t> keepAliveCounter_{1};
+  // Sequence number of the last hand-off of the queue by a yielding worker,
+  // times 4, plus its state. See yieldToParent().
+  static constexpr uint64_t kHandOffPending = 0;
+  static constexpr uint64_t kHandOffHandedBack = 1;
+  static constexpr uint64_t kHandOffClosed = 2;
+  std::atomic<uint64_t> handOff_{kHandOffClosed};
+  const std::size_t maxDrainTasks_;
+  const std::chrono::nanoseconds maxDrainTime_;
+  // Only written by the worker that owns the queue.
+  relaxed_atomic<uint64_t> drains_{0};
+  relaxed_atomic<uint64_t> yields_{0};
+  relaxed_atomic<uint64_t> tasksRun_{0};
+  relaxed_atomic<uint64_t> maxDrainSize_{0};
   Queue<Task> queue_;
 };
 
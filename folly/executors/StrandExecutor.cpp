@@ -56,7 +56,21 @@ class StrandContext::Task {
 };
 
 std::shared_ptr<StrandContext> StrandContext::create() {
-  return std::make_shared<StrandContext>(PrivateTag{});
+  return create(Options());
+}
+
+std::shared_ptr<StrandContext> StrandContext::create(Options options) {
+  return std::make_shared<StrandContext>(PrivateTag{}, options);
+}
+
+StrandContext::Stats StrandContext::getStats() const {
+  Stats stats;
+  stats.queueSize = scheduled_.load(std::memory_order_relaxed);
+  stats.drains = drains_.load();
+  stats.yields = yields_.load();
+  stats.tasksRun = tasksRun_.load();
+  stats.maxDrainSize = maxDrainSize_.load();
+  return stats;
 }
 
 void StrandContext::add(Func func, Executor::KeepAlive<> executor) {
@@ -93,15 +107,32 @@ void StrandContext::addImpl(QueueItem&& item) {
 
 void StrandContext::executeNext(
     std::shared_ptr<StrandContext> thisPtr) noexcept {
-  // Put a cap on the number of items we process in one batch before
-  // rescheduling on to the executor to avoid starvation of other
+  // Put a cap on the number of items, or the time, we process in one batch
+  // before rescheduling on to the executor to avoid starvation of other
   // items queued to the current executor.
-  const std::size_t maxItemsToProcessSynchronously = 32;
+  const std::size_t maxItemsToProcessSynchronously = thisPtr->maxDrainTasks_;
+  const bool timed =
+      thisPtr->maxDrainTime_ != std::chrono::nanoseconds::zero();
+  const auto drainDeadline = timed
+      ? std::chrono::steady_clock::now() + thisPtr->maxDrainTime_
+      : std::chrono::steady_clock::time_point::max();
 
   std::size_t queueSize = thisPtr->scheduled_.load(std::memory_order_acquire);
   DCHECK(queueSize != 0u);
 
+  // The stats are only written while this hop owns the queue, that is before
+  // scheduled_ drops to zero, so they need no read-modify-write.
+  thisPtr->drains_ = thisPtr->drains_.load() + 1;
+  std::size_t drained = 0;
+  auto recordDrain = [&](std::size_t count) {
+    thisPtr->tasksRun_ = thisPtr->tasksRun_.load() + count;
+    if (drained > thisPtr->maxDrainSize_.load()) {
+      thisPtr->maxDrainSize_ = drained;
+    }
+  };
+
   const QueueItem* nextItem = nullptr;
+  bool yield = true;
 
   std::size_t pendingCount = 0;
   {
@@ -113,8 +144,10 @@ void StrandContext::executeNext(
           "StrandExecutor: func", std::exchange(item.func, {}));
 
       ++pendingCount;
+      ++drained;
 
       if (pendingCount == queueSize) {
+        recordDrain(pendingCount);
         queueSize =
             thisPtr->scheduled_.fetch_sub(
                 pendingCount, std::memory_order_acq_rel) -
@@ -134,6 +167,11 @@ void StrandContext::executeNext(
       // If so we'll go around the loop again, otherwise
       // we'll dispatch to the other executor and return.
       if (nextItem->executor.get() != item.executor.get()) {
+        yield = false;
+        break;
+      }
+
+      if (timed && std::chrono::steady_clock::now() >= drainDeadline) {
         break;
       }
     }
@@ -142,6 +180,10 @@ void StrandContext::executeNext(
   DCHECK(nextItem != nullptr);
   DCHECK(pendingCount < queueSize);
 
+  recordDrain(pendingCount);
+  if (yield) {
+    thisPtr->yields_ = thisPtr->yields_.load() + 1;
+  }
   [[maybe_unused]] auto prevQueueSize =
       thisPtr->scheduled_.fetch_sub(pendingCount, std::memory_order_relaxed);
   DCHECK(pendingCount < prevQueueSize);
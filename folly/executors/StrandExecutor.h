@@ -17,12 +17,15 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 
 #include <folly/Optional.h>
 #include <folly/concurrency/UnboundedQueue.h>
 #include <folly/executors/SerializedExecutor.h>
 #include <folly/io/async/Request.h>
+#include <folly/synchronization/RelaxedAtomic.h>
 
 namespace folly {
 class StrandExecutor;
@@ -76,11 +79,46 @@ class StrandExecutor;
 //
 class StrandContext : public std::enable_shared_from_this<StrandContext> {
  public:
+  // Bounds on the work done in one hop on an executor, after which the strand
+  // is rescheduled on the executor so that other work queued there can run.
+  // A hop also ends when the next function is for another executor.
+  struct Options {
+    Options() {}
+
+    Options& setMaxDrainTasks(std::size_t value) {
+      maxDrainTasks = value;
+      return *this;
+    }
+
+    Options& setMaxDrainTime(std::chrono::nanoseconds value) {
+      maxDrainTime = value;
+      return *this;
+    }
+
+    std::size_t maxDrainTasks{32};
+    // Checked after each function. Zero means no limit.
+    std::chrono::nanoseconds maxDrainTime{0};
+  };
+
+  struct Stats {
+    // Functions added but not yet run.
+    std::size_t queueSize{0};
+    // Hops on an executor.
+    uint64_t drains{0};
+    // Hops that ended on Options limits with functions for the same
+    // executor left in the queue.
+    uint64_t yields{0};
+    uint64_t tasksRun{0};
+    // Most functions run in one hop.
+    uint64_t maxDrainSize{0};
+  };
+
   // Create a new StrandContext object. This will allow scheduling work
   // that will execute at most one task at a time but delegate the actual
   // execution to an execution context associated with each particular
   // function.
   static std::shared_ptr<StrandContext> create();
+  static std::shared_ptr<StrandContext> create(Options options);
 
   // Schedule 'func()' to be called on 'executor' after all prior functions
   // scheduled to this context have completed.
@@ -94,6 +132,10 @@ class StrandContext : public std::enable_shared_from_this<StrandContext> {
   void addWithPriority(
       Func func, Executor::KeepAlive<> executor, int8_t priority);
 
+  // The counters are updated at the end of each batch of functions, so they
+  // may lag behind a running hop.
+  Stats getStats() const;
+
  private:
   struct PrivateTag {};
   class Task;
@@ -102,7 +144,9 @@ class StrandContext : public std::enable_shared_from_this<StrandContext> {
   // Public to allow construction using std::make_shared() but a logically
   // private constructor. Try to enforce this by forcing use of a private
   // tag-type as a parameter.
-  explicit StrandContext(PrivateTag) {}
+  StrandContext(PrivateTag, Options options)
+      : maxDrainTasks_(options.maxDrainTasks ? options.maxDrainTasks : 1),
+        maxDrainTime_(options.maxDrainTime) {}
 
  private:
   struct QueueItem {
@@ -118,6 +162,13 @@ class StrandContext : public std::enable_shared_from_this<StrandContext> {
       std::shared_ptr<StrandContext> thisPtr) noexcept;
 
   std::atomic<std::size_t> scheduled_{0};
+  const std::size_t maxDrainTasks_;
+  const std::chrono::nanoseconds maxDrainTime_;
+  // Only written by the hop that owns the queue.
+  relaxed_atomic<uint64_t> drains_{0};
+  relaxed_atomic<uint64_t> yields_{0};
+  relaxed_atomic<uint64_t> tasksRun_{0};
+  relaxed_atomic<uint64_t> maxDrainSize_{0};
   UMPSCQueue<QueueItem, /*MayBlock=*/false, /*LgSegmentSize=*/6> queue_;
 };
 
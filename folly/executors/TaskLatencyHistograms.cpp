@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/TaskLatencyHistograms.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <folly/lang/Bits.h>
+
+namespace folly {
+
+TaskLatencyHistograms::TaskLatencyHistograms(Options options)
+    : sampleRate_(options.sampleRate) {
+  retired_.sampleRate = sampleRate_;
+}
+
+/* static */ std::size_t TaskLatencyHistograms::bucketIndex(
+    std::chrono::nanoseconds value) {
+  if (value.count() < int64_t(kSubBuckets)) {
+    return value.count() > 0 ? std::size_t(value.count()) : 0;
+  }
+  auto v = uint64_t(value.count());
+  // Position of the highest bit, at least 2 here.
+  std::size_t exponent = findLastSet(v) - 1;
+  if (exponent >= kMaxExponent) {
+    return kNumBuckets - 1;
+  }
+  std::size_t sub = (v >> (exponent - 2)) & (kSubBuckets - 1);
+  return kSubBuckets * (exponent - 1) + sub;
+}
+
+/* static */ uint64_t TaskLatencyHistograms::bucketLowerBoundNs(
+    std::size_t bucket) {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  std::size_t exponent = bucket / kSubBuckets + 1;
+  std::size_t sub = bucket % kSubBuckets;
+  return (kSubBuckets + sub) << (exponent - 2);
+}
+
+/* static */ uint64_t TaskLatencyHistograms::bucketUpperBoundNs(
+    std::size_t bucket) {
+  if (bucket < kSubBuckets) {
+    return bucket + 1;
+  }
+  std::size_t exponent = bucket / kSubBuckets + 1;
+  return bucketLowerBoundNs(bucket) + (uint64_t(1) << (exponent - 2));
+}
+
+std::chrono::nanoseconds
+TaskLatencyHistograms::Distribution::percentileEstimate(double pct) const {
+  if (count_ == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  pct = std::clamp(pct, 0.0, 1.0);
+  // Rank of the sample, and where it falls in its bucket.
+  double rank = pct * double(count_);
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < kNumBuckets; ++i) {
+    if (buckets_[i] == 0) {
+      continue;
+    }
+    if (double(seen + buckets_[i]) >= rank) {
+      double fraction = (rank - double(seen)) / double(buckets_[i]);
+      auto lower = double(bucketLowerBoundNs(i));
+      auto upper = double(bucketUpperBoundNs(i));
+      return std::chrono::nanoseconds(
+          int64_t(std::llround(lower + fraction * (upper - lower))));
+    }
+    seen += buckets_[i];
+  }
+  return std::chrono::nanoseconds(bucketUpperBoundNs(kNumBuckets - 1));
+}
+
+void TaskLatencyHistograms::Distribution::merge(const Distribution& other) {
+  for (std::size_t i = 0; i < kNumBuckets; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sumNs_ += other.sumNs_;
+}
+
+void TaskLatencyHistograms::AtomicDistribution::addTo(
+    Distribution& distribution) const {
+  for (std::size_t i = 0; i < kNumBuckets; ++i) {
+    auto count = buckets_[i].load();
+    distribution.buckets_[i] += count;
+    distribution.count_ += count;
+  }
+  distribution.sumNs_ += sumNs_.load();
+}
+
+TaskLatencyHistograms::Shard::~Shard() {
+  std::lock_guard guard(parent.retiredMutex_);
+  parent.retired_.tasks += tasks.load();
+  waitTime.addTo(parent.retired_.waitTime);
+  runTime.addTo(parent.retired_.runTime);
+}
+
+TaskLatencyHistograms::Snapshot TaskLatencyHistograms::getSnapshot() const {
+  Snapshot snapshot;
+  snapshot.sampleRate = sampleRate_;
+  shards_.forEach([&](const Shard& shard) {
+    snapshot.tasks += shard.tasks.load();
+    shard.waitTime.addTo(snapshot.waitTime);
+    shard.runTime.addTo(snapshot.runTime);
+  });
+  std::lock_guard guard(retiredMutex_);
+  snapshot.tasks += retired_.tasks;
+  snapshot.waitTime.merge(retired_.waitTime);
+  snapshot.runTime.merge(retired_.runTime);
+  return snapshot;
+}
+
+} // namespace folly
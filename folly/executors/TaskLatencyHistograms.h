@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <folly/CPortability.h>
+#include <folly/Likely.h>
+#include <folly/ThreadLocal.h>
+#include <folly/synchronization/RelaxedAtomic.h>
+
+namespace folly {
+
+/**
+ * Histograms of the queueing delay (enqueue to start) and the run time of the
+ * tasks of an executor, usually attached with
+ * ThreadPoolExecutor::addTaskLatencyHistograms().
+ *
+ * Every thread records into its own histograms with plain relaxed stores, so
+ * recording takes no lock and no read-modify-write. getSnapshot() sums the
+ * histograms of all threads, and those of the threads that exited.
+ *
+ * Buckets are log-linear, with 4 buckets per power of two of nanoseconds, so
+ * percentile estimates are within 25% of the actual value. Durations of more
+ * than 2^40ns (about 18 minutes) go in the last bucket.
+ *
+ * With Options::sampleRate = N, each thread records one task out of N, and
+ * the histograms count sampled tasks only.
+ */
+class TaskLatencyHistograms {
+ public:
+  static constexpr std::size_t kSubBuckets = 4;
+  static constexpr std::size_t kMaxExponent = 40;
+  // Exact buckets for 0 to 3ns, kSubBuckets per power of two up to
+  // 2^kMaxExponent, and one bucket for longer durations.
+  static constexpr std::size_t kNumBuckets =
+      kSubBuckets * (kMaxExponent - 1) + 1;
+
+  struct Options {
+    Options() {}
+
+    Options& setSampleRate(uint32_t value) {
+      sampleRate = value;
+      return *this;
+    }
+
+    // Record one task out of sampleRate, on each thread. 0 records nothing.
+    uint32_t sampleRate{1};
+  };
+
+  class Distribution {
+   public:
+    uint64_t count() const { return count_; }
+    std::chrono::nanoseconds sum() const {
+      return std::chrono::nanoseconds(sumNs_);
+    }
+    std::chrono::nanoseconds mean() const {
+      return std::chrono::nanoseconds(count_ ? sumNs_ / count_ : 0);
+    }
+
+    // Estimate of the duration below which the given fraction, in [0, 1], of
+    // the samples are.
+    std::chrono::nanoseconds percentileEstimate(double pct) const;
+
+    uint64_t bucketCount(std::size_t bucket) const { return buckets_[bucket]; }
+
+    void merge(const Distribution& other);
+
+   private:
+    friend class TaskLatencyHistograms;
+
+    std::array<uint64_t, kNumBuckets> buckets_{};
+    uint64_t count_{0};
+    uint64_t sumNs_{0};
+  };
+
+  struct Snapshot {
+    // Tasks that completed, sampled or not.
+    uint64_t tasks{0};
+    uint32_t sampleRate{0};
+    Distribution waitTime;
+    // Does not include expired tasks, which did not run.
+    Distribution runTime;
+  };
+
+  explicit TaskLatencyHistograms(Options options = {});
+
+  TaskLatencyHistograms(const TaskLatencyHistograms&) = delete;
+  TaskLatencyHistograms& operator=(const TaskLatencyHistograms&) = delete;
+
+  // Records a task that was processed on the calling thread.
+  void record(
+      std::chrono::nanoseconds waitTime,
+      std::chrono::nanoseconds runTime,
+      bool expired = false) {
+    if (FOLLY_UNLIKELY(sampleRate_ == 0)) {
+      return;
+    }
+    auto& shard = *shards_;
+    shard.tasks = shard.tasks.load() + 1;
+    if (--shard.countdown != 0) {
+      return;
+    }
+    shard.countdown = sampleRate_;
+    shard.waitTime.add(waitTime);
+    if (!expired) {
+      shard.runTime.add(runTime);
+    }
+  }
+
+  Snapshot getSnapshot() const;
+
+  // Index of the bucket of a duration, and the range of durations of a
+  // bucket.
+  static std::size_t bucketIndex(std::chrono::nanoseconds value);
+  static uint64_t bucketLowerBoundNs(std::size_t bucket);
+  static uint64_t bucketUpperBoundNs(std::size_t bucket);
+
+ private:
+  class AtomicDistribution {
+   public:
+    // Only called by the owning thread.
+    void add(std::chrono::nanoseconds value) {
+      auto& bucket = buckets_[bucketIndex(value)];
+      bucket = bucket.load() + 1;
+      sumNs_ = sumNs_.load() + uint64_t(value.count() > 0 ? value.count() : 0);
+    }
+
+    void addTo(Distribution& distribution) const;
+
+   private:
+    std::array<relaxed_atomic<uint64_t>, kNumBuckets> buckets_{};
+    relaxed_atomic<uint64_t> sumNs_{0};
+  };
+
+  struct Shard {
+    explicit Shard(TaskLatencyHistograms& parent_)
+        : parent(parent_), countdown(parent_.sampleRate_) {}
+    // Folds the histograms into parent.retired_ when the thread exits.
+    ~Shard();
+
+    TaskLatencyHistograms& parent;
+    uint32_t countdown;
+    relaxed_atomic<uint64_t> tasks{0};
+    AtomicDistribution waitTime;
+    AtomicDistribution runTime;
+  };
+
+  struct Tag {};
+
+  class ShardPtr {
+   public:
+    explicit ShardPtr(TaskLatencyHistograms& parent) : parent_(parent) {}
+
+    Shard& operator*() const {
+      auto* shard = tl_.get();
+      return FOLLY_LIKELY(!!shard) ? *shard : make();
+    }
+
+    template <class F>
+    void forEach(F&& f) const {
+      for (const auto& shard : tl_.accessAllThreads()) {
+        f(shard);
+      }
+    }
+
+   private:
+    FOLLY_NOINLINE Shard& make() const {
+      auto* shard = new Shard(parent_);
+      tl_.reset(shard);
+      return *shard;
+    }
+
+    TaskLatencyHistograms& parent_;
+    mutable ThreadLocalPtr<Shard, Tag> tl_;
+  };
+
+  const uint32_t sampleRate_;
+  mutable std::mutex retiredMutex_;
+  Snapshot retired_;
+  // Must be destroyed first, since it folds the shards into retired_.
+  ShardPtr shards_{*this};
+};
+
+} // namespace folly
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/ThreadPerCoreExecutor.h>
+
+#include <algorithm>
+
+#include <glog/logging.h>
+#include <folly/ScopeGuard.h>
+#include <folly/executors/thread_factory/AffinityThreadFactory.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/io/async/EventBaseManager.h>
+
+namespace folly {
+
+ThreadPerCoreExecutor::ThreadPerCoreExecutor(Options options)
+    : maxLocalBatch_(std::max(options.maxLocalBatch, size_t(1))) {
+  auto numCores = options.numCores;
+  if (numCores == 0) {
+    numCores = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  auto factory =
+      std::make_shared<NamedThreadFactory>(options.threadNamePrefix);
+  for (size_t i = 0; i < numCores; ++i) {
+    cores_.push_back(std::make_unique<Core>(*this, i));
+  }
+  for (auto& core : cores_) {
+    auto run = [c = core.get()] { c->run(); };
+    if (!options.pinThreads) {
+      core->thread = factory->newThread(std::move(run));
+      continue;
+    }
+    auto const cpu = options.cpus.empty()
+        ? core->index
+        : options.cpus[core->index % options.cpus.size()];
+    core->thread =
+        AffinityThreadFactory(factory, {cpu}).newThread(std::move(run));
+  }
+  for (auto& core : cores_) {
+    core->evb.waitUntilRunning();
+  }
+}
+
+ThreadPerCoreExecutor::~ThreadPerCoreExecutor() {
+  join();
+}
+
+/* static */ ThreadPerCoreExecutor::Core*&
+ThreadPerCoreExecutor::currentCore() {
+  static thread_local Core* core = nullptr;
+  return core;
+}
+
+ThreadPerCoreExecutor::Core* ThreadPerCoreExecutor::currentCoreOfThis() const {
+  auto* core = currentCore();
+  return core && &core->parent == this ? core : nullptr;
+}
+
+ThreadPerCoreExecutor::Core& ThreadPerCoreExecutor::pickCore() {
+  return *cores_[nextCore_++ % cores_.size()];
+}
+
+void ThreadPerCoreExecutor::add(Func func) {
+  if (auto* core = currentCoreOfThis()) {
+    core->addLocal(std::move(func));
+    return;
+  }
+  addRemote(pickCore(), std::move(func));
+}
+
+void ThreadPerCoreExecutor::addToCore(size_t core, Func func) {
+  auto& target = *cores_.at(core);
+  if (currentCoreOfThis() == &target) {
+    target.addLocal(std::move(func));
+    return;
+  }
+  addRemote(target, std::move(func));
+}
+
+void ThreadPerCoreExecutor::addRemote(Core& core, Func func) {
+  core.remoteTasks++;
+  core.remotePending++;
+  core.evb.runInEventBaseThread([&core, func = std::move(func)]() mutable {
+    SCOPE_EXIT {
+      core.remotePending--;
+    };
+    invokeCatchingExns("ThreadPerCoreExecutor: func", std::move(func));
+  });
+}
+
+void ThreadPerCoreExecutor::Core::addLocal(Func func) {
+  localTasks = localTasks.load() + 1;
+  local.emplace_back(std::move(func), RequestContext::saveContext());
+  localPending = local.size();
+  if (!isLoopCallbackScheduled()) {
+    // The tasks carry their own RequestContext.
+    evb.runInLoop(this, /* thisIteration */ false, nullptr);
+  }
+}
+
+void ThreadPerCoreExecutor::Core::runLoopCallback() noexcept {
+  // Tasks added by these tasks run in the next iteration at the earliest,
+  // after the IO events of the core.
+  auto batch = std::min(local.size(), parent.maxLocalBatch_);
+  for (size_t i = 0; i < batch; ++i) {
+    auto task = std::move(local.front());
+    local.pop_front();
+    localPending = local.size();
+    RequestContextScopeGuard rctx(std::move(task.second));
+    invokeCatchingExns("ThreadPerCoreExecutor: func", std::move(task.first));
+  }
+  if (!local.empty() && !isLoopCallbackScheduled()) {
+    evb.runInLoop(this, /* thisIteration */ false, nullptr);
+  }
+}
+
+void ThreadPerCoreExecutor::Core::run() {
+  auto* manager = EventBaseManager::get();
+  manager->setEventBase(&evb, false);
+  currentCore() = this;
+  SCOPE_EXIT {
+    currentCore() = nullptr;
+    manager->clearEventBase();
+  };
+
+  while (shouldRun) {
+    evb.loopForever();
+  }
+  // Run the tasks that are still queued, and those they add to this core.
+  while (remotePending > 0 || !local.empty()) {
+    evb.loopOnce();
+  }
+}
+
+EventBase* ThreadPerCoreExecutor::getEventBase() {
+  if (auto* core = currentCoreOfThis()) {
+    return &core->evb;
+  }
+  return &pickCore().evb;
+}
+
+std::vector<Executor::KeepAlive<EventBase>>
+ThreadPerCoreExecutor::getAllEventBases() {
+  std::vector<Executor::KeepAlive<EventBase>> evbs;
+  evbs.reserve(cores_.size());
+  for (auto& core : cores_) {
+    evbs.push_back(getKeepAliveToken(core->evb));
+  }
+  return evbs;
+}
+
+Optional<size_t> ThreadPerCoreExecutor::getCurrentCore() const {
+  if (auto* core = currentCoreOfThis()) {
+    return core->index;
+  }
+  return none;
+}
+
+ThreadPerCoreExecutor::CoreStats ThreadPerCoreExecutor::getCoreStats(
+    size_t core) const {
+  auto const& c = *cores_.at(core);
+  CoreStats stats;
+  stats.localTasks = c.localTasks;
+  stats.remoteTasks = c.remoteTasks;
+  stats.pendingTasks = c.localPending + c.remotePending;
+  return stats;
+}
+
+void ThreadPerCoreExecutor::join() {
+  if (std::exchange(joined_, true)) {
+    return;
+  }
+  DCHECK(!currentCoreOfThis())
+      << "ThreadPerCoreExecutor: join() from a thread of the executor";
+  joinKeepAlive();
+  for (auto& core : cores_) {
+    core->evb.runInEventBaseThread([c = core.get()] {
+      c->shouldRun = false;
+      c->evb.terminateLoopSoon();
+    });
+  }
+  for (auto& core : cores_) {
+    core->thread.join();
+  }
+}
+
+} // namespace folly
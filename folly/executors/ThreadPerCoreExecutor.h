@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <folly/DefaultKeepAliveExecutor.h>
+#include <folly/Optional.h>
+#include <folly/executors/IOExecutor.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/Request.h>
+#include <folly/lang/Align.h>
+#include <folly/synchronization/RelaxedAtomic.h>
+
+namespace folly {
+
+FOLLY_PUSH_WARNING
+// Suppress "ThreadPerCoreExecutor inherits DefaultKeepAliveExecutor
+// keepAliveAcquire/keepAliveRelease via dominance"
+FOLLY_MSVC_DISABLE_WARNING(4250)
+
+/**
+ * A thread-per-core executor: one thread per core, each pinned to its cpu,
+ * running an EventBase loop that also drains a local queue of CPU tasks.
+ *
+ * It replaces the usual split between an IOThreadPoolExecutor, whose threads
+ * do network IO, and a CPUThreadPoolExecutor, whose threads run the request
+ * handlers: a request is read, handled and answered on the same core, with no
+ * hop between thread pools and no cache misses on the request's data.
+ *
+ * add() from a thread of the executor appends to the local queue of the
+ * calling core, which takes no lock and no atomic read-modify-write. add()
+ * from any other thread picks a core round-robin, and addToCore() passes a
+ * message to a given core explicitly; both go through the EventBase's
+ * AtomicNotificationQueue and wake up its loop.
+ *
+ * The local queue is drained by a loop callback, at most maxLocalBatch tasks
+ * per loop iteration, so that a burst of CPU tasks doesn't starve the IO of
+ * the core.
+ *
+ * As an IOExecutor, getEventBase() returns the EventBase of the calling core,
+ * or one chosen round-robin from other threads, so that an AsyncServerSocket
+ * can accept connections on all the cores:
+ *
+ *   ThreadPerCoreExecutor executor;
+ *   auto socket = AsyncServerSocket::newSocket(executor.getEventBase(0));
+ *   for (auto& evb : executor.getAllEventBases()) {
+ *     socket->addAcceptCallback(&acceptor, evb.get());
+ *   }
+ *
+ * and the handlers of the connections accepted on a core can add() their
+ * work to the executor to keep it on that core.
+ */
+class ThreadPerCoreExecutor : public DefaultKeepAliveExecutor,
+                              public IOExecutor {
+ public:
+  struct Options {
+    Options() {}
+
+    // The number of cores, 0 for one per hardware thread.
+    Options& setNumCores(size_t n) {
+      numCores = n;
+      return *this;
+    }
+    // The cpu of each core, core i running on cpus[i % cpus.size()]. Empty
+    // for cpu i on core i.
+    Options& setCpus(std::vector<size_t> c) {
+      cpus = std::move(c);
+      return *this;
+    }
+    Options& setPinThreads(bool b) {
+      pinThreads = b;
+      return *this;
+    }
+    Options& setMaxLocalBatch(size_t n) {
+      maxLocalBatch = n;
+      return *this;
+    }
+    Options& setThreadNamePrefix(std::string prefix) {
+      threadNamePrefix = std::move(prefix);
+      return *this;
+    }
+
+    size_t numCores{0};
+    std::vector<size_t> cpus;
+    // Whether to restrict the thread of each core to its cpu.
+    bool pinThreads{true};
+    // The maximum number of local tasks run per loop iteration.
+    size_t maxLocalBatch{64};
+    std::string threadNamePrefix{"ThreadPerCore"};
+  };
+
+  struct CoreStats {
+    // Tasks added from the core itself, to its local queue.
+    uint64_t localTasks{0};
+    // Tasks added from other threads, through the EventBase.
+    uint64_t remoteTasks{0};
+    // Tasks added but not run yet.
+    size_t pendingTasks{0};
+  };
+
+  explicit ThreadPerCoreExecutor(Options options = {});
+
+  // Waits for the tasks added so far, as join() does.
+  ~ThreadPerCoreExecutor() override;
+
+  ThreadPerCoreExecutor(const ThreadPerCoreExecutor&) = delete;
+  ThreadPerCoreExecutor& operator=(const ThreadPerCoreExecutor&) = delete;
+
+  // Runs func on the calling core, or on a core chosen round-robin if not
+  // called from a thread of the executor.
+  void add(Func func) override;
+
+  // Runs func on the given core.
+  void addToCore(size_t core, Func func);
+
+  // The EventBase of the calling core, or of a core chosen round-robin if not
+  // called from a thread of the executor.
+  EventBase* getEventBase() override;
+  EventBase* getEventBase(size_t core) { return &cores_.at(core)->evb; }
+
+  std::vector<Executor::KeepAlive<EventBase>> getAllEventBases();
+
+  size_t numCores() const { return cores_.size(); }
+
+  // The core of the calling thread, if it is a thread of this executor.
+  Optional<size_t> getCurrentCore() const;
+
+  CoreStats getCoreStats(size_t core) const;
+
+  // Runs the tasks added so far, and those they add to their own core, and
+  // stops the threads. Tasks must not be added afterwards, and tasks added to
+  // another core by the tasks run during join() may be dropped.
+  void join();
+
+ private:
+  class Core : public EventBase::LoopCallback {
+   public:
+    Core(ThreadPerCoreExecutor& parent_, size_t index_)
+        : parent(parent_), index(index_) {}
+    // Must not be left scheduled on evb, which is destroyed first.
+    ~Core() override { cancelLoopCallback(); }
+
+    // Only called from the thread of the core.
+    void addLocal(Func func);
+    void runLoopCallback() noexcept override;
+
+    void run();
+
+    ThreadPerCoreExecutor& parent;
+    const size_t index;
+    EventBase evb;
+    std::thread thread;
+    // Only accessed from the thread of the core.
+    std::deque<std::pair<Func, std::shared_ptr<RequestContext>>> local;
+    bool shouldRun{true};
+
+    // Only written from the thread of the core.
+    relaxed_atomic<uint64_t> localTasks{0};
+    relaxed_atomic<size_t> localPending{0};
+
+    alignas(hardware_destructive_interference_size)
+        relaxed_atomic<uint64_t> remoteTasks{0};
+    relaxed_atomic<size_t> remotePending{0};
+  };
+
+  static Core*& currentCore();
+  Core* currentCoreOfThis() const;
+  Core& pickCore();
+  void addRemote(Core& core, Func func);
+
+  const size_t maxLocalBatch_;
+  std::vector<std::unique_ptr<Core>> cores_;
+  relaxed_atomic<size_t> nextCore_{0};
+  bool joined_{false};
+};
+
+FOLLY_POP_WARNING
+
+} // namespace folly
@@ -381,6 +381,28 @@ void ThreadPoolExecutor::subscribeToTaskStats(TaskStatsCallback cb) {
   addTaskObserver(std::make_unique<TaskStatsCallbackObserver>(std::move(cb)));
 }
 
+std::shared_ptr<TaskLatencyHistograms>
+ThreadPoolExecutor::addTaskLatencyHistograms(
+    TaskLatencyHistograms::Options options) {
+  class TaskLatencyObserver : public TaskObserver {
+   public:
+    explicit TaskLatencyObserver(
+        std::shared_ptr<TaskLatencyHistograms> histograms)
+        : histograms_(std::move(histograms)) {}
+
+    void taskProcessed(const ProcessedTaskInfo& info) noexcept override {
+      histograms_->record(info.waitTime, info.runTime, info.expired);
+    }
+
+   private:
+    std::shared_ptr<TaskLatencyHistograms> histograms_;
+  };
+
+  auto histograms = std::make_shared<TaskLatencyHistograms>(options);
+  addTaskObserver(std::make_unique<TaskLatencyObserver>(histograms));
+  return histograms;
+}
+
 void ThreadPoolExecutor::addTaskObserver(
     std::unique_ptr<TaskObserver> taskObserver) {
   auto taskObserverPtr = taskObserver.release();
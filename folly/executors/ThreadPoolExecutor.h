@@ -26,6 +26,7 @@
 #include <folly/Memory.h>
 #include <folly/SharedMutex.h>
 #include <folly/executors/GlobalThreadPoolList.h>
+#include <folly/executors/TaskLatencyHistograms.h>
 #include <folly/executors/task_queue/LifoSemMPMCQueue.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/io/async/Request.h>
@@ -205,6 +206,12 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
   // added observers will be destroyed on executor destruction.
   void addTaskObserver(std::unique_ptr<TaskObserver> taskObserver);
 
+  // Adds a TaskObserver that records the wait and run time of every task, or
+  // of a sample of them, into per-thread histograms. The returned object
+  // aggregates them on demand and can outlive the executor.
+  std::shared_ptr<TaskLatencyHistograms> addTaskLatencyHistograms(
+      TaskLatencyHistograms::Options options = {});
+
   // TODO(ott): Migrate call sites to the TaskObserver interface.
   using TaskStats = ProcessedTaskInfo;
   using TaskStatsCallback = std::function<void(const TaskStats&)>;
@@ -19,11 +19,13 @@
 #include <chrono>
 #include <exception>
 #include <stdexcept>
+#include <vector>
 
 #include <glog/logging.h>
 
 #include <folly/CPortability.h>
 #include <folly/Optional.h>
+#include <folly/Range.h>
 
 namespace folly {
 
@@ -55,9 +57,34 @@ class BlockingQueue {
       T item, int8_t /* priority */) {
     return add(std::move(item));
   }
+  // Adds all items, moving them out of the range, with a single wake-up of
+  // the waiting consumers where supported.
+  //
+  // Returns true if existing threads were able to work on all of them.
+  virtual BlockingQueueAddResult addBatch(Range<T*> items) {
+    bool reused = true;
+    for (auto& item : items) {
+      reused = add(std::move(item)).reusedThread && reused;
+    }
+    return reused;
+  }
   virtual uint8_t getNumPriorities() { return 1; }
   virtual T take() = 0;
   virtual folly::Optional<T> try_take_for(std::chrono::milliseconds time) = 0;
+  // Waits as try_take_for() for an item, then takes up to max - 1 more
+  // without blocking. Appends the items to out and returns their number.
+  virtual size_t try_take_batch_for(
+      std::chrono::milliseconds time, size_t max, std::vector<T>& out) {
+    if (max == 0) {
+      return 0;
+    }
+    auto item = try_take_for(time);
+    if (!item) {
+      return 0;
+    }
+    out.push_back(std::move(*item));
+    return 1;
+  }
   virtual size_t size() = 0;
 };
 
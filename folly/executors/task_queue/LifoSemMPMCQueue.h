@@ -17,6 +17,7 @@
 #pragma once
 
 #include <folly/MPMCQueue.h>
+#include <folly/ScopeGuard.h>
 #include <folly/executors/task_queue/BlockingQueue.h>
 #include <folly/synchronization/LifoSem.h>
 
@@ -48,6 +49,31 @@ class LifoSemMPMCQueue : public BlockingQueue<T> {
     return sem_.post();
   }
 
+  BlockingQueueAddResult addBatch(Range<T*> items) override {
+    uint32_t added = 0;
+    // Wake up consumers for the items added so far, even if adding throws.
+    auto guard = makeGuard([&] {
+      if (added > 0) {
+        sem_.post(added);
+      }
+    });
+    for (auto& item : items) {
+      switch (kBehavior) { // static
+        case QueueBehaviorIfFull::THROW:
+          if (!queue_.writeIfNotFull(std::move(item))) {
+            throw QueueFullException("LifoSemMPMCQueue full, can't add item");
+          }
+          break;
+        case QueueBehaviorIfFull::BLOCK:
+          queue_.blockingWrite(std::move(item));
+          break;
+      }
+      ++added;
+    }
+    guard.dismiss();
+    return added == 0 || sem_.post(added);
+  }
+
   T take() override {
     T item;
     while (!queue_.readIfNotEmpty(item)) {
@@ -66,6 +92,29 @@ class LifoSemMPMCQueue : public BlockingQueue<T> {
     return item;
   }
 
+  size_t try_take_batch_for(
+      std::chrono::milliseconds time,
+      size_t max,
+      std::vector<T>& out) override {
+    if (max == 0) {
+      return 0;
+    }
+    auto item = try_take_for(time);
+    if (!item) {
+      return 0;
+    }
+    out.push_back(std::move(*item));
+    // As in take(), the semaphore only wakes up consumers, so items can be
+    // read without waiting on it.
+    size_t taken = 1;
+    T next;
+    while (taken < max && queue_.readIfNotEmpty(next)) {
+      out.push_back(std::move(next));
+      ++taken;
+    }
+    return taken;
+  }
+
   size_t capacity() { return queue_.capacity(); }
 
   size_t size() override { return queue_.size(); }
@@ -34,6 +34,16 @@ class UnboundedBlockingQueue : public BlockingQueue<T> {
     return sem_.post();
   }
 
+  BlockingQueueAddResult addBatch(Range<T*> items) override {
+    if (items.empty()) {
+      return true;
+    }
+    for (auto& item : items) {
+      queue_.enqueue(std::move(item));
+    }
+    return sem_.post(static_cast<uint32_t>(items.size()));
+  }
+
   T take() override {
     sem_.wait();
     return queue_.dequeue();
@@ -46,6 +56,23 @@ class UnboundedBlockingQueue : public BlockingQueue<T> {
     return queue_.dequeue();
   }
 
+  size_t try_take_batch_for(
+      std::chrono::milliseconds time,
+      size_t max,
+      std::vector<T>& out) override {
+    if (max == 0 || !sem_.try_wait_for(time)) {
+      return 0;
+    }
+    // Each successful wait accounts for exactly one enqueued item.
+    size_t taken = 1;
+    out.push_back(queue_.dequeue());
+    while (taken < max && sem_.try_wait()) {
+      out.push_back(queue_.dequeue());
+      ++taken;
+    }
+    return taken;
+  }
+
   size_t size() override { return queue_.size(); }
 
  private:
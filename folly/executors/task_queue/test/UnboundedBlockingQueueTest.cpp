@@ -17,6 +17,7 @@
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
 
 #include <thread>
+#include <vector>
 
 #include <folly/portability/GTest.h>
 #include <folly/synchronization/Baton.h>
@@ -52,3 +53,34 @@ TEST(UnboundedBlockingQueue, concurrentPushPop) {
   EXPECT_EQ(0, q.size());
   t.join();
 }
+
+TEST(UnboundedBlockingQueue, batch) {
+  UnboundedBlockingQueue<int> q;
+  std::vector<int> items{1, 2, 3, 4, 5};
+  EXPECT_FALSE(q.addBatch(range(items)).reusedThread);
+  EXPECT_EQ(5, q.size());
+
+  std::vector<int> out;
+  EXPECT_EQ(2, q.try_take_batch_for(std::chrono::milliseconds(0), 2, out));
+  EXPECT_EQ(3, q.try_take_batch_for(std::chrono::milliseconds(0), 8, out));
+  EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5}), out);
+  EXPECT_EQ(0, q.try_take_batch_for(std::chrono::milliseconds(0), 8, out));
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(UnboundedBlockingQueue, batchWakesWaiter) {
+  UnboundedBlockingQueue<int> q;
+  Baton<> waiting;
+  std::vector<int> out;
+  std::thread t([&] {
+    waiting.post();
+    while (out.size() < 3) {
+      q.try_take_batch_for(std::chrono::seconds(10), 3, out);
+    }
+  });
+  waiting.wait();
+  std::vector<int> items{1, 2, 3};
+  q.addBatch(range(items));
+  t.join();
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), out);
+}
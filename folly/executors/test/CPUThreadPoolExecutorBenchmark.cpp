@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/synchronization/Baton.h>
+#include <folly/synchronization/Latch.h>
+
+using namespace folly;
+
+// Compares the shared queue of CPUThreadPoolExecutor with its work-stealing
+// mode on workloads where tasks add tasks to the pool, adding tasks one by one
+// with adding them in batches, and fixed with adaptive idle spinning.
+
+static constexpr size_t kNumThreads = 16;
+
+static std::unique_ptr<CPUThreadPoolExecutor> makeExecutor(bool workStealing) {
+  return std::make_unique<CPUThreadPoolExecutor>(
+      kNumThreads,
+      CPUThreadPoolExecutor::Options().setWorkStealing(workStealing));
+}
+
+// Runs n leaf tasks as the leaves of a binary tree of tasks, each inner task
+// adding its two subtrees to the pool, as in a recursive divide and conquer.
+static void spawnTree(Executor& ex, size_t leaves, Latch& done) {
+  if (leaves == 1) {
+    done.count_down();
+    return;
+  }
+  auto const half = leaves / 2;
+  ex.add([&ex, half, &done] { spawnTree(ex, half, done); });
+  ex.add([&ex, rest = leaves - half, &done] { spawnTree(ex, rest, done); });
+}
+
+void forkJoin(uint32_t n, std::unique_ptr<CPUThreadPoolExecutor> ex) {
+  if (n == 0) {
+    return;
+  }
+  Latch done(n);
+  ex->add([&] { spawnTree(*ex, n, done); });
+  done.wait();
+  ex->join();
+}
+
+BENCHMARK_NAMED_PARAM(forkJoin, Shared, makeExecutor(false))
+BENCHMARK_RELATIVE_NAMED_PARAM(forkJoin, WorkStealing, makeExecutor(true))
+
+BENCHMARK_DRAW_LINE();
+
+// Runs n tasks added by a few tasks, each adding its share in a loop, as a
+// request handler fanning out to many subrequests.
+void fanOut(
+    uint32_t n, std::unique_ptr<CPUThreadPoolExecutor> ex, size_t sources) {
+  Latch done(n);
+  for (size_t i = 0; i < sources; ++i) {
+    auto const count = n / sources + (i < n % sources ? 1 : 0);
+    ex->add([&, count] {
+      for (size_t j = 0; j < count; ++j) {
+        ex->add([&] { done.count_down(); });
+      }
+    });
+  }
+  done.wait();
+  ex->join();
+}
+
+BENCHMARK_NAMED_PARAM(fanOut, Shared_1, makeExecutor(false), 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(fanOut, WorkStealing_1, makeExecutor(true), 1)
+BENCHMARK_NAMED_PARAM(fanOut, Shared_4, makeExecutor(false), 4)
+BENCHMARK_RELATIVE_NAMED_PARAM(fanOut, WorkStealing_4, makeExecutor(true), 4)
+
+BENCHMARK_DRAW_LINE();
+
+// Runs n tasks added from outside the pool in bursts of burstSize, with add()
+// or addBatch(), and taken by the workers up to maxDequeueBatch at a time.
+void bursts(uint32_t n, size_t burstSize, bool batch, size_t maxDequeueBatch) {
+  std::unique_ptr<CPUThreadPoolExecutor> ex;
+  std::vector<Func> funcs;
+  BENCHMARK_SUSPEND {
+    ex = std::make_unique<CPUThreadPoolExecutor>(
+        kNumThreads,
+        CPUThreadPoolExecutor::Options().setMaxDequeueBatch(maxDequeueBatch));
+    funcs.reserve(burstSize);
+  }
+  Latch done(n);
+  for (uint32_t added = 0; added < n; added += burstSize) {
+    auto const count = std::min<size_t>(burstSize, n - added);
+    for (size_t i = 0; i < count; ++i) {
+      funcs.push_back([&] { done.count_down(); });
+    }
+    if (batch) {
+      ex->addBatch(range(funcs));
+    } else {
+      for (auto& func : funcs) {
+        ex->add(std::move(func));
+      }
+    }
+    funcs.clear();
+  }
+  done.wait();
+  BENCHMARK_SUSPEND {
+    ex.reset();
+  }
+}
+
+BENCHMARK_NAMED_PARAM(bursts, Add_16, 16, false, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(bursts, AddBatch_16, 16, true, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(bursts, AddBatchDequeue8_16, 16, true, 8)
+BENCHMARK_NAMED_PARAM(bursts, Add_256, 256, false, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(bursts, AddBatch_256, 256, true, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(bursts, AddBatchDequeue8_256, 256, true, 8)
+BENCHMARK_RELATIVE_NAMED_PARAM(bursts, AddBatchDequeue32_256, 256, true, 32)
+
+BENCHMARK_DRAW_LINE();
+
+// Runs n tasks one at a time, waiting for each to run, with a pause of gap
+// between them: the latency of a task added to an idle pool.
+void pingPong(uint32_t n, std::chrono::microseconds gap, bool adaptiveSpin) {
+  std::unique_ptr<CPUThreadPoolExecutor> ex;
+  BENCHMARK_SUSPEND {
+    CPUThreadPoolExecutor::Options options;
+    if (adaptiveSpin) {
+      options.setAdaptiveIdleSpin();
+    }
+    ex = std::make_unique<CPUThreadPoolExecutor>(kNumThreads, options);
+  }
+  for (uint32_t i = 0; i < n; ++i) {
+    auto const resume = std::chrono::steady_clock::now() + gap;
+    while (std::chrono::steady_clock::now() < resume) {
+    }
+    Baton<> done;
+    ex->add([&] { done.post(); });
+    done.wait();
+  }
+  BENCHMARK_SUSPEND {
+    ex.reset();
+  }
+}
+
+BENCHMARK_NAMED_PARAM(pingPong, Gap1us, std::chrono::microseconds(1), false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    pingPong, Gap1usAdaptiveSpin, std::chrono::microseconds(1), true)
+BENCHMARK_NAMED_PARAM(pingPong, Gap20us, std::chrono::microseconds(20), false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    pingPong, Gap20usAdaptiveSpin, std::chrono::microseconds(20), true)
+BENCHMARK_NAMED_PARAM(
+    pingPong, Gap200us, std::chrono::microseconds(200), false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    pingPong, Gap200usAdaptiveSpin, std::chrono::microseconds(200), true)
+
+int main(int argc, char* argv[]) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -49,6 +49,25 @@ TEST(CodelTest, Basic) {
   EXPECT_TRUE(c.overloaded_explicit_now(milliseconds(20), now));
 }
 
+TEST(CodelTest, isOverloaded) {
+  folly::Codel c;
+  auto now = c.getIntervalTime();
+  EXPECT_FALSE(c.isOverloaded());
+
+  c.overloaded_explicit_now(milliseconds(50), now + milliseconds(10));
+  c.overloaded_explicit_now(milliseconds(50), now + milliseconds(20));
+  EXPECT_TRUE(c.isOverloaded());
+
+  // A short delay lowers the minimum of the current interval, but the state
+  // is that of the last completed one.
+  c.overloaded_explicit_now(milliseconds(1), now + milliseconds(30));
+  EXPECT_EQ(milliseconds(1), c.getMinDelay());
+  EXPECT_TRUE(c.isOverloaded());
+
+  c.overloaded_explicit_now(milliseconds(50), now + milliseconds(130));
+  EXPECT_FALSE(c.isOverloaded());
+}
+
 TEST(CodelTest, highLoad) {
   folly::Codel c;
   c.overloaded(milliseconds(40));
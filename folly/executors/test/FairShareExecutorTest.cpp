@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/FairShareExecutor.h>
+
+#include <atomic>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ManualExecutor.h>
+#include <folly/portability/GTest.h>
+#include <folly/portability/Time.h>
+
+using namespace folly;
+
+namespace {
+
+// Uses about the given thread CPU time, which is what tasks are charged.
+void burnCpu(std::chrono::microseconds d) {
+  auto const cpuNow = [] {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) +
+        std::chrono::nanoseconds(ts.tv_nsec);
+  };
+  auto const deadline = cpuNow() + d;
+  while (cpuNow() < deadline) {
+  }
+}
+
+// Runs the fair-share executor one task at a time over a ManualExecutor,
+// recording the queue of each task run.
+class FairShareExecutorTest : public testing::Test {
+ protected:
+  void addTasks(FairShareExecutor::QueueId queue, size_t n) {
+    auto ka = executor_.getQueueExecutor(queue);
+    for (size_t i = 0; i < n; ++i) {
+      ka->add([this, queue] {
+        burnCpu(std::chrono::microseconds(50));
+        order_.push_back(queue);
+      });
+    }
+  }
+
+  void run(size_t n) {
+    for (size_t i = 0; i < n && manual_.step(); ++i) {
+    }
+  }
+
+  using Counts = std::map<FairShareExecutor::QueueId, size_t>;
+
+  // Number of tasks of each queue among the runs [begin, end).
+  Counts count(size_t begin, size_t end) {
+    Counts result;
+    for (size_t i = begin; i < end && i < order_.size(); ++i) {
+      ++result[order_[i]];
+    }
+    return result;
+  }
+
+  void TearDown() override { manual_.drain(); }
+
+  ManualExecutor manual_;
+  FairShareExecutor executor_{getKeepAliveToken(manual_)};
+  std::vector<FairShareExecutor::QueueId> order_;
+};
+
+} // namespace
+
+TEST_F(FairShareExecutorTest, Weights) {
+  auto const a = executor_.addQueue("a", 3);
+  auto const b = executor_.addQueue("b", 1);
+  addTasks(a, 100);
+  addTasks(b, 100);
+  run(40);
+  auto counts = count(0, 40);
+  EXPECT_NEAR(30, counts[a], 4);
+  EXPECT_NEAR(10, counts[b], 4);
+}
+
+TEST_F(FairShareExecutorTest, Hierarchy) {
+  auto const group = executor_.addGroup("group", 1);
+  auto const a = executor_.addQueue("a", 1, group);
+  auto const b = executor_.addQueue("b", 1, group);
+  auto const c = executor_.addQueue("c", 1);
+  addTasks(a, 60);
+  addTasks(b, 60);
+  addTasks(c, 60);
+  run(40);
+  auto counts = count(0, 40);
+  EXPECT_NEAR(10, counts[a], 3);
+  EXPECT_NEAR(10, counts[b], 3);
+  EXPECT_NEAR(20, counts[c], 3);
+
+  auto const stats = executor_.getQueueStats();
+  ASSERT_EQ(6, stats.size());
+  EXPECT_TRUE(stats[group].isGroup);
+  EXPECT_EQ(counts[a] + counts[b], stats[group].tasksRun);
+  EXPECT_EQ(120 - counts[a] - counts[b], stats[group].pendingTasks);
+  EXPECT_EQ(40, stats[FairShareExecutor::kRoot].tasksRun);
+  EXPECT_GE(stats[c].cpuTime, counts[c] * std::chrono::microseconds(50));
+}
+
+TEST_F(FairShareExecutorTest, NoCreditWhileIdle) {
+  auto const a = executor_.addQueue("a", 1);
+  auto const b = executor_.addQueue("b", 1);
+  addTasks(a, 50);
+  run(50);
+  // b was idle while a ran, which gives it no priority over a now.
+  addTasks(a, 50);
+  addTasks(b, 50);
+  run(20);
+  auto counts = count(50, 70);
+  EXPECT_NEAR(10, counts[a], 3);
+  EXPECT_NEAR(10, counts[b], 3);
+}
+
+TEST_F(FairShareExecutorTest, SetWeight) {
+  auto const a = executor_.addQueue("a", 1);
+  auto const b = executor_.addQueue("b", 1);
+  executor_.setWeight(b, 4);
+  addTasks(a, 50);
+  addTasks(b, 50);
+  run(25);
+  auto counts = count(0, 25);
+  EXPECT_NEAR(5, counts[a], 3);
+  EXPECT_NEAR(20, counts[b], 3);
+}
+
+TEST_F(FairShareExecutorTest, InvalidArguments) {
+  auto const group = executor_.addGroup("group", 1);
+  auto const queue = executor_.addQueue("queue", 1, group);
+  EXPECT_THROW(executor_.addQueue("zero", 0), std::invalid_argument);
+  EXPECT_THROW(executor_.addQueue("child", 1, queue), std::invalid_argument);
+  EXPECT_THROW(executor_.addQueue("unknown", 1, 100), std::invalid_argument);
+  EXPECT_THROW(executor_.getQueueExecutor(group), std::invalid_argument);
+  EXPECT_THROW(executor_.setWeight(queue, 0), std::invalid_argument);
+}
+
+TEST_F(FairShareExecutorTest, ExecutionObserver) {
+  struct Observer : ExecutionObserver {
+    void starting(uintptr_t, CallbackType type) noexcept override {
+      EXPECT_EQ(CallbackType::Task, type);
+      ++started;
+    }
+    void stopped(uintptr_t, CallbackType) noexcept override { ++stopped_; }
+    int started{0};
+    int stopped_{0};
+  } observer;
+  executor_.addExecutionObserver(&observer);
+  addTasks(FairShareExecutor::kDefaultQueue, 3);
+  run(3);
+  executor_.removeExecutionObserver(&observer);
+  addTasks(FairShareExecutor::kDefaultQueue, 1);
+  run(1);
+  EXPECT_EQ(3, observer.started);
+  EXPECT_EQ(3, observer.stopped_);
+}
+
+TEST(FairShareExecutor, ThreadPool) {
+  constexpr size_t kQueues = 8;
+  constexpr size_t kTasks = 200;
+  CPUThreadPoolExecutor pool(4);
+  std::atomic<size_t> completed{0};
+  {
+    FairShareExecutor::Options options;
+    options.maxInFlight = 4;
+    FairShareExecutor executor(getKeepAliveToken(pool), options);
+    for (size_t q = 0; q < kQueues; ++q) {
+      auto ka = executor.getQueueExecutor(
+          executor.addQueue(fmt::format("tenant{}", q), q + 1));
+      for (size_t i = 0; i < kTasks; ++i) {
+        ka->add([&] { ++completed; });
+      }
+    }
+    executor.add([&] { ++completed; });
+    // The destructor waits for the pending tasks.
+  }
+  EXPECT_EQ(kQueues * kTasks + 1, completed.load());
+}
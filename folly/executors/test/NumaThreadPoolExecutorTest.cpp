@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/NumaThreadPoolExecutor.h>
+
+#include <numeric>
+
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <folly/synchronization/Latch.h>
+#include <folly/system/ThreadName.h>
+
+using namespace folly;
+
+namespace {
+
+// Two nodes, with all the cpus of the machine on node 0, so that callers are
+// always on node 0.
+NumaThreadPoolOptions twoNodeOptions(size_t spillThreshold) {
+  auto const numCpus = CacheLocality::system().numCpus;
+  std::vector<size_t> cpus(numCpus);
+  std::iota(cpus.begin(), cpus.end(), 0);
+  return NumaThreadPoolOptions()
+      .setTopology(NumaTopology::fromCpusByNode({cpus, {numCpus}}))
+      .setSpillThreshold(spillThreshold)
+      .setPinThreads(false);
+}
+
+std::string nodeOfCurrentThread() {
+  auto name = getCurrentThreadName().value_or("");
+  auto const dash = name.rfind('-');
+  return dash == std::string::npos ? name : name.substr(0, dash);
+}
+
+} // namespace
+
+TEST(NumaThreadPoolExecutorTest, SplitThreads) {
+  detail::NumaTaskRouter router(
+      NumaTopology::fromCpusByNode({{0, 1, 2}, {3}}), 0);
+  EXPECT_EQ((std::vector<size_t>{3, 1}), router.splitThreads(4));
+  EXPECT_EQ((std::vector<size_t>{6, 2}), router.splitThreads(8));
+  // Every node gets a thread.
+  EXPECT_EQ((std::vector<size_t>{1, 1}), router.splitThreads(1));
+}
+
+TEST(NumaThreadPoolExecutorTest, RunsOnLocalNode) {
+  NumaCPUThreadPoolExecutor ex(4, twoNodeOptions(64));
+  ASSERT_EQ(2, ex.numNodes());
+  EXPECT_EQ(
+      4,
+      ex.getNodeExecutor(0).numThreads() + ex.getNodeExecutor(1).numThreads());
+
+  constexpr size_t kTasks = 32;
+  std::vector<std::string> nodes(kTasks);
+  Latch done(kTasks);
+  for (size_t i = 0; i < kTasks; ++i) {
+    ex.add([&, i] {
+      nodes[i] = nodeOfCurrentThread();
+      done.count_down();
+    });
+  }
+  done.wait();
+  for (auto const& node : nodes) {
+    EXPECT_EQ("NumaCPUPool0", node);
+  }
+}
+
+TEST(NumaThreadPoolExecutorTest, SpillsWhenLocalNodeIsBusy) {
+  constexpr size_t kSpillThreshold = 4;
+  // One thread per node, as every node gets at least one.
+  NumaCPUThreadPoolExecutor ex(1, twoNodeOptions(kSpillThreshold));
+  ASSERT_EQ(1, ex.getNodeExecutor(0).numThreads());
+
+  // Block node 0, and queue tasks until some spill to node 1.
+  Baton<> blocked;
+  Baton<> unblock;
+  ex.add([&] {
+    blocked.post();
+    unblock.wait();
+  });
+  blocked.wait();
+
+  constexpr size_t kTasks = 4 * kSpillThreshold;
+  std::atomic<size_t> onNode1{0};
+  Latch done(kTasks);
+  for (size_t i = 0; i < kTasks; ++i) {
+    ex.add([&] {
+      if (nodeOfCurrentThread() == "NumaCPUPool1") {
+        ++onNode1;
+      }
+      done.count_down();
+    });
+  }
+  // Node 1 ran tasks while node 0 was still blocked.
+  while (onNode1 == 0) {
+    std::this_thread::yield();
+  }
+  unblock.post();
+  done.wait();
+  EXPECT_GT(onNode1.load(), 0);
+  EXPECT_LT(onNode1.load(), kTasks);
+}
+
+TEST(NumaThreadPoolExecutorTest, KeepAlive) {
+  std::atomic<size_t> ran{0};
+  {
+    NumaCPUThreadPoolExecutor ex(2, twoNodeOptions(64));
+    getKeepAliveToken(ex).add([&](auto&&) { ++ran; });
+    ex.add([&] { ++ran; });
+  }
+  EXPECT_EQ(2, ran.load());
+}
+
+TEST(NumaThreadPoolExecutorTest, IOEventBases) {
+  NumaIOThreadPoolExecutor ex(3, twoNodeOptions(64));
+  ASSERT_EQ(2, ex.numNodes());
+  auto const evbs = ex.getAllEventBases();
+  EXPECT_EQ(
+      ex.getNodeExecutor(0).numThreads() + ex.getNodeExecutor(1).numThreads(),
+      evbs.size());
+
+  // EventBases are taken from the caller's node.
+  auto const local = ex.getNodeExecutor(0).getAllEventBases();
+  auto const evb = ex.getEventBase();
+  EXPECT_TRUE(std::any_of(local.begin(), local.end(), [&](auto const& ka) {
+    return ka.get() == evb;
+  }));
+
+  Baton<> ran;
+  ex.add([&] {
+    EXPECT_EQ("NumaIOPool0", nodeOfCurrentThread());
+    ran.post();
+  });
+  ran.wait();
+}
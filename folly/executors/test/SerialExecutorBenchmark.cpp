@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstddef>
+#include <memory>
+
+#include <folly/Benchmark.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/SerialExecutor.h>
+#include <folly/executors/StrandExecutor.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+
+// Compares how many tasks SerialExecutor and StrandExecutor run per hop on
+// the parent executor: SerialExecutor drains its whole queue by default,
+// StrandExecutor yields after 32 tasks, and both can be given other limits.
+// Each benchmark queues n tasks on one serial executor, as an actor receiving
+// a burst of messages, and waits for the last one.
+
+static constexpr size_t kNumThreads = 4;
+
+template <class SerialExecutorType>
+static void runBurst(
+    uint32_t n, Executor::KeepAlive<SerialExecutorType> ex, size_t& counter) {
+  Baton<> done;
+  for (uint32_t i = 0; i < n; ++i) {
+    ex->add([&counter] { doNotOptimizeAway(++counter); });
+  }
+  ex->add([&done] { done.post(); });
+  done.wait();
+}
+
+void serialBurst(uint32_t n, size_t maxDrainTasks) {
+  std::unique_ptr<CPUThreadPoolExecutor> parent;
+  Executor::KeepAlive<SerialExecutor> ex;
+  BENCHMARK_SUSPEND {
+    parent = std::make_unique<CPUThreadPoolExecutor>(kNumThreads);
+    ex = SerialExecutor::create(
+        parent.get(),
+        SerialExecutor::Options().setMaxDrainTasks(maxDrainTasks));
+  }
+  size_t counter = 0;
+  runBurst(n, std::move(ex), counter);
+  BENCHMARK_SUSPEND {
+    parent.reset();
+  }
+}
+
+void smallSerialBurst(uint32_t n, size_t maxDrainTasks) {
+  std::unique_ptr<CPUThreadPoolExecutor> parent;
+  Executor::KeepAlive<SmallSerialExecutor> ex;
+  BENCHMARK_SUSPEND {
+    parent = std::make_unique<CPUThreadPoolExecutor>(kNumThreads);
+    ex = SmallSerialExecutor::create(
+        parent.get(),
+        SmallSerialExecutor::Options().setMaxDrainTasks(maxDrainTasks));
+  }
+  size_t counter = 0;
+  runBurst(n, std::move(ex), counter);
+  BENCHMARK_SUSPEND {
+    parent.reset();
+  }
+}
+
+void strandBurst(uint32_t n, size_t maxDrainTasks) {
+  std::unique_ptr<CPUThreadPoolExecutor> parent;
+  Executor::KeepAlive<StrandExecutor> ex;
+  BENCHMARK_SUSPEND {
+    parent = std::make_unique<CPUThreadPoolExecutor>(kNumThreads);
+    ex = StrandExecutor::create(
+        StrandContext::create(
+            StrandContext::Options().setMaxDrainTasks(maxDrainTasks)),
+        parent.get());
+  }
+  size_t counter = 0;
+  runBurst(n, std::move(ex), counter);
+  BENCHMARK_SUSPEND {
+    parent.reset();
+  }
+}
+
+BENCHMARK_NAMED_PARAM(serialBurst, Unbounded, size_t(-1))
+BENCHMARK_RELATIVE_NAMED_PARAM(serialBurst, Drain1, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(serialBurst, Drain32, 32)
+BENCHMARK_RELATIVE_NAMED_PARAM(serialBurst, Drain256, 256)
+BENCHMARK_RELATIVE_NAMED_PARAM(smallSerialBurst, Unbounded, size_t(-1))
+BENCHMARK_RELATIVE_NAMED_PARAM(smallSerialBurst, Drain32, 32)
+BENCHMARK_RELATIVE_NAMED_PARAM(strandBurst, Drain1, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(strandBurst, Drain32, 32)
+BENCHMARK_RELATIVE_NAMED_PARAM(strandBurst, Drain256, 256)
+
+int main(int argc, char* argv[]) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+
+  return 0;
+}
@@ -18,11 +18,13 @@
 
 #include <chrono>
 #include <optional>
+#include <stdexcept>
 
 #include <folly/Random.h>
 #include <folly/ScopeGuard.h>
 #include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/executors/InlineExecutor.h>
+#include <folly/executors/ManualExecutor.h>
 #include <folly/io/async/Request.h>
 #include <folly/portability/GTest.h>
 #include <folly/synchronization/Baton.h>
@@ -254,6 +256,100 @@ TYPED_TEST(SerialExecutorTest, Stress) {
   EXPECT_EQ(tasksRan, kNumProducers * (kNumIterations + 1));
 }
 
+TYPED_TEST(SerialExecutorTest, MaxDrainTasks) {
+  folly::ManualExecutor parent;
+  auto se = TypeParam::create(
+      &parent, typename TypeParam::Options().setMaxDrainTasks(3));
+
+  std::vector<int> values;
+  for (int i = 0; i < 10; ++i) {
+    se->add([i, &values] { values.push_back(i); });
+  }
+  // One hop runs 3 tasks, then yields to the parent.
+  EXPECT_EQ(1, parent.run());
+  EXPECT_EQ(3, values.size());
+  auto stats = se->getStats();
+  EXPECT_EQ(7, stats.queueSize);
+  EXPECT_EQ(1, stats.drains);
+  EXPECT_EQ(1, stats.yields);
+
+  parent.drain();
+  EXPECT_EQ(10, values.size());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, values[i]);
+  }
+  stats = se->getStats();
+  EXPECT_EQ(0, stats.queueSize);
+  EXPECT_EQ(4, stats.drains);
+  EXPECT_EQ(3, stats.yields);
+  EXPECT_EQ(10, stats.tasksRun);
+  EXPECT_EQ(3, stats.maxDrainSize);
+}
+
+TYPED_TEST(SerialExecutorTest, MaxDrainTime) {
+  folly::ManualExecutor parent;
+  auto se = TypeParam::create(
+      &parent,
+      typename TypeParam::Options().setMaxDrainTime(
+          std::chrono::milliseconds(1)));
+
+  size_t ran = 0;
+  for (int i = 0; i < 4; ++i) {
+    se->add([&ran] {
+      sleepMs(2);
+      ++ran;
+    });
+  }
+  // Every task exceeds the budget, so each hop runs a single one.
+  parent.drain();
+  EXPECT_EQ(4, ran);
+  auto const stats = se->getStats();
+  EXPECT_EQ(4, stats.drains);
+  EXPECT_EQ(1, stats.maxDrainSize);
+}
+
+TYPED_TEST(SerialExecutorTest, ParentExecutorThrowsOnYield) {
+  struct FakeExecutor : folly::Executor {
+    void add(folly::Func f) override {
+      if (reject) {
+        throw std::runtime_error("rejected");
+      }
+      queue.push_back(std::move(f));
+    }
+
+    bool reject = false;
+    std::vector<folly::Func> queue;
+  };
+
+  FakeExecutor parent;
+  auto se = TypeParam::create(
+      &parent, typename TypeParam::Options().setMaxDrainTasks(2));
+
+  std::vector<int> values;
+  for (int i = 0; i < 5; ++i) {
+    se->add([i, &values] { values.push_back(i); });
+  }
+  ASSERT_EQ(1, parent.queue.size());
+  // The worker cannot yield, so it keeps draining inline.
+  parent.reject = true;
+  std::exchange(parent.queue, {})[0]();
+  EXPECT_EQ(5, values.size());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(i, values[i]);
+  }
+  auto stats = se->getStats();
+  EXPECT_EQ(0, stats.queueSize);
+  EXPECT_EQ(3, stats.drains);
+  EXPECT_EQ(2, stats.yields);
+
+  // The queue is not left scheduled, so the next task starts a worker.
+  parent.reject = false;
+  se->add([&values] { values.push_back(5); });
+  ASSERT_EQ(1, parent.queue.size());
+  std::exchange(parent.queue, {})[0]();
+  EXPECT_EQ(6, values.size());
+}
+
 // Basic test for SerialExecutorMPSCQueue, does not exercise concurrent access
 // but just ensure that the state stays consistent under different
 // enqueue/dequeue patterns.
@@ -151,3 +151,50 @@ TEST(StrandExecutor, RequestContextPropagation) {
 
   EXPECT_EQ(numTasksRan, kNumTasks);
 }
+
+TEST(StrandExecutor, MaxDrainTasks) {
+  ManualExecutor parent;
+  auto strand = StrandContext::create(
+      StrandContext::Options().setMaxDrainTasks(3));
+  auto exec = StrandExecutor::create(strand, &parent);
+
+  std::vector<int> values;
+  for (int i = 0; i < 10; ++i) {
+    exec->add([i, &values] { values.push_back(i); });
+  }
+  // One hop runs 3 functions, then reschedules on the parent.
+  EXPECT_EQ(1, parent.run());
+  EXPECT_EQ(3, values.size());
+  auto stats = strand->getStats();
+  EXPECT_EQ(7, stats.queueSize);
+  EXPECT_EQ(1, stats.yields);
+
+  parent.drain();
+  EXPECT_EQ(10, values.size());
+  stats = strand->getStats();
+  EXPECT_EQ(0, stats.queueSize);
+  EXPECT_EQ(4, stats.drains);
+  EXPECT_EQ(3, stats.yields);
+  EXPECT_EQ(10, stats.tasksRun);
+  EXPECT_EQ(3, stats.maxDrainSize);
+}
+
+TEST(StrandExecutor, HopOnExecutorChangeIsNotAYield) {
+  ManualExecutor parent1;
+  ManualExecutor parent2;
+  auto strand = StrandContext::create();
+  auto exec1 = StrandExecutor::create(strand, &parent1);
+  auto exec2 = StrandExecutor::create(strand, &parent2);
+
+  int ran = 0;
+  exec1->add([&] { ++ran; });
+  exec1->add([&] { ++ran; });
+  exec2->add([&] { ++ran; });
+  parent1.drain();
+  parent2.drain();
+  EXPECT_EQ(3, ran);
+  auto const stats = strand->getStats();
+  EXPECT_EQ(2, stats.drains);
+  EXPECT_EQ(0, stats.yields);
+  EXPECT_EQ(2, stats.maxDrainSize);
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/TaskLatencyHistograms.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/EDFThreadPoolExecutor.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using namespace std::chrono_literals;
+
+TEST(TaskLatencyHistogramsTest, Buckets) {
+  for (int64_t v : {0, 1, 3, 4, 7, 8, 1000, 123456789}) {
+    auto const bucket = TaskLatencyHistograms::bucketIndex(
+        std::chrono::nanoseconds(v));
+    EXPECT_LE(TaskLatencyHistograms::bucketLowerBoundNs(bucket), v);
+    EXPECT_GT(TaskLatencyHistograms::bucketUpperBoundNs(bucket), v);
+  }
+  EXPECT_EQ(
+      TaskLatencyHistograms::kNumBuckets - 1,
+      TaskLatencyHistograms::bucketIndex(std::chrono::hours(1)));
+  EXPECT_EQ(0, TaskLatencyHistograms::bucketIndex(-1ns));
+}
+
+TEST(TaskLatencyHistogramsTest, Percentiles) {
+  TaskLatencyHistograms histograms;
+  for (int i = 1; i <= 1000; ++i) {
+    histograms.record(std::chrono::microseconds(i), 1us);
+  }
+  histograms.record(1ms, 0ns, /* expired */ true);
+
+  auto const snapshot = histograms.getSnapshot();
+  EXPECT_EQ(1001, snapshot.tasks);
+  EXPECT_EQ(1001, snapshot.waitTime.count());
+  EXPECT_EQ(1000, snapshot.runTime.count());
+  EXPECT_EQ(1000us, snapshot.runTime.sum());
+  auto const p50 = snapshot.waitTime.percentileEstimate(0.5);
+  EXPECT_GE(p50, 500us * 3 / 4);
+  EXPECT_LE(p50, 500us * 5 / 4);
+  auto const p99 = snapshot.waitTime.percentileEstimate(0.99);
+  EXPECT_GE(p99, 990us * 3 / 4);
+  EXPECT_LE(p99, 990us * 5 / 4);
+}
+
+TEST(TaskLatencyHistogramsTest, Sampling) {
+  TaskLatencyHistograms histograms(
+      TaskLatencyHistograms::Options().setSampleRate(10));
+  for (int i = 0; i < 100; ++i) {
+    histograms.record(1us, 1us);
+  }
+  auto snapshot = histograms.getSnapshot();
+  EXPECT_EQ(100, snapshot.tasks);
+  EXPECT_EQ(10, snapshot.sampleRate);
+  EXPECT_EQ(10, snapshot.waitTime.count());
+
+  TaskLatencyHistograms disabled(
+      TaskLatencyHistograms::Options().setSampleRate(0));
+  disabled.record(1us, 1us);
+  snapshot = disabled.getSnapshot();
+  EXPECT_EQ(0, snapshot.tasks);
+  EXPECT_EQ(0, snapshot.waitTime.count());
+}
+
+TEST(TaskLatencyHistogramsTest, ExitedThreads) {
+  TaskLatencyHistograms histograms;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 100; ++j) {
+        histograms.record(1us, 2us);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  histograms.record(1us, 2us);
+
+  auto const snapshot = histograms.getSnapshot();
+  EXPECT_EQ(401, snapshot.tasks);
+  EXPECT_EQ(401, snapshot.runTime.count());
+  EXPECT_EQ(802us, snapshot.runTime.sum());
+}
+
+template <class Executor>
+void recordsTasks(Executor& executor) {
+  auto histograms = executor.addTaskLatencyHistograms();
+  for (int i = 0; i < 100; ++i) {
+    executor.add([] {
+      /* sleep override */ std::this_thread::sleep_for(10us);
+    });
+  }
+  executor.join();
+
+  auto const snapshot = histograms->getSnapshot();
+  EXPECT_EQ(100, snapshot.tasks);
+  EXPECT_EQ(100, snapshot.waitTime.count());
+  EXPECT_EQ(100, snapshot.runTime.count());
+  EXPECT_GE(snapshot.runTime.percentileEstimate(0.1), 10us * 3 / 4);
+}
+
+TEST(TaskLatencyHistogramsTest, CPUThreadPoolExecutor) {
+  CPUThreadPoolExecutor executor(4);
+  recordsTasks(executor);
+}
+
+TEST(TaskLatencyHistogramsTest, EDFThreadPoolExecutor) {
+  EDFThreadPoolExecutor executor(4);
+  recordsTasks(executor);
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <folly/Benchmark.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/executors/ThreadPerCoreExecutor.h>
+#include <folly/hash/Hash.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+
+// An echo/RPC-style server loop: each request is "read" on an EventBase,
+// handled by a CPU task, and its response "written" back on the EventBase of
+// the request. The split setup reads and writes on an IOThreadPoolExecutor
+// and handles on a CPUThreadPoolExecutor, as most servers do, so every
+// request hops twice between thread pools. ThreadPerCoreExecutor does all
+// three steps on the core that read the request.
+//
+// Requests are delivered with runInEventBaseThread() instead of a socket, so
+// that the benchmark measures the scheduling rather than the kernel.
+
+static constexpr size_t kNumThreads = 4;
+static constexpr size_t kPayloadSize = 512;
+
+namespace {
+
+struct Request {
+  std::string payload;
+  uint64_t response{0};
+};
+
+// The handler: some CPU work on the request's data.
+void handle(Request& request, size_t rounds) {
+  uint64_t h = 0;
+  for (size_t i = 0; i < rounds; ++i) {
+    h = hash::hash_combine(
+        h, hash::fnv64_buf(request.payload.data(), request.payload.size()));
+  }
+  request.response = h;
+}
+
+class Completion {
+ public:
+  explicit Completion(uint32_t n) : remaining_(n) {}
+
+  void done(Request& request) {
+    doNotOptimizeAway(request.response);
+    if (--remaining_ == 0) {
+      baton_.post();
+    }
+  }
+
+  void wait() { baton_.wait(); }
+
+ private:
+  std::atomic<uint32_t> remaining_;
+  Baton<> baton_;
+};
+
+} // namespace
+
+void ioCpuSplit(uint32_t n, size_t rounds) {
+  std::unique_ptr<IOThreadPoolExecutor> io;
+  std::unique_ptr<CPUThreadPoolExecutor> cpu;
+  BENCHMARK_SUSPEND {
+    io = std::make_unique<IOThreadPoolExecutor>(kNumThreads);
+    cpu = std::make_unique<CPUThreadPoolExecutor>(kNumThreads);
+  }
+  Completion completion(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    auto* evb = io->getEventBase();
+    evb->runInEventBaseThread([&, evb] {
+      auto request = std::make_unique<Request>();
+      request->payload.assign(kPayloadSize, 'x');
+      cpu->add([&, evb, request = std::move(request)]() mutable {
+        handle(*request, rounds);
+        evb->runInEventBaseThread(
+            [&, request = std::move(request)] { completion.done(*request); });
+      });
+    });
+  }
+  completion.wait();
+  BENCHMARK_SUSPEND {
+    cpu.reset();
+    io.reset();
+  }
+}
+
+void threadPerCore(uint32_t n, size_t rounds) {
+  std::unique_ptr<ThreadPerCoreExecutor> ex;
+  BENCHMARK_SUSPEND {
+    ex = std::make_unique<ThreadPerCoreExecutor>(
+        ThreadPerCoreExecutor::Options().setNumCores(kNumThreads));
+  }
+  Completion completion(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    ex->getEventBase()->runInEventBaseThread([&] {
+      auto request = std::make_unique<Request>();
+      request->payload.assign(kPayloadSize, 'x');
+      ex->add([&, request = std::move(request)]() mutable {
+        handle(*request, rounds);
+        ex->add(
+            [&, request = std::move(request)] { completion.done(*request); });
+      });
+    });
+  }
+  completion.wait();
+  BENCHMARK_SUSPEND {
+    ex.reset();
+  }
+}
+
+BENCHMARK_NAMED_PARAM(ioCpuSplit, NoWork, 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(threadPerCore, NoWork, 0)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(ioCpuSplit, LightWork, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(threadPerCore, LightWork, 1)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(ioCpuSplit, HeavyWork, 16)
+BENCHMARK_RELATIVE_NAMED_PARAM(threadPerCore, HeavyWork, 16)
+
+int main(int argc, char* argv[]) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/ThreadPerCoreExecutor.h>
+
+#include <atomic>
+
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <folly/synchronization/Latch.h>
+
+using namespace folly;
+
+namespace {
+
+ThreadPerCoreExecutor::Options options(size_t numCores) {
+  return ThreadPerCoreExecutor::Options().setNumCores(numCores).setPinThreads(
+      false);
+}
+
+} // namespace
+
+TEST(ThreadPerCoreExecutorTest, RunsTasks) {
+  ThreadPerCoreExecutor ex(options(4));
+  EXPECT_EQ(4, ex.numCores());
+  EXPECT_FALSE(ex.getCurrentCore().has_value());
+
+  constexpr size_t kTasks = 100;
+  Latch done(kTasks);
+  for (size_t i = 0; i < kTasks; ++i) {
+    ex.add([&] {
+      EXPECT_TRUE(ex.getCurrentCore().has_value());
+      done.count_down();
+    });
+  }
+  done.wait();
+
+  uint64_t remote = 0;
+  for (size_t core = 0; core < ex.numCores(); ++core) {
+    remote += ex.getCoreStats(core).remoteTasks;
+  }
+  EXPECT_EQ(kTasks, remote);
+}
+
+TEST(ThreadPerCoreExecutorTest, AddToCore) {
+  ThreadPerCoreExecutor ex(options(3));
+  for (size_t core = 0; core < ex.numCores(); ++core) {
+    Baton<> done;
+    ex.addToCore(core, [&] {
+      EXPECT_EQ(core, ex.getCurrentCore());
+      EXPECT_EQ(ex.getEventBase(core), ex.getEventBase());
+      EXPECT_EQ(
+          ex.getEventBase(core), EventBaseManager::get()->getEventBase());
+      EXPECT_TRUE(ex.getEventBase(core)->isInEventBaseThread());
+      done.post();
+    });
+    done.wait();
+  }
+}
+
+TEST(ThreadPerCoreExecutorTest, LocalTasksStayOnCore) {
+  ThreadPerCoreExecutor ex(options(2));
+  constexpr size_t kTasks = 10;
+  std::vector<size_t> order;
+  Baton<> done;
+  ex.addToCore(1, [&] {
+    for (size_t i = 0; i < kTasks; ++i) {
+      ex.add([&, i] {
+        EXPECT_EQ(1, ex.getCurrentCore());
+        order.push_back(i);
+        if (order.size() == kTasks) {
+          done.post();
+        }
+      });
+    }
+  });
+  done.wait();
+  for (size_t i = 0; i < kTasks; ++i) {
+    EXPECT_EQ(i, order[i]);
+  }
+  EXPECT_EQ(kTasks, ex.getCoreStats(1).localTasks);
+  EXPECT_EQ(0, ex.getCoreStats(0).localTasks);
+}
+
+TEST(ThreadPerCoreExecutorTest, LocalBatchYieldsToEventBase) {
+  ThreadPerCoreExecutor ex(options(1).setMaxLocalBatch(2));
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> spins{0};
+  Baton<> done;
+  // A task that keeps re-adding itself must not starve the EventBase.
+  ex.add([&] {
+    struct Spin {
+      ThreadPerCoreExecutor& ex;
+      std::atomic<bool>& stop;
+      std::atomic<size_t>& spins;
+      void operator()() {
+        ++spins;
+        if (!stop) {
+          ex.add(Spin{*this});
+        }
+      }
+    };
+    Spin{ex, stop, spins}();
+  });
+  ex.getEventBase(0)->runInEventBaseThread([&] {
+    stop = true;
+    done.post();
+  });
+  done.wait();
+  EXPECT_GT(spins.load(), 0);
+}
+
+TEST(ThreadPerCoreExecutorTest, JoinRunsPendingTasks) {
+  std::atomic<size_t> count{0};
+  {
+    ThreadPerCoreExecutor ex(options(2));
+    for (size_t i = 0; i < 10; ++i) {
+      ex.add([&] {
+        ex.add([&] {
+          ex.add([&] { ++count; });
+        });
+      });
+    }
+    ex.join();
+    EXPECT_EQ(10, count.load());
+  }
+  EXPECT_EQ(10, count.load());
+}
+
+TEST(ThreadPerCoreExecutorTest, KeepAlive) {
+  Baton<> done;
+  {
+    ThreadPerCoreExecutor ex(options(2));
+    auto ka = getKeepAliveToken(ex);
+    std::thread([ka = std::move(ka), &done]() mutable {
+      /* sleep override */ std::this_thread::sleep_for(
+          std::chrono::milliseconds(10));
+      ka->add([&] { done.post(); });
+    }).detach();
+  }
+  EXPECT_TRUE(done.ready());
+}
+
+TEST(ThreadPerCoreExecutorTest, RequestContextFollowsLocalTasks) {
+  ThreadPerCoreExecutor ex(options(1));
+  Baton<> done;
+  RequestContextScopeGuard outer;
+  auto* ctx = RequestContext::get();
+  ex.add([&] {
+    EXPECT_EQ(ctx, RequestContext::get());
+    RequestContextScopeGuard inner;
+    auto* innerCtx = RequestContext::get();
+    ex.add([&, innerCtx] {
+      EXPECT_EQ(innerCtx, RequestContext::get());
+      done.post();
+    });
+  });
+  done.wait();
+}
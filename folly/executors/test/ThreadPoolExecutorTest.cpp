@@ -23,12 +23,15 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <thread>
 
 #include <boost/thread.hpp>
 
 #include <folly/Exception.h>
 #include <folly/container/F14Map.h>
+#include <folly/executors/AdaptiveIdleSpin.h>
 #include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/executors/EDFThreadPoolExecutor.h>
 #include <folly/executors/FutureExecutor.h>
@@ -101,11 +104,30 @@ FOLLY_KEEP std::unique_ptr<QueueObserverFactory> make_queue_observer_factory(
 
 } // namespace folly
 
+namespace {
+
+class WorkStealingCPUThreadPoolExecutor : public CPUThreadPoolExecutor {
+ public:
+  explicit WorkStealingCPUThreadPoolExecutor(
+      size_t numThreads,
+      std::shared_ptr<ThreadFactory> threadFactory =
+          std::make_shared<NamedThreadFactory>("CPUThreadPool"))
+      : CPUThreadPoolExecutor(
+            numThreads,
+            std::move(threadFactory),
+            Options().setWorkStealing(true)) {}
+};
+
+} // namespace
+
 template <typename T>
 class ThreadPoolExecutorTypedTest : public ::testing::Test {};
 
-using ValueTypes = ::testing::
-    Types<CPUThreadPoolExecutor, IOThreadPoolExecutor, EDFThreadPoolExecutor>;
+using ValueTypes = ::testing::Types<
+    CPUThreadPoolExecutor,
+    WorkStealingCPUThreadPoolExecutor,
+    IOThreadPoolExecutor,
+    EDFThreadPoolExecutor>;
 
 TYPED_TEST_SUITE(ThreadPoolExecutorTypedTest, ValueTypes);
 
@@ -461,6 +483,114 @@ TEST(ThreadPoolExecutorTest, IOExpiration) {
   expiration<IOThreadPoolExecutor>();
 }
 
+TEST(ThreadPoolExecutorTest, EDFExpiration) {
+  expiration<EDFThreadPoolExecutor>();
+}
+
+static EDFThreadPoolExecutor::Options edfLoadShedding() {
+  return EDFThreadPoolExecutor::Options()
+      .setLoadShedding()
+      .setTargetDelay(1ms)
+      .setInterval(10ms);
+}
+
+// A time deadline that has already passed, so that shedding doesn't depend
+// on how long the test takes.
+static uint64_t edfPastDeadline() {
+  return EDFThreadPoolExecutor::deadlineAt(steady_clock::now() - 1s);
+}
+
+TEST(ThreadPoolExecutorTest, EDFShedExpiredTasks) {
+  EDFThreadPoolExecutor pool(
+      1,
+      std::make_shared<NamedThreadFactory>("EDFThreadPool"),
+      EDFThreadPoolExecutor::makeDefaultSemaphore(),
+      edfLoadShedding());
+  Baton<> started;
+  Baton<> unblock;
+  pool.add([&] {
+    started.post();
+    unblock.wait();
+  });
+  started.wait();
+
+  // The queue is not overloaded, so these are admitted and then shed by the
+  // worker.
+  std::atomic<int> ran{0};
+  std::atomic<int> expired{0};
+  for (int i = 0; i < 3; ++i) {
+    pool.add([&] { ++ran; }, edfPastDeadline(), [&] { ++expired; });
+  }
+  pool.add([&] { ++ran; }, /* total */ 2, edfPastDeadline());
+  // Never shed.
+  pool.add([&] { ++ran; }, EDFThreadPoolExecutor::kLatestDeadline);
+  unblock.post();
+  pool.join();
+
+  EXPECT_EQ(1, ran);
+  EXPECT_EQ(3, expired);
+  auto const stats = pool.getLoadSheddingStats();
+  EXPECT_EQ(0, stats.rejected);
+  EXPECT_EQ(5, stats.expired);
+  EXPECT_GT(stats.serviceTime.count(), 0);
+}
+
+TEST(ThreadPoolExecutorTest, EDFRejectUnschedulableTasks) {
+  auto const options = edfLoadShedding();
+  EDFThreadPoolExecutor pool(
+      1,
+      std::make_shared<NamedThreadFactory>("EDFThreadPool"),
+      EDFThreadPoolExecutor::makeDefaultSemaphore(),
+      options);
+  Baton<> started;
+  Baton<> unblock;
+  pool.add([&] {
+    started.post();
+    unblock.wait();
+  });
+  started.wait();
+
+  // Every queued task waits for longer than the interval, so the minimum
+  // delay of the interval in which they are dequeued exceeds the target.
+  constexpr int kTasks = 10;
+  Latch drained(kTasks);
+  for (int i = 0; i < kTasks; ++i) {
+    pool.add([&] { drained.count_down(); });
+  }
+  auto const queued = steady_clock::now();
+  /* sleep override */ std::this_thread::sleep_until(queued + options.interval);
+  unblock.post();
+  drained.wait();
+  auto const drainedTime = steady_clock::now();
+
+  // The overload state is that of the last completed interval, so it is
+  // updated by the first task dequeued after that interval ends.
+  /* sleep override */ std::this_thread::sleep_until(
+      drainedTime + options.interval);
+  Baton<> probed;
+  pool.add([&] { probed.post(); });
+  probed.wait();
+
+  bool rejected = false;
+  pool.add([] { FAIL(); }, edfPastDeadline(), [&] { rejected = true; });
+  // The callback of a rejected task runs inline.
+  EXPECT_TRUE(rejected);
+  // Rejected runs are counted for every overload of add().
+  pool.add([] { FAIL(); }, /* total */ 2, edfPastDeadline());
+  std::vector<Func> fs;
+  fs.emplace_back([] { FAIL(); });
+  pool.add(std::move(fs), edfPastDeadline());
+  // Tasks without a time deadline are always admitted.
+  std::atomic<bool> ran{false};
+  pool.add([&] { ran = true; }, EDFThreadPoolExecutor::kLatestDeadline);
+  pool.join();
+
+  EXPECT_TRUE(ran);
+  auto const stats = pool.getLoadSheddingStats();
+  EXPECT_EQ(4, stats.rejected);
+  EXPECT_EQ(0, stats.expired);
+}
+
 template <typename TPE>
 static void futureExecutor() {
   FutureExecutor<TPE> fe(2);
@@ -536,6 +666,272 @@ TEST(ThreadPoolExecutorTest, PriorityPreemptionTest) {
   EXPECT_EQ(100, completed);
 }
 
+TEST(ThreadPoolExecutorTest, WorkStealingLocalTasks) {
+  CPUThreadPoolExecutor pool(
+      std::make_pair(1, 1),
+      CPUThreadPoolExecutor::makeDefaultPriorityQueue(2),
+      std::make_shared<NamedThreadFactory>("CPUThreadPool"),
+      CPUThreadPoolExecutor::Options().setWorkStealing(true));
+  std::vector<int> order;
+  pool.add([&] {
+    pool.addWithPriority([&] { order.push_back(-1); }, Executor::HI_PRI);
+    for (int i = 0; i < 3; ++i) {
+      pool.add([&, i] { order.push_back(i); });
+    }
+    // Local tasks are pending too. Queue sizes are estimates.
+    EXPECT_GE(pool.getTaskQueueSize(), 4);
+    EXPECT_GE(pool.getPendingTaskCount(), 4);
+  });
+  pool.join();
+  // The worker runs its local tasks, most recent first, before the shared
+  // queue.
+  EXPECT_EQ((std::vector<int>{2, 1, 0, -1}), order);
+}
+
+TEST(ThreadPoolExecutorTest, WorkStealingLocalTaskBelowMaxThreads) {
+  // A dynamic pool of up to 4 threads, running 1.
+  CPUThreadPoolExecutor pool(
+      std::make_pair(4, 1),
+      CPUThreadPoolExecutor::makeDefaultQueue(),
+      std::make_shared<NamedThreadFactory>("CPUThreadPool"),
+      CPUThreadPoolExecutor::Options().setWorkStealing(true));
+  std::thread::id parent;
+  std::thread::id child;
+  Baton<> done;
+  pool.add([&] {
+    parent = std::this_thread::get_id();
+    pool.add([&] {
+      child = std::this_thread::get_id();
+      done.post();
+    });
+    // Were the task sent to the shared queue, a thread started for it would
+    // take it meanwhile.
+    /* sleep override */ std::this_thread::sleep_for(50ms);
+  });
+  done.wait();
+  EXPECT_EQ(parent, child);
+  pool.join();
+}
+
+TEST(ThreadPoolExecutorTest, WorkStealingForkJoin) {
+  constexpr int kDepth = 12;
+  CPUThreadPoolExecutor pool(
+      4, CPUThreadPoolExecutor::Options().setWorkStealing(true));
+  Latch done((1 << kDepth) - 1);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::function<void(int)> spawn = [&](int depth) {
+    if (depth > 1) {
+      pool.add([&, depth] { spawn(depth - 1); });
+      pool.add([&, depth] { spawn(depth - 1); });
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      threads.insert(std::this_thread::get_id());
+    }
+    /* sleep override */ std::this_thread::sleep_for(10us);
+    done.count_down();
+  };
+  pool.add([&] { spawn(kDepth); });
+  done.wait();
+  // Subtasks are added locally, so other threads only run them by stealing.
+  EXPECT_GT(threads.size(), 1);
+  pool.join();
+}
+
+TEST(ThreadPoolExecutorTest, WorkStealingResizeWithLocalTasks) {
+  constexpr int kTasks = 200;
+  CPUThreadPoolExecutor pool(
+      4, CPUThreadPoolExecutor::Options().setWorkStealing(true));
+  Latch spawned(4);
+  Latch completed(4 * kTasks);
+  for (int i = 0; i < 4; ++i) {
+    pool.add([&] {
+      for (int j = 0; j < kTasks; ++j) {
+        pool.add([&] {
+          /* sleep override */ std::this_thread::sleep_for(100us);
+          completed.count_down();
+        });
+      }
+      spawned.count_down();
+    });
+  }
+  spawned.wait();
+  // Stopped threads hand their local tasks over to the remaining ones.
+  pool.setNumThreads(1);
+  pool.setNumThreads(2);
+  EXPECT_TRUE(completed.try_wait_for(10s));
+  pool.join();
+}
+
+template <class TPE>
+static void addBatch() {
+  constexpr int kTasks = 100;
+  std::atomic<int> completed{0};
+  {
+    TPE tpe(4);
+    std::vector<Func> funcs;
+    for (int i = 0; i < kTasks; ++i) {
+      funcs.push_back([&] { ++completed; });
+    }
+    tpe.addBatch(range(funcs));
+    tpe.join();
+  }
+  EXPECT_EQ(kTasks, completed);
+}
+
+TYPED_TEST(ThreadPoolExecutorTypedTest, AddBatch) {
+  addBatch<TypeParam>();
+}
+
+TEST(ThreadPoolExecutorTest, DequeueBatch) {
+  constexpr int kTasks = 1000;
+  CPUThreadPoolExecutor pool(
+      4, CPUThreadPoolExecutor::Options().setMaxDequeueBatch(8));
+  std::vector<int> order;
+  std::mutex mutex;
+  Latch completed(kTasks);
+  std::vector<Func> funcs;
+  for (int i = 0; i < kTasks; ++i) {
+    funcs.push_back([&, i] {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(i);
+      }
+      completed.count_down();
+    });
+  }
+  pool.addBatch(range(funcs));
+  EXPECT_TRUE(completed.try_wait_for(10s));
+  EXPECT_EQ(kTasks, order.size());
+  pool.join();
+  EXPECT_EQ(0, pool.getPendingTaskCount());
+}
+
+TEST(ThreadPoolExecutorTest, DequeueBatchResize) {
+  constexpr int kTasks = 400;
+  CPUThreadPoolExecutor pool(
+      4, CPUThreadPoolExecutor::Options().setMaxDequeueBatch(16));
+  Latch completed(kTasks);
+  for (int i = 0; i < kTasks; ++i) {
+    pool.add([&] {
+      /* sleep override */ std::this_thread::sleep_for(100us);
+      completed.count_down();
+    });
+  }
+  // Stopping threads run the tasks they took in a batch first.
+  pool.setNumThreads(1);
+  pool.setNumThreads(2);
+  EXPECT_TRUE(completed.try_wait_for(10s));
+  pool.join();
+}
+
+TEST(ThreadPoolExecutorTest, AddBatchQueueFull) {
+  CPUThreadPoolExecutor pool(
+      1,
+      std::make_unique<LifoSemMPMCQueue<CPUThreadPoolExecutor::CPUTask>>(4));
+  Baton<> started;
+  Baton<> unblock;
+  pool.add([&] {
+    started.post();
+    unblock.wait();
+  });
+  started.wait();
+
+  Latch completed(4);
+  std::vector<Func> funcs;
+  for (int i = 0; i < 8; ++i) {
+    funcs.push_back([&] { completed.count_down(); });
+  }
+  EXPECT_THROW(pool.addBatch(range(funcs)), QueueFullException);
+  // The tasks added before the queue was full still run.
+  unblock.post();
+  EXPECT_TRUE(completed.try_wait_for(10s));
+  pool.join();
+}
+
+TEST(ThreadPoolExecutorTest, AdaptiveIdleSpinBudget) {
+  AdaptiveIdleSpin::Options options;
+  options.minSpin = 1us;
+  options.maxSpin = 1ms;
+  AdaptiveIdleSpin spin(options);
+  if (std::thread::hardware_concurrency() == 1) {
+    EXPECT_EQ(0ns, spin.spinBudget());
+    return;
+  }
+  // No arrivals yet.
+  EXPECT_EQ(options.minSpin, spin.spinBudget());
+
+  for (int i = 0; i < 100; ++i) {
+    spin.recordArrivals(4);
+  }
+  auto const stats = spin.getStats();
+  EXPECT_GT(stats.meanArrivalGap.count(), 0);
+  EXPECT_LT(stats.meanArrivalGap, options.maxSpin);
+  EXPECT_GE(spin.spinBudget(), options.minSpin);
+  EXPECT_LE(spin.spinBudget(), options.maxSpin);
+
+  // Arrivals stopped for longer than maxSpin.
+  /* sleep override */ std::this_thread::sleep_for(2ms);
+  EXPECT_EQ(options.minSpin, spin.spinBudget());
+
+  auto taken = spin.spin([] { return false; });
+  EXPECT_FALSE(taken);
+  int polls = 0;
+  taken = spin.spin([&] { return ++polls == 2; });
+  EXPECT_TRUE(taken);
+  EXPECT_EQ(2, polls);
+}
+
+template <class Executor>
+void adaptiveIdleSpin(Executor& pool) {
+  constexpr int kTasks = 200;
+  Latch completed(kTasks);
+  for (int i = 0; i < kTasks; ++i) {
+    pool.add([&] { completed.count_down(); });
+    if (i % 10 == 0) {
+      /* sleep override */ std::this_thread::sleep_for(20us);
+    }
+  }
+  EXPECT_TRUE(completed.try_wait_for(10s));
+  pool.join();
+  auto const stats = pool.getIdleSpinStats();
+  EXPECT_GT(stats.meanArrivalGap.count(), 0);
+  EXPECT_GT(stats.spinHits + stats.parks, 0);
+  EXPECT_LE(stats.unparks, stats.parks);
+}
+
+TEST(ThreadPoolExecutorTest, AdaptiveIdleSpinCPU) {
+  CPUThreadPoolExecutor pool(
+      2, CPUThreadPoolExecutor::Options().setAdaptiveIdleSpin());
+  adaptiveIdleSpin(pool);
+}
+
+TEST(ThreadPoolExecutorTest, AdaptiveIdleSpinCPUDequeueBatch) {
+  CPUThreadPoolExecutor::Options options;
+  options.setAdaptiveIdleSpin().setMaxDequeueBatch(4);
+  CPUThreadPoolExecutor pool(2, options);
+  adaptiveIdleSpin(pool);
+}
+
+TEST(ThreadPoolExecutorTest, AdaptiveIdleSpinEDF) {
+  EDFThreadPoolExecutor pool(
+      2,
+      std::make_shared<NamedThreadFactory>("EDFThreadPool"),
+      EDFThreadPoolExecutor::makeDefaultSemaphore(),
+      EDFThreadPoolExecutor::Options().setAdaptiveIdleSpin());
+  adaptiveIdleSpin(pool);
+}
+
+TEST(ThreadPoolExecutorTest, AdaptiveIdleSpinDisabled) {
+  CPUThreadPoolExecutor pool(2);
+  pool.add([] {});
+  pool.join();
+  auto const stats = pool.getIdleSpinStats();
+  EXPECT_EQ(0, stats.spinHits);
+  EXPECT_EQ(0, stats.parks);
+}
+
 class TestObserver : public ThreadPoolExecutor::Observer {
  public:
   void threadStarted(ThreadPoolExecutor::ThreadHandle*) override { threads_++; }
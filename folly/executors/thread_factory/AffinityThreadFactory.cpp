@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/thread_factory/AffinityThreadFactory.h>
+
+#include <glog/logging.h>
+#include <folly/String.h>
+#include <folly/portability/PThread.h>
+#include <folly/portability/Sched.h>
+#include <folly/system/ThreadName.h>
+
+namespace folly {
+
+namespace {
+
+// Returns 0 or an errno value.
+int setCurrentThreadAffinity(const std::vector<size_t>& cpus) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpus;
+  return ENOTSUP;
+#endif
+}
+
+} // namespace
+
+AffinityThreadFactory::AffinityThreadFactory(
+    std::shared_ptr<ThreadFactory> factory, std::vector<size_t> cpus)
+    : InitThreadFactory(std::move(factory), [cpus = std::move(cpus)] {
+        if (int err = setCurrentThreadAffinity(cpus); err != 0) {
+          LOG(WARNING) << "Setting the cpu affinity of thread \""
+                       << folly::getCurrentThreadName().value_or("<unknown>")
+                       << "\" failed with error " << err << " ("
+                       << errnoStr(err) << ")";
+        }
+      }) {}
+
+} // namespace folly
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <folly/executors/thread_factory/InitThreadFactory.h>
+
+namespace folly {
+
+/**
+ * A ThreadFactory that restricts each thread to a set of cpus, such as the
+ * cpus of a NUMA node (see NumaTopology in CacheLocality.h).
+ *
+ * Thread affinity is only supported on Linux; elsewhere, and if setting it
+ * fails, threads run unrestricted and a warning is logged.
+ */
+class AffinityThreadFactory : public InitThreadFactory {
+ public:
+  AffinityThreadFactory(
+      std::shared_ptr<ThreadFactory> factory, std::vector<size_t> cpus);
+};
+
+} // namespace folly
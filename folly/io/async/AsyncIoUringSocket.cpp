@@ -596,6 +596,17 @@ void AsyncIoUringSocket::ReadSqe::callback(const io_uring_cqe* cqe) noexcept {
           << " max=" << maxSize_ << " inflight=" << inFlight()
           << " has_buffer=" << !!(flags & IORING_CQE_F_BUFFER)
           << " bytes_received=" << bytesReceived_;
+  if (pollingForData_) {
+    // readable (or in error): read into a ring buffer if one was returned
+    // in the meantime, otherwise into an allocated one.
+    pollingForData_ = false;
+    if (res != -ECANCELED && parent_ && readCallback_) {
+      polledForData_ = true;
+      parent_->submitRead(true);
+    }
+    return;
+  }
+
   DestructorGuard dg(this);
   auto buffer_guard = makeGuard([&, bp = lastUsedBufferProvider_] {
     if (flags & IORING_CQE_F_BUFFER) {
@@ -627,6 +638,9 @@ void AsyncIoUringSocket::ReadSqe::callback(const io_uring_cqe* cqe) noexcept {
       }
       readCallback_->readEOF();
     } else if (res == -ENOBUFS) {
+      if (parent_) {
+        parent_->readStats_.enobufs++;
+      }
       if (lastUsedBufferProvider_) {
         // urgh, resubmit and let submit logic deal with the fact
         // we have no more buffers
@@ -663,6 +677,9 @@ void AsyncIoUringSocket::ReadSqe::callback(const io_uring_cqe* cqe) noexcept {
       uint64_t const cb_was = setReadCbCount_;
       bytesReceived_ += res;
       if (lastUsedBufferProvider_) {
+        if (parent_) {
+          parent_->readStats_.providedBufferReads++;
+        }
         sendReadBuf(
             lastUsedBufferProvider_->getIoBuf(flags >> 16, res),
             queuedReceivedData_);
@@ -694,11 +711,12 @@ void AsyncIoUringSocket::ReadSqe::callbackCancelled(
           << " has_buffer=" << !!(flags & IORING_CQE_F_BUFFER)
           << " bytes_received=" << bytesReceived_;
   DestructorGuard dg(this);
+  bool const wasPolling = pollingForData_;
   if (readCallback_) {
     callback(cqe);
   }
   if (!(flags & IORING_CQE_F_MORE)) {
-    if (readCallback_ && res > 0) {
+    if (readCallback_ && res > 0 && !wasPolling) {
       // may have more multishot
       readCallback_->readEOF();
       // only cancel from shutdown or event base detaching
@@ -725,39 +743,52 @@ void AsyncIoUringSocket::ReadSqe::processSubmit(
     maxSize_ = tmpBuffer_->tailroom();
     ::io_uring_prep_recv(sqe, fd, tmpBuffer_->writableTail(), maxSize_, 0);
   } else {
-    if (readCallbackUseIoBufs()) {
-      auto* bp = parent_->backend_->bufferProvider();
-      if (bp->available()) {
-        lastUsedBufferProvider_ = bp;
-        maxSize_ = lastUsedBufferProvider_->sizePerBuffer();
-
-        size_t used_len;
-        unsigned int ioprio_flags;
-        if (supportsMultishotRecv_) {
-          ioprio_flags = IORING_RECV_MULTISHOT;
-          used_len = 0;
-        } else {
-          ioprio_flags = 0;
-          used_len = maxSize_;
-        }
-
-        ::io_uring_prep_recv(sqe, fd, nullptr, used_len, 0);
-        sqe->buf_group = lastUsedBufferProvider_->gid();
-        sqe->flags |= IOSQE_BUFFER_SELECT;
-        sqe->ioprio |= ioprio_flags;
-        VLOG(9)
-            << "AsyncIoUringSocket::readProcessSubmit bufferprovider multishot";
+    // Non-movable callbacks read from the ring too, and sendReadBuf() copies
+    // into their buffers, so that no socket holds a buffer while idle.
+    auto* bp = parent_->backend_->bufferProvider();
+    if (bp && bp->available()) {
+      polledForData_ = false;
+      lastUsedBufferProvider_ = bp;
+      maxSize_ = lastUsedBufferProvider_->sizePerBuffer();
+
+      size_t used_len;
+      unsigned int ioprio_flags;
+      if (supportsMultishotRecv_) {
+        ioprio_flags = IORING_RECV_MULTISHOT;
+        used_len = 0;
       } else {
-        // todo: it's possible the callback can hint to us how much data to use.
-        // naively you could use getReadBuffer, however it turns out that many
-        // callbacks that support isBufferMovable do not expect the transport to
-        // switch between both types of callbacks. A new API to provide a size
-        // hint might be useful in the future.
-        tmpBuffer_ = parent_->options_.allocateNoBufferPoolBuffer();
-        maxSize_ = tmpBuffer_->tailroom();
-        ::io_uring_prep_recv(sqe, fd, tmpBuffer_->writableTail(), maxSize_, 0);
+        ioprio_flags = 0;
+        used_len = maxSize_;
       }
+
+      ::io_uring_prep_recv(sqe, fd, nullptr, used_len, 0);
+      sqe->buf_group = lastUsedBufferProvider_->gid();
+      sqe->flags |= IOSQE_BUFFER_SELECT;
+      sqe->ioprio |= ioprio_flags;
+      VLOG(9)
+          << "AsyncIoUringSocket::readProcessSubmit bufferprovider multishot";
+    } else if (
+        bp && parent_->options_.pollWhenNoBuffers && !polledForData_) {
+      // the ring is exhausted: wait until there is something to read before
+      // allocating a buffer, as it may be a while on an idle connection.
+      pollingForData_ = true;
+      parent_->readStats_.pollsWithoutBuffer++;
+      ::io_uring_prep_poll_add(sqe, fd, POLLIN);
+      VLOG(9) << "AsyncIoUringSocket::readProcessSubmit poll without buffer";
+    } else if (readCallbackUseIoBufs()) {
+      // todo: it's possible the callback can hint to us how much data to use.
+      // naively you could use getReadBuffer, however it turns out that many
+      // callbacks that support isBufferMovable do not expect the transport to
+      // switch between both types of callbacks. A new API to provide a size
+      // hint might be useful in the future.
+      polledForData_ = false;
+      parent_->readStats_.fallbackReads++;
+      tmpBuffer_ = parent_->options_.allocateNoBufferPoolBuffer();
+      maxSize_ = tmpBuffer_->tailroom();
+      ::io_uring_prep_recv(sqe, fd, tmpBuffer_->writableTail(), maxSize_, 0);
     } else {
+      polledForData_ = false;
+      parent_->readStats_.fallbackReads++;
       void* buf;
       readCallback_->getReadBuffer(&buf, &maxSize_);
       maxSize_ = std::min<size_t>(maxSize_, 2048);
@@ -1479,6 +1510,17 @@ bool AsyncIoUringSocket::canZC(std::unique_ptr<IOBuf> const& buf) const {
   if (!options_.zeroCopyEnable) {
     return false;
   }
+  // The kernel reads the buffers until the notification, which comes after
+  // writeSuccess(), so they must be kept alive by the WriteSqe: write() and
+  // writev() wrap buffers that the caller may reuse as soon as the write
+  // succeeds.
+  if (!buf->isManaged()) {
+    return false;
+  }
+  if (options_.zeroCopyThreshold > 0 &&
+      buf->computeChainDataLength() < options_.zeroCopyThreshold) {
+    return false;
+  }
   return (*options_.zeroCopyEnable)(buf);
 }
 
@@ -1507,6 +1549,12 @@ void AsyncIoUringSocket::writeChain(
     callback = &sNullWriteCallback;
   }
   WriteSqe* w = new WriteSqe(this, callback, std::move(buf), flags, canzc);
+  if (canzc) {
+    zeroCopyStats_.zeroCopyWrites++;
+    zeroCopyStats_.zeroCopyBytes += w->totalLength_;
+  } else if (options_.zeroCopyEnable) {
+    zeroCopyStats_.copiedWrites++;
+  }
 
   VLOG(5) << "AsyncIoUringSocket::writeChain(" << this
           << " ) state=" << stateAsString() << " size=" << w->totalLength_
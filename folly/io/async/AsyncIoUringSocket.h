@@ -66,7 +66,36 @@ class AsyncIoUringSocket : public AsyncSocketTransport {
     static std::unique_ptr<IOBuf> defaultAllocateNoBufferPoolBuffer();
     folly::Function<std::unique_ptr<IOBuf>()> allocateNoBufferPoolBuffer;
     folly::Optional<AsyncWriter::ZeroCopyEnableFunc> zeroCopyEnable;
+    // Writes shorter than this are copied even if zeroCopyEnable accepts
+    // them: pinning the pages and waiting for the notification costs more
+    // than copying a few kilobytes.
+    size_t zeroCopyThreshold{0};
     bool multishotRecv;
+    // When the provided buffer ring is exhausted, wait for the socket to be
+    // readable before allocating a buffer to read into, rather than holding
+    // one per socket until data arrives.
+    bool pollWhenNoBuffers{true};
+  };
+
+  struct ReadStats {
+    // Reads completed into buffers of the provided buffer ring.
+    size_t providedBufferReads{0};
+    // Times the ring was found empty by the kernel (ENOBUFS).
+    size_t enobufs{0};
+    // Times the socket waited for data holding no buffer, the ring being
+    // exhausted.
+    size_t pollsWithoutBuffer{0};
+    // Reads into allocated buffers.
+    size_t fallbackReads{0};
+  };
+
+  struct ZeroCopyStats {
+    // Writes sent with SENDMSG_ZC, and their bytes.
+    size_t zeroCopyWrites{0};
+    size_t zeroCopyBytes{0};
+    // Writes copied while zero copy was enabled: below zeroCopyThreshold,
+    // refused by zeroCopyEnable, or in buffers not owned by their IOBufs.
+    size_t copiedWrites{0};
   };
 
   using UniquePtr = std::unique_ptr<AsyncIoUringSocket, Destructor>;
@@ -131,6 +160,11 @@ class AsyncIoUringSocket : public AsyncSocketTransport {
       std::unique_ptr<IOBuf>&& buf,
       WriteFlags flags) override;
   bool canZC(std::unique_ptr<IOBuf> const& buf) const;
+  void setZeroCopyThreshold(size_t bytes) {
+    options_.zeroCopyThreshold = bytes;
+  }
+  ZeroCopyStats getZeroCopyStats() const { return zeroCopyStats_; }
+  ReadStats getReadStats() const { return readStats_; }
 
   // AsyncTransport
   void close() override;
@@ -343,6 +377,11 @@ class AsyncIoUringSocket : public AsyncSocketTransport {
     std::unique_ptr<IOBuf> tmpBuffer_;
     bool supportsMultishotRecv_ =
         false; // todo: this can be per process instead of per socket
+    // A poll is in flight instead of a recv.
+    bool pollingForData_ = false;
+    // The socket was readable when the ring was exhausted, so the next
+    // submit reads into an allocated buffer rather than polling again.
+    bool polledForData_ = false;
 
     folly::Optional<folly::SemiFuture<std::unique_ptr<IOBuf>>>
         oldEventBaseRead_;
@@ -473,6 +512,7 @@ class AsyncIoUringSocket : public AsyncSocketTransport {
   // read
   friend struct DetachFdState;
   ReadSqe::UniquePtr readSqe_;
+  ReadStats readStats_;
 
   // write
   std::chrono::milliseconds writeTimeoutTime_{0};
@@ -480,6 +520,7 @@ class AsyncIoUringSocket : public AsyncSocketTransport {
   WriteSqe* writeSqeActive_ = nullptr;
   WriteSqeList writeSqeQueue_;
   size_t bytesWritten_{0};
+  ZeroCopyStats zeroCopyStats_;
 
   // connect
   std::unique_ptr<ConnectSqe> connectSqe_;
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/AsyncIoUringUDPSocket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <folly/String.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/IoUringBackend.h>
+
+#if FOLLY_HAS_LIBURING
+
+namespace folly {
+
+namespace {
+
+// A datagram queued for a sendmsg SQE, with everything its msghdr points to.
+struct QueuedSend {
+  struct msghdr msg {};
+  struct iovec iov {};
+  sockaddr_storage name{};
+  // The cmsgs, followed by the payload.
+  std::unique_ptr<uint8_t[]> buf;
+};
+
+} // namespace
+
+AsyncIoUringUDPSocket::AsyncIoUringUDPSocket(EventBase* evb, Options options)
+    : AsyncUDPSocket(evb),
+      options_(std::move(options)),
+      backend_(getBackend(evb)),
+      sendState_(std::make_shared<SendState>()) {}
+
+AsyncIoUringUDPSocket::~AsyncIoUringUDPSocket() {
+  // ~AsyncUDPSocket() would not flush the queued sends.
+  if (getNetworkSocket() != NetworkSocket()) {
+    close();
+  }
+}
+
+/* static */ IoUringBackend* AsyncIoUringUDPSocket::getBackend(EventBase* evb) {
+  return evb ? dynamic_cast<IoUringBackend*>(evb->getBackend()) : nullptr;
+}
+
+/* static */ bool AsyncIoUringUDPSocket::supports(EventBase* evb) {
+  return getBackend(evb) != nullptr;
+}
+
+AsyncIoUringUDPSocket::Stats AsyncIoUringUDPSocket::getStats() const {
+  auto stats = stats_;
+  stats.failedSends = sendState_->failed;
+  return stats;
+}
+
+size_t AsyncIoUringUDPSocket::getSendsInFlight() const {
+  return sendState_->inFlight;
+}
+
+bool AsyncIoUringUDPSocket::canQueueSend(int flags) const {
+  // The zerocopy notifications are only read by the poll path.
+  return backend_ && flags == 0 &&
+      sendState_->inFlight < options_.maxSendsInFlight;
+}
+
+ssize_t AsyncIoUringUDPSocket::queueSend(
+    NetworkSocket socket, const struct msghdr& message) {
+  size_t len = 0;
+  for (size_t i = 0; i < size_t(message.msg_iovlen); ++i) {
+    len += message.msg_iov[i].iov_len;
+  }
+
+  auto send = std::make_unique<QueuedSend>();
+  size_t const controlLen = message.msg_control ? message.msg_controllen : 0;
+  send->buf.reset(new uint8_t[controlLen + len]);
+  uint8_t* payload = send->buf.get() + controlLen;
+  if (controlLen) {
+    std::memcpy(send->buf.get(), message.msg_control, controlLen);
+    send->msg.msg_control = send->buf.get();
+    send->msg.msg_controllen = message.msg_controllen;
+  }
+  uint8_t* p = payload;
+  for (size_t i = 0; i < size_t(message.msg_iovlen); ++i) {
+    std::memcpy(p, message.msg_iov[i].iov_base, message.msg_iov[i].iov_len);
+    p += message.msg_iov[i].iov_len;
+  }
+  if (message.msg_name) {
+    DCHECK_LE(size_t(message.msg_namelen), sizeof(send->name));
+    std::memcpy(&send->name, message.msg_name, message.msg_namelen);
+    send->msg.msg_name = &send->name;
+    send->msg.msg_namelen = message.msg_namelen;
+  }
+  send->iov.iov_base = payload;
+  send->iov.iov_len = len;
+  send->msg.msg_iov = &send->iov;
+  send->msg.msg_iovlen = 1;
+
+  auto const* msg = &send->msg;
+  ++sendState_->inFlight;
+  ++stats_.queuedSends;
+  backend_->queueSendmsg(
+      socket.toFd(),
+      msg,
+      0,
+      [state = sendState_, send = std::move(send)](int res) {
+        --state->inFlight;
+        if (res < 0) {
+          ++state->failed;
+          VLOG(4) << "AsyncIoUringUDPSocket: sendmsg failed: "
+                  << errnoStr(-res);
+        }
+      });
+  return ssize_t(len);
+}
+
+void AsyncIoUringUDPSocket::submitQueuedSends() {
+  if (backend_ && sendState_->inFlight > 0) {
+    backend_->submitOutstanding();
+  }
+}
+
+ssize_t AsyncIoUringUDPSocket::sendmsg(
+    NetworkSocket socket, const struct msghdr* message, int flags) {
+  if (canQueueSend(flags)) {
+    return queueSend(socket, *message);
+  }
+  // Keep the datagram behind those already queued.
+  submitQueuedSends();
+  auto ret = AsyncUDPSocket::sendmsg(socket, message, flags);
+  if (ret >= 0) {
+    ++stats_.syncSends;
+  }
+  return ret;
+}
+
+int AsyncIoUringUDPSocket::sendmmsg(
+    NetworkSocket socket,
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    int flags) {
+  unsigned int i = 0;
+  for (; i < vlen && canQueueSend(flags); ++i) {
+    msgvec[i].msg_len =
+        static_cast<unsigned int>(queueSend(socket, msgvec[i].msg_hdr));
+  }
+  if (i == vlen) {
+    return static_cast<int>(vlen);
+  }
+  submitQueuedSends();
+  auto ret = AsyncUDPSocket::sendmmsg(socket, msgvec + i, vlen - i, flags);
+  if (ret < 0) {
+    // As sendmmsg(), report the datagrams sent before the error.
+    return i > 0 ? static_cast<int>(i) : ret;
+  }
+  stats_.syncSends += ret;
+  return static_cast<int>(i) + ret;
+}
+
+bool AsyncIoUringUDPSocket::canRecvMultishot(ReadCallback* cob) const {
+  // The error queue is only read by the poll path, and notify-only callbacks
+  // read the datagrams themselves.
+  return options_.multishotRecv && backend_ && backend_->bufferProvider() &&
+      IoUringBackend::kernelSupportsRecvmsgMultishot() &&
+      !errMessageCallback_ && !cob->shouldOnlyNotify();
+}
+
+void AsyncIoUringUDPSocket::setRecvCallback(ReadCallback* cob) {
+  if (cob && canRecvMultishot(cob)) {
+    setRecvmsgMultishotCallback(this);
+  } else {
+    resetEventCallback();
+  }
+}
+
+void AsyncIoUringUDPSocket::resumeRead(ReadCallback* cob) {
+  setRecvCallback(cob);
+  AsyncUDPSocket::resumeRead(cob);
+}
+
+void AsyncIoUringUDPSocket::pauseRead() {
+  setRecvCallback(nullptr);
+  AsyncUDPSocket::pauseRead();
+}
+
+void AsyncIoUringUDPSocket::close() {
+  // The queued sends must be submitted before their fd is closed.
+  submitQueuedSends();
+  AsyncUDPSocket::close();
+}
+
+void AsyncIoUringUDPSocket::setErrMessageCallback(
+    ErrMessageCallback* errMessageCallback) {
+  AsyncUDPSocket::setErrMessageCallback(errMessageCallback);
+  errMessageCallback_ = errMessageCallback;
+  if (auto* cob = readCallback_) {
+    pauseRead();
+    resumeRead(cob);
+  }
+}
+
+void AsyncIoUringUDPSocket::detachEventBase() {
+  submitQueuedSends();
+  AsyncUDPSocket::detachEventBase();
+  backend_ = nullptr;
+}
+
+void AsyncIoUringUDPSocket::attachEventBase(folly::EventBase* evb) {
+  backend_ = getBackend(evb);
+  setRecvCallback(readCallback_);
+  AsyncUDPSocket::attachEventBase(evb);
+}
+
+EventRecvmsgMultishotCallback::Hdr*
+AsyncIoUringUDPSocket::allocateRecvmsgMultishotData() noexcept {
+  auto* hdr = new Hdr();
+  hdr->arg_ = this;
+  hdr->freeFunc_ = [](Hdr* h) { delete h; };
+  hdr->cbFunc_ = [](Hdr* h, int res, std::unique_ptr<IOBuf> buf) {
+    static_cast<AsyncIoUringUDPSocket*>(h->arg_)->onRecvmsgMultishot(
+        h->data_, res, std::move(buf));
+  };
+  ::memset(&hdr->data_, 0, sizeof(hdr->data_));
+  hdr->data_.msg_namelen = sizeof(sockaddr_storage);
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+  hdr->data_.msg_controllen = ReadCallback::OnDataAvailableParams::kCmsgSpace;
+#endif
+  return hdr;
+}
+
+void AsyncIoUringUDPSocket::onRecvmsgMultishot(
+    const struct msghdr& hdr, int res, std::unique_ptr<IOBuf> buf) noexcept {
+  if (res == -ENOBUFS) {
+    // The backend arms the recvmsg again, once buffers are returned to the
+    // ring.
+    ++stats_.noBuffers;
+    return;
+  }
+  if (res < 0) {
+    if (res == -ECANCELED || !readCallback_) {
+      return;
+    }
+    AsyncSocketException ex(
+        AsyncSocketException::INTERNAL_ERROR,
+        "multishot recvmsg failed",
+        -res);
+    // As AsyncUDPSocket::handleRead(), the callback has to resume reading.
+    auto cob = readCallback_;
+    pauseRead();
+    cob->onReadError(ex);
+    return;
+  }
+  if (!buf) {
+    return;
+  }
+
+  EventRecvmsgMultishotCallback::ParsedRecvMsgMultishot parsed;
+  if (!readCallback_ || !parseRecvmsgMultishot(buf->coalesce(), hdr, parsed)) {
+    ++stats_.droppedReads;
+    return;
+  }
+  ++stats_.multishotReads;
+
+  // Zero-length datagrams are delivered too, with len 0.
+  void* readBuf = nullptr;
+  size_t len = 0;
+  readCallback_->getReadBuffer(&readBuf, &len);
+  if (readBuf == nullptr || len == 0) {
+    AsyncSocketException ex(
+        AsyncSocketException::BAD_ARGS,
+        "AsyncUDPSocket::getReadBuffer() returned empty buffer");
+    auto cob = readCallback_;
+    pauseRead();
+    cob->onReadError(ex);
+    return;
+  }
+
+  ReadCallback::OnDataAvailableParams params;
+  struct msghdr msg = {};
+  if (!parsed.control.empty()) {
+    msg.msg_control = const_cast<uint8_t*>(parsed.control.data());
+    msg.msg_controllen = parsed.control.size();
+    fromMsg(params, msg);
+  }
+  if (!parsed.name.empty()) {
+    recvAddress_.setFromSockaddr(
+        reinterpret_cast<const sockaddr*>(parsed.name.data()),
+        static_cast<socklen_t>(parsed.name.size()));
+  }
+
+  auto const n = std::min(len, size_t(parsed.payload.size()));
+  if (n > 0) {
+    std::memcpy(readBuf, parsed.payload.data(), n);
+  }
+  // The kernel sets MSG_TRUNC when the provided buffer was too small.
+  bool const truncated =
+      n < parsed.realPayloadLength || (parsed.flags & MSG_TRUNC) != 0;
+  readCallback_->onDataAvailable(recvAddress_, n, truncated, params);
+}
+
+} // namespace folly
+
+#endif
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <folly/SocketAddress.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/AsyncUDPSocket.h>
+#include <folly/io/async/EventBaseBackendBase.h>
+#include <folly/io/async/Liburing.h>
+
+#if FOLLY_HAS_LIBURING
+
+namespace folly {
+
+class IoUringBackend;
+
+/**
+ * An AsyncUDPSocket that does its IO through the io_uring ring of an
+ * EventBase running an IoUringBackend, instead of with one syscall per
+ * datagram or per sendmmsg() batch.
+ *
+ * Reads arm a multishot recvmsg on the backend's provided buffer ring: the
+ * kernel picks a buffer for each datagram and keeps the request armed, so
+ * that a burst of datagrams is read with no syscall at all. The GRO segment
+ * size, the RX timestamps and the TOS of each datagram are parsed from its
+ * cmsgs, as AsyncUDPSocket::handleRead() does. The provided buffers must be
+ * large enough for the io_uring_recvmsg_out header, the address, the cmsgs
+ * and the largest datagram (64k with GRO); larger datagrams are dropped.
+ * Zero-length datagrams are delivered with len 0, where the poll path of
+ * AsyncUDPSocket drops them.
+ *
+ * Writes queue a sendmsg SQE per datagram, which are submitted together with
+ * the other SQEs of the loop iteration. Every write path of AsyncUDPSocket
+ * goes through them, with its GSO, TX time and other cmsgs. As the SQEs
+ * outlive the write call, each datagram is copied to a buffer owned by its
+ * SQE, and the write returns the number of bytes queued: send errors are
+ * only counted in the stats, as UDP does not guarantee delivery anyway.
+ * Writes beyond maxSendsInFlight, and zerocopy writes, are sent with a
+ * syscall.
+ *
+ * On an EventBase with another backend, and for read callbacks that only
+ * want to be notified, the socket behaves as an AsyncUDPSocket.
+ */
+class AsyncIoUringUDPSocket : public AsyncUDPSocket,
+                              private EventRecvmsgMultishotCallback {
+ public:
+  struct Options {
+    Options() {}
+
+    Options& setMaxSendsInFlight(size_t n) {
+      maxSendsInFlight = n;
+      return *this;
+    }
+    Options& setMultishotRecv(bool b) {
+      multishotRecv = b;
+      return *this;
+    }
+
+    // The maximum number of sendmsg SQEs queued at a time.
+    size_t maxSendsInFlight{1024};
+    // Whether to read with a multishot recvmsg when the kernel supports it.
+    bool multishotRecv{true};
+  };
+
+  struct Stats {
+    // Datagrams sent with a sendmsg SQE, and those that failed.
+    uint64_t queuedSends{0};
+    uint64_t failedSends{0};
+    // Datagrams sent with a syscall.
+    uint64_t syncSends{0};
+    // Datagrams read from a multishot recvmsg.
+    uint64_t multishotReads{0};
+    // Times the multishot recvmsg ran out of provided buffers.
+    uint64_t noBuffers{0};
+    // Datagrams read but not delivered: too large for a provided buffer, or
+    // received after the read callback was uninstalled.
+    uint64_t droppedReads{0};
+  };
+
+  explicit AsyncIoUringUDPSocket(EventBase* evb, Options options = {});
+  ~AsyncIoUringUDPSocket() override;
+
+  // Whether the socket does its IO through io_uring, i.e. whether evb runs
+  // an IoUringBackend.
+  static bool supports(EventBase* evb);
+
+  void resumeRead(ReadCallback* cob) override;
+  void pauseRead() override;
+  void close() override;
+
+  void setErrMessageCallback(ErrMessageCallback* errMessageCallback) override;
+
+  void detachEventBase() override;
+  void attachEventBase(folly::EventBase* evb) override;
+
+  Stats getStats() const;
+  size_t getSendsInFlight() const;
+
+ protected:
+  ssize_t sendmsg(
+      NetworkSocket socket, const struct msghdr* message, int flags) override;
+
+  int sendmmsg(
+      NetworkSocket socket,
+      struct mmsghdr* msgvec,
+      unsigned int vlen,
+      int flags) override;
+
+ private:
+  struct SendState {
+    size_t inFlight{0};
+    uint64_t failed{0};
+  };
+
+  static IoUringBackend* getBackend(EventBase* evb);
+
+  bool canQueueSend(int flags) const;
+  ssize_t queueSend(NetworkSocket socket, const struct msghdr& message);
+  void submitQueuedSends();
+
+  bool canRecvMultishot(ReadCallback* cob) const;
+  // Reads with a multishot recvmsg if cob can, with the poll path otherwise.
+  void setRecvCallback(ReadCallback* cob);
+  EventRecvmsgMultishotCallback::Hdr*
+  allocateRecvmsgMultishotData() noexcept override;
+  void onRecvmsgMultishot(
+      const struct msghdr& hdr,
+      int res,
+      std::unique_ptr<IOBuf> buf) noexcept;
+
+  const Options options_;
+  IoUringBackend* backend_;
+  ErrMessageCallback* errMessageCallback_{nullptr};
+  // Shared with the SQEs, which may complete after the socket is destroyed.
+  std::shared_ptr<SendState> sendState_;
+  folly::SocketAddress recvAddress_;
+  Stats stats_;
+};
+
+} // namespace folly
+
+#endif
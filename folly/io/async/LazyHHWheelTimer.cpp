@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/LazyHHWheelTimer.h>
+
+#include <algorithm>
+
+#include <folly/ScopeGuard.h>
+#include <folly/io/async/Request.h>
+#include <folly/lang/Bits.h>
+
+namespace folly {
+
+template <class Duration>
+int LazyHHWheelTimerBase<Duration>::DEFAULT_TICK_INTERVAL =
+    detail::HHWheelTimerDurationConst<Duration>::DEFAULT_TICK_INTERVAL;
+
+template <class Duration>
+LazyHHWheelTimerBase<Duration>::Callback::~Callback() {
+  if (isScheduled()) {
+    cancelTimeout();
+  }
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::Callback::cancelTimeoutImpl() {
+  auto* wheel = wheel_;
+  if (--wheel->count_ == 0) {
+    wheel->AsyncTimeout::cancelTimeout();
+    wheel->expireTick_ = NO_TICK;
+  }
+  unlink();
+  if (wheel->buckets_[level_][slot_].empty()) {
+    wheel->clearBit(level_, slot_);
+  }
+
+  wheel_ = nullptr;
+  expiration_ = {};
+}
+
+template <class Duration>
+LazyHHWheelTimerBase<Duration>::LazyHHWheelTimerBase(
+    folly::TimeoutManager* timeoutMananger,
+    Duration intervalDuration,
+    AsyncTimeout::InternalEnum internal,
+    Duration defaultTimeoutDuration)
+    : AsyncTimeout(timeoutMananger, internal),
+      interval_(intervalDuration),
+      defaultTimeout_(defaultTimeoutDuration),
+      startTime_(getCurTime()) {
+  for (auto& bitmap : bitmaps_) {
+    bitmap.fill(0);
+  }
+}
+
+template <class Duration>
+LazyHHWheelTimerBase<Duration>::~LazyHHWheelTimerBase() {
+  // Ensure this gets done, but right before destruction finishes.
+  auto destructionPublisherGuard = folly::makeGuard([&] {
+    // Inform the subscriber that this instance is doomed.
+    if (processingCallbacksGuard_) {
+      *processingCallbacksGuard_ = true;
+    }
+  });
+  cancelAll();
+}
+
+template <class Duration>
+int64_t LazyHHWheelTimerBase<Duration>::calcSlotTick(
+    const Callback* callback) const {
+  // The first tick of the slot at or after curTick_, as in findNextTick().
+  auto const shift = callback->level_ * WHEEL_BITS;
+  auto const unit = int64_t(1) << shift;
+  auto const first = (curTick_ + unit - 1) & ~(unit - 1);
+  return first + ((callback->slot_ - (first >> shift)) & WHEEL_MASK) * unit;
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::placeTimeout(
+    Callback* callback, bool expire) {
+  auto const dueTick = calcDueTick(callback);
+  if (expire && dueTick <= curTick_) {
+    timeoutsToRunNow_.push_back(*callback);
+    return;
+  }
+
+  int64_t key = std::max(dueTick, curTick_);
+  int64_t diff = key - curTick_;
+  if (diff > LARGEST_SLOT) {
+    // The timeout is moved down again as the wheel reaches its slot.
+    diff = LARGEST_SLOT;
+    key = curTick_ + diff;
+  }
+
+  int level = 0;
+  while (level < WHEEL_LEVELS - 1 &&
+         diff >= int64_t(1) << ((level + 1) * WHEEL_BITS)) {
+    ++level;
+  }
+  // A slot of a higher level is processed on the first tick of its range,
+  // which is after curTick_ since diff is at least the size of the range.
+  auto const shift = level * WHEEL_BITS;
+  auto const slot = static_cast<unsigned int>((key >> shift) & WHEEL_MASK);
+  callback->level_ = static_cast<uint8_t>(level);
+  callback->slot_ = static_cast<uint8_t>(slot);
+  buckets_[level][slot].push_back(*callback);
+  setBit(level, slot);
+}
+
+template <class Duration>
+int LazyHHWheelTimerBase<Duration>::findFirstSlot(
+    int level, unsigned int from) const {
+  auto const& bitmap = bitmaps_[level];
+  auto word = from / 64;
+  auto bits = bitmap[word] & (~uint64_t(0) << (from % 64));
+  // The words after from, then the one of from again for the slots before it.
+  for (size_t i = 0; i <= bitmap.size(); ++i) {
+    if (bits) {
+      auto const slot = word * 64 + folly::findFirstSet(bits) - 1;
+      return static_cast<int>((slot - from) & WHEEL_MASK);
+    }
+    word = (word + 1) % bitmap.size();
+    bits = bitmap[word];
+  }
+  return -1;
+}
+
+template <class Duration>
+int64_t LazyHHWheelTimerBase<Duration>::findNextTick() const {
+  int64_t next = NO_TICK;
+  for (int level = 0; level < WHEEL_LEVELS; ++level) {
+    auto const shift = level * WHEEL_BITS;
+    auto const unit = int64_t(1) << shift;
+    // The first tick of a slot of this level that is not processed yet.
+    auto const first = (curTick_ + unit - 1) & ~(unit - 1);
+    auto const dist = findFirstSlot(
+        level, static_cast<unsigned int>((first >> shift) & WHEEL_MASK));
+    if (dist >= 0) {
+      next = std::min(next, first + dist * unit);
+    }
+  }
+  return next;
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::cascadeTimers(
+    int level, unsigned int slot) {
+  CallbackList cbs;
+  cbs.swap(buckets_[level][slot]);
+  clearBit(level, slot);
+  while (!cbs.empty()) {
+    auto* cb = &cbs.front();
+    cbs.pop_front();
+    placeTimeout(cb, true);
+  }
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::advanceTo(int64_t endTick) {
+  while (curTick_ < endTick) {
+    auto const tick = findNextTick();
+    if (tick >= endTick) {
+      // Nothing to do until endTick.
+      curTick_ = endTick;
+      break;
+    }
+    curTick_ = tick;
+
+    // Cascade from the top, so that the timeouts cascaded into a lower slot
+    // starting at this tick are cascaded again or expired right away.
+    for (int level = WHEEL_LEVELS - 1; level > 0; --level) {
+      auto const shift = level * WHEEL_BITS;
+      if ((tick & ((int64_t(1) << shift) - 1)) == 0) {
+        auto const slot =
+            static_cast<unsigned int>((tick >> shift) & WHEEL_MASK);
+        if (!buckets_[level][slot].empty()) {
+          cascadeTimers(level, slot);
+        }
+      }
+    }
+
+    auto const slot = static_cast<unsigned int>(tick & WHEEL_MASK);
+    timeoutsToRunNow_.splice(timeoutsToRunNow_.end(), buckets_[0][slot]);
+    clearBit(0, slot);
+    curTick_ = tick + 1;
+  }
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::scheduleTimeout(
+    Callback* callback, Duration timeout) {
+  // Make sure that the timeout is not negative.
+  timeout = std::max(timeout, Duration::zero());
+  auto const now = getCurTime();
+
+  if (callback->wheel_ == this &&
+      calcNextTick(now + timeout) >= calcSlotTick(callback)) {
+    // Pushed back: leave it where it is until the wheel reaches its slot. If
+    // it is in timeoutsToRunNow_, calcSlotTick() is wrong, but can only be
+    // later than the tick it is due at, in which case it is moved.
+    callback->expiration_ = now + timeout;
+    callback->requestContext_ = RequestContext::saveContext();
+    return;
+  }
+
+  // Cancel the callback if it happens to be scheduled already.
+  callback->cancelTimeout();
+  callback->requestContext_ = RequestContext::saveContext();
+
+  if (count_ == 0 && !processingCallbacksGuard_) {
+    // The wheel is empty, skip the ticks since it last ran.
+    curTick_ = std::max(curTick_, calcNextTick(now));
+  }
+  count_++;
+
+  callback->wheel_ = this;
+  callback->expiration_ = now + timeout;
+  placeTimeout(callback, false);
+
+  // If we're calling callbacks, timer will be reset after all callbacks are
+  // called.
+  if (!processingCallbacksGuard_) {
+    auto const slotTick = calcSlotTick(callback);
+    if (slotTick < expireTick_) {
+      scheduleTimeoutAt(slotTick, now);
+    }
+  }
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::scheduleTimeout(Callback* callback) {
+  CHECK(Duration(-1) != defaultTimeout_)
+      << "Default timeout was not initialized";
+  scheduleTimeout(callback, defaultTimeout_);
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::scheduleTimeoutInternal(
+    Duration timeout) {
+  this->AsyncTimeout::scheduleTimeout(timeout, {});
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::scheduleTimeoutAt(
+    int64_t tick, std::chrono::steady_clock::time_point curTime) {
+  // The tick is processed once it is over.
+  auto const deadline = startTime_ + interval_.fromWheelTicks(tick + 1);
+  auto timeout = Duration::zero();
+  if (deadline > curTime) {
+    timeout = std::chrono::ceil<Duration>(deadline - curTime);
+  }
+  scheduleTimeoutInternal(timeout);
+  expireTick_ = tick;
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::scheduleNextTimeout(
+    std::chrono::steady_clock::time_point curTime) {
+  auto const tick = findNextTick();
+  if (tick != NO_TICK) {
+    scheduleTimeoutAt(tick, curTime);
+  }
+}
+
+template <class Duration>
+void LazyHHWheelTimerBase<Duration>::timeoutExpired() noexcept {
+  expireTick_ = NO_TICK;
+  advanceTo(calcNextTick(getCurTime()));
+
+  // If the last smart pointer for "this" is reset inside the callback's
+  // timeoutExpired(), then the guard will detect that it is time to bail from
+  // this method.
+  auto isDestroyed = false;
+  // If scheduleTimeout is called from a callback in this function, it may
+  // cause inconsistencies in the state of this object. As such, we need
+  // to treat these calls slightly differently.
+  CHECK(!processingCallbacksGuard_);
+  FOLLY_PUSH_WARNING
+#if __GNUC__ >= 12
+  FOLLY_GCC_DISABLE_WARNING("-Wdangling-pointer")
+#endif
+  processingCallbacksGuard_ = &isDestroyed;
+  FOLLY_POP_WARNING
+  auto reEntryGuard = folly::makeGuard([&] {
+    if (!isDestroyed) {
+      processingCallbacksGuard_ = nullptr;
+    }
+  });
+
+  // Restores the context of the loop once, rather than after each callback.
+  RequestContextSaverScopeGuard rctx;
+  while (!timeoutsToRunNow_.empty()) {
+    auto* cb = &timeoutsToRunNow_.front();
+    timeoutsToRunNow_.pop_front();
+    if (calcDueTick(cb) >= curTick_) {
+      // Pushed back after it was put in its slot.
+      placeTimeout(cb, false);
+      continue;
+    }
+    count_--;
+    cb->wheel_ = nullptr;
+    cb->expiration_ = {};
+    auto requestContext = std::move(cb->requestContext_);
+    if (RequestContext::try_get() != requestContext.get()) {
+      RequestContext::setContext(std::move(requestContext));
+    }
+    cb->timeoutExpired();
+    if (isDestroyed) {
+      // The LazyHHWheelTimerBase itself has been destroyed. The other
+      // callbacks will have been cancelled from the destructor. Bail before
+      // causing damage.
+      return;
+    }
+  }
+
+  // We don't need to schedule a new timeout if there're nothing in the wheel.
+  if (count_ > 0) {
+    scheduleNextTimeout(getCurTime());
+  }
+}
+
+template <class Duration>
+size_t LazyHHWheelTimerBase<Duration>::cancelAll() {
+  size_t count = 0;
+
+  if (count_ != 0) {
+    const std::size_t numElements = WHEEL_LEVELS * WHEEL_SIZE;
+    auto maxBuckets = std::min(numElements, count_);
+    auto buckets = std::make_unique<CallbackList[]>(maxBuckets);
+    size_t countBuckets = 0;
+    for (auto& level : buckets_) {
+      for (auto& bucket : level) {
+        if (bucket.empty()) {
+          continue;
+        }
+        count += bucket.size();
+        std::swap(bucket, buckets[countBuckets++]);
+        if (countBuckets == maxBuckets) {
+          break;
+        }
+      }
+      if (countBuckets == maxBuckets) {
+        break;
+      }
+    }
+    for (auto& bitmap : bitmaps_) {
+      bitmap.fill(0);
+    }
+
+    for (size_t i = 0; i < countBuckets; ++i) {
+      cancelTimeoutsFromList(buckets[i]);
+    }
+    // Swap the list to prevent potential recursion if cancelAll is called by
+    // one of the callbacks.
+    CallbackList timeoutsToRunNow;
+    timeoutsToRunNow.swap(timeoutsToRunNow_);
+    count += cancelTimeoutsFromList(timeoutsToRunNow);
+  }
+
+  return count;
+}
+
+template <class Duration>
+size_t LazyHHWheelTimerBase<Duration>::cancelTimeoutsFromList(
+    CallbackList& timeouts) {
+  size_t count = 0;
+  while (!timeouts.empty()) {
+    ++count;
+    auto& cb = timeouts.front();
+    cb.cancelTimeout();
+    cb.callbackCanceled();
+  }
+  return count;
+}
+
+// std::chrono::microseconds
+template <>
+void LazyHHWheelTimerBase<std::chrono::microseconds>::scheduleTimeoutInternal(
+    std::chrono::microseconds timeout) {
+  this->AsyncTimeout::scheduleTimeoutHighRes(timeout, {});
+}
+
+// std::chrono::milliseconds
+template class LazyHHWheelTimerBase<std::chrono::milliseconds>;
+
+// std::chrono::microseconds
+template class LazyHHWheelTimerBase<std::chrono::microseconds>;
+} // namespace folly
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include <boost/intrusive/list.hpp>
+#include <glog/logging.h>
+
+#include <folly/ExceptionString.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/DelayedDestruction.h>
+#include <folly/io/async/HHWheelTimer.h>
+
+namespace folly {
+
+/**
+ * A hierarchical timing wheel with the API of HHWheelTimerBase, for timers
+ * that are mostly pushed back or cancelled before they expire, such as the
+ * idle timeouts of millions of connections.
+ *
+ * Like HHWheelTimerBase, it has 4 levels of 256 slots, a timeout being in
+ * the level of the most significant byte of the number of ticks until it is
+ * due. It differs in how the timeouts move through the wheel:
+ *
+ * - Lazy cascading: the wheel only wakes up for the ticks that have a
+ *   timeout, and for the first tick of the higher level slots that are not
+ *   empty, found with a bitmap per level. Only those slots are cascaded, on
+ *   demand, instead of cascading at every revolution of the lower level.
+ *
+ * - Cheap reschedule: scheduling a timeout that is already scheduled to a
+ *   later deadline only updates its deadline, and leaves it in its slot.
+ *   When the slot is reached, the timeout is moved to the slot of its new
+ *   deadline, so a timeout pushed back on every read only moves through the
+ *   wheel about once per timeout period, instead of on every read, and the
+ *   slots keep the order the timeouts were scheduled in.
+ *
+ * - Batched expiry: the due slots are spliced into the list of timeouts to
+ *   run in O(1), the request context is only switched between callbacks
+ *   with different contexts, and the wheel timeout is rearmed once after
+ *   the batch.
+ *
+ * A timeout never expires early, and expires at most one tick late when the
+ * loop is not lagging.
+ */
+template <class Duration>
+class LazyHHWheelTimerBase
+    : private folly::AsyncTimeout,
+      public folly::DelayedDestruction {
+ public:
+  using UniquePtr = std::unique_ptr<LazyHHWheelTimerBase, Destructor>;
+  using SharedPtr = std::shared_ptr<LazyHHWheelTimerBase>;
+
+  template <typename... Args>
+  static UniquePtr newTimer(Args&&... args) {
+    return UniquePtr(new LazyHHWheelTimerBase(std::forward<Args>(args)...));
+  }
+
+  /**
+   * A callback to be notified when a timeout has expired.
+   */
+  class Callback
+      : public boost::intrusive::list_base_hook<
+            boost::intrusive::link_mode<boost::intrusive::auto_unlink>> {
+   public:
+    Callback() = default;
+    virtual ~Callback();
+
+    /**
+     * timeoutExpired() is invoked when the timeout has expired.
+     */
+    virtual void timeoutExpired() noexcept = 0;
+
+    /// This callback was canceled. The default implementation is to just
+    /// proxy to `timeoutExpired` but if you care about the difference between
+    /// the timeout finishing or being canceled you can override this.
+    virtual void callbackCanceled() noexcept { timeoutExpired(); }
+
+    /**
+     * Cancel the timeout, if it is running.
+     *
+     * If the timeout is not scheduled, cancelTimeout() does nothing.
+     */
+    void cancelTimeout() {
+      if (wheel_ == nullptr) {
+        // We're not scheduled, so there's nothing to do.
+        return;
+      }
+      cancelTimeoutImpl();
+    }
+
+    /**
+     * Return true if this timeout is currently scheduled, and false otherwise.
+     */
+    bool isScheduled() const { return wheel_ != nullptr; }
+
+    /**
+     * Get the time remaining until this timeout expires. Return 0 if this
+     * timeout is not scheduled or expired. Otherwise, return expiration
+     * time minus current time.
+     */
+    Duration getTimeRemaining() const {
+      return getTimeRemaining(std::chrono::steady_clock::now());
+    }
+
+   private:
+    Duration getTimeRemaining(std::chrono::steady_clock::time_point now) const {
+      if (now >= expiration_) {
+        return Duration(0);
+      }
+      return std::chrono::duration_cast<Duration>(expiration_ - now);
+    }
+
+    void cancelTimeoutImpl();
+
+    LazyHHWheelTimerBase* wheel_{nullptr};
+    // The deadline, which may be later than the slot the timeout is in if it
+    // was pushed back.
+    std::chrono::steady_clock::time_point expiration_{};
+    // The slot the timeout was last put in. It is left as is when the slot
+    // is moved to the list of timeouts to run: the bit of the slot is only
+    // cleared on cancel if the slot is empty, which is right either way.
+    uint8_t level_{0};
+    uint8_t slot_{0};
+
+    typedef boost::intrusive::
+        list<Callback, boost::intrusive::constant_time_size<false>>
+            List;
+
+    std::shared_ptr<RequestContext> requestContext_;
+
+    friend class LazyHHWheelTimerBase;
+  };
+
+  static int DEFAULT_TICK_INTERVAL;
+  explicit LazyHHWheelTimerBase(
+      folly::TimeoutManager* timeoutMananger,
+      Duration intervalDuration = Duration(DEFAULT_TICK_INTERVAL),
+      AsyncTimeout::InternalEnum internal = AsyncTimeout::InternalEnum::NORMAL,
+      Duration defaultTimeoutDuration = Duration(-1));
+
+  /**
+   * Cancel all outstanding timeouts
+   *
+   * @returns the number of timeouts that were cancelled.
+   */
+  size_t cancelAll();
+
+  Duration getTickInterval() const { return interval_.interval(); }
+
+  Duration getDefaultTimeout() const { return defaultTimeout_; }
+
+  void setDefaultTimeout(Duration timeout) { defaultTimeout_ = timeout; }
+
+  /**
+   * Schedule the specified Callback to be invoked after the
+   * specified timeout interval.
+   *
+   * If the callback is already scheduled, its timeout is replaced by the new
+   * one. This is O(1), and does not touch the wheel, if the new deadline is
+   * not earlier than the slot the callback is in.
+   */
+  void scheduleTimeout(Callback* callback, Duration timeout);
+
+  /**
+   * Schedule the specified Callback to be invoked after the
+   * default timeout interval.
+   *
+   * This method uses CHECK() to make sure that the default timeout was
+   * specified on the object initialization.
+   */
+  void scheduleTimeout(Callback* callback);
+
+  template <class F>
+  void scheduleTimeoutFn(F fn, Duration timeout) {
+    struct Wrapper : Callback {
+      Wrapper(F f) : fn_(std::move(f)) {}
+      void timeoutExpired() noexcept override {
+        try {
+          fn_();
+        } catch (...) {
+          LOG(ERROR)
+              << "LazyHHWheelTimerBase timeout callback threw unhandled "
+              << exceptionStr(current_exception());
+        }
+        delete this;
+      }
+      F fn_;
+    };
+    Wrapper* w = new Wrapper(std::move(fn));
+    scheduleTimeout(w, timeout);
+  }
+
+  /**
+   * Return the number of currently pending timeouts
+   */
+  std::size_t count() const { return count_; }
+
+  bool isDetachable() const { return !folly::AsyncTimeout::isScheduled(); }
+
+  using folly::AsyncTimeout::attachEventBase;
+  using folly::AsyncTimeout::detachEventBase;
+  using folly::AsyncTimeout::getTimeoutManager;
+
+ protected:
+  /**
+   * Protected destructor.
+   *
+   * Use destroy() instead.  See the comments in DelayedDestruction for more
+   * details.
+   */
+  ~LazyHHWheelTimerBase() override;
+
+ private:
+  LazyHHWheelTimerBase(LazyHHWheelTimerBase const&) = delete;
+  LazyHHWheelTimerBase& operator=(LazyHHWheelTimerBase const&) = delete;
+
+  // Methods inherited from AsyncTimeout
+  void timeoutExpired() noexcept override;
+
+  static constexpr int WHEEL_LEVELS = 4;
+  static constexpr int WHEEL_BITS = 8;
+  static constexpr unsigned int WHEEL_SIZE = (1 << WHEEL_BITS);
+  static constexpr unsigned int WHEEL_MASK = (WHEEL_SIZE - 1);
+  static constexpr int64_t LARGEST_SLOT = 0xffffffffLL;
+  static constexpr int64_t NO_TICK = std::numeric_limits<int64_t>::max();
+
+  typedef typename Callback::List CallbackList;
+  typedef std::array<uint64_t, WHEEL_SIZE / 64> Bitmap;
+
+  int64_t calcNextTick(std::chrono::steady_clock::time_point curTime) const {
+    return interval_.toWheelTicksFromSteadyClock(curTime - startTime_);
+  }
+
+  // A timeout expires once the tick its deadline is in is over, so never
+  // early.
+  int64_t calcDueTick(const Callback* callback) const {
+    return calcNextTick(callback->expiration_);
+  }
+
+  // The tick the slot of callback is processed at, if it is in a slot.
+  int64_t calcSlotTick(const Callback* callback) const;
+
+  // Puts callback in the slot of its due tick relative to curTick_, or in
+  // timeoutsToRunNow_ if expire is set and it is due.
+  void placeTimeout(Callback* callback, bool expire);
+
+  // Moves the timeouts of the slot to the lower levels, or to
+  // timeoutsToRunNow_ if they are due.
+  void cascadeTimers(int level, unsigned int slot);
+
+  // Processes the ticks up to, but not including, endTick.
+  void advanceTo(int64_t endTick);
+
+  // The first tick after curTick_ (or curTick_ itself) that has a slot to
+  // expire or to cascade, or NO_TICK.
+  int64_t findNextTick() const;
+
+  void scheduleNextTimeout(std::chrono::steady_clock::time_point curTime);
+  void scheduleTimeoutAt(
+      int64_t tick, std::chrono::steady_clock::time_point curTime);
+  void scheduleTimeoutInternal(Duration timeout);
+
+  size_t cancelTimeoutsFromList(CallbackList& timeouts);
+
+  void setBit(int level, unsigned int slot) {
+    bitmaps_[level][slot / 64] |= uint64_t(1) << (slot % 64);
+  }
+  void clearBit(int level, unsigned int slot) {
+    bitmaps_[level][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+  }
+  // The first set slot at or after from in the bitmap of level, wrapping
+  // around, as a distance from from, or -1 if there is none.
+  int findFirstSlot(int level, unsigned int from) const;
+
+  detail::HHWheelTimerDurationInterval<Duration> interval_;
+  Duration defaultTimeout_;
+
+  CallbackList buckets_[WHEEL_LEVELS][WHEEL_SIZE];
+  Bitmap bitmaps_[WHEEL_LEVELS];
+
+  std::chrono::steady_clock::time_point startTime_;
+  // The first tick that was not processed yet.
+  int64_t curTick_{0};
+  // The tick the wheel timeout fires after, or NO_TICK if it is not
+  // scheduled.
+  int64_t expireTick_{NO_TICK};
+  std::size_t count_{0};
+
+  bool* processingCallbacksGuard_{nullptr};
+  // Timeouts that we're about to run. They're already extracted from their
+  // corresponding buckets, so we need this list for the `cancelAll` to be able
+  // to cancel them.
+  CallbackList timeoutsToRunNow_;
+
+  std::chrono::steady_clock::time_point getCurTime() const {
+    return std::chrono::steady_clock::now();
+  }
+};
+
+// std::chrono::milliseconds
+using LazyHHWheelTimer = LazyHHWheelTimerBase<std::chrono::milliseconds>;
+extern template class LazyHHWheelTimerBase<std::chrono::milliseconds>;
+
+// std::chrono::microseconds
+template <>
+void LazyHHWheelTimerBase<std::chrono::microseconds>::scheduleTimeoutInternal(
+    std::chrono::microseconds timeout);
+
+using LazyHHWheelTimerHighRes =
+    LazyHHWheelTimerBase<std::chrono::microseconds>;
+extern template class LazyHHWheelTimerBase<std::chrono::microseconds>;
+
+} // namespace folly
@@ -16,9 +16,11 @@
 
 #include <folly/io/async/MuxIOThreadPoolExecutor.h>
 
+#include <cmath>
 #include <stdexcept>
 
 #include <fmt/format.h>
+#include <folly/Random.h>
 #include <folly/container/Enumerate.h>
 #include <folly/experimental/io/EpollBackend.h>
 #include <folly/lang/Align.h>
@@ -35,6 +37,12 @@ ThrottledLifoSem::Options throttledLifoSemOptions(
   return opts;
 }
 
+uint64_t nowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 } // namespace
 
 struct MuxIOThreadPoolExecutor::EvbState {
@@ -45,6 +53,26 @@ struct MuxIOThreadPoolExecutor::EvbState {
 
   alignas(cacheline_align_v) std::atomic<size_t> pendingTasks = 0;
 
+  // Only written by the thread driving the EventBase.
+  alignas(cacheline_align_v) relaxed_atomic<uint64_t> busyNanos{0};
+  relaxed_atomic<uint64_t> numLoops{0};
+  // Busy time decayed exponentially, as of lastLoopEndNanos.
+  relaxed_atomic<double> recentBusyNanos{0};
+  relaxed_atomic<uint64_t> lastLoopEndNanos{0};
+
+  void recordLoop(uint64_t start, uint64_t end, double halfLifeNanos) {
+    busyNanos += end - start;
+    ++numLoops;
+    recentBusyNanos = recentBusy(end, halfLifeNanos) + double(end - start);
+    lastLoopEndNanos = end;
+  }
+
+  double recentBusy(uint64_t now, double halfLifeNanos) const {
+    auto const last = lastLoopEndNanos.load();
+    auto const elapsed = now > last ? double(now - last) : 0.0;
+    return recentBusyNanos.load() * std::exp2(-elapsed / halfLifeNanos);
+  }
+
  private:
   static const EventBase::Options& evbOptions() {
 #if FOLLY_HAS_EPOLL
@@ -68,6 +96,9 @@ MuxIOThreadPoolExecutor::MuxIOThreadPoolExecutor(
       options_(std::move(options)),
       numEventBases_(
           options_.numEventBases == 0 ? numThreads : options_.numEventBases),
+      loadHalfLifeNanos_(std::max(
+          double(std::chrono::nanoseconds(options_.loadHalfLife).count()),
+          1.0)),
       eventBaseManager_(ebm),
       readyQueueSem_(throttledLifoSemOptions(options.wakeUpInterval)) {
   setNumThreads(numThreads);
@@ -160,18 +191,20 @@ void MuxIOThreadPoolExecutor::threadRun(ThreadPtr thread) {
 
   while (true) {
     readyQueueSem_.wait(WaitOptions{}.spin_max(options_.idleSpinMax));
-    auto handle = readyQueue_.dequeue();
-    if (handle == nullptr) {
+    if (tryDecrToStop()) {
       break;
     }
+    auto handle = readyQueue_.dequeue();
     auto* evbState = handle->getUserData<EvbState>();
     auto* evb = &evbState->evb;
 
     ioThread->curEvbState = evbState;
     eventBaseManager_->setEventBase(evb, false);
 
+    auto const start = nowNanos();
     auto status = evb->loopWithSuspension();
     CHECK(status != EventBase::LoopStatus::kError);
+    evbState->recordLoop(start, nowNanos(), loadHalfLifeNanos_);
 
     eventBaseManager_->clearEventBase();
     ioThread->curEvbState = nullptr;
@@ -189,10 +222,41 @@ void MuxIOThreadPoolExecutor::threadRun(ThreadPtr thread) {
 
 MuxIOThreadPoolExecutor::EvbState& MuxIOThreadPoolExecutor::pickEvbState() {
   if (auto ioThread = thisThread_.get_existing()) {
-    return *(*ioThread)->curEvbState;
+    // Work added by the EventBase being driven stays on it. Pool threads
+    // between loops, for example in observer callbacks, have none.
+    if (auto* evbState = (*ioThread)->curEvbState) {
+      return *evbState;
+    }
   }
 
-  return *evbStates_[nextEvb_++ % evbStates_.size()];
+  auto const n = evbStates_.size();
+  auto& first = *evbStates_[nextEvb_++ % n];
+  if (!options_.loadAwarePlacement || n == 1) {
+    return first;
+  }
+  // Power of two choices: compare with another EventBase picked at random.
+  auto& second = *evbStates_[folly::Random::rand32(uint32_t(n))];
+  auto const now = nowNanos();
+  auto const firstBusy = first.recentBusy(now, loadHalfLifeNanos_);
+  auto const secondBusy = second.recentBusy(now, loadHalfLifeNanos_);
+  if (firstBusy != secondBusy) {
+    return firstBusy < secondBusy ? first : second;
+  }
+  return first.pendingTasks.load(std::memory_order_relaxed) <=
+          second.pendingTasks.load(std::memory_order_relaxed)
+      ? first
+      : second;
+}
+
+bool MuxIOThreadPoolExecutor::tryDecrToStop() {
+  auto toStop = threadsToStop_.load(std::memory_order_relaxed);
+  while (toStop > 0) {
+    if (threadsToStop_.compare_exchange_weak(
+            toStop, toStop - 1, std::memory_order_acq_rel)) {
+      return true;
+    }
+  }
+  return false;
 }
 
 size_t MuxIOThreadPoolExecutor::getPendingTaskCountImpl() const {
@@ -223,7 +287,7 @@ void MuxIOThreadPoolExecutor::maybeUnregisterEventBases(Observer* o) {
 
 void MuxIOThreadPoolExecutor::removeObserver(std::shared_ptr<Observer> o) {
   maybeUnregisterEventBases(o.get());
-  ThreadPoolExecutor::addObserver(std::move(o));
+  ThreadPoolExecutor::removeObserver(std::move(o));
 }
 
 std::vector<folly::Executor::KeepAlive<folly::EventBase>>
@@ -235,14 +299,28 @@ folly::EventBaseManager* MuxIOThreadPoolExecutor::getEventBaseManager() {
   return eventBaseManager_;
 }
 
+std::vector<MuxIOThreadPoolExecutor::EventBaseStats>
+MuxIOThreadPoolExecutor::getEventBaseStats() const {
+  auto const now = nowNanos();
+  std::vector<EventBaseStats> stats;
+  stats.reserve(evbStates_.size());
+  for (const auto& evbState : evbStates_) {
+    auto& s = stats.emplace_back();
+    s.busyTime = std::chrono::nanoseconds(evbState->busyNanos.load());
+    s.numLoops = evbState->numLoops.load();
+    s.recentBusyTime = std::chrono::nanoseconds(
+        uint64_t(evbState->recentBusy(now, loadHalfLifeNanos_)));
+    s.pendingTasks = evbState->pendingTasks.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
 EventBase* MuxIOThreadPoolExecutor::getEventBase() {
   return &pickEvbState().evb;
 }
 
 void MuxIOThreadPoolExecutor::stopThreads(size_t n) {
-  for (size_t i = 0; i < n; i++) {
-    readyQueue_.enqueue(nullptr); // Poison.
-  }
+  threadsToStop_.fetch_add(n, std::memory_order_acq_rel);
   readyQueueSem_.post(n);
 }
 
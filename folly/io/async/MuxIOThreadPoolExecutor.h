@@ -33,8 +33,6 @@
 namespace folly {
 
 /**
- * NOTE: This is highly experimental. Do not use.
- *
  * A pool of EventBases scheduled over a pool of threads.
  *
  * Intended as a drop-in replacement for folly::IOThreadPoolExecutor, but with a
@@ -56,6 +54,26 @@ namespace folly {
  * supported either: attempting to set the number of threads to 0 or to a value
  * greater than numEventBases() (either in construction or using
  * setNumThreads()) will throw std::invalid_argument).
+ *
+ * Load balancing: the time each EventBase spends in its loop is tracked (see
+ * getEventBaseStats()), and getEventBase() and add() called from outside the
+ * pool place new work, such as new connections, on the less busy of two
+ * EventBases picked at random, based on their recent busy time. A hot
+ * EventBase keeps a thread busy only while its loop runs: the other
+ * EventBases are driven by the other threads in the meantime, instead of
+ * queueing behind it as the EventBases pinned to a thread of an
+ * IOThreadPoolExecutor would.
+ *
+ * Thread affinity: an EventBase is driven by a single thread at a time, so
+ * its callbacks are serialized as usual and isInEventBaseThread() holds
+ * within them, but successive loops of the same EventBase may run on
+ * different threads. State that belongs to the EventBase must therefore be
+ * kept in an EventBaseLocal, which moves with the EventBase, and not in
+ * thread-locals. EventBaseManager::getEventBase() returns the EventBase being
+ * driven by the calling thread. Timers (runAfterDelay(), HHWheelTimer,
+ * AsyncTimeout) work as with any EventBase: they are backed by the backend's
+ * pollable fd, so an expiring timer makes the EventBase ready and schedules
+ * it on a thread.
  */
 class MuxIOThreadPoolExecutor : public IOThreadPoolExecutorBase {
  public:
@@ -82,12 +100,37 @@ class MuxIOThreadPoolExecutor : public IOThreadPoolExecutorBase {
       return *this;
     }
 
+    Options& setLoadAwarePlacement(bool b) {
+      loadAwarePlacement = b;
+      return *this;
+    }
+
+    Options& setLoadHalfLife(std::chrono::nanoseconds h) {
+      loadHalfLife = h;
+      return *this;
+    }
+
     bool enableThreadIdCollection{false};
     // If 0, the number of EventBases is set to the number of threads.
     size_t numEventBases{0};
     std::chrono::nanoseconds wakeUpInterval{std::chrono::microseconds{100}};
     // Max spin for an idle thread waiting for work before going to sleep.
     std::chrono::nanoseconds idleSpinMax = std::chrono::microseconds{10};
+    // If false, work added from outside the pool is placed round-robin.
+    bool loadAwarePlacement{true};
+    // How fast the busy time of an EventBase is forgotten when placing work.
+    std::chrono::nanoseconds loadHalfLife{std::chrono::milliseconds{100}};
+  };
+
+  struct EventBaseStats {
+    // Total time spent driving the EventBase, and number of times it was
+    // driven.
+    std::chrono::nanoseconds busyTime{0};
+    size_t numLoops{0};
+    // Busy time decayed with Options::loadHalfLife, as used for placement.
+    std::chrono::nanoseconds recentBusyTime{0};
+    // Tasks added with add() and not yet run.
+    size_t pendingTasks{0};
   };
 
   explicit MuxIOThreadPoolExecutor(
@@ -115,6 +158,10 @@ class MuxIOThreadPoolExecutor : public IOThreadPoolExecutorBase {
 
   folly::EventBaseManager* getEventBaseManager() override;
 
+  // Returns the stats of each EventBase, in the order of getAllEventBases().
+  // Must not be called concurrently with join().
+  std::vector<EventBaseStats> getEventBaseStats() const;
+
   // Returns nullptr unless explicitly enabled through constructor
   folly::WorkerProvider* getThreadIdCollector() override {
     return threadIdCollector_.get();
@@ -140,12 +187,14 @@ class MuxIOThreadPoolExecutor : public IOThreadPoolExecutorBase {
   void validateNumThreads(size_t numThreads) override;
   ThreadPtr makeThread() override;
   EvbState& pickEvbState();
+  bool tryDecrToStop();
   void threadRun(ThreadPtr thread) override;
   void stopThreads(size_t n) override;
   size_t getPendingTaskCountImpl() const override final;
 
   const Options options_;
   const size_t numEventBases_;
+  const double loadHalfLifeNanos_;
   folly::EventBaseManager* eventBaseManager_;
 
   std::unique_ptr<EventBasePoller::FdGroup> fdGroup_;
@@ -155,7 +204,9 @@ class MuxIOThreadPoolExecutor : public IOThreadPoolExecutorBase {
   relaxed_atomic<size_t> nextEvb_{0};
   folly::ThreadLocal<std::shared_ptr<IOThread>> thisThread_;
   std::unique_ptr<ThreadIdWorkerProvider> threadIdCollector_;
-  std::atomic<size_t> pendingTasks_{0};
+  // Threads to stop, each accounting for a post to readyQueueSem_. Not a
+  // poison in readyQueue_, which only the poller thread may enqueue to.
+  std::atomic<size_t> threadsToStop_{0};
 
   USPMCQueue<EventBasePoller::Handle*, /* MayBlock */ false> readyQueue_;
   folly::ThrottledLifoSem readyQueueSem_;
@@ -652,6 +652,54 @@ TEST_P(AsyncIoUringSocketTest, FastOpen) {
   }
 }
 
+TEST_P(AsyncIoUringSocketTest, ZeroCopyThreshold) {
+  MAYBE_SKIP();
+  if (!IoUringBackend::kernelSupportsSendZC()) {
+    LOG(INFO) << "Kernel does not support SEND_ZC";
+    return;
+  }
+  auto [e, s, cb] = makeConnected();
+  auto* socket = dynamic_cast<AsyncIoUringSocket*>(s.get());
+  ASSERT_NE(nullptr, socket);
+  s->setZeroCopy(true);
+  socket->setZeroCopyThreshold(1024);
+  cb->setHoldData(true);
+
+  std::string small(100, 'a');
+  std::string big(4096, 'b');
+  s->writeChain(&nullWriteCallback, IOBuf::copyBuffer(small));
+  s->writeChain(&nullWriteCallback, IOBuf::copyBuffer(big));
+  // Not owned by an IOBuf, so copied although it is over the threshold.
+  s->write(&nullWriteCallback, big.data(), big.size());
+  auto expected = small + big + big;
+  EXPECT_EQ(
+      expected,
+      cb->waitFor(expected.size()).via(base.get()).getVia(base.get()));
+
+  auto stats = socket->getZeroCopyStats();
+  EXPECT_EQ(1, stats.zeroCopyWrites);
+  EXPECT_EQ(big.size(), stats.zeroCopyBytes);
+  EXPECT_EQ(2, stats.copiedWrites);
+}
+
+TEST_P(AsyncIoUringSocketTest, ProvidedBuffersExhausted) {
+  MAYBE_SKIP();
+  // The backend has a single provided buffer of 2MB, which the callback
+  // holds on to, so that reading 4MB finds the ring empty.
+  auto [e, s, cb] = makeConnected();
+  auto* socket = dynamic_cast<AsyncIoUringSocket*>(s.get());
+  ASSERT_NE(nullptr, socket);
+  cb->setHoldData(true);
+
+  std::string big(4000000, 'X');
+  s->write(&nullWriteCallback, big.c_str(), big.size());
+  EXPECT_EQ(big, cb->waitFor(big.size()).via(base.get()).getVia(base.get()));
+
+  auto stats = socket->getReadStats();
+  EXPECT_GT(stats.pollsWithoutBuffer, 0);
+  EXPECT_GT(stats.fallbackReads, 0);
+}
+
 class AsyncIoUringSocketTestAll : public AsyncIoUringSocketTest {};
 
 TEST_P(AsyncIoUringSocketTestAll, WriteChain2) {
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/AsyncIoUringSocket.h>
+#include <folly/io/async/AsyncServerSocket.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/IoUringBackend.h>
+#include <folly/portability/GFlags.h>
+
+// Loopback throughput of AsyncIoUringSocket writing large IOBuf chains, with
+// plain sendmsg and with SENDMSG_ZC. Each write is a clone of the same chain
+// of kChunkSize buffers, with kWritesInFlight writes queued at a time. The
+// receiving end is a plain AsyncSocket on the same EventBase.
+//
+// Note that the loopback device copies zerocopy sends when they are
+// received, so this measures the cost of the zerocopy path on the sending
+// side rather than its savings on a real NIC.
+
+#if FOLLY_HAS_LIBURING
+
+using namespace folly;
+
+namespace {
+
+constexpr size_t kChunkSize = 64 * 1024;
+constexpr size_t kWritesInFlight = 4;
+
+EventBase::Options ioUringOptions() {
+  return EventBase::Options().setBackendFactory(
+      []() -> std::unique_ptr<EventBaseBackendBase> {
+        return std::make_unique<folly::IoUringBackend>(
+            folly::IoUringBackend::Options().setInitialProvidedBuffers(
+                kChunkSize, 64));
+      });
+}
+
+class Sink : public AsyncReader::ReadCallback,
+             public AsyncServerSocket::AcceptCallback {
+ public:
+  Sink(EventBase* evb, size_t expected)
+      : evb_(evb), expected_(expected), buf_(kChunkSize) {}
+
+  ~Sink() override {
+    if (socket_) {
+      socket_->setReadCB(nullptr);
+    }
+  }
+
+  bool accepted() const { return !!socket_; }
+
+  void connectionAccepted(
+      NetworkSocket fd, const SocketAddress&, AcceptInfo) noexcept override {
+    socket_ = AsyncSocket::newSocket(evb_, fd);
+    socket_->setReadCB(this);
+  }
+
+  void getReadBuffer(void** bufReturn, size_t* lenReturn) override {
+    *bufReturn = buf_.data();
+    *lenReturn = buf_.size();
+  }
+
+  void readDataAvailable(size_t len) noexcept override {
+    received_ += len;
+    if (received_ >= expected_) {
+      evb_->terminateLoopSoon();
+    }
+  }
+
+  void readEOF() noexcept override {}
+
+  void readErr(const AsyncSocketException& ex) noexcept override {
+    LOG(FATAL) << ex.what();
+  }
+
+ private:
+  EventBase* evb_;
+  const size_t expected_;
+  size_t received_{0};
+  std::vector<char> buf_;
+  AsyncSocket::UniquePtr socket_;
+};
+
+class Source : public AsyncSocket::ConnectCallback,
+               public AsyncWriter::WriteCallback {
+ public:
+  Source(
+      AsyncIoUringSocket* socket, std::unique_ptr<IOBuf> chain, size_t writes)
+      : socket_(socket), chain_(std::move(chain)), remaining_(writes) {}
+
+  bool connected() const { return connected_; }
+  bool writing() const { return inFlight_ > 0; }
+
+  void start() {
+    for (size_t i = 0; i < kWritesInFlight && remaining_ > 0; ++i) {
+      writeOne();
+    }
+  }
+
+  void connectSuccess() noexcept override { connected_ = true; }
+
+  void connectErr(const AsyncSocketException& ex) noexcept override {
+    LOG(FATAL) << ex.what();
+  }
+
+  void writeSuccess() noexcept override {
+    --inFlight_;
+    if (remaining_ > 0) {
+      writeOne();
+    }
+  }
+
+  void writeErr(size_t, const AsyncSocketException& ex) noexcept override {
+    LOG(FATAL) << ex.what();
+  }
+
+ private:
+  void writeOne() {
+    --remaining_;
+    ++inFlight_;
+    socket_->writeChain(this, chain_->clone(), WriteFlags::NONE);
+  }
+
+  AsyncIoUringSocket* socket_;
+  std::unique_ptr<IOBuf> chain_;
+  size_t remaining_;
+  size_t inFlight_{0};
+  bool connected_{false};
+};
+
+std::unique_ptr<IOBuf> makeChain(size_t chunks) {
+  std::unique_ptr<IOBuf> chain;
+  for (size_t i = 0; i < chunks; ++i) {
+    auto buf = IOBuf::create(kChunkSize);
+    std::memset(buf->writableData(), 'x', kChunkSize);
+    buf->append(kChunkSize);
+    if (chain) {
+      chain->appendToChain(std::move(buf));
+    } else {
+      chain = std::move(buf);
+    }
+  }
+  return chain;
+}
+
+void runLoopback(unsigned iters, bool zeroCopy, size_t chunks) {
+  BenchmarkSuspender suspender;
+  EventBase evb(ioUringOptions());
+
+  Sink sink(&evb, iters * chunks * kChunkSize);
+  auto serverSocket = AsyncServerSocket::newSocket(&evb);
+  serverSocket->bind(0);
+  serverSocket->listen(16);
+  serverSocket->addAcceptCallback(&sink, nullptr);
+  serverSocket->startAccepting();
+  SocketAddress address;
+  serverSocket->getAddress(&address);
+
+  AsyncIoUringSocket::Options options;
+  if (zeroCopy) {
+    options.zeroCopyEnable = [](auto&&) { return true; };
+  }
+  AsyncIoUringSocket::UniquePtr client(
+      new AsyncIoUringSocket(&evb, std::move(options)));
+  Source source(client.get(), makeChain(chunks), iters);
+  client->connect(&source, address);
+  while (!source.connected() || !sink.accepted()) {
+    evb.loopOnce();
+  }
+
+  suspender.dismiss();
+  source.start();
+  evb.loopForever();
+  suspender.rehire();
+
+  // The data may be received before the last completions are processed.
+  while (source.writing()) {
+    evb.loopOnce();
+  }
+  client->closeNow();
+  serverSocket->stopAccepting();
+}
+
+} // namespace
+
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(runLoopback, copy_64k, false, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(runLoopback, zerocopy_64k, true, 1)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(runLoopback, copy_1m, false, 16)
+BENCHMARK_RELATIVE_NAMED_PARAM(runLoopback, zerocopy_1m, true, 16)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(runLoopback, copy_8m, false, 128)
+BENCHMARK_RELATIVE_NAMED_PARAM(runLoopback, zerocopy_8m, true, 128)
+BENCHMARK_DRAW_LINE();
+
+#endif
+
+int main(int argc, char** argv) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+#if FOLLY_HAS_LIBURING
+  if (!folly::IoUringBackend::isAvailable()) {
+    LOG(INFO) << "io_uring is not available";
+    return 0;
+  }
+  folly::runBenchmarks();
+#endif
+  return 0;
+}
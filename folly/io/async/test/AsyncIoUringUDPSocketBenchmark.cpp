@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/SocketAddress.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/AsyncIoUringUDPSocket.h>
+#include <folly/io/async/AsyncUDPSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/IoUringBackend.h>
+#include <folly/portability/GFlags.h>
+
+// Loopback packets per second of AsyncUDPSocket, on the default EventBase
+// backend and on an IoUringBackend, and of AsyncIoUringUDPSocket. Each
+// iteration is one datagram: the sender writes a window of kWindow
+// datagrams with writem() in batches of the given size, and writes the next
+// window once the receiver got all of them, so that the receive buffer never
+// overflows.
+
+#if FOLLY_HAS_LIBURING
+
+using namespace folly;
+
+namespace {
+
+constexpr size_t kPacketSize = 64;
+constexpr size_t kWindow = 256;
+
+std::unique_ptr<EventBase> makeEventBase(bool ioUring) {
+  if (!ioUring) {
+    return std::make_unique<EventBase>();
+  }
+  return std::make_unique<EventBase>(EventBase::Options().setBackendFactory(
+      []() -> std::unique_ptr<EventBaseBackendBase> {
+        return std::make_unique<folly::IoUringBackend>(
+            folly::IoUringBackend::Options()
+                .setCapacity(4096)
+                .setMaxSubmit(256)
+                .setInitialProvidedBuffers(512, 2048));
+      }));
+}
+
+class Pump : public AsyncUDPSocket::ReadCallback {
+ public:
+  Pump(
+      EventBase* evb,
+      AsyncUDPSocket& sender,
+      const SocketAddress& dest,
+      size_t total,
+      size_t batch)
+      : evb_(evb), sender_(sender), dest_(dest), total_(total), batch_(batch) {
+    for (size_t i = 0; i < batch_; ++i) {
+      bufs_.push_back(IOBuf::copyBuffer(std::string(kPacketSize, 'x')));
+    }
+  }
+
+  void start() { sendWindow(); }
+
+  void getReadBuffer(void** buf, size_t* len) noexcept override {
+    *buf = buf_.data();
+    *len = buf_.size();
+  }
+
+  void onDataAvailable(
+      const SocketAddress&,
+      size_t,
+      bool,
+      OnDataAvailableParams) noexcept override {
+    if (++received_ == total_) {
+      evb_->terminateLoopSoon();
+    } else if (received_ == sent_) {
+      sendWindow();
+    }
+  }
+
+  void onReadError(const AsyncSocketException& ex) noexcept override {
+    LOG(FATAL) << ex.what();
+  }
+
+  void onReadClosed() noexcept override {}
+
+ private:
+  void sendWindow() {
+    auto const window = std::min(kWindow, total_ - sent_);
+    for (size_t n = 0; n < window;) {
+      auto const count = std::min(batch_, window - n);
+      auto const ret =
+          sender_.writem(range(&dest_, &dest_ + 1), bufs_.data(), count);
+      CHECK_EQ(ret, count);
+      n += count;
+    }
+    sent_ += window;
+  }
+
+  EventBase* evb_;
+  AsyncUDPSocket& sender_;
+  const SocketAddress dest_;
+  const size_t total_;
+  const size_t batch_;
+  size_t sent_{0};
+  size_t received_{0};
+  std::vector<std::unique_ptr<IOBuf>> bufs_;
+  std::array<char, 2048> buf_;
+};
+
+template <class Socket>
+void runPps(unsigned iters, bool ioUring, size_t batch) {
+  BenchmarkSuspender suspender;
+  auto evb = makeEventBase(ioUring);
+  Socket receiver(evb.get());
+  receiver.setRcvBuf(8 * 1024 * 1024);
+  receiver.bind(SocketAddress("::1", 0));
+  Socket sender(evb.get());
+  sender.bind(SocketAddress("::1", 0));
+
+  Pump pump(evb.get(), sender, receiver.address(), iters, batch);
+  receiver.resumeRead(&pump);
+
+  suspender.dismiss();
+  pump.start();
+  evb->loopForever();
+  suspender.rehire();
+
+  receiver.pauseRead();
+}
+
+void epoll(unsigned iters, size_t batch) {
+  runPps<AsyncUDPSocket>(iters, false, batch);
+}
+
+void ioUringBackend(unsigned iters, size_t batch) {
+  runPps<AsyncUDPSocket>(iters, true, batch);
+}
+
+void ioUringSocket(unsigned iters, size_t batch) {
+  runPps<AsyncIoUringUDPSocket>(iters, true, batch);
+}
+
+} // namespace
+
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(epoll, batch_1, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(ioUringBackend, batch_1, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(ioUringSocket, batch_1, 1)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(epoll, batch_16, 16)
+BENCHMARK_RELATIVE_NAMED_PARAM(ioUringBackend, batch_16, 16)
+BENCHMARK_RELATIVE_NAMED_PARAM(ioUringSocket, batch_16, 16)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(epoll, batch_64, 64)
+BENCHMARK_RELATIVE_NAMED_PARAM(ioUringBackend, batch_64, 64)
+BENCHMARK_RELATIVE_NAMED_PARAM(ioUringSocket, batch_64, 64)
+BENCHMARK_DRAW_LINE();
+
+#endif
+
+int main(int argc, char** argv) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+#if FOLLY_HAS_LIBURING
+  if (!folly::IoUringBackend::isAvailable()) {
+    LOG(INFO) << "io_uring is not available";
+    return 0;
+  }
+  folly::runBenchmarks();
+#endif
+  return 0;
+}
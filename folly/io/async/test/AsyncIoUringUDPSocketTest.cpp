@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <folly/SocketAddress.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/AsyncIoUringUDPSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/IoUringBackend.h>
+#include <folly/portability/GTest.h>
+#include <folly/test/TestUtils.h>
+
+#if FOLLY_HAS_LIBURING
+
+namespace folly {
+
+namespace {
+
+constexpr size_t kPacketSize = 100;
+
+std::unique_ptr<EventBase> makeIoUringEventBase() {
+  try {
+    auto factory = [] {
+      return std::make_unique<IoUringBackend>(
+          IoUringBackend::Options().setInitialProvidedBuffers(2048, 256));
+    };
+    return std::make_unique<EventBase>(
+        EventBase::Options().setBackendFactory(std::move(factory)));
+  } catch (const IoUringBackend::NotAvailable&) {
+    return nullptr;
+  }
+}
+
+class Collector : public AsyncUDPSocket::ReadCallback {
+ public:
+  Collector(EventBase* evb, size_t expected)
+      : evb_(evb), expected_(expected) {}
+
+  void getReadBuffer(void** buf, size_t* len) noexcept override {
+    *buf = buf_.data();
+    *len = buf_.size();
+  }
+
+  void onDataAvailable(
+      const SocketAddress& client,
+      size_t len,
+      bool truncated,
+      OnDataAvailableParams) noexcept override {
+    EXPECT_FALSE(truncated);
+    from = client;
+    packets.emplace_back(buf_.data(), len);
+    if (packets.size() == expected_) {
+      evb_->terminateLoopSoon();
+    }
+  }
+
+  void onReadError(const AsyncSocketException& ex) noexcept override {
+    FAIL() << ex.what();
+  }
+
+  void onReadClosed() noexcept override {}
+
+  std::vector<std::string> packets;
+  SocketAddress from;
+
+ private:
+  EventBase* evb_;
+  const size_t expected_;
+  std::array<char, 2048> buf_;
+};
+
+void loopWithTimeout(EventBase& evb) {
+  evb.runAfterDelay([&] { evb.terminateLoopSoon(); }, 10000);
+  evb.loopForever();
+}
+
+} // namespace
+
+TEST(AsyncIoUringUDPSocketTest, WriteAndRead) {
+  auto evb = makeIoUringEventBase();
+  SKIP_IF(!evb) << "Backend not available";
+  EXPECT_TRUE(AsyncIoUringUDPSocket::supports(evb.get()));
+
+  constexpr size_t kPackets = 32;
+  AsyncIoUringUDPSocket server(evb.get());
+  server.bind(SocketAddress("::1", 0));
+  Collector collector(evb.get(), kPackets);
+  server.resumeRead(&collector);
+
+  AsyncIoUringUDPSocket client(evb.get());
+  client.bind(SocketAddress("::1", 0));
+
+  std::vector<std::unique_ptr<IOBuf>> bufs;
+  for (size_t i = 0; i < kPackets; ++i) {
+    bufs.push_back(IOBuf::copyBuffer(std::string(kPacketSize, 'a' + i % 26)));
+  }
+  // Half of the packets one by one, and half of them in one batch.
+  for (size_t i = 0; i < kPackets / 2; ++i) {
+    EXPECT_EQ(kPacketSize, client.write(server.address(), bufs[i]));
+  }
+  auto const address = server.address();
+  EXPECT_EQ(
+      kPackets / 2,
+      client.writem(
+          range(&address, &address + 1), &bufs[kPackets / 2], kPackets / 2));
+  EXPECT_EQ(kPackets, client.getSendsInFlight());
+
+  loopWithTimeout(*evb);
+  ASSERT_EQ(kPackets, collector.packets.size());
+  // Loopback delivers the datagrams in order.
+  for (size_t i = 0; i < kPackets; ++i) {
+    EXPECT_EQ(std::string(kPacketSize, 'a' + i % 26), collector.packets[i]);
+  }
+  EXPECT_EQ(client.address(), collector.from);
+
+  auto const clientStats = client.getStats();
+  EXPECT_EQ(kPackets, clientStats.queuedSends);
+  EXPECT_EQ(0, clientStats.syncSends);
+  EXPECT_EQ(0, clientStats.failedSends);
+  if (IoUringBackend::kernelSupportsRecvmsgMultishot()) {
+    EXPECT_EQ(kPackets, server.getStats().multishotReads);
+  }
+}
+
+TEST(AsyncIoUringUDPSocketTest, EmptyDatagram) {
+  auto evb = makeIoUringEventBase();
+  SKIP_IF(!evb) << "Backend not available";
+  SKIP_IF(!IoUringBackend::kernelSupportsRecvmsgMultishot())
+      << "Multishot recvmsg not supported";
+
+  AsyncIoUringUDPSocket server(evb.get());
+  server.bind(SocketAddress("::1", 0));
+  Collector collector(evb.get(), 2);
+  server.resumeRead(&collector);
+
+  AsyncIoUringUDPSocket client(evb.get());
+  client.bind(SocketAddress("::1", 0));
+  auto const empty = IOBuf::create(0);
+  EXPECT_EQ(0, client.write(server.address(), empty));
+  auto const buf = IOBuf::copyBuffer(std::string(kPacketSize, 'x'));
+  EXPECT_EQ(kPacketSize, client.write(server.address(), buf));
+
+  loopWithTimeout(*evb);
+  ASSERT_EQ(2, collector.packets.size());
+  EXPECT_EQ("", collector.packets[0]);
+  EXPECT_EQ(std::string(kPacketSize, 'x'), collector.packets[1]);
+  EXPECT_EQ(2, server.getStats().multishotReads);
+}
+
+TEST(AsyncIoUringUDPSocketTest, MaxSendsInFlight) {
+  auto evb = makeIoUringEventBase();
+  SKIP_IF(!evb) << "Backend not available";
+
+  constexpr size_t kPackets = 8;
+  AsyncIoUringUDPSocket server(evb.get());
+  server.bind(SocketAddress("::1", 0));
+  Collector collector(evb.get(), kPackets);
+  server.resumeRead(&collector);
+
+  AsyncIoUringUDPSocket client(
+      evb.get(), AsyncIoUringUDPSocket::Options().setMaxSendsInFlight(2));
+  client.bind(SocketAddress("::1", 0));
+  auto buf = IOBuf::copyBuffer(std::string(kPacketSize, 'x'));
+  for (size_t i = 0; i < kPackets; ++i) {
+    EXPECT_EQ(kPacketSize, client.write(server.address(), buf));
+  }
+
+  loopWithTimeout(*evb);
+  EXPECT_EQ(kPackets, collector.packets.size());
+  auto const stats = client.getStats();
+  EXPECT_EQ(2, stats.queuedSends);
+  EXPECT_EQ(kPackets - 2, stats.syncSends);
+  EXPECT_EQ(0, client.getSendsInFlight());
+}
+
+TEST(AsyncIoUringUDPSocketTest, GSO) {
+  auto evb = makeIoUringEventBase();
+  SKIP_IF(!evb) << "Backend not available";
+
+  constexpr size_t kSegments = 4;
+  AsyncIoUringUDPSocket server(evb.get());
+  server.bind(SocketAddress("::1", 0));
+  Collector collector(evb.get(), kSegments);
+  server.resumeRead(&collector);
+
+  AsyncIoUringUDPSocket client(evb.get());
+  client.bind(SocketAddress("::1", 0));
+  SKIP_IF(client.getGSO() < 0) << "GSO not supported";
+
+  // The segments are sent as one datagram, split up by the kernel.
+  std::string data;
+  for (size_t i = 0; i < kSegments; ++i) {
+    data.append(kPacketSize, 'a' + i);
+  }
+  EXPECT_EQ(
+      data.size(),
+      client.writeGSO(
+          server.address(),
+          IOBuf::copyBuffer(data),
+          AsyncUDPSocket::WriteOptions(kPacketSize, false)));
+
+  loopWithTimeout(*evb);
+  ASSERT_EQ(kSegments, collector.packets.size());
+  for (size_t i = 0; i < kSegments; ++i) {
+    EXPECT_EQ(std::string(kPacketSize, 'a' + i), collector.packets[i]);
+  }
+  EXPECT_EQ(1, client.getStats().queuedSends);
+}
+
+TEST(AsyncIoUringUDPSocketTest, OtherBackend) {
+  EventBase evb;
+  EXPECT_FALSE(AsyncIoUringUDPSocket::supports(&evb));
+
+  AsyncIoUringUDPSocket server(&evb);
+  server.bind(SocketAddress("::1", 0));
+  Collector collector(&evb, 1);
+  server.resumeRead(&collector);
+
+  AsyncIoUringUDPSocket client(&evb);
+  client.bind(SocketAddress("::1", 0));
+  auto buf = IOBuf::copyBuffer(std::string(kPacketSize, 'x'));
+  EXPECT_EQ(kPacketSize, client.write(server.address(), buf));
+
+  loopWithTimeout(evb);
+  EXPECT_EQ(1, collector.packets.size());
+  EXPECT_EQ(1, client.getStats().syncSends);
+  EXPECT_EQ(0, client.getStats().queuedSends);
+}
+
+} // namespace folly
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <folly/io/async/LazyHHWheelTimer.h>
+#include <folly/io/async/test/UndelayedDestruction.h>
+#include <folly/portability/GFlags.h>
+
+// The cost per timeout of HHWheelTimer and LazyHHWheelTimer with up to 1M
+// idle timeouts of about a minute, as connections have: scheduling and
+// cancelling them, and pushing them back as on every read.
+
+using namespace folly;
+using std::chrono::milliseconds;
+
+namespace {
+
+template <class Wheel>
+class TestTimeout : public Wheel::Callback {
+ public:
+  void timeoutExpired() noexcept override {}
+
+  void callbackCanceled() noexcept override {}
+};
+
+// Spread the timeouts over a few seconds, as connections go idle at
+// different times.
+milliseconds idleTimeout(unsigned int j) {
+  return milliseconds(60000 + j % 5000);
+}
+
+template <class Wheel>
+size_t scheduleCancel(unsigned int iters, unsigned int timers) {
+  BenchmarkSuspender susp;
+
+  EventBase evb;
+  UndelayedDestruction<Wheel> t(&evb);
+  std::vector<TestTimeout<Wheel>> timeouts(timers);
+
+  susp.dismiss();
+  for (unsigned int i = 0; i < iters; ++i) {
+    for (unsigned int j = 0; j < timers; ++j) {
+      t.scheduleTimeout(&timeouts[j], idleTimeout(j));
+    }
+
+    for (unsigned int j = 0; j < timers; ++j) {
+      timeouts[j].cancelTimeout();
+    }
+  }
+  susp.rehire();
+
+  return size_t(iters) * timers * 2;
+}
+
+template <class Wheel>
+size_t reschedule(unsigned int iters, unsigned int timers) {
+  BenchmarkSuspender susp;
+
+  EventBase evb;
+  UndelayedDestruction<Wheel> t(&evb);
+  std::vector<TestTimeout<Wheel>> timeouts(timers);
+  for (unsigned int j = 0; j < timers; ++j) {
+    t.scheduleTimeout(&timeouts[j], idleTimeout(j));
+  }
+
+  susp.dismiss();
+  for (unsigned int i = 0; i < iters; ++i) {
+    for (unsigned int j = 0; j < timers; ++j) {
+      t.scheduleTimeout(&timeouts[j], idleTimeout(j + i + 1));
+    }
+  }
+  susp.rehire();
+
+  t.cancelAll();
+  return size_t(iters) * timers;
+}
+
+size_t scheduleCancelHH(unsigned int iters, unsigned int timers) {
+  return scheduleCancel<HHWheelTimer>(iters, timers);
+}
+
+size_t scheduleCancelLazy(unsigned int iters, unsigned int timers) {
+  return scheduleCancel<LazyHHWheelTimer>(iters, timers);
+}
+
+size_t rescheduleHH(unsigned int iters, unsigned int timers) {
+  return reschedule<HHWheelTimer>(iters, timers);
+}
+
+size_t rescheduleLazy(unsigned int iters, unsigned int timers) {
+  return reschedule<LazyHHWheelTimer>(iters, timers);
+}
+
+} // namespace
+
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM_MULTI(scheduleCancelHH, 1k, 1000)
+BENCHMARK_RELATIVE_NAMED_PARAM_MULTI(scheduleCancelLazy, 1k, 1000)
+BENCHMARK_NAMED_PARAM_MULTI(scheduleCancelHH, 1m, 1000000)
+BENCHMARK_RELATIVE_NAMED_PARAM_MULTI(scheduleCancelLazy, 1m, 1000000)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM_MULTI(rescheduleHH, 1k, 1000)
+BENCHMARK_RELATIVE_NAMED_PARAM_MULTI(rescheduleLazy, 1k, 1000)
+BENCHMARK_NAMED_PARAM_MULTI(rescheduleHH, 1m, 1000000)
+BENCHMARK_RELATIVE_NAMED_PARAM_MULTI(rescheduleLazy, 1m, 1000000)
+BENCHMARK_DRAW_LINE();
+
+int main(int argc, char* argv[]) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+
+  return 0;
+}
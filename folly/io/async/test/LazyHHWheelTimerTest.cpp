@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/LazyHHWheelTimer.h>
+
+#include <thread>
+#include <vector>
+
+#include <folly/Random.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/test/UndelayedDestruction.h>
+#include <folly/io/async/test/Util.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using std::chrono::milliseconds;
+
+typedef UndelayedDestruction<LazyHHWheelTimer> StackWheelTimer;
+
+class TestTimeout : public LazyHHWheelTimer::Callback {
+ public:
+  TestTimeout() {}
+
+  void timeoutExpired() noexcept override {
+    timestamps.emplace_back();
+    if (fn) {
+      fn();
+    }
+  }
+
+  void callbackCanceled() noexcept override {
+    canceledTimestamps.emplace_back();
+    if (fn) {
+      fn();
+    }
+  }
+
+  std::deque<TimePoint> timestamps;
+  std::deque<TimePoint> canceledTimestamps;
+  std::function<void()> fn;
+};
+
+struct LazyHHWheelTimerTest : public ::testing::Test {
+  EventBase eventBase;
+};
+
+TEST_F(LazyHHWheelTimerTest, FireOnce) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+
+  TestTimeout t1;
+  TestTimeout t2;
+  TestTimeout t3;
+
+  ASSERT_EQ(t.count(), 0);
+
+  t.scheduleTimeout(&t1, milliseconds(5));
+  t.scheduleTimeout(&t2, milliseconds(5));
+  // Verify scheduling it twice only gets one callback.
+  t.scheduleTimeout(&t2, milliseconds(5));
+  t.scheduleTimeout(&t3, milliseconds(10));
+
+  ASSERT_EQ(t.count(), 3);
+
+  TimePoint start;
+  eventBase.loop();
+  TimePoint end;
+
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  ASSERT_EQ(t3.timestamps.size(), 1);
+
+  ASSERT_EQ(t.count(), 0);
+
+  T_CHECK_TIMEOUT(start, t1.timestamps[0], milliseconds(5));
+  T_CHECK_TIMEOUT(start, t2.timestamps[0], milliseconds(5));
+  T_CHECK_TIMEOUT(start, t3.timestamps[0], milliseconds(10));
+  T_CHECK_TIMEOUT(start, end, milliseconds(10));
+}
+
+TEST_F(LazyHHWheelTimerTest, CancelTimeout) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+
+  TestTimeout t1;
+  TestTimeout t2;
+  TestTimeout t3;
+
+  t.scheduleTimeout(&t1, milliseconds(5));
+  t.scheduleTimeout(&t2, milliseconds(300));
+  t.scheduleTimeout(&t3, milliseconds(10));
+  t1.fn = [&] { t2.cancelTimeout(); };
+
+  TimePoint start;
+  eventBase.loop();
+
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t2.timestamps.size(), 0);
+  ASSERT_EQ(t3.timestamps.size(), 1);
+  // Cancelling does not call callbackCanceled().
+  ASSERT_EQ(t2.canceledTimestamps.size(), 0);
+  ASSERT_EQ(t.count(), 0);
+  EXPECT_FALSE(t2.isScheduled());
+
+  T_CHECK_TIMEOUT(start, t3.timestamps[0], milliseconds(10));
+}
+
+/*
+ * Test pushing a timeout back repeatedly, as an idle timeout is on every
+ * read: it only fires once, at its last deadline.
+ */
+TEST_F(LazyHHWheelTimerTest, PushBack) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+
+  TestTimeout idle;
+  TestTimeout tick;
+  size_t ticks = 0;
+  TimePoint lastPush;
+  tick.fn = [&] {
+    t.scheduleTimeout(&idle, milliseconds(20));
+    lastPush.reset();
+    if (++ticks < 10) {
+      t.scheduleTimeout(&tick, milliseconds(5));
+    }
+  };
+  t.scheduleTimeout(&idle, milliseconds(20));
+  t.scheduleTimeout(&tick, milliseconds(5));
+  ASSERT_EQ(t.count(), 2);
+
+  eventBase.loop();
+
+  ASSERT_EQ(ticks, 10);
+  ASSERT_EQ(idle.timestamps.size(), 1);
+  ASSERT_EQ(t.count(), 0);
+  T_CHECK_TIMEOUT(lastPush, idle.timestamps[0], milliseconds(20));
+}
+
+TEST_F(LazyHHWheelTimerTest, PullIn) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+
+  TestTimeout t1;
+  t.scheduleTimeout(&t1, milliseconds(500));
+  t.scheduleTimeout(&t1, milliseconds(5));
+  ASSERT_EQ(t.count(), 1);
+
+  TimePoint start;
+  eventBase.loop();
+
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  T_CHECK_TIMEOUT(start, t1.timestamps[0], milliseconds(5));
+}
+
+TEST_F(LazyHHWheelTimerTest, ReschedTest) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+
+  TestTimeout t1;
+  TestTimeout t2;
+
+  t.scheduleTimeout(&t1, milliseconds(128));
+  TimePoint start2;
+  t1.fn = [&]() {
+    t.scheduleTimeout(&t2, milliseconds(255)); // WHEEL_SIZE - 1
+    start2.reset();
+    ASSERT_EQ(t.count(), 1);
+  };
+
+  TimePoint start;
+  eventBase.loop();
+
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  ASSERT_EQ(t.count(), 0);
+
+  T_CHECK_TIMEOUT(start, t1.timestamps[0], milliseconds(128));
+  T_CHECK_TIMEOUT(start2, t2.timestamps[0], milliseconds(255));
+}
+
+TEST_F(LazyHHWheelTimerTest, Level1) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+  TestTimeout tt;
+  // Schedule the timeout for the tick in a next epoch.
+  t.scheduleTimeout(&tt, std::chrono::milliseconds(500));
+  TimePoint start;
+  eventBase.loop();
+  TimePoint end;
+  ASSERT_EQ(tt.timestamps.size(), 1);
+  T_CHECK_TIMEOUT(start, end, milliseconds(500));
+}
+
+/*
+ * Test that timeouts spread over the levels never fire early, and fire in
+ * the order of their deadlines.
+ */
+TEST_F(LazyHHWheelTimerTest, ManyTimeouts) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+
+  constexpr size_t kTimeouts = 1000;
+  std::vector<TestTimeout> timeouts(kTimeouts);
+  std::vector<milliseconds> delays(kTimeouts);
+  std::vector<size_t> order;
+  TimePoint start;
+  for (size_t i = 0; i < kTimeouts; ++i) {
+    delays[i] = milliseconds(folly::Random::rand32(1, 700));
+    timeouts[i].fn = [&order, i] { order.push_back(i); };
+    t.scheduleTimeout(&timeouts[i], delays[i]);
+  }
+  ASSERT_EQ(t.count(), kTimeouts);
+
+  eventBase.loop();
+
+  ASSERT_EQ(order.size(), kTimeouts);
+  ASSERT_EQ(t.count(), 0);
+  for (size_t i = 0; i < kTimeouts; ++i) {
+    EXPECT_GE(timeouts[i].timestamps[0].getTime() - start.getTime(), delays[i])
+        << i;
+  }
+  for (size_t i = 1; i < kTimeouts; ++i) {
+    // Timeouts in the same tick can fire in any order.
+    EXPECT_LE(delays[order[i - 1]], delays[order[i]] + milliseconds(1));
+  }
+}
+
+TEST_F(LazyHHWheelTimerTest, DeleteWheelInTimeout) {
+  auto t = LazyHHWheelTimer::newTimer(&eventBase, milliseconds(1));
+
+  TestTimeout t1;
+  TestTimeout t2;
+  TestTimeout t3;
+
+  t->scheduleTimeout(&t1, milliseconds(128));
+  t->scheduleTimeout(&t2, milliseconds(128));
+  t->scheduleTimeout(&t3, milliseconds(128));
+  t1.fn = [&]() { t2.cancelTimeout(); };
+  t3.fn = [&]() { t.reset(); };
+
+  ASSERT_EQ(t->count(), 3);
+
+  TimePoint start;
+  eventBase.loop();
+
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t2.timestamps.size(), 0);
+  ASSERT_EQ(t3.timestamps.size(), 1);
+
+  T_CHECK_TIMEOUT(start, t1.timestamps[0], milliseconds(128));
+}
+
+TEST_F(LazyHHWheelTimerTest, DefaultTimeout) {
+  milliseconds defaultTimeout(milliseconds(5));
+  StackWheelTimer t(
+      &eventBase,
+      milliseconds(1),
+      AsyncTimeout::InternalEnum::NORMAL,
+      defaultTimeout);
+
+  TestTimeout t1;
+  ASSERT_EQ(t.getDefaultTimeout(), defaultTimeout);
+  t.scheduleTimeout(&t1);
+
+  TimePoint start;
+  eventBase.loop();
+
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  T_CHECK_TIMEOUT(start, t1.timestamps[0], defaultTimeout);
+}
+
+TEST_F(LazyHHWheelTimerTest, lambda) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+  size_t count = 0;
+  t.scheduleTimeoutFn([&] { count++; }, milliseconds(1));
+  eventBase.loop();
+  EXPECT_EQ(1, count);
+}
+
+TEST_F(LazyHHWheelTimerTest, cancelAll) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+  TestTimeout t1;
+  TestTimeout t2;
+  TestTimeout t3;
+  t.scheduleTimeout(&t1, std::chrono::milliseconds(1));
+  t.scheduleTimeout(&t2, std::chrono::milliseconds(1));
+  t.scheduleTimeout(&t3, std::chrono::milliseconds(1000));
+  size_t canceled = 0;
+  t1.fn = [&] { canceled += t.cancelAll(); };
+  t2.fn = [&] { canceled += t.cancelAll(); };
+  // Sleep 20ms to ensure both timeouts will fire in a single event (in case
+  // they ended up in different slots)
+  ::usleep(20000);
+  eventBase.loop();
+  EXPECT_EQ(1, t1.canceledTimestamps.size() + t2.canceledTimestamps.size());
+  EXPECT_EQ(1, t3.canceledTimestamps.size());
+  EXPECT_EQ(2, canceled);
+  EXPECT_EQ(0, t.count());
+}
+
+TEST_F(LazyHHWheelTimerTest, RequestContext) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+
+  TestTimeout t1;
+  TestTimeout t2;
+  TestTimeout t3;
+  std::shared_ptr<RequestContext> ctx1;
+  std::shared_ptr<RequestContext> ctx2;
+  {
+    RequestContextScopeGuard g;
+    ctx1 = RequestContext::saveContext();
+    t.scheduleTimeout(&t1, milliseconds(5));
+    t.scheduleTimeout(&t2, milliseconds(5));
+  }
+  {
+    RequestContextScopeGuard g;
+    ctx2 = RequestContext::saveContext();
+    t.scheduleTimeout(&t3, milliseconds(5));
+  }
+  t1.fn = [&] { EXPECT_EQ(ctx1.get(), RequestContext::try_get()); };
+  t2.fn = [&] { EXPECT_EQ(ctx1.get(), RequestContext::try_get()); };
+  t3.fn = [&] { EXPECT_EQ(ctx2.get(), RequestContext::try_get()); };
+
+  auto const before = RequestContext::saveContext();
+  eventBase.loop();
+  EXPECT_EQ(before, RequestContext::saveContext());
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  ASSERT_EQ(t3.timestamps.size(), 1);
+}
+
+TEST_F(LazyHHWheelTimerTest, GetTimeRemaining) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+  TestTimeout t1;
+
+  ASSERT_EQ(t1.getTimeRemaining(), milliseconds(0));
+  t.scheduleTimeout(&t1, milliseconds(300));
+  EXPECT_GT(t1.getTimeRemaining(), milliseconds(200));
+  // Pushing it back updates the time remaining.
+  t.scheduleTimeout(&t1, milliseconds(600));
+  EXPECT_GT(t1.getTimeRemaining(), milliseconds(500));
+
+  eventBase.loop();
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  EXPECT_EQ(t1.getTimeRemaining(), milliseconds(0));
+}
+
+// Test that we handle negative timeouts properly (i.e. treat them as 0)
+TEST_F(LazyHHWheelTimerTest, NegativeTimeout) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  TestTimeout tt1;
+  TestTimeout tt2;
+  t.scheduleTimeout(&tt1, std::chrono::milliseconds(1));
+  t.scheduleTimeout(&tt2, std::chrono::milliseconds(-500000000));
+  TimePoint start;
+  eventBase.loop();
+  TimePoint end;
+  ASSERT_EQ(tt2.timestamps.size(), 1);
+  T_CHECK_TIMEOUT(start, end, milliseconds(1));
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/io/Epoll.h>
+
+#if FOLLY_HAS_EPOLL
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/experimental/io/MuxIOThreadPoolExecutor.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/Latch.h>
+
+DEFINE_uint32(threads, 4, "Number of threads of the pools");
+DEFINE_uint32(connections, 64, "Number of simulated connections");
+DEFINE_uint32(hot_connections, 1, "Connections that receive heavy requests");
+DEFINE_uint32(heavy_us, 200, "CPU time of a request on a hot connection");
+DEFINE_uint32(light_us, 2, "CPU time of a request on other connections");
+
+using namespace folly;
+
+namespace {
+
+void burn(std::chrono::microseconds d) {
+  auto const deadline = std::chrono::steady_clock::now() + d;
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+}
+
+// Simulates a skewed load: each connection is served by one EventBase, and
+// the hot connections receive requests much more expensive than the
+// others. With an IOThreadPoolExecutor the connections sharing a thread with
+// a hot one wait behind it; with a MuxIOThreadPoolExecutor each connection
+// has its own EventBase, which idle threads pick up.
+void runSkewed(size_t iters, const std::vector<EventBase*>& connections) {
+  const std::chrono::microseconds heavy{FLAGS_heavy_us};
+  const std::chrono::microseconds light{FLAGS_light_us};
+  for (size_t i = 0; i < iters; ++i) {
+    Latch done(connections.size());
+    for (size_t c = 0; c < connections.size(); ++c) {
+      const auto cost = c < FLAGS_hot_connections ? heavy : light;
+      connections[c]->runInEventBaseThread([&done, cost] {
+        burn(cost);
+        done.count_down();
+      });
+    }
+    done.wait();
+  }
+}
+
+// Connections are assigned the way a server assigns accepted sockets, one
+// EventBase each from getEventBase().
+std::vector<EventBase*> acceptConnections(IOThreadPoolExecutorBase& ex) {
+  std::vector<EventBase*> connections;
+  for (size_t c = 0; c < FLAGS_connections; ++c) {
+    connections.push_back(ex.getEventBase());
+  }
+  return connections;
+}
+
+std::unique_ptr<MuxIOThreadPoolExecutor> makeMux(bool loadAware) {
+  MuxIOThreadPoolExecutor::Options options;
+  options.setNumEventBases(FLAGS_connections).setLoadAwarePlacement(loadAware);
+  return std::make_unique<MuxIOThreadPoolExecutor>(FLAGS_threads, options);
+}
+
+} // namespace
+
+BENCHMARK(SkewedIOThreadPoolExecutor, iters) {
+  std::unique_ptr<IOThreadPoolExecutor> ex;
+  std::vector<EventBase*> connections;
+  BENCHMARK_SUSPEND {
+    ex = std::make_unique<IOThreadPoolExecutor>(FLAGS_threads);
+    connections = acceptConnections(*ex);
+  }
+  runSkewed(iters, connections);
+  BENCHMARK_SUSPEND {
+    ex.reset();
+  }
+}
+
+BENCHMARK_RELATIVE(SkewedMuxIOThreadPoolExecutor, iters) {
+  std::unique_ptr<MuxIOThreadPoolExecutor> ex;
+  std::vector<EventBase*> connections;
+  BENCHMARK_SUSPEND {
+    ex = makeMux(/* loadAware */ true);
+    connections = acceptConnections(*ex);
+  }
+  runSkewed(iters, connections);
+  BENCHMARK_SUSPEND {
+    ex.reset();
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+// Connections accepted while the hot ones are busy: with load-aware
+// placement new connections avoid the EventBases of the hot ones.
+void runSkewedAccepts(size_t iters, bool loadAware) {
+  std::unique_ptr<MuxIOThreadPoolExecutor> ex;
+  std::vector<EventBase*> hot;
+  BENCHMARK_SUSPEND {
+    ex = makeMux(loadAware);
+    for (size_t c = 0; c < FLAGS_hot_connections; ++c) {
+      hot.push_back(ex->getEventBase());
+    }
+  }
+  const std::chrono::microseconds heavy{FLAGS_heavy_us};
+  const std::chrono::microseconds light{FLAGS_light_us};
+  for (size_t i = 0; i < iters; ++i) {
+    Latch done(FLAGS_connections);
+    for (auto evb : hot) {
+      evb->runInEventBaseThread([&done, heavy] {
+        burn(heavy);
+        done.count_down();
+      });
+    }
+    for (size_t c = hot.size(); c < FLAGS_connections; ++c) {
+      ex->getEventBase()->runInEventBaseThread([&done, light] {
+        burn(light);
+        done.count_down();
+      });
+    }
+    done.wait();
+  }
+  BENCHMARK_SUSPEND {
+    ex.reset();
+  }
+}
+
+BENCHMARK(SkewedAcceptsRoundRobin, iters) {
+  runSkewedAccepts(iters, /* loadAware */ false);
+}
+
+BENCHMARK_RELATIVE(SkewedAcceptsLoadAware, iters) {
+  runSkewedAccepts(iters, /* loadAware */ true);
+}
+
+int main(int argc, char** argv) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  runBenchmarks();
+}
+
+#else
+
+int main() {}
+
+#endif
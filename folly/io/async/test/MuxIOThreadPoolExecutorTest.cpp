@@ -22,7 +22,9 @@
 
 #include <folly/executors/test/IOThreadPoolExecutorBaseTestLib.h>
 #include <folly/experimental/io/MuxIOThreadPoolExecutor.h>
+#include <folly/io/async/EventBaseLocal.h>
 #include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
 #include <folly/synchronization/Latch.h>
 
 namespace folly {
@@ -103,6 +105,130 @@ TEST(MuxIOThreadPoolExecutor, InvalidSetNumThreads) {
       folly::MuxIOThreadPoolExecutor(2, options), std::invalid_argument);
 }
 
+TEST(MuxIOThreadPoolExecutor, SetNumThreadsUnderLoad) {
+  static constexpr size_t kNumEventBases = 8;
+  static constexpr size_t kNumTasks = 20000;
+  folly::MuxIOThreadPoolExecutor ex(
+      kNumEventBases,
+      folly::MuxIOThreadPoolExecutor::Options().setNumEventBases(
+          kNumEventBases));
+
+  // Threads are stopped while the poller is scheduling EventBases.
+  folly::Latch latch(kNumTasks);
+  std::thread producer([&] {
+    for (size_t i = 0; i < kNumTasks; ++i) {
+      ex.add([&] { latch.count_down(); });
+    }
+  });
+  for (size_t i = 0; i < 50; ++i) {
+    ex.setNumThreads(1 + i % kNumEventBases);
+  }
+  producer.join();
+  latch.wait();
+}
+
+TEST(MuxIOThreadPoolExecutor, EventBaseStats) {
+  static constexpr size_t kNumEventBases = 8;
+  folly::MuxIOThreadPoolExecutor ex(
+      2,
+      folly::MuxIOThreadPoolExecutor::Options()
+          .setNumEventBases(kNumEventBases)
+          .setLoadHalfLife(std::chrono::seconds{10}));
+  auto evbs = ex.getAllEventBases();
+
+  // Keep the first EventBase busy.
+  folly::Baton<> done;
+  evbs[0]->runInEventBaseThread([&] {
+    auto const deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds{20};
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+    done.post();
+  });
+  done.wait();
+  // The stats are recorded when the loop returns.
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds{10};
+  while (ex.getEventBaseStats()[0].busyTime < std::chrono::milliseconds{20} &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+
+  auto stats = ex.getEventBaseStats();
+  ASSERT_EQ(stats.size(), kNumEventBases);
+  EXPECT_GE(stats[0].busyTime, std::chrono::milliseconds{20});
+  EXPECT_GE(stats[0].recentBusyTime, std::chrono::milliseconds{10});
+  for (size_t i = 1; i < kNumEventBases; ++i) {
+    EXPECT_LT(stats[i].recentBusyTime, stats[0].recentBusyTime);
+  }
+
+  // New work avoids the busy EventBase, which is only picked if both
+  // choices fall on it.
+  static constexpr size_t kPicks = 800;
+  size_t busyPicks = 0;
+  for (size_t i = 0; i < kPicks; ++i) {
+    busyPicks += ex.getEventBase() == evbs[0].get();
+  }
+  EXPECT_LT(busyPicks, kPicks / kNumEventBases / 2);
+}
+
+TEST(MuxIOThreadPoolExecutor, EventBaseLocal) {
+  static constexpr size_t kNumTasks = 1000;
+  folly::MuxIOThreadPoolExecutor ex(
+      4, folly::MuxIOThreadPoolExecutor::Options().setNumEventBases(4));
+  auto evb = ex.getAllEventBases()[0];
+
+  // EventBaseLocal values move with the EventBase across threads.
+  folly::EventBaseLocal<size_t> local;
+  folly::Latch latch(kNumTasks);
+  for (size_t i = 0; i < kNumTasks; ++i) {
+    evb->runInEventBaseThread([&, i] {
+      EXPECT_TRUE(evb->isInEventBaseThread());
+      EXPECT_EQ(
+          folly::EventBaseManager::get()->getExistingEventBase(), evb.get());
+      EXPECT_EQ(local.try_emplace(*evb, size_t(0))++, i);
+      latch.count_down();
+    });
+  }
+  latch.wait();
+}
+
+TEST(MuxIOThreadPoolExecutor, RemoveObserver) {
+  struct Observer : folly::IOThreadPoolExecutorBase::IOObserver {
+    void registerEventBase(folly::EventBase&) override { ++evbs; }
+    void unregisterEventBase(folly::EventBase&) override { --evbs; }
+    void threadStarted(folly::ThreadPoolExecutor::ThreadHandle*) override {
+      ++threads;
+    }
+    void threadStopped(folly::ThreadPoolExecutor::ThreadHandle*) override {
+      --threads;
+    }
+    void threadPreviouslyStarted(
+        folly::ThreadPoolExecutor::ThreadHandle*) override {
+      ++threads;
+    }
+    void threadNotYetStopped(
+        folly::ThreadPoolExecutor::ThreadHandle*) override {
+      --threads;
+    }
+
+    int evbs{0};
+    int threads{0};
+  };
+
+  folly::MuxIOThreadPoolExecutor ex(
+      2, folly::MuxIOThreadPoolExecutor::Options().setNumEventBases(4));
+  auto observer = std::make_shared<Observer>();
+  ex.addObserver(observer);
+  EXPECT_EQ(observer->evbs, 4);
+  EXPECT_EQ(observer->threads, 2);
+  ex.removeObserver(observer);
+  EXPECT_EQ(observer->evbs, 0);
+  EXPECT_EQ(observer->threads, 0);
+  ex.setNumThreads(4);
+  EXPECT_EQ(observer->threads, 0);
+}
+
 INSTANTIATE_TYPED_TEST_SUITE_P(
     MuxIOThreadPoolExecutorTest,
     IOThreadPoolExecutorBaseTest,
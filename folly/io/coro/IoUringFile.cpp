@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/coro/IoUringFile.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include <folly/Exception.h>
+#include <folly/Function.h>
+#include <folly/Memory.h>
+#include <folly/coro/Baton.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/IoUringBackend.h>
+#include <folly/io/async/IoUringEventBaseLocal.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysUio.h>
+#include <folly/portability/Unistd.h>
+
+#include <glog/logging.h>
+
+#if FOLLY_HAS_COROUTINES && FOLLY_HAS_LIBURING
+
+namespace folly {
+namespace coro {
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+
+IoUringBackend* getBackend(EventBase* evb) {
+  auto* backend = IoUringEventBaseLocal::try_get(evb);
+  if (!backend) {
+    backend = dynamic_cast<IoUringBackend*>(evb->getBackend());
+  }
+  if (!backend) {
+    throw std::invalid_argument("need a IoUringBackend event base");
+  }
+  return backend;
+}
+
+int checkResult(int res, const char* what) {
+  if (res < 0) {
+    throw makeSystemErrorExplicit(-res, what);
+  }
+  return res;
+}
+
+// The SQEs take the length as an unsigned int, and return it as an int.
+unsigned int clampLength(size_t len) {
+  return static_cast<unsigned int>(
+      std::min<size_t>(len, std::numeric_limits<int>::max()));
+}
+
+using QueueFunc =
+    folly::Function<void(IoUringBackend&, IoUringBackend::FileOpCallback&&)>;
+
+// Queues an operation on the thread of evb, where the backend may be used,
+// and waits for its result.
+Task<int> runOp(EventBase* evb, IoUringBackend* backend, QueueFunc queue) {
+  Baton done;
+  int res = 0;
+  auto submit = [&] {
+    queue(*backend, [&](int r) {
+      res = r;
+      done.post();
+    });
+  };
+  if (evb->isInEventBaseThread()) {
+    submit();
+  } else {
+    evb->runInEventBaseThread(submit);
+  }
+  co_await done;
+  co_return res;
+}
+
+// A read or write of a registered buffer, which the backend has no queue*()
+// method for.
+struct FixedIoSqe : public IoSqeBase {
+  FixedIoSqe(
+      bool write, int fd, uint8_t* buf, unsigned int len, off_t offset, int idx)
+      : write_(write),
+        fd_(fd),
+        buf_(buf),
+        len_(len),
+        offset_(offset),
+        idx_(idx) {}
+
+  void processSubmit(struct io_uring_sqe* sqe) noexcept override {
+    if (write_) {
+      ::io_uring_prep_write_fixed(sqe, fd_, buf_, len_, offset_, idx_);
+    } else {
+      ::io_uring_prep_read_fixed(sqe, fd_, buf_, len_, offset_, idx_);
+    }
+  }
+
+  void callback(const io_uring_cqe* cqe) noexcept override {
+    // The waiter may destroy this as soon as it is called.
+    auto cb = std::move(cb_);
+    cb(cqe->res);
+  }
+
+  void callbackCancelled(const io_uring_cqe* cqe) noexcept override {
+    callback(cqe);
+  }
+
+  const bool write_;
+  const int fd_;
+  uint8_t* const buf_;
+  const unsigned int len_;
+  const off_t offset_;
+  const int idx_;
+  IoUringBackend::FileOpCallback cb_;
+};
+
+} // namespace
+
+RegisteredBufferPool::Buffer& RegisteredBufferPool::Buffer::operator=(
+    Buffer&& other) noexcept {
+  if (this != &other) {
+    reset();
+    pool_ = std::exchange(other.pool_, nullptr);
+    index_ = std::exchange(other.index_, -1);
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+void RegisteredBufferPool::Buffer::reset() {
+  if (auto* pool = std::exchange(pool_, nullptr)) {
+    pool->release(index_);
+    index_ = -1;
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+void RegisteredBufferPool::AlignedFree::operator()(uint8_t* p) const {
+  aligned_free(p);
+}
+
+RegisteredBufferPool::RegisteredBufferPool(
+    EventBase* evb, size_t count, size_t bufferSize)
+    : evb_(evb),
+      backend_(getBackend(evb)),
+      count_(count),
+      bufferSize_((bufferSize + kPageSize - 1) / kPageSize * kPageSize) {
+  if (count == 0 || count > std::numeric_limits<uint16_t>::max()) {
+    throw std::invalid_argument("invalid number of registered buffers");
+  }
+  auto* memory =
+      static_cast<uint8_t*>(aligned_malloc(count * bufferSize_, kPageSize));
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  memory_.reset(memory);
+
+  std::vector<struct iovec> iovecs(count);
+  free_.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    iovecs[i].iov_base = memory + i * bufferSize_;
+    iovecs[i].iov_len = bufferSize_;
+    // Hand out the lowest indices first.
+    free_.push_back(static_cast<int>(count - 1 - i));
+  }
+  // A ring created with IORING_SETUP_SINGLE_ISSUER may only be registered
+  // with from its submitter thread.
+  int res = 0;
+  evb_->runInEventBaseThreadAndWait([&] {
+    res = ::io_uring_register_buffers(
+        backend_->ioRingPtr(), iovecs.data(), static_cast<unsigned>(count));
+  });
+  checkResult(res, "io_uring_register_buffers failed");
+}
+
+RegisteredBufferPool::~RegisteredBufferPool() {
+  DCHECK_EQ(free_.size(), count_)
+      << "RegisteredBufferPool destroyed with buffers in use";
+  evb_->runInEventBaseThreadAndWait(
+      [&] { ::io_uring_unregister_buffers(backend_->ioRingPtr()); });
+}
+
+RegisteredBufferPool::Buffer RegisteredBufferPool::tryGet() {
+  std::lock_guard<std::mutex> g(mutex_);
+  if (free_.empty()) {
+    return Buffer();
+  }
+  auto const index = free_.back();
+  free_.pop_back();
+  return Buffer(this, index, memory_.get() + index * bufferSize_, bufferSize_);
+}
+
+size_t RegisteredBufferPool::available() const {
+  std::lock_guard<std::mutex> g(mutex_);
+  return free_.size();
+}
+
+void RegisteredBufferPool::release(int index) noexcept {
+  std::lock_guard<std::mutex> g(mutex_);
+  free_.push_back(index);
+}
+
+Task<IoUringFile> IoUringFile::open(
+    EventBase* evb, std::string path, int flags, mode_t mode) {
+  auto* backend = getBackend(evb);
+  auto res = co_await runOp(
+      evb,
+      backend,
+      [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+        b.queueOpenat(AT_FDCWD, path.c_str(), flags, mode, std::move(cb));
+      });
+  co_return IoUringFile(evb, checkResult(res, "IoUringFile: open failed"));
+}
+
+IoUringFile::IoUringFile(EventBase* evb, int fd)
+    : evb_(evb), backend_(getBackend(evb)), fd_(fd) {}
+
+IoUringFile::IoUringFile(IoUringFile&& other) noexcept
+    : evb_(other.evb_),
+      backend_(other.backend_),
+      fd_(std::exchange(other.fd_, -1)) {}
+
+IoUringFile& IoUringFile::operator=(IoUringFile&& other) noexcept {
+  if (this != &other) {
+    if (fd_ >= 0) {
+      fileops::close(fd_);
+    }
+    evb_ = other.evb_;
+    backend_ = other.backend_;
+    fd_ = std::exchange(other.fd_, -1);
+  }
+  return *this;
+}
+
+IoUringFile::~IoUringFile() {
+  if (fd_ >= 0) {
+    fileops::close(fd_);
+  }
+}
+
+int IoUringFile::release() {
+  return std::exchange(fd_, -1);
+}
+
+Task<size_t> IoUringFile::read(MutableByteRange buf, off_t offset) {
+  auto res = co_await runOp(
+      evb_,
+      backend_,
+      [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+        b.queueRead(
+            fd_, buf.data(), clampLength(buf.size()), offset, std::move(cb));
+      });
+  co_return checkResult(res, "IoUringFile: read failed");
+}
+
+Task<Unit> IoUringFile::write(ByteRange buf, off_t offset) {
+  while (!buf.empty()) {
+    auto res = co_await runOp(
+        evb_,
+        backend_,
+        [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+          b.queueWrite(
+              fd_, buf.data(), clampLength(buf.size()), offset, std::move(cb));
+        });
+    if (checkResult(res, "IoUringFile: write failed") == 0) {
+      throw makeSystemErrorExplicit(EIO, "IoUringFile: write returned 0");
+    }
+    buf.advance(res);
+    offset += res;
+  }
+  co_return unit;
+}
+
+Task<size_t> IoUringFile::read(
+    const RegisteredBufferPool::Buffer& buf, size_t len, off_t offset) {
+  if (!buf || buf.pool()->getEventBase() != evb_ || len > buf.size()) {
+    throw std::invalid_argument("IoUringFile: invalid registered buffer");
+  }
+  FixedIoSqe sqe(
+      false, fd_, buf.data(), clampLength(len), offset, buf.index());
+  auto res = co_await runOp(
+      evb_,
+      backend_,
+      [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+        sqe.cb_ = std::move(cb);
+        b.submit(sqe);
+      });
+  co_return checkResult(res, "IoUringFile: read failed");
+}
+
+Task<Unit> IoUringFile::write(
+    const RegisteredBufferPool::Buffer& buf, size_t len, off_t offset) {
+  if (!buf || buf.pool()->getEventBase() != evb_ || len > buf.size()) {
+    throw std::invalid_argument("IoUringFile: invalid registered buffer");
+  }
+  size_t written = 0;
+  while (written < len) {
+    FixedIoSqe sqe(
+        true,
+        fd_,
+        buf.data() + written,
+        clampLength(len - written),
+        offset + written,
+        buf.index());
+    auto res = co_await runOp(
+        evb_,
+        backend_,
+        [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+          sqe.cb_ = std::move(cb);
+          b.submit(sqe);
+        });
+    if (checkResult(res, "IoUringFile: write failed") == 0) {
+      throw makeSystemErrorExplicit(EIO, "IoUringFile: write returned 0");
+    }
+    written += res;
+  }
+  co_return unit;
+}
+
+Task<Unit> IoUringFile::fsync() {
+  auto res = co_await runOp(
+      evb_,
+      backend_,
+      [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+        b.queueFsync(fd_, std::move(cb));
+      });
+  checkResult(res, "IoUringFile: fsync failed");
+  co_return unit;
+}
+
+Task<Unit> IoUringFile::fdatasync() {
+  auto res = co_await runOp(
+      evb_,
+      backend_,
+      [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+        b.queueFdatasync(fd_, std::move(cb));
+      });
+  checkResult(res, "IoUringFile: fdatasync failed");
+  co_return unit;
+}
+
+Task<struct statx> IoUringFile::statx(unsigned int mask) {
+  struct statx st {};
+  auto res = co_await runOp(
+      evb_,
+      backend_,
+      [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+        b.queueStatx(fd_, "", AT_EMPTY_PATH, mask, &st, std::move(cb));
+      });
+  checkResult(res, "IoUringFile: statx failed");
+  co_return st;
+}
+
+Task<Unit> IoUringFile::fallocate(off_t offset, off_t len, int mode) {
+  auto res = co_await runOp(
+      evb_,
+      backend_,
+      [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+        b.queueFallocate(fd_, mode, offset, len, std::move(cb));
+      });
+  checkResult(res, "IoUringFile: fallocate failed");
+  co_return unit;
+}
+
+Task<Unit> IoUringFile::close() {
+  auto const fd = std::exchange(fd_, -1);
+  if (fd < 0) {
+    co_return unit;
+  }
+  auto res = co_await runOp(
+      evb_,
+      backend_,
+      [&](IoUringBackend& b, IoUringBackend::FileOpCallback&& cb) {
+        b.queueClose(fd, std::move(cb));
+      });
+  checkResult(res, "IoUringFile: close failed");
+  co_return unit;
+}
+
+struct IoUringFile::ReadAhead::Chunk {
+  std::unique_ptr<IOBuf> buf;
+  off_t offset{0};
+  int res{0};
+  Baton done;
+};
+
+IoUringFile::ReadAhead::ReadAhead(
+    IoUringFile& file, off_t offset, size_t chunkSize, size_t depth)
+    : file_(&file),
+      offset_(offset),
+      chunkSize_(clampLength(std::max(chunkSize, size_t(1)))),
+      depth_(std::max(depth, size_t(1))) {}
+
+IoUringFile::ReadAhead::~ReadAhead() = default;
+
+IoUringFile::ReadAhead IoUringFile::readAhead(
+    off_t offset, size_t chunkSize, size_t depth) {
+  return ReadAhead(*this, offset, chunkSize, depth);
+}
+
+void IoUringFile::ReadAhead::fill() {
+  if (eof_ || inFlight_.size() >= depth_) {
+    return;
+  }
+  std::vector<std::shared_ptr<Chunk>> chunks;
+  while (inFlight_.size() < depth_) {
+    auto chunk = std::make_shared<Chunk>();
+    chunk->buf = IOBuf::create(chunkSize_);
+    chunk->offset = offset_;
+    offset_ += chunkSize_;
+    inFlight_.push_back(chunk);
+    chunks.push_back(std::move(chunk));
+  }
+  // The reads are queued together, and submitted in one batch.
+  auto submit = [backend = file_->backend_,
+                 fd = file_->fd_,
+                 len = static_cast<unsigned int>(chunkSize_),
+                 chunks = std::move(chunks)]() mutable {
+    for (auto& chunk : chunks) {
+      auto* c = chunk.get();
+      backend->queueRead(
+          fd,
+          c->buf->writableData(),
+          len,
+          c->offset,
+          [chunk = std::move(chunk)](int res) {
+            chunk->res = res;
+            chunk->done.post();
+          });
+    }
+  };
+  if (file_->evb_->isInEventBaseThread()) {
+    submit();
+  } else {
+    file_->evb_->runInEventBaseThread(std::move(submit));
+  }
+}
+
+Task<std::unique_ptr<IOBuf>> IoUringFile::ReadAhead::next() {
+  fill();
+  if (inFlight_.empty()) {
+    co_return nullptr;
+  }
+  auto chunk = std::move(inFlight_.front());
+  inFlight_.pop_front();
+  co_await chunk->done;
+
+  if (chunk->res < 0) {
+    eof_ = true;
+    inFlight_.clear();
+    throw makeSystemErrorExplicit(-chunk->res, "IoUringFile: read failed");
+  }
+  if (size_t(chunk->res) < chunkSize_) {
+    // The chunks read ahead are past the end of the file or, after a short
+    // read, at the wrong offset: drop them, they complete on their own.
+    inFlight_.clear();
+    offset_ = chunk->offset + chunk->res;
+    eof_ = chunk->res == 0;
+  }
+  if (chunk->res == 0) {
+    co_return nullptr;
+  }
+  chunk->buf->append(chunk->res);
+  fill();
+  co_return std::move(chunk->buf);
+}
+
+} // namespace coro
+} // namespace folly
+
+#endif // FOLLY_HAS_COROUTINES && FOLLY_HAS_LIBURING
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/Unit.h>
+#include <folly/coro/Task.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/Liburing.h>
+#include <folly/portability/SysStat.h>
+
+#if FOLLY_HAS_COROUTINES && FOLLY_HAS_LIBURING
+
+namespace folly {
+
+class EventBase;
+class IoUringBackend;
+
+namespace coro {
+
+/**
+ * A pool of buffers registered with the io_uring ring of an EventBase, for
+ * IoUringFile reads and writes that skip the per-request pinning and mapping
+ * of the user pages by the kernel.
+ *
+ * A ring has at most one table of registered buffers, so there is at most
+ * one pool per EventBase, and the constructor throws if the ring already has
+ * one. The buffers are aligned to a page, which allows O_DIRECT IO.
+ *
+ * Buffers can be taken and returned from any thread, and must all be
+ * returned before the pool is destroyed.
+ */
+class RegisteredBufferPool {
+ public:
+  class Buffer {
+   public:
+    Buffer() = default;
+    Buffer(Buffer&& other) noexcept { *this = std::move(other); }
+    Buffer& operator=(Buffer&& other) noexcept;
+    ~Buffer() { reset(); }
+
+    uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    MutableByteRange range() const { return MutableByteRange(data_, size_); }
+    RegisteredBufferPool* pool() const { return pool_; }
+    int index() const { return index_; }
+
+    explicit operator bool() const { return pool_ != nullptr; }
+
+    // Returns the buffer to its pool.
+    void reset();
+
+   private:
+    friend class RegisteredBufferPool;
+    Buffer(RegisteredBufferPool* pool, int index, uint8_t* data, size_t size)
+        : pool_(pool), index_(index), data_(data), size_(size) {}
+
+    RegisteredBufferPool* pool_{nullptr};
+    int index_{-1};
+    uint8_t* data_{nullptr};
+    size_t size_{0};
+  };
+
+  // evb must run an IoUringBackend.
+  RegisteredBufferPool(EventBase* evb, size_t count, size_t bufferSize);
+  ~RegisteredBufferPool();
+
+  RegisteredBufferPool(const RegisteredBufferPool&) = delete;
+  RegisteredBufferPool& operator=(const RegisteredBufferPool&) = delete;
+
+  // A free buffer, or an empty one if all of them are in use.
+  Buffer tryGet();
+
+  size_t available() const;
+  size_t bufferSize() const { return bufferSize_; }
+  EventBase* getEventBase() const { return evb_; }
+
+ private:
+  struct AlignedFree {
+    void operator()(uint8_t* p) const;
+  };
+
+  void release(int index) noexcept;
+
+  EventBase* const evb_;
+  IoUringBackend* const backend_;
+  const size_t count_;
+  const size_t bufferSize_;
+  std::unique_ptr<uint8_t, AlignedFree> memory_;
+  mutable std::mutex mutex_;
+  std::vector<int> free_;
+};
+
+/**
+ * A file whose operations are io_uring requests on the ring of an EventBase
+ * running an IoUringBackend, awaited by coroutines instead of blocking a
+ * thread. The requests are queued on the thread of the EventBase, and
+ * submitted together with the other SQEs of its loop iteration.
+ *
+ * Unlike AsyncIO and SimpleAsyncIO, which have their own ring or libaio
+ * context, this shares the ring, and the thread, of the EventBase that
+ * already does the network IO of the service.
+ *
+ *   auto file = co_await IoUringFile::open(evb, path, O_RDONLY);
+ *   auto reader = file.readAhead(0, 1 << 20, 4);
+ *   while (auto buf = co_await reader.next()) {
+ *     co_await upload(std::move(buf));
+ *   }
+ *   co_await file.close();
+ *
+ * Errors are reported as std::system_error. The operations can't be
+ * cancelled: once submitted, they are awaited until they complete.
+ */
+class IoUringFile {
+ public:
+  // Opens path relative to the current directory, as openat(2).
+  static Task<IoUringFile> open(
+      EventBase* evb, std::string path, int flags, mode_t mode = 0644);
+
+  // Takes ownership of fd. evb must run an IoUringBackend.
+  IoUringFile(EventBase* evb, int fd);
+
+  IoUringFile(IoUringFile&& other) noexcept;
+  IoUringFile& operator=(IoUringFile&& other) noexcept;
+
+  // Closes the fd with close(2) if close() was not awaited.
+  ~IoUringFile();
+
+  int fd() const { return fd_; }
+  EventBase* getEventBase() const { return evb_; }
+
+  // Gives up the ownership of the fd.
+  int release();
+
+  // Reads up to buf.size() bytes at offset. Returns 0 at the end of the file.
+  Task<size_t> read(MutableByteRange buf, off_t offset);
+
+  // Writes all of buf at offset.
+  Task<Unit> write(ByteRange buf, off_t offset);
+
+  // Reads up to len bytes at offset into a registered buffer, or writes len
+  // bytes of it, with IORING_OP_READ_FIXED / IORING_OP_WRITE_FIXED. The pool
+  // of buf must belong to the EventBase of the file.
+  Task<size_t> read(
+      const RegisteredBufferPool::Buffer& buf, size_t len, off_t offset);
+  Task<Unit> write(
+      const RegisteredBufferPool::Buffer& buf, size_t len, off_t offset);
+
+  Task<Unit> fsync();
+  Task<Unit> fdatasync();
+
+  Task<struct statx> statx(unsigned int mask = STATX_BASIC_STATS);
+
+  Task<Unit> fallocate(off_t offset, off_t len, int mode = 0);
+
+  Task<Unit> close();
+
+  /**
+   * Reads a file sequentially in chunks of chunkSize bytes, keeping up to
+   * depth chunks read ahead of the one being consumed, so that the disk
+   * latency overlaps with the processing of the previous chunks.
+   */
+  class ReadAhead {
+   public:
+    ReadAhead(ReadAhead&&) = default;
+    ReadAhead& operator=(ReadAhead&&) = default;
+    ~ReadAhead();
+
+    // The next chunk, nullptr at the end of the file. Chunks are shorter
+    // than chunkSize only at the end of the file, or if the kernel returns
+    // a short read.
+    Task<std::unique_ptr<IOBuf>> next();
+
+   private:
+    friend class IoUringFile;
+    struct Chunk;
+
+    ReadAhead(IoUringFile& file, off_t offset, size_t chunkSize, size_t depth);
+
+    void fill();
+
+    IoUringFile* file_;
+    off_t offset_;
+    size_t chunkSize_;
+    size_t depth_;
+    bool eof_{false};
+    // Shared with the requests, which complete after the ReadAhead is
+    // destroyed if it is destroyed first.
+    std::deque<std::shared_ptr<Chunk>> inFlight_;
+  };
+
+  // The file must outlive the ReadAhead.
+  ReadAhead readAhead(off_t offset, size_t chunkSize, size_t depth);
+
+ private:
+  EventBase* evb_;
+  IoUringBackend* backend_;
+  int fd_;
+};
+
+} // namespace coro
+} // namespace folly
+
+#endif // FOLLY_HAS_COROUTINES && FOLLY_HAS_LIBURING
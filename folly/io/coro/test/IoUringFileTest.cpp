@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Portability.h>
+
+#include <string>
+#include <system_error>
+
+#include <folly/coro/BlockingWait.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/IoUringBackend.h>
+#include <folly/io/coro/IoUringFile.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/GTest.h>
+#include <folly/test/TestUtils.h>
+#include <folly/testing/TestUtil.h>
+
+#if FOLLY_HAS_COROUTINES && FOLLY_HAS_LIBURING
+
+using namespace folly;
+using namespace folly::coro;
+
+namespace {
+
+std::string makeData(size_t size) {
+  std::string data(size, '\0');
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<char>('a' + i % 26);
+  }
+  return data;
+}
+
+} // namespace
+
+class IoUringFileTest : public testing::Test {
+ public:
+  void SetUp() override {
+    try {
+      evb = std::make_unique<EventBase>(EventBase::Options().setBackendFactory(
+          [] {
+            return std::make_unique<folly::IoUringBackend>(
+                folly::IoUringBackend::Options());
+          }));
+    } catch (const folly::IoUringBackend::NotAvailable&) {
+    }
+  }
+
+  template <typename F>
+  void run(F f) {
+    blockingWait(co_invoke(std::move(f)), evb.get());
+  }
+
+  std::unique_ptr<EventBase> evb;
+  test::TemporaryFile tmp{"IoUringFileTest"};
+};
+
+TEST_F(IoUringFileTest, WriteAndRead) {
+  SKIP_IF(!evb) << "Backend not available";
+  run([&]() -> Task<> {
+    auto const data = makeData(10000);
+    auto file = co_await IoUringFile::open(
+        evb.get(), tmp.path().string(), O_RDWR | O_TRUNC);
+    co_await file.write(StringPiece(data), 0);
+    co_await file.fdatasync();
+
+    std::string out(data.size() + 100, '\0');
+    auto n = co_await file.read(
+        MutableByteRange(
+            reinterpret_cast<uint8_t*>(out.data()), out.size()),
+        0);
+    EXPECT_EQ(data.size(), n);
+    EXPECT_EQ(data, out.substr(0, n));
+
+    auto st = co_await file.statx();
+    EXPECT_EQ(data.size(), st.stx_size);
+
+    co_await file.fallocate(0, 1 << 20);
+    st = co_await file.statx(STATX_SIZE);
+    EXPECT_EQ(1 << 20, st.stx_size);
+
+    co_await file.fsync();
+    co_await file.close();
+    EXPECT_EQ(-1, file.fd());
+  });
+}
+
+TEST_F(IoUringFileTest, OpenFailure) {
+  SKIP_IF(!evb) << "Backend not available";
+  run([&]() -> Task<> {
+    EXPECT_THROW(
+        co_await IoUringFile::open(
+            evb.get(), tmp.path().string() + ".missing", O_RDONLY),
+        std::system_error);
+  });
+}
+
+TEST_F(IoUringFileTest, ReadAhead) {
+  SKIP_IF(!evb) << "Backend not available";
+  auto const data = makeData(100000);
+  run([&]() -> Task<> {
+    auto file = co_await IoUringFile::open(
+        evb.get(), tmp.path().string(), O_RDWR | O_TRUNC);
+    co_await file.write(StringPiece(data), 0);
+
+    std::string out;
+    size_t chunks = 0;
+    auto reader = file.readAhead(0, 4096, 4);
+    while (auto buf = co_await reader.next()) {
+      EXPECT_LE(buf->length(), 4096);
+      out.append(buf->moveToFbString().toStdString());
+      ++chunks;
+    }
+    EXPECT_EQ(data, out);
+    EXPECT_EQ((data.size() + 4095) / 4096, chunks);
+    // The end of the file is sticky.
+    EXPECT_EQ(nullptr, co_await reader.next());
+  });
+}
+
+TEST_F(IoUringFileTest, RegisteredBuffers) {
+  SKIP_IF(!evb) << "Backend not available";
+  RegisteredBufferPool pool(evb.get(), 2, 1000);
+  EXPECT_EQ(4096, pool.bufferSize());
+  EXPECT_EQ(2, pool.available());
+
+  run([&]() -> Task<> {
+    auto file = co_await IoUringFile::open(
+        evb.get(), tmp.path().string(), O_RDWR | O_TRUNC);
+    auto in = pool.tryGet();
+    auto out = pool.tryGet();
+    EXPECT_TRUE(in);
+    EXPECT_TRUE(out);
+    EXPECT_FALSE(pool.tryGet());
+    EXPECT_EQ(0, pool.available());
+
+    auto const data = makeData(pool.bufferSize());
+    std::copy(data.begin(), data.end(), in.data());
+    co_await file.write(in, data.size(), 4096);
+    auto n = co_await file.read(out, out.size(), 4096);
+    EXPECT_EQ(data.size(), n);
+    EXPECT_EQ(data, std::string(reinterpret_cast<char*>(out.data()), n));
+
+    EXPECT_THROW(
+        co_await file.read(out, out.size() + 1, 0), std::invalid_argument);
+  });
+  EXPECT_EQ(2, pool.available());
+}
+
+#endif
@@ -31,6 +31,7 @@
 #include <folly/lang/CheckedMath.h>
 #include <folly/lang/Exception.h>
 #include <folly/memory/Malloc.h>
+#include <folly/memory/MemoryResource.h>
 
 namespace folly {
 
@@ -141,6 +142,9 @@ class Arena {
   // `bytesUsed()` will be 6KB, while `totalSize()` will be 8KB+.
   size_t bytesUsed() const { return bytesUsed_; }
 
+  // Alignment of every pointer returned by `allocate`.
+  size_t maxAlign() const { return maxAlign_; }
+
   // not copyable or movable
   Arena(const Arena&) = delete;
   Arena& operator=(const Arena&) = delete;
@@ -320,6 +324,65 @@ using FallbackArenaAllocator =
 template <typename T>
 using FallbackSysArenaAllocator = FallbackArenaAllocator<T, SysAllocator<char>>;
 
+#if FOLLY_HAS_MEMORY_RESOURCE
+
+/**
+ * A memory_resource that allocates from an arena, for the folly::pmr
+ * containers (F14 maps and sets, sorted_vector_map, heap_vector_map, ...).
+ *
+ * As with the arena, deallocation is a no-op. Memory is reclaimed all at
+ * once by release(), which keeps the arena's regular blocks for reuse, so a
+ * resource that is released at the end of each request stops allocating
+ * from the system once it has grown to the size of a typical request.
+ * Containers using the resource must be destroyed before release().
+ *
+ *   SysArenaMemoryResource resource;
+ *   for (auto& request : requests) {
+ *     {
+ *       folly::pmr::F14FastMap<int, int> map(&resource);
+ *       handle(request, map);
+ *     }
+ *     resource.release();
+ *   }
+ */
+template <class ArenaT>
+class ArenaMemoryResource : public detail::std_pmr::memory_resource {
+ public:
+  template <typename... Args>
+  explicit ArenaMemoryResource(Args&&... args)
+      : arena_(std::forward<Args>(args)...) {}
+
+  ArenaT& arena() { return arena_; }
+  const ArenaT& arena() const { return arena_; }
+
+  void release() { arena_.clear(); }
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    if (FOLLY_LIKELY(alignment <= arena_.maxAlign())) {
+      return arena_.allocate(bytes);
+    }
+    size_t padded;
+    if (!checked_add<size_t>(&padded, bytes, alignment - 1)) {
+      throw_exception<std::bad_alloc>();
+    }
+    return align_ceil(static_cast<char*>(arena_.allocate(padded)), alignment);
+  }
+
+  void do_deallocate(void*, size_t, size_t) override {}
+
+  bool do_is_equal(
+      const detail::std_pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  ArenaT arena_;
+};
+
+using SysArenaMemoryResource = ArenaMemoryResource<SysArena>;
+
+#endif // FOLLY_HAS_MEMORY_RESOURCE
+
 } // namespace folly
 
 #include <folly/memory/Arena-inl.h>
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Request-scoped containers: each iteration builds a map, looks up every
+// key once, and destroys the map, as a request handler would. Compares the
+// default allocator with an arena that is cleared after every request,
+// through ArenaAllocator and through the pmr memory resource.
+
+#include <folly/memory/Arena.h>
+
+#include <string>
+
+#include <folly/Benchmark.h>
+#include <folly/container/F14Map.h>
+#include <folly/container/sorted_vector_types.h>
+#include <folly/portability/GFlags.h>
+
+#include <fmt/format.h>
+
+using namespace folly;
+
+namespace {
+
+template <typename Map>
+void useMap(Map& map, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    map.emplace(i * 7919, i);
+  }
+  size_t sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    sum += map.find(i * 7919)->second;
+  }
+  doNotOptimizeAway(sum);
+}
+
+template <template <typename...> class Map>
+void stdRequest(size_t iters, size_t size) {
+  while (iters--) {
+    Map<size_t, size_t> map;
+    useMap(map, size);
+  }
+}
+
+template <template <typename...> class Map>
+void arenaRequest(size_t iters, size_t size) {
+  using Alloc = SysArenaAllocator<std::pair<const size_t, size_t>>;
+  SysArena arena;
+  while (iters--) {
+    {
+      Map<size_t,
+          size_t,
+          f14::DefaultHasher<size_t>,
+          f14::DefaultKeyEqual<size_t>,
+          Alloc>
+          map{Alloc(arena)};
+      useMap(map, size);
+    }
+    arena.clear();
+  }
+}
+
+void stdSortedRequest(size_t iters, size_t size) {
+  while (iters--) {
+    sorted_vector_map<size_t, size_t> map;
+    useMap(map, size);
+  }
+}
+
+void arenaSortedRequest(size_t iters, size_t size) {
+  using Alloc = SysArenaAllocator<std::pair<size_t, size_t>>;
+  SysArena arena;
+  while (iters--) {
+    {
+      sorted_vector_map<size_t, size_t, std::less<size_t>, Alloc> map{
+          Alloc(arena)};
+      useMap(map, size);
+    }
+    arena.clear();
+  }
+}
+
+#if FOLLY_HAS_MEMORY_RESOURCE
+
+template <typename Map>
+void pmrRequest(size_t iters, size_t size) {
+  SysArenaMemoryResource resource;
+  while (iters--) {
+    {
+      Map map(&resource);
+      useMap(map, size);
+    }
+    resource.release();
+  }
+}
+
+#endif // FOLLY_HAS_MEMORY_RESOURCE
+
+template <typename Fn>
+void addRequestBenchmark(
+    std::string const& container,
+    char const* allocator,
+    bool relative,
+    size_t size,
+    Fn fn) {
+  addBenchmark(
+      __FILE__,
+      fmt::format(
+          "{}{}[{}] {}", relative ? "%" : "", container, size, allocator),
+      [=](unsigned iters) {
+        fn(iters, size);
+        return iters;
+      });
+}
+
+void addRequestBenchmarks() {
+  for (size_t size : {16, 256, 4096}) {
+    addRequestBenchmark(
+        "F14FastMap", "std", false, size, stdRequest<F14FastMap>);
+    addRequestBenchmark(
+        "F14FastMap", "arena", true, size, arenaRequest<F14FastMap>);
+#if FOLLY_HAS_MEMORY_RESOURCE
+    addRequestBenchmark(
+        "F14FastMap",
+        "pmr",
+        true,
+        size,
+        pmrRequest<pmr::F14FastMap<size_t, size_t>>);
+#endif
+    addRequestBenchmark(
+        "F14NodeMap", "std", false, size, stdRequest<F14NodeMap>);
+    addRequestBenchmark(
+        "F14NodeMap", "arena", true, size, arenaRequest<F14NodeMap>);
+#if FOLLY_HAS_MEMORY_RESOURCE
+    addRequestBenchmark(
+        "F14NodeMap",
+        "pmr",
+        true,
+        size,
+        pmrRequest<pmr::F14NodeMap<size_t, size_t>>);
+#endif
+    addRequestBenchmark(
+        "sorted_vector_map", "std", false, size, stdSortedRequest);
+    addRequestBenchmark(
+        "sorted_vector_map", "arena", true, size, arenaSortedRequest);
+#if FOLLY_HAS_MEMORY_RESOURCE
+    addRequestBenchmark(
+        "sorted_vector_map",
+        "pmr",
+        true,
+        size,
+        pmrRequest<pmr::sorted_vector_map<size_t, size_t>>);
+#endif
+    addBenchmark(__FILE__, "-", [](unsigned iters) { return iters; });
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  addRequestBenchmarks();
+  folly::runBenchmarks();
+  return 0;
+}
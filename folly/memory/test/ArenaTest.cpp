@@ -18,12 +18,15 @@
 
 #include <scoped_allocator>
 #include <set>
+#include <string>
 #include <vector>
 
 #include <glog/logging.h>
 
 #include <folly/Memory.h>
 #include <folly/Random.h>
+#include <folly/container/F14Map.h>
+#include <folly/container/sorted_vector_types.h>
 #include <folly/memory/MallctlHelper.h>
 #include <folly/memory/Malloc.h>
 #include <folly/portability/GFlags.h>
@@ -346,6 +349,134 @@ TEST(Arena, Merge) {
   EXPECT_EQ(0, arena2.bytesUsed());
 }
 
+namespace {
+
+struct CountDestroys {
+  static int destroyed;
+
+  explicit CountDestroys(int v) : value(v) {}
+  CountDestroys(const CountDestroys& other) : value(other.value) {}
+  ~CountDestroys() { ++destroyed; }
+
+  int value;
+};
+
+int CountDestroys::destroyed = 0;
+
+} // namespace
+
+TEST(Arena, F14Maps) {
+  using Hasher = f14::DefaultHasher<int>;
+  using KeyEqual = f14::DefaultKeyEqual<int>;
+  SysArena arena;
+  {
+    using Alloc = SysArenaAllocator<std::pair<const int, int>>;
+    F14NodeMap<int, int, Hasher, KeyEqual, Alloc> node{Alloc(arena)};
+    F14ValueMap<int, int, Hasher, KeyEqual, Alloc> value{Alloc(arena)};
+    F14VectorMap<int, int, Hasher, KeyEqual, Alloc> vector{Alloc(arena)};
+    for (int i = 0; i < 1000; ++i) {
+      node[i] = i;
+      value[i] = i;
+      vector[i] = i;
+    }
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_EQ(i, node.at(i));
+      EXPECT_EQ(i, value.at(i));
+      EXPECT_EQ(i, vector.at(i));
+    }
+    node.clear();
+    EXPECT_TRUE(node.empty());
+    node[1] = 2;
+    EXPECT_EQ(2, node.at(1));
+  }
+  EXPECT_GT(arena.bytesUsed(), 1000 * 3 * sizeof(std::pair<int, int>));
+
+  // Nodes holding values that need to be destroyed are still destroyed
+  // when the map is cleared, though their memory isn't freed.
+  {
+    using Alloc = SysArenaAllocator<std::pair<const int, CountDestroys>>;
+    F14NodeMap<int, CountDestroys, Hasher, KeyEqual, Alloc> node{
+        Alloc(arena)};
+    for (int i = 0; i < 100; ++i) {
+      node.emplace(i, i);
+    }
+    CountDestroys::destroyed = 0;
+    node.clear();
+    EXPECT_EQ(100, CountDestroys::destroyed);
+    node.emplace(0, 0);
+  }
+  EXPECT_EQ(101, CountDestroys::destroyed);
+}
+
+TEST(Arena, SortedVectorMap) {
+  SysArena arena;
+  using Alloc = SysArenaAllocator<std::pair<int, std::string>>;
+  sorted_vector_map<int, std::string, std::less<int>, Alloc> map{Alloc(arena)};
+  for (int i = 100; i > 0; --i) {
+    map[i] = std::to_string(i);
+  }
+  EXPECT_EQ(100, map.size());
+  EXPECT_EQ(1, map.begin()->first);
+  EXPECT_EQ("42", map.at(42));
+}
+
+#if FOLLY_HAS_MEMORY_RESOURCE
+
+TEST(Arena, MemoryResource) {
+  SysArenaMemoryResource resource(1024);
+  EXPECT_TRUE(resource.is_equal(resource));
+  EXPECT_FALSE(resource.is_equal(SysArenaMemoryResource{}));
+
+  for (size_t align : {1, 2, 8, 16, 64, 256, 4096}) {
+    SCOPED_TRACE(align);
+    void* p = resource.allocate(100, align);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) & (align - 1));
+    resource.deallocate(p, 100, align);
+  }
+
+  // release() reuses the regular blocks of the arena.
+  resource.release();
+  EXPECT_EQ(0, resource.arena().bytesUsed());
+  std::vector<void*> addresses;
+  for (int i = 0; i < 100; ++i) {
+    addresses.push_back(resource.allocate(64));
+  }
+  auto totalSize = resource.arena().totalSize();
+  resource.release();
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(addresses[i], resource.allocate(64));
+  }
+  EXPECT_EQ(totalSize, resource.arena().totalSize());
+}
+
+TEST(Arena, MemoryResourceContainers) {
+  SysArenaMemoryResource resource;
+  size_t totalSize = 0;
+  for (int request = 0; request < 10; ++request) {
+    {
+      pmr::F14FastMap<int, int> fast(&resource);
+      pmr::F14NodeMap<int, std::string> node(&resource);
+      pmr::sorted_vector_map<int, int> sorted(&resource);
+      for (int i = 0; i < 1000; ++i) {
+        fast[i] = i;
+        node[i] = std::to_string(i);
+        sorted[-i] = i;
+      }
+      EXPECT_EQ(1000, fast.size());
+      EXPECT_EQ("999", node.at(999));
+      EXPECT_EQ(999, sorted.begin()->second);
+    }
+    resource.release();
+    // Every request after the first is served from the same blocks.
+    if (request > 0) {
+      EXPECT_EQ(totalSize, resource.arena().totalSize());
+    }
+    totalSize = resource.arena().totalSize();
+  }
+}
+
+#endif // FOLLY_HAS_MEMORY_RESOURCE
+
 int main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
   folly::gflags::ParseCommandLineFlags(&argc, &argv, true);
@@ -217,6 +217,14 @@ TEST_F(LifoSemTest, shutdown_multi) {
   }
 }
 
+TEST(LifoSem, multiPostHandoff) {
+  LifoSem sem;
+  // No waiters to hand off to.
+  EXPECT_FALSE(sem.post(2));
+  EXPECT_TRUE(sem.post(0));
+  EXPECT_EQ(2, sem.tryWait(10));
+}
+
 TEST(LifoSem, multiTryWaitSimple) {
   LifoSem sem;
   sem.post(5);